@@ -0,0 +1,555 @@
+// Copyright (c) 2017-2019 Tobias Hector
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <vulkan/vulkan.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+  #include <windows.h>
+#else
+  #include <time.h>
+#endif
+
+#define THSVS_SIMPLER_VULKAN_SYNCHRONIZATION_IMPLEMENTATION
+#include "../thsvs_simpler_vulkan_synchronization.h"
+
+// Everything the translation produces is folded into this, so none of it can be optimized away
+static volatile uint64_t sink = 0;
+
+//// Stubbed Vulkan Commands ////
+/*
+The benchmark only measures the cost of translating barriers, so the Vulkan
+commands called by the library are replaced with stubs that just consume
+their parameters. No Vulkan implementation is needed to build or run this.
+*/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+VKAPI_ATTR void VKAPI_CALL vkCmdPipelineBarrier(
+    VkCommandBuffer              commandBuffer,
+    VkPipelineStageFlags         srcStageMask,
+    VkPipelineStageFlags         dstStageMask,
+    VkDependencyFlags            dependencyFlags,
+    uint32_t                     memoryBarrierCount,
+    const VkMemoryBarrier*       pMemoryBarriers,
+    uint32_t                     bufferMemoryBarrierCount,
+    const VkBufferMemoryBarrier* pBufferMemoryBarriers,
+    uint32_t                     imageMemoryBarrierCount,
+    const VkImageMemoryBarrier*  pImageMemoryBarriers)
+{
+    (void)commandBuffer;
+    (void)dependencyFlags;
+    uint64_t result = srcStageMask ^ dstStageMask;
+    for (uint32_t i = 0; i < memoryBarrierCount; ++i)
+        result ^= pMemoryBarriers[i].srcAccessMask ^ pMemoryBarriers[i].dstAccessMask;
+    for (uint32_t i = 0; i < bufferMemoryBarrierCount; ++i)
+        result ^= pBufferMemoryBarriers[i].srcAccessMask ^ pBufferMemoryBarriers[i].dstAccessMask;
+    for (uint32_t i = 0; i < imageMemoryBarrierCount; ++i)
+        result ^= pImageMemoryBarriers[i].srcAccessMask ^ pImageMemoryBarriers[i].newLayout;
+    sink ^= result;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdSetEvent(
+    VkCommandBuffer      commandBuffer,
+    VkEvent              event,
+    VkPipelineStageFlags stageMask)
+{
+    (void)commandBuffer;
+    (void)event;
+    sink ^= stageMask;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdResetEvent(
+    VkCommandBuffer      commandBuffer,
+    VkEvent              event,
+    VkPipelineStageFlags stageMask)
+{
+    (void)commandBuffer;
+    (void)event;
+    sink ^= stageMask;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdWaitEvents(
+    VkCommandBuffer              commandBuffer,
+    uint32_t                     eventCount,
+    const VkEvent*               pEvents,
+    VkPipelineStageFlags         srcStageMask,
+    VkPipelineStageFlags         dstStageMask,
+    uint32_t                     memoryBarrierCount,
+    const VkMemoryBarrier*       pMemoryBarriers,
+    uint32_t                     bufferMemoryBarrierCount,
+    const VkBufferMemoryBarrier* pBufferMemoryBarriers,
+    uint32_t                     imageMemoryBarrierCount,
+    const VkImageMemoryBarrier*  pImageMemoryBarriers)
+{
+    (void)eventCount;
+    (void)pEvents;
+    vkCmdPipelineBarrier(commandBuffer, srcStageMask, dstStageMask, 0,
+                         memoryBarrierCount, pMemoryBarriers,
+                         bufferMemoryBarrierCount, pBufferMemoryBarriers,
+                         imageMemoryBarrierCount, pImageMemoryBarriers);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateEvent(
+    VkDevice                     device,
+    const VkEventCreateInfo*     pCreateInfo,
+    const VkAllocationCallbacks* pAllocator,
+    VkEvent*                     pEvent)
+{
+    static uintptr_t nextEvent = 1;
+    (void)device;
+    (void)pCreateInfo;
+    (void)pAllocator;
+    *pEvent = (VkEvent)nextEvent++;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyEvent(
+    VkDevice                     device,
+    VkEvent                      event,
+    const VkAllocationCallbacks* pAllocator)
+{
+    (void)device;
+    (void)event;
+    (void)pAllocator;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkResetEvent(
+    VkDevice                     device,
+    VkEvent                      event)
+{
+    (void)device;
+    (void)event;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateQueryPool(
+    VkDevice                     device,
+    const VkQueryPoolCreateInfo* pCreateInfo,
+    const VkAllocationCallbacks* pAllocator,
+    VkQueryPool*                 pQueryPool)
+{
+    static uintptr_t nextQueryPool = 1;
+    (void)device;
+    (void)pCreateInfo;
+    (void)pAllocator;
+    *pQueryPool = (VkQueryPool)nextQueryPool++;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyQueryPool(
+    VkDevice                     device,
+    VkQueryPool                  queryPool,
+    const VkAllocationCallbacks* pAllocator)
+{
+    (void)device;
+    (void)queryPool;
+    (void)pAllocator;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdResetQueryPool(
+    VkCommandBuffer              commandBuffer,
+    VkQueryPool                  queryPool,
+    uint32_t                     firstQuery,
+    uint32_t                     queryCount)
+{
+    (void)commandBuffer;
+    (void)queryPool;
+    (void)firstQuery;
+    (void)queryCount;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdWriteTimestamp(
+    VkCommandBuffer              commandBuffer,
+    VkPipelineStageFlagBits      pipelineStage,
+    VkQueryPool                  queryPool,
+    uint32_t                     query)
+{
+    (void)commandBuffer;
+    (void)queryPool;
+    sink ^= (uint64_t)pipelineStage ^ query;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkGetQueryPoolResults(
+    VkDevice                     device,
+    VkQueryPool                  queryPool,
+    uint32_t                     firstQuery,
+    uint32_t                     queryCount,
+    size_t                       dataSize,
+    void*                        pData,
+    VkDeviceSize                 stride,
+    VkQueryResultFlags           flags)
+{
+    (void)device;
+    (void)queryPool;
+    (void)firstQuery;
+    (void)queryCount;
+    (void)stride;
+    (void)flags;
+    memset(pData, 0, dataSize);
+    return VK_SUCCESS;
+}
+
+#ifdef VK_VERSION_1_3
+VKAPI_ATTR void VKAPI_CALL vkCmdPipelineBarrier2(
+    VkCommandBuffer         commandBuffer,
+    const VkDependencyInfo* pDependencyInfo)
+{
+    (void)commandBuffer;
+    uint64_t result = 0;
+    for (uint32_t i = 0; i < pDependencyInfo->memoryBarrierCount; ++i)
+        result ^= pDependencyInfo->pMemoryBarriers[i].srcStageMask ^ pDependencyInfo->pMemoryBarriers[i].dstAccessMask;
+    for (uint32_t i = 0; i < pDependencyInfo->bufferMemoryBarrierCount; ++i)
+        result ^= pDependencyInfo->pBufferMemoryBarriers[i].srcStageMask ^ pDependencyInfo->pBufferMemoryBarriers[i].dstAccessMask;
+    for (uint32_t i = 0; i < pDependencyInfo->imageMemoryBarrierCount; ++i)
+        result ^= pDependencyInfo->pImageMemoryBarriers[i].srcStageMask ^ pDependencyInfo->pImageMemoryBarriers[i].newLayout;
+    sink ^= result;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdSetEvent2(
+    VkCommandBuffer         commandBuffer,
+    VkEvent                 event,
+    const VkDependencyInfo* pDependencyInfo)
+{
+    (void)event;
+    vkCmdPipelineBarrier2(commandBuffer, pDependencyInfo);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdWaitEvents2(
+    VkCommandBuffer         commandBuffer,
+    uint32_t                eventCount,
+    const VkEvent*          pEvents,
+    const VkDependencyInfo* pDependencyInfos)
+{
+    (void)pEvents;
+    for (uint32_t i = 0; i < eventCount; ++i)
+        vkCmdPipelineBarrier2(commandBuffer, &pDependencyInfos[i]);
+}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+//// Timing ////
+static double now_ns()
+{
+#if defined(_WIN32)
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart * 1.0e9 / (double)frequency.QuadPart;
+#else
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec * 1.0e9 + (double)time.tv_nsec;
+#endif
+}
+
+static void report(const char* benchmarkName, double startTime, double endTime, double barrierCount)
+{
+    double nsPerBarrier = (endTime - startTime) / barrierCount;
+    printf("%-56s %10.2f ns/barrier %14.0f barriers/sec\n", benchmarkName, nsPerBarrier, 1.0e9 / nsPerBarrier);
+}
+
+//// Barrier Mixes ////
+#define IMAGE_BATCH_SIZE 64
+
+// A write followed by a single read, as a global barrier
+static void global_single_access_benchmark(uint32_t iterations)
+{
+    ThsvsAccessType prevAccess = THSVS_ACCESS_COMPUTE_SHADER_WRITE;
+    ThsvsAccessType nextAccess = THSVS_ACCESS_COMPUTE_SHADER_READ_OTHER;
+    ThsvsGlobalBarrier barrier = {1, &prevAccess, 1, &nextAccess};
+
+    double startTime = now_ns();
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        VkPipelineStageFlags srcStages;
+        VkPipelineStageFlags dstStages;
+        VkMemoryBarrier vkBarrier;
+        thsvsGetVulkanMemoryBarrier(barrier, &srcStages, &dstStages, &vkBarrier);
+        sink ^= srcStages ^ dstStages ^ vkBarrier.dstAccessMask;
+    }
+    report("thsvsGetVulkanMemoryBarrier, single access", startTime, now_ns(), iterations);
+}
+
+// A write followed by reads in several different stages, as a global barrier
+static void global_multi_read_benchmark(uint32_t iterations)
+{
+    ThsvsAccessType prevAccess = THSVS_ACCESS_TRANSFER_WRITE;
+    ThsvsAccessType nextAccesses[] = {
+        THSVS_ACCESS_INDIRECT_BUFFER,
+        THSVS_ACCESS_VERTEX_BUFFER,
+        THSVS_ACCESS_VERTEX_SHADER_READ_UNIFORM_BUFFER,
+        THSVS_ACCESS_FRAGMENT_SHADER_READ_UNIFORM_BUFFER,
+        THSVS_ACCESS_COMPUTE_SHADER_READ_OTHER};
+    ThsvsGlobalBarrier barrier = {1, &prevAccess, sizeof(nextAccesses) / sizeof(nextAccesses[0]), nextAccesses};
+
+    double startTime = now_ns();
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        VkPipelineStageFlags srcStages;
+        VkPipelineStageFlags dstStages;
+        VkMemoryBarrier vkBarrier;
+        thsvsGetVulkanMemoryBarrier(barrier, &srcStages, &dstStages, &vkBarrier);
+        sink ^= srcStages ^ dstStages ^ vkBarrier.dstAccessMask;
+    }
+    report("thsvsGetVulkanMemoryBarrier, multiple reads", startTime, now_ns(), iterations);
+}
+
+static void init_image_barriers(ThsvsImageBarrier* pBarriers, uint32_t count, const ThsvsAccessType* pPrevAccess, const ThsvsAccessType* pNextAccess)
+{
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        ThsvsImageBarrier barrier = {
+            1, pPrevAccess, 1, pNextAccess,
+            THSVS_IMAGE_LAYOUT_OPTIMAL, THSVS_IMAGE_LAYOUT_OPTIMAL,
+            VK_FALSE, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, (VkImage)(uintptr_t)(i + 1),
+            {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}};
+        pBarriers[i] = barrier;
+    }
+}
+
+// A render target being sampled, as an image barrier
+static void image_single_benchmark(uint32_t iterations)
+{
+    ThsvsAccessType prevAccess = THSVS_ACCESS_COLOR_ATTACHMENT_WRITE;
+    ThsvsAccessType nextAccess = THSVS_ACCESS_FRAGMENT_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER;
+    ThsvsImageBarrier barrier;
+    init_image_barriers(&barrier, 1, &prevAccess, &nextAccess);
+
+    double startTime = now_ns();
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        VkPipelineStageFlags srcStages;
+        VkPipelineStageFlags dstStages;
+        VkImageMemoryBarrier vkBarrier;
+        thsvsGetVulkanImageMemoryBarrier(barrier, &srcStages, &dstStages, &vkBarrier);
+        sink ^= srcStages ^ dstStages ^ vkBarrier.newLayout;
+    }
+    report("thsvsGetVulkanImageMemoryBarrier, single image", startTime, now_ns(), iterations);
+}
+
+// Transitioning a large number of render targets at once, e.g. at the end of a G-buffer pass
+static void image_batch_benchmark(uint32_t iterations)
+{
+    ThsvsAccessType prevAccess = THSVS_ACCESS_COLOR_ATTACHMENT_WRITE;
+    ThsvsAccessType nextAccess = THSVS_ACCESS_FRAGMENT_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER;
+    ThsvsImageBarrier barriers[IMAGE_BATCH_SIZE];
+    init_image_barriers(barriers, IMAGE_BATCH_SIZE, &prevAccess, &nextAccess);
+
+    uint32_t batches = (iterations + IMAGE_BATCH_SIZE - 1) / IMAGE_BATCH_SIZE;
+
+    double startTime = now_ns();
+    for (uint32_t i = 0; i < batches; ++i)
+        thsvsCmdPipelineBarrier(VK_NULL_HANDLE, NULL, 0, NULL, IMAGE_BATCH_SIZE, barriers);
+    report("thsvsCmdPipelineBarrier, image batch", startTime, now_ns(), (double)batches * IMAGE_BATCH_SIZE);
+
+    VkImageMemoryBarrier vkBarriers[IMAGE_BATCH_SIZE];
+
+    startTime = now_ns();
+    for (uint32_t i = 0; i < batches; ++i)
+    {
+        VkPipelineStageFlags srcStages;
+        VkPipelineStageFlags dstStages;
+        thsvsGetVulkanImageMemoryBarriers(IMAGE_BATCH_SIZE, barriers, &srcStages, &dstStages, vkBarriers);
+        sink ^= srcStages ^ dstStages ^ vkBarriers[i % IMAGE_BATCH_SIZE].newLayout;
+    }
+    report("thsvsGetVulkanImageMemoryBarriers, image batch", startTime, now_ns(), (double)batches * IMAGE_BATCH_SIZE);
+
+    char scratchMemory[IMAGE_BATCH_SIZE * sizeof(VkImageMemoryBarrier) + THSVS_SCRATCH_ALIGNMENT];
+    ThsvsScratch scratch;
+    thsvsInitScratch(&scratch, scratchMemory, sizeof(scratchMemory));
+
+    startTime = now_ns();
+    for (uint32_t i = 0; i < batches; ++i)
+        thsvsCmdPipelineBarrierScratch(VK_NULL_HANDLE, &scratch, NULL, 0, NULL, IMAGE_BATCH_SIZE, barriers);
+    report("thsvsCmdPipelineBarrierScratch, image batch", startTime, now_ns(), (double)batches * IMAGE_BATCH_SIZE);
+
+#ifdef VK_VERSION_1_3
+    startTime = now_ns();
+    for (uint32_t i = 0; i < batches; ++i)
+        thsvsCmdPipelineBarrier2(VK_NULL_HANDLE, NULL, 0, NULL, IMAGE_BATCH_SIZE, barriers);
+    report("thsvsCmdPipelineBarrier2, image batch", startTime, now_ns(), (double)batches * IMAGE_BATCH_SIZE);
+#endif
+}
+
+// Releasing buffers from a transfer queue to a graphics queue
+static void queue_transfer_benchmark(uint32_t iterations)
+{
+    ThsvsAccessType prevAccess = THSVS_ACCESS_TRANSFER_WRITE;
+    ThsvsAccessType nextAccess = THSVS_ACCESS_VERTEX_BUFFER;
+    ThsvsBufferBarrier barrier = {1, &prevAccess, 1, &nextAccess, 1, 0, (VkBuffer)(uintptr_t)1, 0, VK_WHOLE_SIZE};
+
+    double startTime = now_ns();
+    for (uint32_t i = 0; i < iterations; ++i)
+        thsvsCmdPipelineBarrier(VK_NULL_HANDLE, NULL, 1, &barrier, 0, NULL);
+    report("thsvsCmdPipelineBarrier, buffer queue transfer", startTime, now_ns(), iterations);
+}
+
+// The same render target transition, with the access lists compiled up front
+static void compiled_image_benchmark(uint32_t iterations)
+{
+    ThsvsAccessType prevAccess = THSVS_ACCESS_COLOR_ATTACHMENT_WRITE;
+    ThsvsAccessType nextAccess = THSVS_ACCESS_FRAGMENT_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER;
+    ThsvsAccessSet prevAccessSet;
+    ThsvsAccessSet nextAccessSet;
+    thsvsCompileAccessSet(1, &prevAccess, &prevAccessSet);
+    thsvsCompileAccessSet(1, &nextAccess, &nextAccessSet);
+    ThsvsCompiledImageBarrier barrier = {
+        &prevAccessSet, &nextAccessSet,
+        THSVS_IMAGE_LAYOUT_OPTIMAL, THSVS_IMAGE_LAYOUT_OPTIMAL,
+        VK_FALSE, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, (VkImage)(uintptr_t)1,
+        {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}};
+
+    double startTime = now_ns();
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        VkPipelineStageFlags srcStages;
+        VkPipelineStageFlags dstStages;
+        VkImageMemoryBarrier vkBarrier;
+        thsvsGetVulkanCompiledImageMemoryBarrier(barrier, &srcStages, &dstStages, &vkBarrier);
+        sink ^= srcStages ^ dstStages ^ vkBarrier.newLayout;
+    }
+    report("thsvsGetVulkanCompiledImageMemoryBarrier", startTime, now_ns(), iterations);
+}
+
+// The same render target transition, with the accesses given as masks
+static void mask_image_benchmark(uint32_t iterations)
+{
+    ThsvsAccessType prevAccess = THSVS_ACCESS_COLOR_ATTACHMENT_WRITE;
+    ThsvsAccessType nextAccess = THSVS_ACCESS_FRAGMENT_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER;
+    ThsvsMaskImageBarrier barrier = {
+        {{0, 0}}, {{0, 0}},
+        THSVS_IMAGE_LAYOUT_OPTIMAL, THSVS_IMAGE_LAYOUT_OPTIMAL,
+        VK_FALSE, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, (VkImage)(uintptr_t)1,
+        {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}};
+    thsvsMakeAccessMask(1, &prevAccess, &barrier.prevAccesses);
+    thsvsMakeAccessMask(1, &nextAccess, &barrier.nextAccesses);
+
+    double startTime = now_ns();
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        VkPipelineStageFlags srcStages;
+        VkPipelineStageFlags dstStages;
+        VkImageMemoryBarrier vkBarrier;
+        thsvsGetVulkanMaskImageMemoryBarrier(barrier, &srcStages, &dstStages, &vkBarrier);
+        sink ^= srcStages ^ dstStages ^ vkBarrier.newLayout;
+    }
+    report("thsvsGetVulkanMaskImageMemoryBarrier", startTime, now_ns(), iterations);
+}
+
+// A render target transition split across unrelated work, with events recycled every "frame"
+static void split_barrier_benchmark(uint32_t iterations)
+{
+    ThsvsAccessType prevAccess = THSVS_ACCESS_COLOR_ATTACHMENT_WRITE;
+    ThsvsAccessType nextAccess = THSVS_ACCESS_FRAGMENT_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER;
+    ThsvsImageBarrier barrier;
+    init_image_barriers(&barrier, 1, &prevAccess, &nextAccess);
+
+    VkEvent events[IMAGE_BATCH_SIZE];
+    ThsvsEventPool eventPool;
+    thsvsCreateEventPool(&eventPool, VK_NULL_HANDLE, IMAGE_BATCH_SIZE, events);
+
+    double startTime = now_ns();
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        ThsvsSplitBarrier splitBarrier;
+        if (eventPool.usedEventCount == eventPool.eventCount)
+            thsvsResetEventPool(&eventPool);
+        thsvsCmdBeginSplitBarrier(VK_NULL_HANDLE, &eventPool, NULL, 0, NULL, 1, &barrier, &splitBarrier);
+        thsvsCmdEndSplitBarrier(VK_NULL_HANDLE, &splitBarrier, NULL, 0, NULL, 1, &barrier);
+    }
+    report("thsvsCmdBeginSplitBarrier + thsvsCmdEndSplitBarrier", startTime, now_ns(), iterations);
+
+    thsvsDestroyEventPool(&eventPool);
+}
+
+// Many small split barriers at once, e.g. one per particle emitter, set and waited on per event or in bulk
+static void event_batch_benchmark(uint32_t iterations)
+{
+    ThsvsAccessType prevAccess = THSVS_ACCESS_COMPUTE_SHADER_WRITE;
+    ThsvsAccessType nextAccess = THSVS_ACCESS_VERTEX_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER;
+    ThsvsImageBarrier barriers[IMAGE_BATCH_SIZE];
+    init_image_barriers(barriers, IMAGE_BATCH_SIZE, &prevAccess, &nextAccess);
+
+    VkEvent events[IMAGE_BATCH_SIZE];
+    ThsvsEventBarrier eventBarriers[IMAGE_BATCH_SIZE];
+    for (uint32_t i = 0; i < IMAGE_BATCH_SIZE; ++i)
+    {
+        ThsvsEventBarrier eventBarrier = {(VkEvent)(uintptr_t)(i + 1), NULL, 0, NULL, 1, &barriers[i]};
+        events[i]        = eventBarrier.event;
+        eventBarriers[i] = eventBarrier;
+    }
+
+    uint32_t batches = (iterations + IMAGE_BATCH_SIZE - 1) / IMAGE_BATCH_SIZE;
+
+    double startTime = now_ns();
+    for (uint32_t i = 0; i < batches; ++i)
+    {
+        for (uint32_t j = 0; j < IMAGE_BATCH_SIZE; ++j)
+            thsvsCmdSetEvent(VK_NULL_HANDLE, events[j], 1, &prevAccess);
+        thsvsCmdWaitEvents(VK_NULL_HANDLE, IMAGE_BATCH_SIZE, events, NULL, 0, NULL, IMAGE_BATCH_SIZE, barriers);
+    }
+    report("thsvsCmdSetEvent + thsvsCmdWaitEvents, per event", startTime, now_ns(), (double)batches * IMAGE_BATCH_SIZE);
+
+    startTime = now_ns();
+    for (uint32_t i = 0; i < batches; ++i)
+    {
+        thsvsCmdSetEvents(VK_NULL_HANDLE, IMAGE_BATCH_SIZE, eventBarriers);
+        thsvsCmdWaitEventBarriers(VK_NULL_HANDLE, NULL, IMAGE_BATCH_SIZE, eventBarriers);
+    }
+    report("thsvsCmdSetEvents + thsvsCmdWaitEventBarriers", startTime, now_ns(), (double)batches * IMAGE_BATCH_SIZE);
+
+#ifdef VK_VERSION_1_3
+    startTime = now_ns();
+    for (uint32_t i = 0; i < batches; ++i)
+    {
+        thsvsCmdSetEvents2(VK_NULL_HANDLE, NULL, IMAGE_BATCH_SIZE, eventBarriers);
+        thsvsCmdWaitEvents2(VK_NULL_HANDLE, NULL, IMAGE_BATCH_SIZE, eventBarriers);
+    }
+    report("thsvsCmdSetEvents2 + thsvsCmdWaitEvents2", startTime, now_ns(), (double)batches * IMAGE_BATCH_SIZE);
+#endif
+}
+
+int main(int argc, char* argv[])
+{
+    uint32_t iterations = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : 10000000;
+    if (iterations == 0)
+        iterations = 1;
+
+    printf("Translating %u barriers per benchmark\n", iterations);
+
+    global_single_access_benchmark(iterations);
+    global_multi_read_benchmark(iterations);
+    image_single_benchmark(iterations);
+    image_batch_benchmark(iterations);
+    queue_transfer_benchmark(iterations);
+    compiled_image_benchmark(iterations);
+    mask_image_benchmark(iterations);
+    split_barrier_benchmark(iterations);
+    event_batch_benchmark(iterations);
+
+    return 0;
+}
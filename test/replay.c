@@ -0,0 +1,260 @@
+// Copyright (c) 2017-2019 Tobias Hector
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do
+// so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <vulkan/vulkan.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define THSVS_SIMPLER_VULKAN_SYNCHRONIZATION_IMPLEMENTATION
+#include "../thsvs_simpler_vulkan_synchronization.h"
+
+/*
+Reads a capture written out from thsvsGetCaptureData, re-runs the
+translation of every captured barrier, and prints a summary of the barriers
+recorded in each pass.
+A re-translation that doesn't match the capture means the capture was made
+with a different version of the library, or with different options.
+*/
+
+typedef struct PassSummary {
+    uint32_t    passIndex;
+    const char* pName;
+    uint64_t    firstTimestamp;
+    uint64_t    lastTimestamp;
+    uint32_t    commandCount;
+    uint32_t    elidedCommandCount;
+    uint32_t    broadStageMaskCount;
+    uint32_t    barrierCount;
+    uint32_t    neededBarrierCount;
+    uint32_t    layoutTransitionCount;
+    uint32_t    queueTransferCount;
+} PassSummary;
+
+static PassSummary* add_pass(PassSummary** ppPasses, uint32_t* pPassCount, uint32_t passIndex, const char* pName, uint64_t timestamp)
+{
+    PassSummary* pPasses = (PassSummary*)realloc(*ppPasses, sizeof(PassSummary) * (*pPassCount + 1));
+    if (pPasses == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+
+    PassSummary* pPass = &pPasses[*pPassCount];
+    memset(pPass, 0, sizeof(PassSummary));
+    pPass->passIndex      = passIndex;
+    pPass->pName          = pName;
+    pPass->firstTimestamp = timestamp;
+    pPass->lastTimestamp  = timestamp;
+
+    *ppPasses = pPasses;
+    ++*pPassCount;
+    return pPass;
+}
+
+// Translates a captured barrier again, returning whether it matches what was captured
+static int replay_barrier(const ThsvsCaptureBarrier* pBarrier, const uint8_t* pAccessBytes)
+{
+    ThsvsAccessType prevAccesses[255];
+    ThsvsAccessType nextAccesses[255];
+    for (uint32_t i = 0; i < pBarrier->prevAccessCount; ++i)
+        prevAccesses[i] = (ThsvsAccessType)pAccessBytes[i];
+    for (uint32_t i = 0; i < pBarrier->nextAccessCount; ++i)
+        nextAccesses[i] = (ThsvsAccessType)pAccessBytes[pBarrier->prevAccessCount + i];
+
+    VkPipelineStageFlags srcStages;
+    VkPipelineStageFlags dstStages;
+    VkAccessFlags        srcAccessMask = 0;
+    VkAccessFlags        dstAccessMask = 0;
+    VkImageLayout        oldLayout     = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkImageLayout        newLayout     = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkBool32             needed        = VK_FALSE;
+
+    if (pBarrier->type == THSVS_CAPTURE_BARRIER_GLOBAL)
+    {
+        ThsvsGlobalBarrier barrier = {pBarrier->prevAccessCount, prevAccesses, pBarrier->nextAccessCount, nextAccesses};
+        VkMemoryBarrier vkBarrier;
+        needed = thsvsGetVulkanMemoryBarrier(barrier, &srcStages, &dstStages, &vkBarrier);
+        srcAccessMask = vkBarrier.srcAccessMask;
+        dstAccessMask = vkBarrier.dstAccessMask;
+    }
+    else if (pBarrier->type == THSVS_CAPTURE_BARRIER_BUFFER)
+    {
+        ThsvsBufferBarrier barrier = {pBarrier->prevAccessCount, prevAccesses, pBarrier->nextAccessCount, nextAccesses,
+                                      pBarrier->srcQueueFamilyIndex, pBarrier->dstQueueFamilyIndex, 0, 0, VK_WHOLE_SIZE};
+        VkBufferMemoryBarrier vkBarrier;
+        needed = thsvsGetVulkanBufferMemoryBarrier(barrier, &srcStages, &dstStages, &vkBarrier);
+        srcAccessMask = vkBarrier.srcAccessMask;
+        dstAccessMask = vkBarrier.dstAccessMask;
+    }
+    else
+    {
+        ThsvsImageBarrier barrier = {pBarrier->prevAccessCount, prevAccesses, pBarrier->nextAccessCount, nextAccesses,
+                                     (ThsvsImageLayout)pBarrier->prevLayout, (ThsvsImageLayout)pBarrier->nextLayout,
+                                     (pBarrier->flags & THSVS_CAPTURE_BARRIER_DISCARD_CONTENTS_BIT) ? VK_TRUE : VK_FALSE,
+                                     pBarrier->srcQueueFamilyIndex, pBarrier->dstQueueFamilyIndex, 0,
+                                     {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}};
+        VkImageMemoryBarrier vkBarrier;
+        needed = thsvsGetVulkanImageMemoryBarrier(barrier, &srcStages, &dstStages, &vkBarrier);
+        srcAccessMask = vkBarrier.srcAccessMask;
+        dstAccessMask = vkBarrier.dstAccessMask;
+        oldLayout     = vkBarrier.oldLayout;
+        newLayout     = vkBarrier.newLayout;
+    }
+
+    return srcAccessMask == pBarrier->srcAccessMask &&
+           dstAccessMask == pBarrier->dstAccessMask &&
+           oldLayout == pBarrier->oldLayout &&
+           newLayout == pBarrier->newLayout &&
+           (needed == VK_TRUE) == ((pBarrier->flags & THSVS_CAPTURE_BARRIER_NEEDED_BIT) != 0);
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s <capture file>\n", argv[0]);
+        return 1;
+    }
+
+    FILE* pFile = fopen(argv[1], "rb");
+    if (pFile == NULL)
+    {
+        fprintf(stderr, "Couldn't open %s\n", argv[1]);
+        return 1;
+    }
+
+    fseek(pFile, 0, SEEK_END);
+    long fileSize = ftell(pFile);
+    fseek(pFile, 0, SEEK_SET);
+
+    uint8_t* pData = (uint8_t*)malloc(fileSize > 0 ? (size_t)fileSize : 1);
+    size_t dataSize = (fileSize > 0 && pData != NULL) ? fread(pData, 1, (size_t)fileSize, pFile) : 0;
+    fclose(pFile);
+
+    ThsvsCaptureHeader header;
+    if (dataSize < sizeof(header))
+    {
+        fprintf(stderr, "%s is too small to be a capture\n", argv[1]);
+        return 1;
+    }
+
+    memcpy(&header, pData, sizeof(header));
+    if (header.magic != THSVS_CAPTURE_MAGIC || header.version != THSVS_CAPTURE_VERSION)
+    {
+        fprintf(stderr, "%s is not a version %u capture\n", argv[1], THSVS_CAPTURE_VERSION);
+        return 1;
+    }
+
+    PassSummary* pPasses   = NULL;
+    uint32_t     passCount = 0;
+    uint32_t     mismatchCount = 0;
+    PassSummary* pPass     = NULL;
+
+    size_t offset = sizeof(header);
+    for (uint32_t i = 0; i < header.recordCount; ++i)
+    {
+        ThsvsCaptureRecord record;
+        if (offset + sizeof(record) > dataSize)
+        {
+            fprintf(stderr, "Capture is truncated after %u records\n", i);
+            break;
+        }
+
+        memcpy(&record, pData + offset, sizeof(record));
+        if (record.size < sizeof(record) || offset + record.size > dataSize)
+        {
+            fprintf(stderr, "Capture is truncated after %u records\n", i);
+            break;
+        }
+
+        const uint8_t* pPayload   = pData + offset + sizeof(record);
+        const uint8_t* pRecordEnd = pData + offset + record.size;
+        offset += record.size;
+
+        if (record.type == THSVS_CAPTURE_RECORD_PASS)
+        {
+            pPass = add_pass(&pPasses, &passCount, record.srcStageMask, (const char*)pPayload, record.timestamp);
+            continue;
+        }
+
+        // Barriers recorded before the first pass record are summarized on their own
+        if (pPass == NULL)
+            pPass = add_pass(&pPasses, &passCount, 0, "(before first pass)", record.timestamp);
+
+        pPass->lastTimestamp = record.timestamp;
+        ++pPass->commandCount;
+        if (record.recorded != VK_TRUE)
+            ++pPass->elidedCommandCount;
+        if ((record.srcStageMask | record.dstStageMask) & (VK_PIPELINE_STAGE_ALL_COMMANDS_BIT | VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT))
+            ++pPass->broadStageMaskCount;
+
+        for (uint32_t j = 0; j < record.barrierCount; ++j)
+        {
+            ThsvsCaptureBarrier barrier;
+            if ((size_t)(pRecordEnd - pPayload) < sizeof(barrier))
+            {
+                fprintf(stderr, "Record %u is too small for its %u barriers\n", i, record.barrierCount);
+                break;
+            }
+
+            memcpy(&barrier, pPayload, sizeof(barrier));
+            const uint8_t* pAccessBytes = pPayload + sizeof(barrier);
+            size_t         accessSize   = (barrier.prevAccessCount + barrier.nextAccessCount + 3) & ~3u;
+            if ((size_t)(pRecordEnd - pAccessBytes) < accessSize)
+            {
+                fprintf(stderr, "Record %u is too small for its %u barriers\n", i, record.barrierCount);
+                break;
+            }
+            pPayload = pAccessBytes + accessSize;
+
+            ++pPass->barrierCount;
+            if (barrier.flags & THSVS_CAPTURE_BARRIER_NEEDED_BIT)
+                ++pPass->neededBarrierCount;
+            if (barrier.oldLayout != barrier.newLayout)
+                ++pPass->layoutTransitionCount;
+            if (barrier.srcQueueFamilyIndex != barrier.dstQueueFamilyIndex)
+                ++pPass->queueTransferCount;
+
+            // Barriers captured without access types can't be translated again
+            if ((barrier.flags & THSVS_CAPTURE_BARRIER_NO_ACCESS_TYPES_BIT) == 0 && !replay_barrier(&barrier, pAccessBytes))
+                ++mismatchCount;
+        }
+    }
+
+    printf("%u records, %u dropped\n", header.recordCount, header.droppedRecordCount);
+    printf("%-6s %-32s %8s %8s %8s %8s %8s %8s %8s %12s\n",
+           "Pass", "Name", "Commands", "Elided", "Broad", "Barriers", "Needed", "Layouts", "Queues", "Time (us)");
+    for (uint32_t i = 0; i < passCount; ++i)
+    {
+        const PassSummary& pass = pPasses[i];
+        printf("%-6u %-32.32s %8u %8u %8u %8u %8u %8u %8u %12.3f\n",
+               pass.passIndex, pass.pName, pass.commandCount, pass.elidedCommandCount, pass.broadStageMaskCount,
+               pass.barrierCount, pass.neededBarrierCount, pass.layoutTransitionCount, pass.queueTransferCount,
+               (double)(pass.lastTimestamp - pass.firstTimestamp) / 1000.0);
+    }
+
+    if (mismatchCount > 0)
+        printf("%u barriers translated differently on replay - was this captured with a different version or options?\n", mismatchCount);
+
+    free(pPasses);
+    free(pData);
+    return 0;
+}
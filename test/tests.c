@@ -20,10 +20,134 @@
 
 #include <vulkan/vulkan.h>
 #include <stdio.h>
+#include <string.h>
 
 #define THSVS_SIMPLER_VULKAN_SYNCHRONIZATION_IMPLEMENTATION
 #include "../thsvs_simpler_vulkan_synchronization.h"
 
+//// Stubbed Vulkan Commands ////
+/*
+Event pools and split barriers are tested by what they record, so the
+commands they call are replaced with stubs that note their parameters in
+recordedCommands, rather than needing a device.
+*/
+typedef struct RecordedCommands {
+    uint32_t             pipelineBarrierCount;
+    uint32_t             setEventCount;
+    VkEvent              setEvent;
+    VkPipelineStageFlags setStageMask;
+    uint32_t             waitEventsCount;
+    VkEvent              waitEvent;
+    VkPipelineStageFlags waitSrcStageMask;
+    uint32_t             resetEventCount;
+} RecordedCommands;
+
+static RecordedCommands recordedCommands;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+VKAPI_ATTR void VKAPI_CALL vkCmdPipelineBarrier(
+    VkCommandBuffer              commandBuffer,
+    VkPipelineStageFlags         srcStageMask,
+    VkPipelineStageFlags         dstStageMask,
+    VkDependencyFlags            dependencyFlags,
+    uint32_t                     memoryBarrierCount,
+    const VkMemoryBarrier*       pMemoryBarriers,
+    uint32_t                     bufferMemoryBarrierCount,
+    const VkBufferMemoryBarrier* pBufferMemoryBarriers,
+    uint32_t                     imageMemoryBarrierCount,
+    const VkImageMemoryBarrier*  pImageMemoryBarriers)
+{
+    (void)commandBuffer;
+    (void)srcStageMask;
+    (void)dstStageMask;
+    (void)dependencyFlags;
+    (void)memoryBarrierCount;
+    (void)pMemoryBarriers;
+    (void)bufferMemoryBarrierCount;
+    (void)pBufferMemoryBarriers;
+    (void)imageMemoryBarrierCount;
+    (void)pImageMemoryBarriers;
+    recordedCommands.pipelineBarrierCount++;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdSetEvent(
+    VkCommandBuffer      commandBuffer,
+    VkEvent              event,
+    VkPipelineStageFlags stageMask)
+{
+    (void)commandBuffer;
+    recordedCommands.setEventCount++;
+    recordedCommands.setEvent     = event;
+    recordedCommands.setStageMask = stageMask;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdWaitEvents(
+    VkCommandBuffer              commandBuffer,
+    uint32_t                     eventCount,
+    const VkEvent*               pEvents,
+    VkPipelineStageFlags         srcStageMask,
+    VkPipelineStageFlags         dstStageMask,
+    uint32_t                     memoryBarrierCount,
+    const VkMemoryBarrier*       pMemoryBarriers,
+    uint32_t                     bufferMemoryBarrierCount,
+    const VkBufferMemoryBarrier* pBufferMemoryBarriers,
+    uint32_t                     imageMemoryBarrierCount,
+    const VkImageMemoryBarrier*  pImageMemoryBarriers)
+{
+    (void)commandBuffer;
+    (void)dstStageMask;
+    (void)memoryBarrierCount;
+    (void)pMemoryBarriers;
+    (void)bufferMemoryBarrierCount;
+    (void)pBufferMemoryBarriers;
+    (void)imageMemoryBarrierCount;
+    (void)pImageMemoryBarriers;
+    recordedCommands.waitEventsCount++;
+    recordedCommands.waitEvent        = (eventCount > 0) ? pEvents[0] : VK_NULL_HANDLE;
+    recordedCommands.waitSrcStageMask = srcStageMask;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateEvent(
+    VkDevice                     device,
+    const VkEventCreateInfo*     pCreateInfo,
+    const VkAllocationCallbacks* pAllocator,
+    VkEvent*                     pEvent)
+{
+    static uintptr_t nextEvent = 1;
+    (void)device;
+    (void)pCreateInfo;
+    (void)pAllocator;
+    *pEvent = (VkEvent)nextEvent++;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyEvent(
+    VkDevice                     device,
+    VkEvent                      event,
+    const VkAllocationCallbacks* pAllocator)
+{
+    (void)device;
+    (void)event;
+    (void)pAllocator;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkResetEvent(
+    VkDevice                     device,
+    VkEvent                      event)
+{
+    (void)device;
+    (void)event;
+    recordedCommands.resetEventCount++;
+    return VK_SUCCESS;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
 void global_barrier_test_array(const char* testName,
                                unsigned int numPrevAccesses,
                                ThsvsAccessType* prevAccesses,
@@ -34,135 +158,2629 @@ void global_barrier_test_array(const char* testName,
                                VkAccessFlags expectedSrcAccessMask,
                                VkAccessFlags expectedDstAccessMask)
 {
-    ThsvsGlobalBarrier barrier = {numPrevAccesses, prevAccesses, numNextAccesses, nextAccesses};
-    
-    VkMemoryBarrier vkBarrier = { 0 };
-    VkPipelineStageFlags srcStages = 0;
-    VkPipelineStageFlags dstStages = 0;
+    ThsvsGlobalBarrier barrier = {numPrevAccesses, prevAccesses, numNextAccesses, nextAccesses};
+    
+    VkMemoryBarrier vkBarrier = { 0 };
+    VkPipelineStageFlags srcStages = 0;
+    VkPipelineStageFlags dstStages = 0;
+    unsigned int testPassed = 1;
+    
+    thsvsGetVulkanMemoryBarrier(barrier, &srcStages, &dstStages, &vkBarrier);
+
+    printf("Test: %s\n", testName);
+    
+    if (srcStages != expectedSrcStageMask)
+    {
+        printf("\tUnexpected source stage %0#10X\n", srcStages);
+        testPassed = 0;
+    }
+
+    if (dstStages != expectedDstStageMask)
+    {
+        printf("\tUnexpected destination stage %0#10X\n", dstStages);
+        testPassed = 0;
+    }
+    
+    if (vkBarrier.srcAccessMask != expectedSrcAccessMask)
+    {
+        printf("\tUnexpected source access mask %0#10X\n", vkBarrier.srcAccessMask);
+        testPassed = 0;
+    }
+    
+    if (vkBarrier.dstAccessMask != expectedDstAccessMask)
+    {
+        printf("\tUnexpected destination access mask %0#10X\n", vkBarrier.dstAccessMask);
+        testPassed = 0;
+    }
+
+    ThsvsAccessSet prevAccessSet;
+    ThsvsAccessSet nextAccessSet;
+    thsvsCompileAccessSet(numPrevAccesses, prevAccesses, &prevAccessSet);
+    thsvsCompileAccessSet(numNextAccesses, nextAccesses, &nextAccessSet);
+    ThsvsCompiledGlobalBarrier compiledBarrier = {&prevAccessSet, &nextAccessSet};
+
+    VkMemoryBarrier vkCompiledBarrier = { 0 };
+    thsvsGetVulkanCompiledMemoryBarrier(compiledBarrier, &srcStages, &dstStages, &vkCompiledBarrier);
+
+    if (srcStages != expectedSrcStageMask ||
+        dstStages != expectedDstStageMask ||
+        vkCompiledBarrier.srcAccessMask != expectedSrcAccessMask ||
+        vkCompiledBarrier.dstAccessMask != expectedDstAccessMask)
+    {
+        printf("\tCompiled barrier does not match\n");
+        testPassed = 0;
+    }
+    
+    if (testPassed == 1)
+        printf("\tPASSED\n");
+    else
+        printf("\tFAILED\n");
+}
+
+void global_barrier_test(const char* testName,
+                         ThsvsAccessType prevAccess,
+                         ThsvsAccessType nextAccess,
+                         VkPipelineStageFlags expectedSrcStageMask,
+                         VkPipelineStageFlags expectedDstStageMask,
+                         VkAccessFlags expectedSrcAccessMask,
+                         VkAccessFlags expectedDstAccessMask)
+{
+    global_barrier_test_array(testName, 1, &prevAccess, 1, &nextAccess, expectedSrcStageMask, expectedDstStageMask, expectedSrcAccessMask, expectedDstAccessMask);
+}
+
+void image_barrier_test_array(const char* testName,
+                              unsigned int numPrevAccesses,
+                              ThsvsAccessType* prevAccesses,
+                              unsigned int numNextAccesses,
+                              ThsvsAccessType* nextAccesses,
+                              VkPipelineStageFlags expectedSrcStageMask,
+                              VkPipelineStageFlags expectedDstStageMask,
+                              VkAccessFlags expectedSrcAccessMask,
+                              VkAccessFlags expectedDstAccessMask,
+                              VkImageLayout expectedOldLayout,
+                              VkImageLayout expectedNewLayout)
+{
+    ThsvsImageBarrier barrier = {numPrevAccesses, prevAccesses, numNextAccesses, nextAccesses};
+    
+    VkImageMemoryBarrier vkBarrier = { 0 };
+    VkPipelineStageFlags srcStages = 0;
+    VkPipelineStageFlags dstStages = 0;
+    unsigned int testPassed = 1;
+    
+    thsvsGetVulkanImageMemoryBarrier(barrier, &srcStages, &dstStages, &vkBarrier);
+
+    printf("Test: %s\n", testName);
+    
+    if (srcStages != expectedSrcStageMask)
+    {
+        printf("\tUnexpected source stage %0#10X\n", srcStages);
+        testPassed = 0;
+    }
+
+    if (dstStages != expectedDstStageMask)
+    {
+        printf("\tUnexpected destination stage %0#10X\n", dstStages);
+        testPassed = 0;
+    }
+    
+    if (vkBarrier.srcAccessMask != expectedSrcAccessMask)
+    {
+        printf("\tUnexpected source access mask %0#10X\n", vkBarrier.srcAccessMask);
+        testPassed = 0;
+    }
+    
+    if (vkBarrier.dstAccessMask != expectedDstAccessMask)
+    {
+        printf("\tUnexpected destination access mask %0#10X\n", vkBarrier.dstAccessMask);
+        testPassed = 0;
+    }
+    
+    if (vkBarrier.oldLayout != expectedOldLayout)
+    {
+        printf("\tUnexpected old layout %d\n", vkBarrier.oldLayout);
+        testPassed = 0;
+    }
+    
+    if (vkBarrier.newLayout != expectedNewLayout)
+    {
+        printf("\tUnexpected new layout %d\n", vkBarrier.newLayout);
+        testPassed = 0;
+    }
+
+    ThsvsAccessSet prevAccessSet;
+    ThsvsAccessSet nextAccessSet;
+    thsvsCompileAccessSet(numPrevAccesses, prevAccesses, &prevAccessSet);
+    thsvsCompileAccessSet(numNextAccesses, nextAccesses, &nextAccessSet);
+    ThsvsCompiledImageBarrier compiledBarrier = {&prevAccessSet, &nextAccessSet};
+
+    VkImageMemoryBarrier vkCompiledBarrier = { 0 };
+    thsvsGetVulkanCompiledImageMemoryBarrier(compiledBarrier, &srcStages, &dstStages, &vkCompiledBarrier);
+
+    if (srcStages != expectedSrcStageMask ||
+        dstStages != expectedDstStageMask ||
+        vkCompiledBarrier.srcAccessMask != expectedSrcAccessMask ||
+        vkCompiledBarrier.dstAccessMask != expectedDstAccessMask ||
+        vkCompiledBarrier.oldLayout != expectedOldLayout ||
+        vkCompiledBarrier.newLayout != expectedNewLayout)
+    {
+        printf("\tCompiled barrier does not match\n");
+        testPassed = 0;
+    }
+    
+    if (testPassed == 1)
+        printf("\tPASSED\n");
+    else
+        printf("\tFAILED\n");
+}
+
+void image_barrier_test(const char* testName,
+                        ThsvsAccessType prevAccess,
+                        ThsvsAccessType nextAccess,
+                        VkPipelineStageFlags expectedSrcStageMask,
+                        VkPipelineStageFlags expectedDstStageMask,
+                        VkAccessFlags expectedSrcAccessMask,
+                        VkAccessFlags expectedDstAccessMask,
+                        VkImageLayout expectedOldLayout,
+                        VkImageLayout expectedNewLayout)
+{
+    image_barrier_test_array(testName, 1, &prevAccess, 1, &nextAccess, expectedSrcStageMask, expectedDstStageMask, expectedSrcAccessMask, expectedDstAccessMask, expectedOldLayout, expectedNewLayout);
+}
+
+void scratch_test(const char* testName)
+{
+    char memory[256];
+    ThsvsScratch scratch;
+    unsigned int testPassed = 1;
+
+    thsvsInitScratch(&scratch, memory + 1, sizeof(memory) - 1);
+
+    printf("Test: %s\n", testName);
+
+    void* pFirst = thsvsScratchAlloc(&scratch, 3);
+    void* pSecond = thsvsScratchAlloc(&scratch, sizeof(VkImageMemoryBarrier));
+
+    if (pFirst == NULL || pSecond == NULL ||
+        ((uintptr_t)pFirst % THSVS_SCRATCH_ALIGNMENT) != 0 ||
+        ((uintptr_t)pSecond % THSVS_SCRATCH_ALIGNMENT) != 0)
+    {
+        printf("\tUnexpected allocations %p %p\n", pFirst, pSecond);
+        testPassed = 0;
+    }
+
+    if (thsvsScratchAlloc(&scratch, sizeof(memory)) != NULL)
+    {
+        printf("\tAllocation larger than the remaining space succeeded\n");
+        testPassed = 0;
+    }
+
+    thsvsResetScratch(&scratch);
+
+    if (thsvsScratchAlloc(&scratch, 3) != pFirst)
+    {
+        printf("\tReset did not release previous allocations\n");
+        testPassed = 0;
+    }
+
+    if (testPassed == 1)
+        printf("\tPASSED\n");
+    else
+        printf("\tFAILED\n");
+}
+
+void barrier_batch_test(const char* testName)
+{
+    VkImageMemoryBarrier imageBarrierStorage[2];
+    ThsvsBarrierBatch batch;
+    unsigned int testPassed = 1;
+
+    thsvsInitBarrierBatch(&batch, VK_NULL_HANDLE, 0, NULL, 2, imageBarrierStorage);
+
+    printf("Test: %s\n", testName);
+
+    ThsvsAccessType computeWrite = THSVS_ACCESS_COMPUTE_SHADER_WRITE;
+    ThsvsAccessType computeRead = THSVS_ACCESS_COMPUTE_SHADER_READ_OTHER;
+    ThsvsAccessType transferWrite = THSVS_ACCESS_TRANSFER_WRITE;
+    ThsvsAccessType fragmentRead = THSVS_ACCESS_FRAGMENT_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER;
+
+    ThsvsGlobalBarrier globalBarrier = {1, &computeWrite, 1, &computeRead};
+
+    ThsvsImageBarrier imageBarrier = {
+        1, &transferWrite, 1, &fragmentRead,
+        THSVS_IMAGE_LAYOUT_OPTIMAL, THSVS_IMAGE_LAYOUT_OPTIMAL,
+        VK_FALSE, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, VK_NULL_HANDLE,
+        {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}};
+
+    thsvsBatchPipelineBarrier(&batch, &globalBarrier, 0, NULL, 0, NULL);
+    thsvsBatchPipelineBarrier(&batch, &globalBarrier, 0, NULL, 1, &imageBarrier);
+
+    // A different mip level of the same image doesn't overlap, so shouldn't cause a flush
+    imageBarrier.subresourceRange.baseMipLevel = 1;
+    thsvsBatchPipelineBarrier(&batch, NULL, 0, NULL, 1, &imageBarrier);
+
+    if (batch.srcStageMask != (VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT) ||
+        batch.dstStageMask != (VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT))
+    {
+        printf("\tUnexpected stage masks: %u, %u\n", batch.srcStageMask, batch.dstStageMask);
+        testPassed = 0;
+    }
+
+    if (batch.memoryBarrier.srcAccessMask != VK_ACCESS_SHADER_WRITE_BIT ||
+        batch.memoryBarrier.dstAccessMask != VK_ACCESS_SHADER_READ_BIT)
+    {
+        printf("\tUnexpected memory barrier access masks: %u, %u\n", batch.memoryBarrier.srcAccessMask, batch.memoryBarrier.dstAccessMask);
+        testPassed = 0;
+    }
+
+    if (batch.imageBarrierCount != 2 ||
+        imageBarrierStorage[0].newLayout != VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL ||
+        imageBarrierStorage[1].subresourceRange.baseMipLevel != 1)
+    {
+        printf("\tUnexpected image barriers in batch: %u\n", batch.imageBarrierCount);
+        testPassed = 0;
+    }
+
+    if (testPassed == 1)
+        printf("\tPASSED\n");
+    else
+        printf("\tFAILED\n");
+}
+
+void state_tracker_test(const char* testName)
+{
+    ThsvsBufferState state;
+    VkPipelineStageFlags srcStageMask = 0;
+    VkPipelineStageFlags dstStageMask = 0;
+    VkBufferMemoryBarrier barrier;
+    unsigned int testPassed = 1;
+
+    thsvsInitBufferState(&state, VK_NULL_HANDLE, 0, VK_WHOLE_SIZE);
+
+    printf("Test: %s\n", testName);
+
+    ThsvsAccessType computeWrite = THSVS_ACCESS_COMPUTE_SHADER_WRITE;
+    ThsvsAccessType vertexRead = THSVS_ACCESS_VERTEX_SHADER_READ_OTHER;
+    ThsvsAccessType fragmentRead = THSVS_ACCESS_FRAGMENT_SHADER_READ_OTHER;
+
+    if (thsvsTransitionBufferState(&state, 1, &computeWrite, &srcStageMask, &dstStageMask, &barrier) != VK_FALSE)
+    {
+        printf("\tFirst access produced a barrier\n");
+        testPassed = 0;
+    }
+
+    if (thsvsTransitionBufferState(&state, 1, &vertexRead, &srcStageMask, &dstStageMask, &barrier) != VK_TRUE ||
+        srcStageMask != VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT ||
+        dstStageMask != VK_PIPELINE_STAGE_VERTEX_SHADER_BIT ||
+        barrier.srcAccessMask != VK_ACCESS_SHADER_WRITE_BIT ||
+        barrier.dstAccessMask != VK_ACCESS_SHADER_READ_BIT)
+    {
+        printf("\tRead after write produced an unexpected barrier\n");
+        testPassed = 0;
+    }
+
+    if (thsvsTransitionBufferState(&state, 1, &vertexRead, &srcStageMask, &dstStageMask, &barrier) != VK_FALSE)
+    {
+        printf("\tRead after read produced a barrier\n");
+        testPassed = 0;
+    }
+
+    // A stage that hasn't waited on the write yet still needs to
+    if (thsvsTransitionBufferState(&state, 1, &fragmentRead, &srcStageMask, &dstStageMask, &barrier) != VK_TRUE ||
+        dstStageMask != VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT)
+    {
+        printf("\tRead after write in a new stage produced an unexpected barrier\n");
+        testPassed = 0;
+    }
+
+    if (thsvsTransitionBufferState(&state, 1, &computeWrite, &srcStageMask, &dstStageMask, &barrier) != VK_TRUE ||
+        srcStageMask != (VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT) ||
+        dstStageMask != VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT)
+    {
+        printf("\tWrite after read produced an unexpected barrier\n");
+        testPassed = 0;
+    }
+
+    if (testPassed == 1)
+        printf("\tPASSED\n");
+    else
+        printf("\tFAILED\n");
+}
+
+void state_tracker_hazard_test(const char* testName)
+{
+    ThsvsImageState state;
+    ThsvsLocalImageState localState;
+    VkPipelineStageFlags srcStageMask = 0;
+    VkPipelineStageFlags dstStageMask = 0;
+    VkImageMemoryBarrier barrier;
+    unsigned int testPassed = 1;
+
+    VkImageSubresourceRange range;
+    range.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+    range.baseMipLevel = 0;
+    range.levelCount = 1;
+    range.baseArrayLayer = 0;
+    range.layerCount = 1;
+
+    printf("Test: %s\n", testName);
+
+    ThsvsAccessType colorReadWrite = THSVS_ACCESS_COLOR_ATTACHMENT_READ_WRITE;
+    ThsvsAccessType colorRead = THSVS_ACCESS_COLOR_ATTACHMENT_READ;
+    ThsvsAccessType computeRead = THSVS_ACCESS_COMPUTE_SHADER_READ_OTHER;
+    ThsvsAccessType depthWriteStencilRead = THSVS_ACCESS_DEPTH_ATTACHMENT_WRITE_STENCIL_READ_ONLY;
+    ThsvsAccessType depthStencilRead = THSVS_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ;
+
+    // A write that reads in the same stages hasn't made itself visible to later reads in them
+    thsvsInitImageState(&state, VK_NULL_HANDLE, range, VK_IMAGE_LAYOUT_GENERAL);
+    thsvsTransitionImageState(&state, 1, &colorReadWrite, THSVS_IMAGE_LAYOUT_GENERAL, VK_FALSE, &srcStageMask, &dstStageMask, &barrier);
+    if (thsvsTransitionImageState(&state, 1, &colorRead, THSVS_IMAGE_LAYOUT_GENERAL, VK_FALSE, &srcStageMask, &dstStageMask, &barrier) != VK_TRUE ||
+        srcStageMask != VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT ||
+        dstStageMask != VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT ||
+        (barrier.srcAccessMask & VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT) == 0 ||
+        barrier.dstAccessMask != VK_ACCESS_COLOR_ATTACHMENT_READ_BIT)
+    {
+        printf("\tColor read after a first read/write access produced an unexpected barrier\n");
+        testPassed = 0;
+    }
+
+    // The same applies to a write that follows a barrier
+    thsvsTransitionImageState(&state, 1, &computeRead, THSVS_IMAGE_LAYOUT_GENERAL, VK_FALSE, &srcStageMask, &dstStageMask, &barrier);
+    thsvsTransitionImageState(&state, 1, &colorReadWrite, THSVS_IMAGE_LAYOUT_GENERAL, VK_FALSE, &srcStageMask, &dstStageMask, &barrier);
+    if (thsvsTransitionImageState(&state, 1, &colorRead, THSVS_IMAGE_LAYOUT_GENERAL, VK_FALSE, &srcStageMask, &dstStageMask, &barrier) != VK_TRUE ||
+        (barrier.srcAccessMask & VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT) == 0 ||
+        barrier.dstAccessMask != VK_ACCESS_COLOR_ATTACHMENT_READ_BIT)
+    {
+        printf("\tColor read after a read/write access following a barrier produced no barrier\n");
+        testPassed = 0;
+    }
+
+    thsvsInitImageState(&state, VK_NULL_HANDLE, range, VK_IMAGE_LAYOUT_GENERAL);
+    thsvsTransitionImageState(&state, 1, &depthWriteStencilRead, THSVS_IMAGE_LAYOUT_GENERAL, VK_FALSE, &srcStageMask, &dstStageMask, &barrier);
+    if (thsvsTransitionImageState(&state, 1, &depthStencilRead, THSVS_IMAGE_LAYOUT_GENERAL, VK_FALSE, &srcStageMask, &dstStageMask, &barrier) != VK_TRUE ||
+        (barrier.srcAccessMask & VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT) == 0 ||
+        barrier.dstAccessMask != VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT)
+    {
+        printf("\tDepth/stencil read after a depth write produced an unexpected barrier\n");
+        testPassed = 0;
+    }
+
+    // Local state starts from the same assumption for its first write
+    thsvsInitLocalImageState(&localState, VK_NULL_HANDLE, range);
+    thsvsTransitionLocalImageState(&localState, 1, &colorReadWrite, THSVS_IMAGE_LAYOUT_GENERAL, VK_FALSE, &srcStageMask, &dstStageMask, &barrier);
+    if (thsvsTransitionLocalImageState(&localState, 1, &colorRead, THSVS_IMAGE_LAYOUT_GENERAL, VK_FALSE, &srcStageMask, &dstStageMask, &barrier) != VK_TRUE ||
+        (barrier.srcAccessMask & VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT) == 0 ||
+        barrier.dstAccessMask != VK_ACCESS_COLOR_ATTACHMENT_READ_BIT)
+    {
+        printf("\tRead after write in local state produced an unexpected barrier\n");
+        testPassed = 0;
+    }
+
+    if (testPassed == 1)
+        printf("\tPASSED\n");
+    else
+        printf("\tFAILED\n");
+}
+
+void split_barrier_test(const char* testName)
+{
+    VkEvent eventStorage[1];
+    ThsvsEventPool pool;
+    unsigned int testPassed = 1;
+
+    printf("Test: %s\n", testName);
+
+    if (thsvsCreateEventPool(&pool, VK_NULL_HANDLE, 1, eventStorage) != VK_SUCCESS)
+    {
+        printf("\tThe event pool couldn't be created\n");
+        printf("\tFAILED\n");
+        return;
+    }
+
+    ThsvsAccessType computeWrite = THSVS_ACCESS_COMPUTE_SHADER_WRITE;
+    ThsvsAccessType vertexRead = THSVS_ACCESS_VERTEX_BUFFER;
+    ThsvsAccessType fragmentRead = THSVS_ACCESS_FRAGMENT_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER;
+
+    // The image barrier is read-after-read in the same layout, so may be elided from the wait
+    ThsvsGlobalBarrier globalBarrier = {1, &computeWrite, 1, &vertexRead};
+    ThsvsImageBarrier imageBarrier = {1, &fragmentRead, 1, &fragmentRead,
+                                      THSVS_IMAGE_LAYOUT_OPTIMAL, THSVS_IMAGE_LAYOUT_OPTIMAL, VK_FALSE,
+                                      VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, 0,
+                                      {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}};
+    VkPipelineStageFlags setStageMask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                                        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+    ThsvsSplitBarrier splitBarrier;
+    memset(&recordedCommands, 0, sizeof(recordedCommands));
+    thsvsCmdBeginSplitBarrier(VK_NULL_HANDLE, &pool, &globalBarrier, 0, NULL, 1, &imageBarrier, &splitBarrier);
+    thsvsCmdEndSplitBarrier(VK_NULL_HANDLE, &splitBarrier, &globalBarrier, 0, NULL, 1, &imageBarrier);
+
+    if (splitBarrier.event != eventStorage[0] || recordedCommands.setEventCount != 1 ||
+        recordedCommands.setEvent != eventStorage[0] || recordedCommands.setStageMask != setStageMask)
+    {
+        printf("\tThe first half didn't set a pool event with the barriers' previous stages\n");
+        testPassed = 0;
+    }
+
+    // The wait has to name the same stages as the set, even if a barrier was elided
+    if (recordedCommands.waitEventsCount != 1 || recordedCommands.waitEvent != eventStorage[0] ||
+        recordedCommands.waitSrcStageMask != setStageMask || recordedCommands.pipelineBarrierCount != 0)
+    {
+        printf("\tThe second half didn't wait on the event with the stages it was set with\n");
+        testPassed = 0;
+    }
+
+    // The pool is used up, so the second half is a pipeline barrier instead
+    memset(&recordedCommands, 0, sizeof(recordedCommands));
+    thsvsCmdBeginSplitBarrier(VK_NULL_HANDLE, &pool, &globalBarrier, 0, NULL, 1, &imageBarrier, &splitBarrier);
+    thsvsCmdEndSplitBarrier(VK_NULL_HANDLE, &splitBarrier, &globalBarrier, 0, NULL, 1, &imageBarrier);
+
+    if (splitBarrier.event != VK_NULL_HANDLE || recordedCommands.setEventCount != 0 ||
+        recordedCommands.waitEventsCount != 0 || recordedCommands.pipelineBarrierCount != 1)
+    {
+        printf("\tAn exhausted pool didn't fall back to a pipeline barrier\n");
+        testPassed = 0;
+    }
+
+    // Resetting makes the used event available again
+    memset(&recordedCommands, 0, sizeof(recordedCommands));
+    if (thsvsResetEventPool(&pool) != VK_SUCCESS || recordedCommands.resetEventCount != 1 || pool.usedEventCount != 0)
+    {
+        printf("\tResetting the pool didn't reset its used events\n");
+        testPassed = 0;
+    }
+
+    thsvsCmdBeginSplitBarrier(VK_NULL_HANDLE, &pool, &globalBarrier, 0, NULL, 1, &imageBarrier, &splitBarrier);
+
+    if (splitBarrier.event != eventStorage[0] || recordedCommands.setEventCount != 1)
+    {
+        printf("\tA reset pool's event wasn't used again\n");
+        testPassed = 0;
+    }
+
+    thsvsDestroyEventPool(&pool);
+
+    if (testPassed == 1)
+        printf("\tPASSED\n");
+    else
+        printf("\tFAILED\n");
+}
+
+void context_test(const char* testName)
+{
+    ThsvsContext context;
+    char scratchMemory[1024];
+    ThsvsCachedAccessSet accessSetCache[16];
+    ThsvsBufferState state;
+    ThsvsLocalBufferState localState;
+    VkPipelineStageFlags srcStageMask = 0;
+    VkPipelineStageFlags dstStageMask = 0;
+    VkBufferMemoryBarrier barrier;
+    unsigned int testPassed = 1;
+
+    thsvsInitContext(&context, scratchMemory, sizeof(scratchMemory), 16, accessSetCache);
+    thsvsInitBufferState(&state, VK_NULL_HANDLE, 0, VK_WHOLE_SIZE);
+    thsvsInitLocalBufferState(&localState, VK_NULL_HANDLE, 0, VK_WHOLE_SIZE);
+
+    printf("Test: %s\n", testName);
+
+    ThsvsAccessType computeWrite = THSVS_ACCESS_COMPUTE_SHADER_WRITE;
+    ThsvsAccessType vertexRead = THSVS_ACCESS_VERTEX_SHADER_READ_OTHER;
+    ThsvsAccessType fragmentRead = THSVS_ACCESS_FRAGMENT_SHADER_READ_OTHER;
+    ThsvsAccessType reads[2] = {fragmentRead, vertexRead};
+
+    const ThsvsAccessSet* pFirstSet = thsvsContextGetAccessSet(&context, 2, reads);
+    const ThsvsAccessSet* pSecondSet = thsvsContextGetAccessSet(&context, 2, reads);
+    if (pFirstSet == NULL || pFirstSet != pSecondSet ||
+        pFirstSet->stageMask != (VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT) ||
+        context.stats.accessSetCacheHitCount != 1 || context.stats.accessSetCacheMissCount != 1)
+    {
+        printf("\tAccess set cache returned an unexpected access set\n");
+        testPassed = 0;
+    }
+
+    ThsvsGlobalBarrier globalBarrier = {1, &computeWrite, 1, &vertexRead};
+    thsvsContextCmdPipelineBarrier(&context, VK_NULL_HANDLE, &globalBarrier, 0, NULL, 0, NULL);
+    if (context.stats.pipelineBarrierCount != 1 || context.stats.memoryBarrierCount != 1)
+    {
+        printf("\tPipeline barrier wasn't counted\n");
+        testPassed = 0;
+    }
+
+    // The primary writes, then a secondary reads and writes without knowing about it
+    thsvsTransitionBufferState(&state, 1, &computeWrite, &srcStageMask, &dstStageMask, &barrier);
+
+    if (thsvsTransitionLocalBufferState(&localState, 1, &vertexRead, &srcStageMask, &dstStageMask, &barrier) != VK_FALSE ||
+        thsvsTransitionLocalBufferState(&localState, 1, &fragmentRead, &srcStageMask, &dstStageMask, &barrier) != VK_FALSE)
+    {
+        printf("\tLeading reads in a secondary produced a barrier\n");
+        testPassed = 0;
+    }
+
+    if (thsvsTransitionLocalBufferState(&localState, 1, &computeWrite, &srcStageMask, &dstStageMask, &barrier) != VK_TRUE ||
+        srcStageMask != (VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT) ||
+        dstStageMask != VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT ||
+        barrier.srcAccessMask != 0)
+    {
+        printf("\tWrite after read in a secondary produced an unexpected barrier\n");
+        testPassed = 0;
+    }
+
+    // Merging makes the secondary's leading reads wait on the primary's write
+    if (thsvsMergeBufferState(&state, &localState, &srcStageMask, &dstStageMask, &barrier) != VK_TRUE ||
+        srcStageMask != VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT ||
+        dstStageMask != (VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT) ||
+        barrier.srcAccessMask != VK_ACCESS_SHADER_WRITE_BIT ||
+        barrier.dstAccessMask != VK_ACCESS_SHADER_READ_BIT)
+    {
+        printf("\tMerge produced an unexpected barrier\n");
+        testPassed = 0;
+    }
+
+    // The primary's state now ends with the secondary's write
+    if (thsvsTransitionBufferState(&state, 1, &vertexRead, &srcStageMask, &dstStageMask, &barrier) != VK_TRUE ||
+        srcStageMask != VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT ||
+        dstStageMask != VK_PIPELINE_STAGE_VERTEX_SHADER_BIT)
+    {
+        printf("\tRead after merge produced an unexpected barrier\n");
+        testPassed = 0;
+    }
+
+    // A capacity that isn't a power of two only uses the largest power of two that fits
+    ThsvsContext oddContext;
+    thsvsInitContext(&oddContext, scratchMemory, sizeof(scratchMemory), 6, accessSetCache);
+
+    const ThsvsAccessSet* pOddSet = thsvsContextGetAccessSet(&oddContext, 2, reads);
+    if (oddContext.accessSetCacheCapacity != 4 || pOddSet == NULL ||
+        pOddSet < &accessSetCache[0].accessSet || pOddSet > &accessSetCache[3].accessSet ||
+        thsvsContextGetAccessSet(&oddContext, 2, reads) != pOddSet)
+    {
+        printf("\tAn access set cache that isn't a power of two wasn't rounded down\n");
+        testPassed = 0;
+    }
+
+    if (testPassed == 1)
+        printf("\tPASSED\n");
+    else
+        printf("\tFAILED\n");
+}
+
+void queue_transfer_test(const char* testName)
+{
+    VkPipelineStageFlags releaseSrcStageMask = 0;
+    VkPipelineStageFlags releaseDstStageMask = 0;
+    VkPipelineStageFlags acquireSrcStageMask = 0;
+    VkPipelineStageFlags acquireDstStageMask = 0;
+    VkImageMemoryBarrier releaseBarrier;
+    VkImageMemoryBarrier acquireBarrier;
+    unsigned int testPassed = 1;
+
+    printf("Test: %s\n", testName);
+
+    ThsvsAccessType prevAccess = THSVS_ACCESS_COMPUTE_SHADER_WRITE;
+    ThsvsAccessType nextAccess = THSVS_ACCESS_FRAGMENT_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER;
+
+    ThsvsImageTransfer transfer;
+    transfer.prevAccessCount = 1;
+    transfer.pPrevAccesses = &prevAccess;
+    transfer.nextAccessCount = 1;
+    transfer.pNextAccesses = &nextAccess;
+    transfer.prevLayout = THSVS_IMAGE_LAYOUT_OPTIMAL;
+    transfer.nextLayout = THSVS_IMAGE_LAYOUT_OPTIMAL;
+    transfer.discardContents = VK_FALSE;
+    transfer.srcQueueFamilyIndex = 1;
+    transfer.dstQueueFamilyIndex = 0;
+    transfer.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    transfer.image = VK_NULL_HANDLE;
+    transfer.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    transfer.subresourceRange.baseMipLevel = 0;
+    transfer.subresourceRange.levelCount = 1;
+    transfer.subresourceRange.baseArrayLayer = 0;
+    transfer.subresourceRange.layerCount = 1;
+
+    if (thsvsGetVulkanImageReleaseBarrier(transfer, &releaseSrcStageMask, &releaseDstStageMask, &releaseBarrier) != VK_TRUE ||
+        releaseSrcStageMask != VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT ||
+        releaseDstStageMask != VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT ||
+        releaseBarrier.srcAccessMask != VK_ACCESS_SHADER_WRITE_BIT ||
+        releaseBarrier.dstAccessMask != 0)
+    {
+        printf("\tUnexpected release barrier\n");
+        testPassed = 0;
+    }
+
+    if (thsvsGetVulkanImageAcquireBarrier(transfer, &acquireSrcStageMask, &acquireDstStageMask, &acquireBarrier) != VK_TRUE ||
+        acquireSrcStageMask != VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT ||
+        acquireDstStageMask != VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT ||
+        acquireBarrier.srcAccessMask != 0 ||
+        acquireBarrier.dstAccessMask != VK_ACCESS_SHADER_READ_BIT)
+    {
+        printf("\tUnexpected acquire barrier\n");
+        testPassed = 0;
+    }
+
+    // Both halves have to agree on the transfer itself
+    if (releaseBarrier.oldLayout != VK_IMAGE_LAYOUT_GENERAL ||
+        releaseBarrier.newLayout != VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL ||
+        acquireBarrier.oldLayout != releaseBarrier.oldLayout ||
+        acquireBarrier.newLayout != releaseBarrier.newLayout ||
+        releaseBarrier.srcQueueFamilyIndex != 1 || acquireBarrier.srcQueueFamilyIndex != 1 ||
+        releaseBarrier.dstQueueFamilyIndex != 0 || acquireBarrier.dstQueueFamilyIndex != 0)
+    {
+        printf("\tRelease and acquire barriers don't match\n");
+        testPassed = 0;
+    }
+
+    // Concurrent resources only need a regular barrier on the destination queue
+    transfer.sharingMode = VK_SHARING_MODE_CONCURRENT;
+    if (thsvsGetVulkanImageReleaseBarrier(transfer, &releaseSrcStageMask, &releaseDstStageMask, &releaseBarrier) != VK_FALSE ||
+        thsvsGetVulkanImageAcquireBarrier(transfer, &acquireSrcStageMask, &acquireDstStageMask, &acquireBarrier) != VK_TRUE ||
+        acquireSrcStageMask != VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT ||
+        acquireBarrier.srcQueueFamilyIndex != VK_QUEUE_FAMILY_IGNORED ||
+        acquireBarrier.dstQueueFamilyIndex != VK_QUEUE_FAMILY_IGNORED)
+    {
+        printf("\tConcurrent resource produced an ownership transfer\n");
+        testPassed = 0;
+    }
+
+    if (testPassed == 1)
+        printf("\tPASSED\n");
+    else
+        printf("\tFAILED\n");
+}
+
+void subpass_dependency_test(const char* testName)
+{
+    VkSubpassDependency dependency;
+    unsigned int testPassed = 1;
+
+    printf("Test: %s\n", testName);
+
+    ThsvsAccessType colorWrite = THSVS_ACCESS_COLOR_ATTACHMENT_WRITE;
+    ThsvsAccessType inputRead = THSVS_ACCESS_FRAGMENT_SHADER_READ_COLOR_INPUT_ATTACHMENT;
+    ThsvsAccessType sampledRead = THSVS_ACCESS_FRAGMENT_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER;
+
+    ThsvsGlobalBarrier inputBarrier = {1, &colorWrite, 1, &inputRead};
+    thsvsGetVulkanSubpassDependency(inputBarrier, 0, 1, &dependency);
+    if (dependency.srcSubpass != 0 || dependency.dstSubpass != 1 ||
+        dependency.srcStageMask != VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT ||
+        dependency.dstStageMask != VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT ||
+        dependency.srcAccessMask != VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT ||
+        dependency.dstAccessMask != VK_ACCESS_INPUT_ATTACHMENT_READ_BIT ||
+        dependency.dependencyFlags != VK_DEPENDENCY_BY_REGION_BIT)
+    {
+        printf("\tInput attachment dependency is not by region\n");
+        testPassed = 0;
+    }
+
+    // Sampling can read anywhere in the image, so needs the whole framebuffer
+    ThsvsGlobalBarrier sampledBarrier = {1, &colorWrite, 1, &sampledRead};
+    thsvsGetVulkanSubpassDependency(sampledBarrier, 0, 1, &dependency);
+    if (dependency.dependencyFlags != 0)
+    {
+        printf("\tSampled image dependency is by region\n");
+        testPassed = 0;
+    }
+
+    thsvsGetVulkanSubpassDependency(inputBarrier, VK_SUBPASS_EXTERNAL, 0, &dependency);
+    if (dependency.srcSubpass != VK_SUBPASS_EXTERNAL || dependency.dependencyFlags != 0)
+    {
+        printf("\tExternal dependency is by region\n");
+        testPassed = 0;
+    }
+
+    // A self-dependency in framebuffer-space stages must be by region, even for accesses that aren't local
+    thsvsGetVulkanSubpassDependency(sampledBarrier, 1, 1, &dependency);
+    if (dependency.srcSubpass != 1 || dependency.dstSubpass != 1 ||
+        dependency.dependencyFlags != VK_DEPENDENCY_BY_REGION_BIT)
+    {
+        printf("\tSelf-dependency is not by region\n");
+        testPassed = 0;
+    }
+
+    if (testPassed == 1)
+        printf("\tPASSED\n");
+    else
+        printf("\tFAILED\n");
+}
+
+void attachment_barrier_test(const char* testName)
+{
+    VkPipelineStageFlags srcStageMask = 0;
+    VkPipelineStageFlags dstStageMask = 0;
+    VkImageMemoryBarrier barrier;
+    unsigned int testPassed = 1;
+
+    printf("Test: %s\n", testName);
+
+    ThsvsAccessType sampledRead = THSVS_ACCESS_FRAGMENT_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER;
+    ThsvsAccessType colorWrite = THSVS_ACCESS_COLOR_ATTACHMENT_WRITE;
+
+    ThsvsAttachmentBarrier attachmentBarrier;
+    attachmentBarrier.prevAccessCount = 1;
+    attachmentBarrier.pPrevAccesses = &sampledRead;
+    attachmentBarrier.nextAccessCount = 1;
+    attachmentBarrier.pNextAccesses = &colorWrite;
+    attachmentBarrier.prevLayout = THSVS_IMAGE_LAYOUT_OPTIMAL;
+    attachmentBarrier.nextLayout = THSVS_IMAGE_LAYOUT_OPTIMAL;
+    attachmentBarrier.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachmentBarrier.discardContents = VK_TRUE;
+    attachmentBarrier.image = VK_NULL_HANDLE;
+    attachmentBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    attachmentBarrier.subresourceRange.baseMipLevel = 0;
+    attachmentBarrier.subresourceRange.levelCount = 1;
+    attachmentBarrier.subresourceRange.baseArrayLayer = 0;
+    attachmentBarrier.subresourceRange.layerCount = 1;
+
+    // Clearing the whole attachment doesn't need to preserve the previous contents
+    if (thsvsGetVulkanAttachmentBarrier(attachmentBarrier, &srcStageMask, &dstStageMask, &barrier) != VK_TRUE ||
+        srcStageMask != VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT ||
+        dstStageMask != VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT ||
+        barrier.oldLayout != VK_IMAGE_LAYOUT_UNDEFINED ||
+        barrier.newLayout != thsvsGetVulkanImageLayout(1, &colorWrite, THSVS_IMAGE_LAYOUT_OPTIMAL) ||
+        barrier.newLayout != VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL)
+    {
+        printf("\tClearing attachment produced an unexpected barrier\n");
+        testPassed = 0;
+    }
+
+    // Clearing only part of it keeps whatever is outside the render area
+    attachmentBarrier.discardContents = VK_FALSE;
+    if (thsvsGetVulkanAttachmentBarrier(attachmentBarrier, &srcStageMask, &dstStageMask, &barrier) != VK_TRUE ||
+        barrier.oldLayout != VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+    {
+        printf("\tClearing part of an attachment discarded its contents\n");
+        testPassed = 0;
+    }
+
+    attachmentBarrier.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+    attachmentBarrier.discardContents = VK_TRUE;
+    if (thsvsGetVulkanAttachmentBarrier(attachmentBarrier, &srcStageMask, &dstStageMask, &barrier) != VK_TRUE ||
+        barrier.oldLayout != VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+    {
+        printf("\tLoading attachment discarded its contents\n");
+        testPassed = 0;
+    }
+
+    // Loading after a write makes the write visible to the load as well
+    attachmentBarrier.pPrevAccesses = &colorWrite;
+    if (thsvsGetVulkanAttachmentBarrier(attachmentBarrier, &srcStageMask, &dstStageMask, &barrier) != VK_TRUE ||
+        barrier.srcAccessMask != VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT ||
+        barrier.dstAccessMask != (VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT))
+    {
+        printf("\tLoading attachment after a write produced an unexpected barrier\n");
+        testPassed = 0;
+    }
+
+    if (testPassed == 1)
+        printf("\tPASSED\n");
+    else
+        printf("\tFAILED\n");
+}
+
+void barrier_stats_test(const char* testName)
+{
+    ThsvsContext context;
+    char scratchMemory[1024];
+    unsigned int testPassed = 1;
+
+    thsvsInitContext(&context, scratchMemory, sizeof(scratchMemory), 0, NULL);
+
+    printf("Test: %s\n", testName);
+
+    // Only counted if the implementation is instrumented
+    ThsvsContextStats threadStats;
+    memset(&threadStats, 0, sizeof(threadStats));
+    if (thsvsGetThreadStats() != NULL)
+        threadStats = *thsvsGetThreadStats();
+
+    ThsvsAccessType transferWrite = THSVS_ACCESS_TRANSFER_WRITE;
+    ThsvsAccessType fragmentRead = THSVS_ACCESS_FRAGMENT_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER;
+    ThsvsAccessType general = THSVS_ACCESS_GENERAL;
+
+    ThsvsImageBarrier imageBarrier;
+    imageBarrier.prevAccessCount = 1;
+    imageBarrier.pPrevAccesses = &transferWrite;
+    imageBarrier.nextAccessCount = 1;
+    imageBarrier.pNextAccesses = &fragmentRead;
+    imageBarrier.prevLayout = THSVS_IMAGE_LAYOUT_OPTIMAL;
+    imageBarrier.nextLayout = THSVS_IMAGE_LAYOUT_OPTIMAL;
+    imageBarrier.discardContents = VK_FALSE;
+    imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    imageBarrier.image = VK_NULL_HANDLE;
+    imageBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    imageBarrier.subresourceRange.baseArrayLayer = 0;
+    imageBarrier.subresourceRange.layerCount = 1;
+    imageBarrier.subresourceRange.baseMipLevel = 0;
+    imageBarrier.subresourceRange.levelCount = 1;
+
+    ThsvsGlobalBarrier globalBarrier = {1, &general, 1, &general};
+
+    thsvsContextCmdPipelineBarrier(&context, VK_NULL_HANDLE, NULL, 0, NULL, 1, &imageBarrier);
+    thsvsContextCmdPipelineBarrier(&context, VK_NULL_HANDLE, &globalBarrier, 0, NULL, 0, NULL);
+
+    if (context.stats.pipelineBarrierCount != 2 ||
+        context.stats.memoryBarrierCount != 1 ||
+        context.stats.imageMemoryBarrierCount != 1 ||
+        context.stats.layoutTransitionCount != 1 ||
+        context.stats.queueTransferCount != 0 ||
+        context.stats.broadStageMaskCount != 1)
+    {
+        printf("\tContext stats didn't count the recorded barriers\n");
+        testPassed = 0;
+    }
+
+    if (thsvsGetThreadStats() != NULL &&
+        (thsvsGetThreadStats()->pipelineBarrierCount != threadStats.pipelineBarrierCount + 2 ||
+         thsvsGetThreadStats()->broadStageMaskCount != threadStats.broadStageMaskCount + 1))
+    {
+        printf("\tThread stats didn't count the recorded barriers\n");
+        testPassed = 0;
+    }
+
+#ifdef VK_VERSION_1_3
+    thsvsCmdPipelineBarrier2(VK_NULL_HANDLE, &globalBarrier, 0, NULL, 1, &imageBarrier);
+    if (thsvsGetThreadStats() != NULL &&
+        (thsvsGetThreadStats()->pipelineBarrierCount != threadStats.pipelineBarrierCount + 3 ||
+         thsvsGetThreadStats()->layoutTransitionCount != threadStats.layoutTransitionCount + 2 ||
+         thsvsGetThreadStats()->broadStageMaskCount != threadStats.broadStageMaskCount + 2))
+    {
+        printf("\tThread stats didn't count the synchronization2 barrier\n");
+        testPassed = 0;
+    }
+#endif
+
+    if (testPassed == 1)
+        printf("\tPASSED\n");
+    else
+        printf("\tFAILED\n");
+}
+
+void aliasing_barrier_test(const char* testName)
+{
+    VkPipelineStageFlags srcStageMask = 0;
+    VkPipelineStageFlags dstStageMask = 0;
+    VkMemoryBarrier memoryBarrier;
+    VkImageMemoryBarrier imageBarrier;
+    unsigned int testPassed = 1;
+
+    printf("Test: %s\n", testName);
+
+    ThsvsAccessType colorWrite = THSVS_ACCESS_COLOR_ATTACHMENT_WRITE;
+    ThsvsAccessType computeWrite = THSVS_ACCESS_COMPUTE_SHADER_WRITE;
+    ThsvsAccessType fragmentRead = THSVS_ACCESS_FRAGMENT_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER;
+    ThsvsAccessType vertexRead = THSVS_ACCESS_VERTEX_BUFFER;
+
+    // A render target handing its memory to a storage image
+    ThsvsAliasingBarrier aliasingBarrier;
+    aliasingBarrier.prevAccessCount = 1;
+    aliasingBarrier.pPrevAccesses = &colorWrite;
+    aliasingBarrier.nextAccessCount = 1;
+    aliasingBarrier.pNextAccesses = &computeWrite;
+    aliasingBarrier.nextLayout = THSVS_IMAGE_LAYOUT_OPTIMAL;
+    aliasingBarrier.image = (VkImage)1;
+    aliasingBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    aliasingBarrier.subresourceRange.baseMipLevel = 0;
+    aliasingBarrier.subresourceRange.levelCount = 1;
+    aliasingBarrier.subresourceRange.baseArrayLayer = 0;
+    aliasingBarrier.subresourceRange.layerCount = 1;
+
+    if (thsvsGetVulkanAliasingBarrier(aliasingBarrier, &srcStageMask, &dstStageMask, &memoryBarrier, &imageBarrier) != VK_TRUE ||
+        srcStageMask != VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT ||
+        dstStageMask != VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT ||
+        memoryBarrier.srcAccessMask != VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT ||
+        memoryBarrier.dstAccessMask != VK_ACCESS_SHADER_WRITE_BIT ||
+        imageBarrier.srcAccessMask != 0 ||
+        imageBarrier.dstAccessMask != VK_ACCESS_SHADER_WRITE_BIT ||
+        imageBarrier.oldLayout != VK_IMAGE_LAYOUT_UNDEFINED ||
+        imageBarrier.newLayout != VK_IMAGE_LAYOUT_GENERAL)
+    {
+        printf("\tAliasing an image produced an unexpected barrier\n");
+        testPassed = 0;
+    }
+
+    // Memory that was only read can be handed to a buffer that's only read without a barrier
+    aliasingBarrier.pPrevAccesses = &fragmentRead;
+    aliasingBarrier.pNextAccesses = &vertexRead;
+    aliasingBarrier.image = VK_NULL_HANDLE;
+    if (thsvsGetVulkanAliasingBarrier(aliasingBarrier, &srcStageMask, &dstStageMask, &memoryBarrier, NULL) != VK_FALSE)
+    {
+        printf("\tAliasing a buffer after reads produced a barrier\n");
+        testPassed = 0;
+    }
+
+    if (testPassed == 1)
+        printf("\tPASSED\n");
+    else
+        printf("\tFAILED\n");
+}
+
+void semaphore_test(const char* testName)
+{
+    unsigned int testPassed = 1;
+
+    printf("Test: %s\n", testName);
+
+    ThsvsAccessType computeWrite = THSVS_ACCESS_COMPUTE_SHADER_WRITE;
+    ThsvsAccessType vertexRead = THSVS_ACCESS_VERTEX_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER;
+
+    // A graphics queue consuming async compute results only stalls vertex shading
+    if (thsvsGetSemaphoreWaitStageMask(1, &vertexRead) != VK_PIPELINE_STAGE_VERTEX_SHADER_BIT ||
+        thsvsGetSemaphoreWaitStageMask(0, NULL) != VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT)
+    {
+        printf("\tUnexpected semaphore wait stage mask\n");
+        testPassed = 0;
+    }
+
+#ifdef VK_VERSION_1_3
+    VkSemaphoreSubmitInfo signalInfo;
+    VkSemaphoreSubmitInfo waitInfo;
+    thsvsGetSemaphoreSignalInfo(VK_NULL_HANDLE, 2, 1, &computeWrite, &signalInfo);
+    thsvsGetSemaphoreWaitInfo(VK_NULL_HANDLE, 2, 1, &vertexRead, &waitInfo);
+
+    if (signalInfo.sType != VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO ||
+        signalInfo.stageMask != VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT ||
+        signalInfo.value != 2 ||
+        waitInfo.stageMask != VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT ||
+        waitInfo.value != 2)
+    {
+        printf("\tUnexpected semaphore submit info\n");
+        testPassed = 0;
+    }
+#else
+    (void)computeWrite;
+#endif
+
+    if (testPassed == 1)
+        printf("\tPASSED\n");
+    else
+        printf("\tFAILED\n");
+}
+
+void reverse_lookup_test(const char* testName)
+{
+    ThsvsAccessType accesses[4];
+    uint32_t accessCount = 4;
+    ThsvsImageLayout layout = THSVS_IMAGE_LAYOUT_GENERAL;
+    unsigned int testPassed = 1;
+
+    printf("Test: %s\n", testName);
+
+    if (thsvsGetAccessTypes(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                            VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, &accessCount, accesses, &layout) != VK_TRUE ||
+        accessCount != 1 || accesses[0] != THSVS_ACCESS_COLOR_ATTACHMENT_WRITE || layout != THSVS_IMAGE_LAYOUT_OPTIMAL)
+    {
+        printf("\tColor attachment write wasn't found\n");
+        testPassed = 0;
+    }
+
+    accessCount = 4;
+    if (thsvsGetAccessTypes(VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+                            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, &accessCount, accesses, &layout) != VK_TRUE ||
+        accessCount != 2 ||
+        accesses[0] != THSVS_ACCESS_FRAGMENT_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER ||
+        accesses[1] != THSVS_ACCESS_COMPUTE_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER)
+    {
+        printf("\tSampled reads in two stages weren't found\n");
+        testPassed = 0;
+    }
+
+    accessCount = 1;
+    if (thsvsGetAccessTypes(VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+                            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, &accessCount, accesses, &layout) != VK_FALSE ||
+        accessCount != 0)
+    {
+        printf("\tAccess types were written beyond the space given\n");
+        testPassed = 0;
+    }
+
+    accessCount = 4;
+    if (thsvsGetAccessTypes(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, &accessCount, accesses, &layout) != VK_TRUE ||
+        accessCount != 1 || accesses[0] != THSVS_ACCESS_PRESENT)
+    {
+        printf("\tPresentation wasn't found\n");
+        testPassed = 0;
+    }
+
+    // No access type waits on all commands for just color attachment writes
+    accessCount = 4;
+    if (thsvsGetAccessTypes(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                            VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, &accessCount, accesses, &layout) != VK_FALSE)
+    {
+        printf("\tAn access type was found that doesn't cover all stages\n");
+        testPassed = 0;
+    }
+
+    if (testPassed == 1)
+        printf("\tPASSED\n");
+    else
+        printf("\tFAILED\n");
+}
+
+void event_barrier_test(const char* testName)
+{
+    char scratchMemory[1024];
+    ThsvsScratch scratch;
+    unsigned int testPassed = 1;
+
+    thsvsInitScratch(&scratch, scratchMemory, sizeof(scratchMemory));
+
+    printf("Test: %s\n", testName);
+
+    // Only counted if the implementation is instrumented
+    ThsvsContextStats threadStats;
+    memset(&threadStats, 0, sizeof(threadStats));
+    if (thsvsGetThreadStats() != NULL)
+        threadStats = *thsvsGetThreadStats();
+
+    ThsvsAccessType computeWrite = THSVS_ACCESS_COMPUTE_SHADER_WRITE;
+    ThsvsAccessType vertexRead = THSVS_ACCESS_VERTEX_BUFFER;
+    ThsvsAccessType fragmentRead = THSVS_ACCESS_FRAGMENT_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER;
+
+    ThsvsGlobalBarrier globalBarrier = {1, &computeWrite, 1, &vertexRead};
+    ThsvsImageBarrier imageBarriers[2] = {
+        {1, &computeWrite, 1, &fragmentRead, THSVS_IMAGE_LAYOUT_GENERAL, THSVS_IMAGE_LAYOUT_OPTIMAL, VK_FALSE,
+         VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, 0, {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}},
+        {1, &computeWrite, 1, &fragmentRead, THSVS_IMAGE_LAYOUT_GENERAL, THSVS_IMAGE_LAYOUT_OPTIMAL, VK_FALSE,
+         VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, 0, {VK_IMAGE_ASPECT_COLOR_BIT, 1, 1, 0, 1}}};
+
+    ThsvsEventBarrier eventBarriers[3] = {
+        {0, &globalBarrier, 0, NULL, 0, NULL},
+        {0, NULL, 0, NULL, 2, imageBarriers},
+        {0, &globalBarrier, 0, NULL, 0, NULL}};
+
+    thsvsCmdSetEvents(VK_NULL_HANDLE, 3, eventBarriers);
+    thsvsCmdWaitEventBarriers(VK_NULL_HANDLE, &scratch, 3, eventBarriers);
+
+    // Both global barriers are merged into one, and the image barriers are appended
+    if (thsvsGetThreadStats() != NULL &&
+        (thsvsGetThreadStats()->waitEventsCount != threadStats.waitEventsCount + 1 ||
+         thsvsGetThreadStats()->memoryBarrierCount != threadStats.memoryBarrierCount + 1 ||
+         thsvsGetThreadStats()->imageMemoryBarrierCount != threadStats.imageMemoryBarrierCount + 2))
+    {
+        printf("\tEvents weren't all waited on with a single call\n");
+        testPassed = 0;
+    }
+
+#ifdef VK_VERSION_1_3
+    thsvsCmdSetEvents2(VK_NULL_HANDLE, &scratch, 3, eventBarriers);
+    thsvsCmdWaitEvents2(VK_NULL_HANDLE, &scratch, 3, eventBarriers);
+
+    // Each event keeps its own dependency info, but it's still a single wait
+    if (thsvsGetThreadStats() != NULL &&
+        (thsvsGetThreadStats()->waitEventsCount != threadStats.waitEventsCount + 2 ||
+         thsvsGetThreadStats()->memoryBarrierCount != threadStats.memoryBarrierCount + 3 ||
+         thsvsGetThreadStats()->imageMemoryBarrierCount != threadStats.imageMemoryBarrierCount + 4 ||
+         thsvsGetThreadStats()->layoutTransitionCount != threadStats.layoutTransitionCount + 4))
+    {
+        printf("\tSynchronization2 event wait wasn't counted\n");
+        testPassed = 0;
+    }
+#endif
+
+    if (scratch.offset != 0)
+    {
+        printf("\tTemporary barriers weren't given back to the scratch allocator\n");
+        testPassed = 0;
+    }
+
+    if (testPassed == 1)
+        printf("\tPASSED\n");
+    else
+        printf("\tFAILED\n");
+}
+
+// A short access list, used to enumerate every list the reference tests cover
+typedef struct ReferenceAccessList {
+    uint32_t accessCount;
+    ThsvsAccessType accesses[2];
+} ReferenceAccessList;
+
+typedef struct ReferenceBarrier {
+    VkPipelineStageFlags srcStages;
+    VkPipelineStageFlags dstStages;
+    VkAccessFlags srcAccessMask;
+    VkAccessFlags dstAccessMask;
+    VkImageLayout oldLayout;
+    VkImageLayout newLayout;
+    VkBool32 needed;
+} ReferenceBarrier;
+
+// Reference image layout of an access, restated from the ThsvsImageLayout documentation
+VkImageLayout reference_image_layout(ThsvsAccessType access, ThsvsImageLayout layout)
+{
+    VkImageLayout optimalLayout = ThsvsAccessMap[access].imageLayout;
+
+    switch (layout)
+    {
+        case THSVS_IMAGE_LAYOUT_GENERAL:
+            return (access == THSVS_ACCESS_PRESENT) ? VK_IMAGE_LAYOUT_PRESENT_SRC_KHR : VK_IMAGE_LAYOUT_GENERAL;
+        case THSVS_IMAGE_LAYOUT_GENERAL_AND_PRESENTATION:
+            return VK_IMAGE_LAYOUT_SHARED_PRESENT_KHR;
+#ifdef VK_VERSION_1_3
+        case THSVS_IMAGE_LAYOUT_OPTIMAL_SYNCHRONIZATION2:
+            if (optimalLayout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL ||
+                optimalLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL)
+                return VK_IMAGE_LAYOUT_ATTACHMENT_OPTIMAL;
+            if (optimalLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL ||
+                optimalLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL)
+                return VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
+            return optimalLayout;
+#endif
+        default:
+            return optimalLayout;
+    }
+}
+
+// Whether every access in a list shares an image layout, as image barriers require
+unsigned int reference_layouts_match(const ReferenceAccessList& list, ThsvsImageLayout layout)
+{
+    for (uint32_t i = 1; i < list.accessCount; ++i)
+    {
+        if (reference_image_layout(list.accesses[i], layout) != reference_image_layout(list.accesses[0], layout))
+            return 0;
+    }
+    return 1;
+}
+
+/*
+Reference translation of a barrier, written as plainly as possible straight
+from ThsvsAccessMap, so that the tables and translators the library actually
+uses can be checked against it.
+*/
+void reference_barrier(const ReferenceAccessList& prev,
+                       const ReferenceAccessList& next,
+                       ThsvsImageLayout prevLayout,
+                       ThsvsImageLayout nextLayout,
+                       VkBool32 discardContents,
+                       unsigned int queueTransfer,
+                       unsigned int image,
+                       ReferenceBarrier* pBarrier)
+{
+    VkPipelineStageFlags prevStages = 0;
+    VkPipelineStageFlags nextStages = 0;
+    VkAccessFlags prevWriteAccessMask = 0;
+    VkAccessFlags nextAccessMask = 0;
+    unsigned int prevHasWrite = 0;
+    unsigned int nextHasWrite = 0;
+
+    for (uint32_t i = 0; i < prev.accessCount; ++i)
+    {
+        prevStages |= ThsvsAccessMap[prev.accesses[i]].stageMask;
+        if (prev.accesses[i] > THSVS_END_OF_READ_ACCESS)
+        {
+            prevWriteAccessMask |= ThsvsAccessMap[prev.accesses[i]].accessMask;
+            prevHasWrite = 1;
+        }
+    }
+
+    for (uint32_t i = 0; i < next.accessCount; ++i)
+    {
+        nextStages |= ThsvsAccessMap[next.accesses[i]].stageMask;
+        nextAccessMask |= ThsvsAccessMap[next.accesses[i]].accessMask;
+        if (next.accesses[i] > THSVS_END_OF_READ_ACCESS)
+            nextHasWrite = 1;
+    }
+
+    pBarrier->srcStages = (prevStages != 0) ? prevStages : (VkPipelineStageFlags)VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    pBarrier->dstStages = (nextStages != 0) ? nextStages : (VkPipelineStageFlags)VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+    pBarrier->srcAccessMask = prevWriteAccessMask;
+    pBarrier->dstAccessMask = (prevWriteAccessMask != 0) ? nextAccessMask : 0;
+
+    pBarrier->oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    pBarrier->newLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    if (image && prev.accessCount > 0 && discardContents != VK_TRUE)
+        pBarrier->oldLayout = reference_image_layout(prev.accesses[prev.accessCount - 1], prevLayout);
+    if (image && next.accessCount > 0)
+        pBarrier->newLayout = reference_image_layout(next.accesses[next.accessCount - 1], nextLayout);
+
+    unsigned int transition = queueTransfer || pBarrier->oldLayout != pBarrier->newLayout;
+    pBarrier->needed = (prevHasWrite || (nextHasWrite && prevStages != 0) || transition) ? VK_TRUE : VK_FALSE;
+}
+
+// Stages that each access flag can be used with, from the "Supported access types" table in the Vulkan spec
+typedef struct ReferenceAccessStages {
+    VkAccessFlags accessFlag;
+    VkPipelineStageFlags stageMask;
+} ReferenceAccessStages;
+
+#define REFERENCE_SHADER_STAGES (VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT | \
+                                 VK_PIPELINE_STAGE_TESSELLATION_EVALUATION_SHADER_BIT | VK_PIPELINE_STAGE_GEOMETRY_SHADER_BIT | \
+                                 VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | \
+                                 VK_PIPELINE_STAGE_TASK_SHADER_BIT_NV | VK_PIPELINE_STAGE_MESH_SHADER_BIT_NV | \
+                                 VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_NV)
+
+static const ReferenceAccessStages referenceAccessStages[] = {
+    {VK_ACCESS_INDIRECT_COMMAND_READ_BIT,               VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_NV},
+    {VK_ACCESS_INDEX_READ_BIT,                          VK_PIPELINE_STAGE_VERTEX_INPUT_BIT},
+    {VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT,               VK_PIPELINE_STAGE_VERTEX_INPUT_BIT},
+    {VK_ACCESS_UNIFORM_READ_BIT,                        REFERENCE_SHADER_STAGES},
+    {VK_ACCESS_INPUT_ATTACHMENT_READ_BIT,               VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT},
+    {VK_ACCESS_SHADER_READ_BIT,                         REFERENCE_SHADER_STAGES | VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_NV},
+    {VK_ACCESS_SHADER_WRITE_BIT,                        REFERENCE_SHADER_STAGES},
+    {VK_ACCESS_COLOR_ATTACHMENT_READ_BIT,               VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT},
+    {VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,              VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT},
+    {VK_ACCESS_COLOR_ATTACHMENT_READ_NONCOHERENT_BIT_EXT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT},
+    {VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,       VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT},
+    {VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,      VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT},
+    {VK_ACCESS_TRANSFER_READ_BIT,                       VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_NV},
+    {VK_ACCESS_TRANSFER_WRITE_BIT,                      VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_NV},
+    {VK_ACCESS_HOST_READ_BIT,                           VK_PIPELINE_STAGE_HOST_BIT},
+    {VK_ACCESS_HOST_WRITE_BIT,                          VK_PIPELINE_STAGE_HOST_BIT},
+    {VK_ACCESS_TRANSFORM_FEEDBACK_WRITE_BIT_EXT,        VK_PIPELINE_STAGE_TRANSFORM_FEEDBACK_BIT_EXT},
+    {VK_ACCESS_TRANSFORM_FEEDBACK_COUNTER_READ_BIT_EXT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_TRANSFORM_FEEDBACK_BIT_EXT},
+    {VK_ACCESS_TRANSFORM_FEEDBACK_COUNTER_WRITE_BIT_EXT, VK_PIPELINE_STAGE_TRANSFORM_FEEDBACK_BIT_EXT},
+    {VK_ACCESS_CONDITIONAL_RENDERING_READ_BIT_EXT,      VK_PIPELINE_STAGE_CONDITIONAL_RENDERING_BIT_EXT},
+    {VK_ACCESS_COMMAND_PREPROCESS_READ_BIT_NV,          VK_PIPELINE_STAGE_COMMAND_PREPROCESS_BIT_NV},
+    {VK_ACCESS_COMMAND_PREPROCESS_WRITE_BIT_NV,         VK_PIPELINE_STAGE_COMMAND_PREPROCESS_BIT_NV},
+    {VK_ACCESS_SHADING_RATE_IMAGE_READ_BIT_NV,          VK_PIPELINE_STAGE_SHADING_RATE_IMAGE_BIT_NV},
+    {VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_NV,      REFERENCE_SHADER_STAGES | VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_NV},
+    {VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_NV,     VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_NV},
+    {VK_ACCESS_FRAGMENT_DENSITY_MAP_READ_BIT_EXT,       VK_PIPELINE_STAGE_FRAGMENT_DENSITY_PROCESS_BIT_EXT}
+};
+
+// Whether every flag in accessMask is supported by at least one of the stages, as vkCmdPipelineBarrier requires
+unsigned int reference_access_supported(VkAccessFlags accessMask, VkPipelineStageFlags stageMask)
+{
+    if (stageMask & VK_PIPELINE_STAGE_ALL_COMMANDS_BIT)
+        return 1;
+
+    if (stageMask & VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT)
+        stageMask |= REFERENCE_SHADER_STAGES | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+                     VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT |
+                     VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+    accessMask &= ~(VkAccessFlags)(VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT);
+
+    for (uint32_t i = 0; i < sizeof(referenceAccessStages) / sizeof(referenceAccessStages[0]); ++i)
+    {
+        if ((accessMask & referenceAccessStages[i].accessFlag) != 0 && (stageMask & referenceAccessStages[i].stageMask) != 0)
+            accessMask &= ~referenceAccessStages[i].accessFlag;
+    }
+
+    // Anything left either isn't supported by the stages, or isn't in the table
+    return accessMask == 0;
+}
+
+// Returns why a translated barrier breaks a valid usage rule of vkCmdPipelineBarrier, or NULL if it doesn't
+const char* reference_valid_usage(const ReferenceAccessList& next,
+                                  VkPipelineStageFlags srcStages,
+                                  VkPipelineStageFlags dstStages,
+                                  VkAccessFlags srcAccessMask,
+                                  VkAccessFlags dstAccessMask,
+                                  unsigned int image,
+                                  VkImageLayout newLayout)
+{
+    if (srcStages == 0 || dstStages == 0)
+        return "a stage mask is zero";
+    if (!reference_access_supported(srcAccessMask, srcStages))
+        return "srcAccessMask isn't supported by srcStageMask";
+    if (!reference_access_supported(dstAccessMask, dstStages))
+        return "dstAccessMask isn't supported by dstStageMask";
+
+    // Next accesses that don't apply to images, or that are only valid before the first use, have no layout of their own
+    VkImageLayout nextOptimalLayout = (next.accessCount > 0) ? ThsvsAccessMap[next.accesses[next.accessCount - 1]].imageLayout
+                                                             : VK_IMAGE_LAYOUT_UNDEFINED;
+    if (image && nextOptimalLayout != VK_IMAGE_LAYOUT_UNDEFINED && nextOptimalLayout != VK_IMAGE_LAYOUT_PREINITIALIZED &&
+        (newLayout == VK_IMAGE_LAYOUT_UNDEFINED || newLayout == VK_IMAGE_LAYOUT_PREINITIALIZED))
+        return "newLayout is VK_IMAGE_LAYOUT_UNDEFINED or VK_IMAGE_LAYOUT_PREINITIALIZED";
+
+    return NULL;
+}
+
+void reference_report(unsigned int* pFailureCount,
+                      const char* pBarrierType,
+                      const char* pReason,
+                      const ReferenceAccessList& prev,
+                      const ReferenceAccessList& next,
+                      uint32_t prevLayout,
+                      uint32_t nextLayout)
+{
+    // Only the first few failures are printed, as one bad table entry fails thousands of barriers
+    if ((*pFailureCount)++ < 10)
+        printf("\t%s barrier {%d, %d} (%u) -> {%d, %d} (%u) %s\n", pBarrierType,
+               (prev.accessCount > 0) ? (int)prev.accesses[0] : -1, (prev.accessCount > 1) ? (int)prev.accesses[1] : -1, prevLayout,
+               (next.accessCount > 0) ? (int)next.accesses[0] : -1, (next.accessCount > 1) ? (int)next.accesses[1] : -1, nextLayout,
+               pReason);
+}
+
+void reference_barrier_test(const char* testName)
+{
+    static ReferenceAccessList lists[1 + THSVS_NUM_ACCESS_TYPES + THSVS_END_OF_READ_ACCESS * THSVS_END_OF_READ_ACCESS / 2];
+    static ThsvsAccessSet accessSets[sizeof(lists) / sizeof(lists[0])];
+    static ThsvsAccessMask accessMasks[sizeof(lists) / sizeof(lists[0])];
+    uint32_t listCount = 0;
+    unsigned int failureCount = 0;
+
+    printf("Test: %s\n", testName);
+
+    // No accesses, every access on its own, and every pair of reads in the order masks visit them
+    lists[listCount++].accessCount = 0;
+    for (uint32_t access = 0; access < THSVS_NUM_ACCESS_TYPES; ++access)
+    {
+        if (access == THSVS_END_OF_READ_ACCESS)
+            continue;
+        lists[listCount].accessCount = 1;
+        lists[listCount++].accesses[0] = (ThsvsAccessType)access;
+    }
+    for (uint32_t first = THSVS_ACCESS_NONE + 1; first < THSVS_END_OF_READ_ACCESS; ++first)
+    {
+        for (uint32_t second = first + 1; second < THSVS_END_OF_READ_ACCESS; ++second)
+        {
+            lists[listCount].accessCount = 2;
+            lists[listCount].accesses[0] = (ThsvsAccessType)first;
+            lists[listCount++].accesses[1] = (ThsvsAccessType)second;
+        }
+    }
+
+    for (uint32_t i = 0; i < listCount; ++i)
+    {
+        thsvsCompileAccessSet(lists[i].accessCount, lists[i].accesses, &accessSets[i]);
+        thsvsMakeAccessMask(lists[i].accessCount, lists[i].accesses, &accessMasks[i]);
+    }
+
+    for (uint32_t prevIndex = 0; prevIndex < listCount; ++prevIndex)
+    {
+        for (uint32_t nextIndex = 0; nextIndex < listCount; ++nextIndex)
+        {
+            const ReferenceAccessList& prev = lists[prevIndex];
+            const ReferenceAccessList& next = lists[nextIndex];
+            ReferenceBarrier expected;
+            VkPipelineStageFlags srcStages = 0;
+            VkPipelineStageFlags dstStages = 0;
+            VkBool32 needed = VK_FALSE;
+            const char* pInvalid = NULL;
+
+            // Global barriers, through every mapping function that takes one
+            reference_barrier(prev, next, THSVS_IMAGE_LAYOUT_OPTIMAL, THSVS_IMAGE_LAYOUT_OPTIMAL, VK_FALSE, 0, 0, &expected);
+
+            ThsvsGlobalBarrier globalBarrier = {prev.accessCount, prev.accesses, next.accessCount, next.accesses};
+            ThsvsCompiledGlobalBarrier compiledGlobalBarrier = {&accessSets[prevIndex], &accessSets[nextIndex]};
+            ThsvsMaskGlobalBarrier maskGlobalBarrier = {accessMasks[prevIndex], accessMasks[nextIndex]};
+            VkMemoryBarrier memoryBarrier;
+
+            for (uint32_t path = 0; path < 4; ++path)
+            {
+                if (path == 0)
+                    needed = thsvsGetVulkanMemoryBarrier(globalBarrier, &srcStages, &dstStages, &memoryBarrier);
+                else if (path == 1)
+                    needed = thsvsGetVulkanMemoryBarrierFast(globalBarrier, &srcStages, &dstStages, &memoryBarrier);
+                else if (path == 2)
+                    needed = thsvsGetVulkanCompiledMemoryBarrier(compiledGlobalBarrier, &srcStages, &dstStages, &memoryBarrier);
+                else
+                    needed = thsvsGetVulkanMaskMemoryBarrier(maskGlobalBarrier, &srcStages, &dstStages, &memoryBarrier);
+
+                if (needed != expected.needed || srcStages != expected.srcStages || dstStages != expected.dstStages ||
+                    memoryBarrier.srcAccessMask != expected.srcAccessMask || memoryBarrier.dstAccessMask != expected.dstAccessMask)
+                    reference_report(&failureCount, "Global", "differs from the reference", prev, next, 0, 0);
+            }
+
+            pInvalid = reference_valid_usage(next, srcStages, dstStages, memoryBarrier.srcAccessMask, memoryBarrier.dstAccessMask, 0,
+                                             VK_IMAGE_LAYOUT_UNDEFINED);
+            if (pInvalid != NULL)
+                reference_report(&failureCount, "Global", pInvalid, prev, next, 0, 0);
+
+            // Buffer barriers, with and without a queue family ownership transfer
+            for (uint32_t queueTransfer = 0; queueTransfer < 2; ++queueTransfer)
+            {
+                reference_barrier(prev, next, THSVS_IMAGE_LAYOUT_OPTIMAL, THSVS_IMAGE_LAYOUT_OPTIMAL, VK_FALSE, queueTransfer, 0, &expected);
+
+                ThsvsBufferBarrier bufferBarrier = {prev.accessCount, prev.accesses, next.accessCount, next.accesses,
+                                                    0, queueTransfer, 0, 0, VK_WHOLE_SIZE};
+                ThsvsCompiledBufferBarrier compiledBufferBarrier = {&accessSets[prevIndex], &accessSets[nextIndex],
+                                                                    0, queueTransfer, 0, 0, VK_WHOLE_SIZE};
+                ThsvsMaskBufferBarrier maskBufferBarrier = {accessMasks[prevIndex], accessMasks[nextIndex],
+                                                            0, queueTransfer, 0, 0, VK_WHOLE_SIZE};
+                VkBufferMemoryBarrier bufferMemoryBarrier;
+
+                for (uint32_t path = 0; path < 4; ++path)
+                {
+                    if (path == 0)
+                        needed = thsvsGetVulkanBufferMemoryBarrier(bufferBarrier, &srcStages, &dstStages, &bufferMemoryBarrier);
+                    else if (path == 1)
+                        needed = thsvsGetVulkanBufferMemoryBarrierFast(bufferBarrier, &srcStages, &dstStages, &bufferMemoryBarrier);
+                    else if (path == 2)
+                        needed = thsvsGetVulkanCompiledBufferMemoryBarrier(compiledBufferBarrier, &srcStages, &dstStages, &bufferMemoryBarrier);
+                    else
+                        needed = thsvsGetVulkanMaskBufferMemoryBarrier(maskBufferBarrier, &srcStages, &dstStages, &bufferMemoryBarrier);
+
+                    if (needed != expected.needed || srcStages != expected.srcStages || dstStages != expected.dstStages ||
+                        bufferMemoryBarrier.srcAccessMask != expected.srcAccessMask ||
+                        bufferMemoryBarrier.dstAccessMask != expected.dstAccessMask ||
+                        bufferMemoryBarrier.dstQueueFamilyIndex != queueTransfer)
+                        reference_report(&failureCount, "Buffer", "differs from the reference", prev, next, 0, 0);
+                }
+
+                pInvalid = reference_valid_usage(next, srcStages, dstStages, bufferMemoryBarrier.srcAccessMask,
+                                                 bufferMemoryBarrier.dstAccessMask, 0, VK_IMAGE_LAYOUT_UNDEFINED);
+                if (pInvalid != NULL)
+                    reference_report(&failureCount, "Buffer", pInvalid, prev, next, 0, 0);
+            }
+
+            // Image barriers under every pair of layout modes for single accesses, and matching modes for lists
+            for (uint32_t prevLayout = 0; prevLayout < THSVS_NUM_IMAGE_LAYOUTS; ++prevLayout)
+            {
+                for (uint32_t nextLayout = 0; nextLayout < THSVS_NUM_IMAGE_LAYOUTS; ++nextLayout)
+                {
+                    if ((prev.accessCount > 1 || next.accessCount > 1) && prevLayout != nextLayout)
+                        continue;
+                    if (!reference_layouts_match(prev, (ThsvsImageLayout)prevLayout) ||
+                        !reference_layouts_match(next, (ThsvsImageLayout)nextLayout))
+                        continue;
+
+                    for (uint32_t discard = 0; discard < 2; ++discard)
+                    {
+                        VkBool32 discardContents = (discard == 1) ? VK_TRUE : VK_FALSE;
+                        reference_barrier(prev, next, (ThsvsImageLayout)prevLayout, (ThsvsImageLayout)nextLayout,
+                                          discardContents, 0, 1, &expected);
+
+                        ThsvsImageBarrier imageBarrier = {prev.accessCount, prev.accesses, next.accessCount, next.accesses,
+                                                          (ThsvsImageLayout)prevLayout, (ThsvsImageLayout)nextLayout, discardContents,
+                                                          VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, 0,
+                                                          {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}};
+                        ThsvsCompiledImageBarrier compiledImageBarrier = {&accessSets[prevIndex], &accessSets[nextIndex],
+                                                                          (ThsvsImageLayout)prevLayout, (ThsvsImageLayout)nextLayout,
+                                                                          discardContents, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, 0,
+                                                                          {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}};
+                        ThsvsMaskImageBarrier maskImageBarrier = {accessMasks[prevIndex], accessMasks[nextIndex],
+                                                                  (ThsvsImageLayout)prevLayout, (ThsvsImageLayout)nextLayout,
+                                                                  discardContents, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, 0,
+                                                                  {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}};
+                        VkImageMemoryBarrier imageMemoryBarrier;
+
+                        for (uint32_t path = 0; path < 6; ++path)
+                        {
+                            if (path == 0)
+                                needed = thsvsGetVulkanImageMemoryBarrier(imageBarrier, &srcStages, &dstStages, &imageMemoryBarrier);
+                            else if (path == 1)
+                                needed = thsvsGetVulkanImageMemoryBarrierFast(imageBarrier, &srcStages, &dstStages, &imageMemoryBarrier);
+                            else if (path == 2)
+                                needed = thsvsGetVulkanCompiledImageMemoryBarrier(compiledImageBarrier, &srcStages, &dstStages, &imageMemoryBarrier);
+                            else if (path == 3)
+                                needed = thsvsGetVulkanMaskImageMemoryBarrier(maskImageBarrier, &srcStages, &dstStages, &imageMemoryBarrier);
+                            else
+                            {
+                                // The batch functions accumulate into the stage masks rather than overwriting them
+                                srcStages = 0;
+                                dstStages = 0;
+                                if (path == 4)
+                                    needed = thsvsGetVulkanImageMemoryBarriers(1, &imageBarrier, &srcStages, &dstStages, &imageMemoryBarrier);
+                                else
+                                    needed = thsvsGetVulkanImageMemoryBarriersFast(1, &imageBarrier, &srcStages, &dstStages, &imageMemoryBarrier);
+                            }
+
+                            if (needed != expected.needed || srcStages != expected.srcStages || dstStages != expected.dstStages ||
+                                imageMemoryBarrier.srcAccessMask != expected.srcAccessMask ||
+                                imageMemoryBarrier.dstAccessMask != expected.dstAccessMask ||
+                                imageMemoryBarrier.oldLayout != expected.oldLayout ||
+                                imageMemoryBarrier.newLayout != expected.newLayout)
+                                reference_report(&failureCount, "Image", "differs from the reference", prev, next, prevLayout, nextLayout);
+                        }
+
+                        pInvalid = reference_valid_usage(next, srcStages, dstStages, imageMemoryBarrier.srcAccessMask,
+                                                         imageMemoryBarrier.dstAccessMask, 1, imageMemoryBarrier.newLayout);
+                        if (pInvalid != NULL)
+                            reference_report(&failureCount, "Image", pInvalid, prev, next, prevLayout, nextLayout);
+                    }
+                }
+            }
+        }
+    }
+
+    if (failureCount > 10)
+        printf("\t... and %u more\n", failureCount - 10);
+
+    if (failureCount == 0)
+        printf("\tPASSED\n");
+    else
+        printf("\tFAILED\n");
+}
+
+void fast_barrier_test(const char* testName)
+{
+    unsigned int testPassed = 1;
+
+    printf("Test: %s\n", testName);
+
+    // Every pair of access types, as global, buffer and image barriers
+    for (uint32_t prev = 0; prev < THSVS_NUM_ACCESS_TYPES; ++prev)
+    {
+        for (uint32_t next = 0; next < THSVS_NUM_ACCESS_TYPES; ++next)
+        {
+            ThsvsAccessType prevAccess = (ThsvsAccessType)prev;
+            ThsvsAccessType nextAccess = (ThsvsAccessType)next;
+
+            VkPipelineStageFlags srcStages = 0;
+            VkPipelineStageFlags dstStages = 0;
+            VkPipelineStageFlags fastSrcStages = 0;
+            VkPipelineStageFlags fastDstStages = 0;
+
+            ThsvsGlobalBarrier globalBarrier = {1, &prevAccess, 1, &nextAccess};
+            VkMemoryBarrier memoryBarrier;
+            VkMemoryBarrier fastMemoryBarrier;
+            VkBool32 needed = thsvsGetVulkanMemoryBarrier(globalBarrier, &srcStages, &dstStages, &memoryBarrier);
+            VkBool32 fastNeeded = thsvsGetVulkanMemoryBarrierFast(globalBarrier, &fastSrcStages, &fastDstStages, &fastMemoryBarrier);
+
+            if (needed != fastNeeded || srcStages != fastSrcStages || dstStages != fastDstStages ||
+                memoryBarrier.srcAccessMask != fastMemoryBarrier.srcAccessMask ||
+                memoryBarrier.dstAccessMask != fastMemoryBarrier.dstAccessMask)
+            {
+                printf("\tGlobal barrier %u -> %u differs\n", prev, next);
+                testPassed = 0;
+            }
+
+            ThsvsBufferBarrier bufferBarrier = {1, &prevAccess, 1, &nextAccess, 0, 1, 0, 0, VK_WHOLE_SIZE};
+            VkBufferMemoryBarrier bufferMemoryBarrier;
+            VkBufferMemoryBarrier fastBufferMemoryBarrier;
+            needed = thsvsGetVulkanBufferMemoryBarrier(bufferBarrier, &srcStages, &dstStages, &bufferMemoryBarrier);
+            fastNeeded = thsvsGetVulkanBufferMemoryBarrierFast(bufferBarrier, &fastSrcStages, &fastDstStages, &fastBufferMemoryBarrier);
+
+            if (needed != fastNeeded || srcStages != fastSrcStages || dstStages != fastDstStages ||
+                bufferMemoryBarrier.srcAccessMask != fastBufferMemoryBarrier.srcAccessMask ||
+                bufferMemoryBarrier.dstAccessMask != fastBufferMemoryBarrier.dstAccessMask ||
+                fastBufferMemoryBarrier.dstQueueFamilyIndex != 1)
+            {
+                printf("\tBuffer barrier %u -> %u differs\n", prev, next);
+                testPassed = 0;
+            }
+
+            ThsvsImageBarrier imageBarrier = {1, &prevAccess, 1, &nextAccess,
+                                              THSVS_IMAGE_LAYOUT_OPTIMAL, THSVS_IMAGE_LAYOUT_GENERAL,
+                                              (next % 2 == 0) ? VK_TRUE : VK_FALSE,
+                                              VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, 0,
+                                              {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}};
+            VkImageMemoryBarrier imageMemoryBarrier;
+            VkImageMemoryBarrier fastImageMemoryBarrier;
+            needed = thsvsGetVulkanImageMemoryBarrier(imageBarrier, &srcStages, &dstStages, &imageMemoryBarrier);
+            fastNeeded = thsvsGetVulkanImageMemoryBarrierFast(imageBarrier, &fastSrcStages, &fastDstStages, &fastImageMemoryBarrier);
+
+            if (needed != fastNeeded || srcStages != fastSrcStages || dstStages != fastDstStages ||
+                imageMemoryBarrier.srcAccessMask != fastImageMemoryBarrier.srcAccessMask ||
+                imageMemoryBarrier.dstAccessMask != fastImageMemoryBarrier.dstAccessMask ||
+                imageMemoryBarrier.oldLayout != fastImageMemoryBarrier.oldLayout ||
+                imageMemoryBarrier.newLayout != fastImageMemoryBarrier.newLayout)
+            {
+                printf("\tImage barrier %u -> %u differs\n", prev, next);
+                testPassed = 0;
+            }
+        }
+    }
+
+    if (testPassed == 1)
+        printf("\tPASSED\n");
+    else
+        printf("\tFAILED\n");
+}
+
+typedef struct RecordedPasses {
+    uint32_t passCount;
+    uint32_t passIndices[4];
+} RecordedPasses;
+
+void record_pass(VkCommandBuffer commandBuffer, uint32_t passIndex, void* pUserData)
+{
+    (void)commandBuffer;
+    RecordedPasses* pRecorded = (RecordedPasses*)pUserData;
+    pRecorded->passIndices[pRecorded->passCount++] = passIndex;
+}
+
+void frame_graph_test(const char* testName)
+{
+    ThsvsBufferState bufferState;
+    ThsvsImageState imageState;
+    ThsvsBarrierBatch batch;
+    VkBufferMemoryBarrier bufferBarriers[4];
+    VkImageMemoryBarrier imageBarriers[4];
+    uint32_t passOrder[4];
+    uint32_t passLevels[4];
+    RecordedPasses recorded = {0, {0}};
+    unsigned int testPassed = 1;
+
+    VkImageSubresourceRange range;
+    range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    range.baseMipLevel = 0;
+    range.levelCount = 1;
+    range.baseArrayLayer = 0;
+    range.layerCount = 1;
+
+    thsvsInitBufferState(&bufferState, VK_NULL_HANDLE, 0, VK_WHOLE_SIZE);
+    thsvsInitImageState(&imageState, VK_NULL_HANDLE, range, VK_IMAGE_LAYOUT_UNDEFINED);
+    thsvsInitBarrierBatch(&batch, VK_NULL_HANDLE, 4, bufferBarriers, 4, imageBarriers);
+
+    printf("Test: %s\n", testName);
+
+    ThsvsAccessType computeWrite = THSVS_ACCESS_COMPUTE_SHADER_WRITE;
+    ThsvsAccessType transferWrite = THSVS_ACCESS_TRANSFER_WRITE;
+    ThsvsAccessType fragmentRead = THSVS_ACCESS_FRAGMENT_SHADER_READ_OTHER;
+    ThsvsAccessType computeSampled = THSVS_ACCESS_COMPUTE_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER;
+    ThsvsAccessType fragmentSampled = THSVS_ACCESS_FRAGMENT_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER;
+
+    ThsvsPassAccess bufferWrite = {&bufferState, NULL, 1, &computeWrite, THSVS_IMAGE_LAYOUT_OPTIMAL, VK_FALSE};
+    ThsvsPassAccess bufferRead = {&bufferState, NULL, 1, &fragmentRead, THSVS_IMAGE_LAYOUT_OPTIMAL, VK_FALSE};
+    ThsvsPassAccess imageWrite = {NULL, &imageState, 1, &transferWrite, THSVS_IMAGE_LAYOUT_OPTIMAL, VK_TRUE};
+    ThsvsPassAccess imageReads[2] = {{NULL, &imageState, 1, &computeSampled, THSVS_IMAGE_LAYOUT_OPTIMAL, VK_FALSE},
+                                     {NULL, &imageState, 1, &fragmentSampled, THSVS_IMAGE_LAYOUT_OPTIMAL, VK_FALSE}};
+
+    // In this order, each pass would need a barrier before it
+    ThsvsPass passes[4] = {{1, &bufferWrite}, {1, &bufferRead}, {1, &imageWrite}, {2, imageReads}};
+
+    uint32_t levelCount = thsvsScheduleFrameGraph(4, passes, passOrder, passLevels);
+    if (levelCount != 2 ||
+        passOrder[0] != 0 || passOrder[1] != 2 || passOrder[2] != 1 || passOrder[3] != 3 ||
+        passLevels[0] != 0 || passLevels[1] != 1 || passLevels[2] != 0 || passLevels[3] != 1)
+    {
+        printf("\tIndependent passes weren't scheduled together\n");
+        testPassed = 0;
+    }
+
+    thsvsCmdExecuteFrameGraph(&batch, NULL, 4, passes, passOrder, passLevels, record_pass, &recorded);
+    if (recorded.passCount != 4 ||
+        recorded.passIndices[0] != 0 || recorded.passIndices[1] != 2 ||
+        recorded.passIndices[2] != 1 || recorded.passIndices[3] != 3 ||
+        batch.srcStageMask != 0)
+    {
+        printf("\tPasses weren't recorded in schedule order\n");
+        testPassed = 0;
+    }
+
+    // Both reads of the image in the last level were transitioned together
+    if ((bufferState.readStageMask & VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT) == 0 ||
+        imageState.layout != VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL ||
+        imageState.readStageMask != (VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT))
+    {
+        printf("\tStates weren't transitioned for the scheduled passes\n");
+        testPassed = 0;
+    }
+
+    if (testPassed == 1)
+        printf("\tPASSED\n");
+    else
+        printf("\tFAILED\n");
+}
+
+#ifdef THSVS_DIAGNOSTICS
+void count_diagnostic(ThsvsDiagnosticType type, const char* pMessage, void* pUserData)
+{
+    (void)pMessage;
+    ((unsigned int*)pUserData)[type]++;
+}
+
+void diagnostics_test(const char* testName)
+{
+    unsigned int diagnosticCounts[THSVS_NUM_DIAGNOSTIC_TYPES] = {0};
+    unsigned int testPassed = 1;
+
+    thsvsSetDiagnosticCallback(count_diagnostic, diagnosticCounts);
+
+    printf("Test: %s\n", testName);
+
+    ThsvsAccessType general = THSVS_ACCESS_GENERAL;
+    ThsvsAccessType computeWrite = THSVS_ACCESS_COMPUTE_SHADER_WRITE;
+    ThsvsAccessType fragmentRead = THSVS_ACCESS_FRAGMENT_SHADER_READ_OTHER;
+
+    ThsvsGlobalBarrier generalBarrier = {1, &general, 1, &fragmentRead};
+    thsvsCmdPipelineBarrier(VK_NULL_HANDLE, &generalBarrier, 0, NULL, 0, NULL);
+    if (diagnosticCounts[THSVS_DIAGNOSTIC_NARROWER_ACCESS_TYPE] != 1)
+    {
+        printf("\tTHSVS_ACCESS_GENERAL wasn't reported\n");
+        testPassed = 0;
+    }
+
+    ThsvsImageBarrier imageBarrier;
+    imageBarrier.prevAccessCount = 1;
+    imageBarrier.pPrevAccesses = &computeWrite;
+    imageBarrier.nextAccessCount = 1;
+    imageBarrier.pNextAccesses = &fragmentRead;
+    imageBarrier.prevLayout = THSVS_IMAGE_LAYOUT_GENERAL;
+    imageBarrier.nextLayout = THSVS_IMAGE_LAYOUT_GENERAL;
+    imageBarrier.discardContents = VK_FALSE;
+    imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    imageBarrier.image = VK_NULL_HANDLE;
+    imageBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    imageBarrier.subresourceRange.baseArrayLayer = 0;
+    imageBarrier.subresourceRange.layerCount = 1;
+    imageBarrier.subresourceRange.baseMipLevel = 0;
+    imageBarrier.subresourceRange.levelCount = 1;
+
+    thsvsCmdPipelineBarrier(VK_NULL_HANDLE, NULL, 0, NULL, 1, &imageBarrier);
+    if (diagnosticCounts[THSVS_DIAGNOSTIC_GLOBAL_BARRIER] != 1 ||
+        diagnosticCounts[THSVS_DIAGNOSTIC_MERGEABLE_BARRIERS] != 0)
+    {
+        printf("\tImage barrier without a transition wasn't reported\n");
+        testPassed = 0;
+    }
+
+    // Sequences are only tracked once other commands are reported
+    ThsvsGlobalBarrier globalBarrier = {1, &computeWrite, 1, &fragmentRead};
+    thsvsDiagnoseCommand(VK_NULL_HANDLE);
+    thsvsCmdPipelineBarrier(VK_NULL_HANDLE, &globalBarrier, 0, NULL, 0, NULL);
+    thsvsDiagnoseCommand(VK_NULL_HANDLE);
+    thsvsCmdPipelineBarrier(VK_NULL_HANDLE, &globalBarrier, 0, NULL, 0, NULL);
+    if (diagnosticCounts[THSVS_DIAGNOSTIC_MERGEABLE_BARRIERS] != 0)
+    {
+        printf("\tBarriers separated by other commands were reported as mergeable\n");
+        testPassed = 0;
+    }
+
+    thsvsCmdPipelineBarrier(VK_NULL_HANDLE, &globalBarrier, 0, NULL, 0, NULL);
+    if (diagnosticCounts[THSVS_DIAGNOSTIC_MERGEABLE_BARRIERS] != 1 ||
+        diagnosticCounts[THSVS_DIAGNOSTIC_NARROWER_ACCESS_TYPE] != 1 ||
+        diagnosticCounts[THSVS_DIAGNOSTIC_GLOBAL_BARRIER] != 1)
+    {
+        printf("\tSequential barriers weren't reported as mergeable\n");
+        testPassed = 0;
+    }
+
+    thsvsSetDiagnosticCallback(NULL, NULL);
+
+    if (testPassed == 1)
+        printf("\tPASSED\n");
+    else
+        printf("\tFAILED\n");
+}
+#endif
+
+#ifdef THSVS_CAPTURE
+void capture_test(const char* testName)
+{
+    char captureMemory[512];
+    ThsvsCapture capture;
+    unsigned int testPassed = 1;
+
+    thsvsInitCapture(&capture, captureMemory, sizeof(captureMemory));
+    thsvsSetThreadCapture(&capture);
+
+    printf("Test: %s\n", testName);
+
+    ThsvsAccessType colorWrite = THSVS_ACCESS_COLOR_ATTACHMENT_WRITE;
+    ThsvsAccessType fragmentRead = THSVS_ACCESS_FRAGMENT_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER;
+    ThsvsImageBarrier imageBarrier = {1, &colorWrite, 1, &fragmentRead,
+                                      THSVS_IMAGE_LAYOUT_OPTIMAL, THSVS_IMAGE_LAYOUT_OPTIMAL, VK_FALSE,
+                                      VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, 0,
+                                      {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}};
+
+    thsvsCaptureBeginPass(3, "lighting");
+    thsvsCmdPipelineBarrier(VK_NULL_HANDLE, NULL, 0, NULL, 1, &imageBarrier);
+
+    char data[1024];
+    size_t dataSize = thsvsGetCaptureData(&capture, data, sizeof(data));
+
+    ThsvsCaptureHeader header;
+    ThsvsCaptureRecord passRecord;
+    ThsvsCaptureRecord barrierRecord;
+    ThsvsCaptureBarrier barrier;
+    memcpy(&header, data, sizeof(header));
+    memcpy(&passRecord, data + sizeof(header), sizeof(passRecord));
+    memcpy(&barrierRecord, data + sizeof(header) + passRecord.size, sizeof(barrierRecord));
+    memcpy(&barrier, data + sizeof(header) + passRecord.size + sizeof(barrierRecord), sizeof(barrier));
+    const char* pAccessBytes = data + sizeof(header) + passRecord.size + sizeof(barrierRecord) + sizeof(barrier);
+
+    if (header.magic != THSVS_CAPTURE_MAGIC ||
+        header.recordCount != 2 ||
+        passRecord.type != THSVS_CAPTURE_RECORD_PASS ||
+        passRecord.srcStageMask != 3 ||
+        strcmp(data + sizeof(header) + sizeof(passRecord), "lighting") != 0 ||
+        dataSize != sizeof(header) + passRecord.size + barrierRecord.size)
+    {
+        printf("\tThe pass wasn't captured\n");
+        testPassed = 0;
+    }
+
+    if (barrierRecord.type != THSVS_CAPTURE_RECORD_PIPELINE_BARRIER ||
+        barrierRecord.barrierCount != 1 ||
+        barrierRecord.timestamp < passRecord.timestamp ||
+        (barrierRecord.srcStageMask & VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT) == 0 ||
+        barrier.type != THSVS_CAPTURE_BARRIER_IMAGE ||
+        barrier.prevAccessCount != 1 || barrier.nextAccessCount != 1 ||
+        pAccessBytes[0] != (char)colorWrite || pAccessBytes[1] != (char)fragmentRead ||
+        barrier.srcAccessMask != VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT ||
+        barrier.dstAccessMask != VK_ACCESS_SHADER_READ_BIT ||
+        barrier.oldLayout != VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL ||
+        barrier.newLayout != VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+    {
+        printf("\tThe barrier wasn't captured with its translation\n");
+        testPassed = 0;
+    }
+
+    // Overflow the ring - only the newest records remain, in order
+    for (uint32_t i = 0; i < 50; ++i)
+        thsvsCmdPipelineBarrier(VK_NULL_HANDLE, NULL, 0, NULL, 1, &imageBarrier);
+
+    dataSize = thsvsGetCaptureData(&capture, data, sizeof(data));
+    memcpy(&header, data, sizeof(header));
+
+    size_t offset = sizeof(header);
+    uint64_t lastTimestamp = 0;
+    for (uint32_t i = 0; i < header.recordCount && offset < dataSize; ++i)
+    {
+        ThsvsCaptureRecord record;
+        memcpy(&record, data + offset, sizeof(record));
+        if (record.type != THSVS_CAPTURE_RECORD_PIPELINE_BARRIER || record.timestamp < lastTimestamp)
+            break;
+        lastTimestamp = record.timestamp;
+        offset += record.size;
+    }
+
+    if (header.recordCount == 0 ||
+        header.recordCount + header.droppedRecordCount != 52 ||
+        offset != dataSize ||
+        dataSize > sizeof(captureMemory) + sizeof(header))
+    {
+        printf("\tThe oldest records weren't overwritten in order\n");
+        testPassed = 0;
+    }
+
+    // Batches only have Vulkan barriers left by the time they're recorded
+    VkImageMemoryBarrier batchStorage[1];
+    ThsvsBarrierBatch batch;
+    thsvsInitBarrierBatch(&batch, VK_NULL_HANDLE, 0, NULL, 1, batchStorage);
+    thsvsBatchPipelineBarrier(&batch, NULL, 0, NULL, 1, &imageBarrier);
+
+    thsvsResetCapture(&capture);
+    thsvsCmdFlushBarrierBatch(&batch);
+
+    dataSize = thsvsGetCaptureData(&capture, data, sizeof(data));
+    memcpy(&header, data, sizeof(header));
+    memcpy(&barrierRecord, data + sizeof(header), sizeof(barrierRecord));
+    memcpy(&barrier, data + sizeof(header) + sizeof(barrierRecord), sizeof(barrier));
+
+    if (header.recordCount != 1 ||
+        barrierRecord.type != THSVS_CAPTURE_RECORD_PIPELINE_BARRIER ||
+        barrierRecord.barrierCount != 1 ||
+        (barrier.flags & THSVS_CAPTURE_BARRIER_NO_ACCESS_TYPES_BIT) == 0 ||
+        barrier.prevAccessCount != 0 || barrier.nextAccessCount != 0 ||
+        barrier.oldLayout != VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL ||
+        barrier.newLayout != VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+    {
+        printf("\tThe batch wasn't captured with its Vulkan barriers\n");
+        testPassed = 0;
+    }
+
+    // Every event's barriers are captured in the one wait
+    ThsvsGlobalBarrier globalBarrier = {1, &colorWrite, 1, &fragmentRead};
+    ThsvsEventBarrier eventBarriers[2] = {
+        {VK_NULL_HANDLE, &globalBarrier, 0, NULL, 0, NULL},
+        {VK_NULL_HANDLE, NULL, 0, NULL, 1, &imageBarrier}};
+
+    thsvsResetCapture(&capture);
+    thsvsCmdWaitEventBarriers(VK_NULL_HANDLE, NULL, 2, eventBarriers);
+
+    dataSize = thsvsGetCaptureData(&capture, data, sizeof(data));
+    memcpy(&header, data, sizeof(header));
+    memcpy(&barrierRecord, data + sizeof(header), sizeof(barrierRecord));
+    memcpy(&barrier, data + sizeof(header) + sizeof(barrierRecord), sizeof(barrier));
+
+    if (header.recordCount != 1 ||
+        barrierRecord.type != THSVS_CAPTURE_RECORD_WAIT_EVENTS ||
+        barrierRecord.barrierCount != 2 ||
+        barrier.type != THSVS_CAPTURE_BARRIER_GLOBAL ||
+        (barrier.flags & THSVS_CAPTURE_BARRIER_NO_ACCESS_TYPES_BIT) != 0 ||
+        barrier.prevAccessCount != 1 || barrier.nextAccessCount != 1)
+    {
+        printf("\tThe event barriers weren't captured with their access types\n");
+        testPassed = 0;
+    }
+
+#ifdef VK_VERSION_1_3
+    // Synchronization2 has no legacy stage masks, so the record gets the translated ones
+    thsvsResetCapture(&capture);
+    thsvsCmdPipelineBarrier2(VK_NULL_HANDLE, NULL, 0, NULL, 1, &imageBarrier);
+
+    dataSize = thsvsGetCaptureData(&capture, data, sizeof(data));
+    memcpy(&header, data, sizeof(header));
+    memcpy(&barrierRecord, data + sizeof(header), sizeof(barrierRecord));
+
+    if (header.recordCount != 1 ||
+        barrierRecord.barrierCount != 1 ||
+        barrierRecord.srcStageMask != VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT ||
+        barrierRecord.dstStageMask != VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT)
+    {
+        printf("\tThe synchronization2 barrier wasn't captured\n");
+        testPassed = 0;
+    }
+#endif
+
+    thsvsSetThreadCapture(NULL);
+
+    if (testPassed == 1)
+        printf("\tPASSED\n");
+    else
+        printf("\tFAILED\n");
+}
+#endif
+
+#ifdef THSVS_PROFILE
+void profiler_test(const char* testName)
+{
+    ThsvsProfilerFrame frames[2];
+    ThsvsProfileTag tags[2 * 2];
+    ThsvsTransitionCost transitions[4];
+    ThsvsProfiler profiler;
+    unsigned int testPassed = 1;
+
+    printf("Test: %s\n", testName);
+
+    if (thsvsCreateProfiler(&profiler, VK_NULL_HANDLE, 1.0f, 2, 2, frames, tags, 4, transitions) != VK_SUCCESS)
+    {
+        printf("\tThe profiler couldn't be created\n");
+        printf("\tFAILED\n");
+        return;
+    }
+
+    thsvsSetThreadProfiler(&profiler);
+
+    ThsvsAccessType colorWrite = THSVS_ACCESS_COLOR_ATTACHMENT_WRITE;
+    ThsvsAccessType fragmentRead = THSVS_ACCESS_FRAGMENT_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER;
+    ThsvsAccessType computeWrite = THSVS_ACCESS_COMPUTE_SHADER_WRITE;
+    ThsvsAccessType indirectRead = THSVS_ACCESS_INDIRECT_BUFFER;
+    ThsvsImageBarrier imageBarriers[2] = {
+        {1, &fragmentRead, 1, &fragmentRead,
+         THSVS_IMAGE_LAYOUT_OPTIMAL, THSVS_IMAGE_LAYOUT_OPTIMAL, VK_FALSE,
+         VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, 0,
+         {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}},
+        {1, &colorWrite, 1, &fragmentRead,
+         THSVS_IMAGE_LAYOUT_OPTIMAL, THSVS_IMAGE_LAYOUT_OPTIMAL, VK_FALSE,
+         VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, 0,
+         {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}}};
+    ThsvsBufferBarrier bufferBarrier = {1, &computeWrite, 1, &indirectRead,
+                                        VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, 0, 0, VK_WHOLE_SIZE};
+
+    // The third barrier doesn't fit in the frame, so isn't timed
+    thsvsCmdBeginProfilerFrame(&profiler, VK_NULL_HANDLE);
+    thsvsCmdPipelineBarrier(VK_NULL_HANDLE, NULL, 0, NULL, 2, imageBarriers);
+    thsvsCmdPipelineBarrier(VK_NULL_HANDLE, NULL, 1, &bufferBarrier, 0, NULL);
+    thsvsCmdPipelineBarrier(VK_NULL_HANDLE, NULL, 1, &bufferBarrier, 0, NULL);
+
+    // Results for a frame are read once it's recycled
+    const ThsvsTransitionCost* pCosts = NULL;
+    thsvsCmdBeginProfilerFrame(&profiler, VK_NULL_HANDLE);
+    uint32_t costCount = thsvsGetTransitionCosts(&profiler, &pCosts);
+    thsvsCmdBeginProfilerFrame(&profiler, VK_NULL_HANDLE);
+
+    if (costCount != 0 || frames[0].barrierCount != 0 || profiler.droppedBarrierCount != 1)
+    {
+        printf("\tThe frame's barriers weren't timed until its queries were recycled\n");
+        testPassed = 0;
+    }
+
+    costCount = thsvsGetTransitionCosts(&profiler, &pCosts);
+
+    const ThsvsTransitionCost* pImageCost = NULL;
+    const ThsvsTransitionCost* pBufferCost = NULL;
+    unsigned int sorted = 1;
+    for (uint32_t i = 0; i < costCount; ++i)
+    {
+        if (pCosts[i].tag.newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+            pImageCost = &pCosts[i];
+        else
+            pBufferCost = &pCosts[i];
+        if (i > 0 && pCosts[i].totalMicroseconds > pCosts[i - 1].totalMicroseconds)
+            sorted = 0;
+    }
+
+    if (costCount != 2 || pImageCost == NULL || pBufferCost == NULL || sorted == 0 ||
+        pImageCost->count != 1 || pBufferCost->count != 1)
+    {
+        printf("\tEach transition wasn't reported once, most expensive first\n");
+        testPassed = 0;
+    }
+    else if (pImageCost->tag.prevAccess != colorWrite || pImageCost->tag.nextAccess != fragmentRead ||
+             pImageCost->tag.oldLayout != VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL ||
+             pBufferCost->tag.prevAccess != computeWrite || pBufferCost->tag.nextAccess != indirectRead ||
+             pBufferCost->tag.oldLayout != VK_IMAGE_LAYOUT_UNDEFINED)
+    {
+        printf("\tBarriers weren't tagged with the transition they make\n");
+        testPassed = 0;
+    }
+
+    // Batches only have their layouts left to tag them with by the time they're recorded
+    VkImageMemoryBarrier batchStorage[1];
+    ThsvsBarrierBatch batch;
+    thsvsInitBarrierBatch(&batch, VK_NULL_HANDLE, 0, NULL, 1, batchStorage);
+    thsvsBatchPipelineBarrier(&batch, NULL, 0, NULL, 1, &imageBarriers[1]);
+
+    thsvsCmdBeginProfilerFrame(&profiler, VK_NULL_HANDLE);
+    thsvsCmdFlushBarrierBatch(&batch);
+    thsvsCmdBeginProfilerFrame(&profiler, VK_NULL_HANDLE);
+    thsvsCmdBeginProfilerFrame(&profiler, VK_NULL_HANDLE);
+
+    costCount = thsvsGetTransitionCosts(&profiler, &pCosts);
+
+    const ThsvsTransitionCost* pBatchCost = NULL;
+    for (uint32_t i = 0; i < costCount; ++i)
+    {
+        if (pCosts[i].tag.prevAccess == THSVS_ACCESS_NONE && pCosts[i].tag.nextAccess == THSVS_ACCESS_NONE)
+            pBatchCost = &pCosts[i];
+    }
+
+    if (costCount != 3 || pBatchCost == NULL || pBatchCost->count != 1 ||
+        pBatchCost->tag.oldLayout != VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL ||
+        pBatchCost->tag.newLayout != VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+    {
+        printf("\tA flushed batch wasn't timed and tagged with its layouts\n");
+        testPassed = 0;
+    }
+
+    thsvsSetThreadProfiler(NULL);
+    thsvsDestroyProfiler(&profiler);
+
+    if (testPassed == 1)
+        printf("\tPASSED\n");
+    else
+        printf("\tFAILED\n");
+}
+#endif
+
+void subresource_map_test(const char* testName)
+{
+    ThsvsSubresourceState states[8];
+    ThsvsImageSubresourceMap map;
+    VkPipelineStageFlags srcStageMask = 0;
+    VkPipelineStageFlags dstStageMask = 0;
+    VkImageMemoryBarrier barriers[8];
+    unsigned int testPassed = 1;
+
+    // 4 mip levels, 2 array layers
+    thsvsInitImageSubresourceMap(&map, VK_NULL_HANDLE, VK_IMAGE_ASPECT_COLOR_BIT, 4, 2, states, VK_IMAGE_LAYOUT_UNDEFINED);
+
+    printf("Test: %s\n", testName);
+
+    ThsvsAccessType transferWrite = THSVS_ACCESS_TRANSFER_WRITE;
+    ThsvsAccessType transferRead = THSVS_ACCESS_TRANSFER_READ;
+    ThsvsAccessType fragmentRead = THSVS_ACCESS_FRAGMENT_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER;
+
+    VkImageSubresourceRange wholeImage = {VK_IMAGE_ASPECT_COLOR_BIT, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS};
+    VkImageSubresourceRange firstMip = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 2};
+
+    // Every subresource makes the same transition, so one barrier covers all of them
+    uint32_t barrierCount = thsvsTransitionImageSubresources(&map, wholeImage, 1, &transferWrite, THSVS_IMAGE_LAYOUT_OPTIMAL, VK_TRUE,
+                                                             &srcStageMask, &dstStageMask, barriers);
+    if (barrierCount != 1 ||
+        barriers[0].subresourceRange.baseMipLevel != 0 || barriers[0].subresourceRange.levelCount != 4 ||
+        barriers[0].subresourceRange.baseArrayLayer != 0 || barriers[0].subresourceRange.layerCount != 2 ||
+        barriers[0].newLayout != VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
+    {
+        printf("\tInitial transition was not merged into a single barrier\n");
+        testPassed = 0;
+    }
+
+    barrierCount = thsvsTransitionImageSubresources(&map, firstMip, 1, &transferRead, THSVS_IMAGE_LAYOUT_OPTIMAL, VK_FALSE,
+                                                    &srcStageMask, &dstStageMask, barriers);
+    if (barrierCount != 1 ||
+        barriers[0].subresourceRange.levelCount != 1 ||
+        barriers[0].oldLayout != VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL ||
+        barriers[0].newLayout != VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL)
+    {
+        printf("\tFirst mip transition produced unexpected barriers\n");
+        testPassed = 0;
+    }
+
+    // The first mip and the rest are in different layouts, so need a barrier each
+    barrierCount = thsvsTransitionImageSubresources(&map, wholeImage, 1, &fragmentRead, THSVS_IMAGE_LAYOUT_OPTIMAL, VK_FALSE,
+                                                    &srcStageMask, &dstStageMask, barriers);
+    if (barrierCount != 2 ||
+        barriers[0].oldLayout != VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL ||
+        barriers[0].subresourceRange.baseMipLevel != 0 || barriers[0].subresourceRange.levelCount != 1 ||
+        barriers[0].subresourceRange.layerCount != 2 ||
+        barriers[1].oldLayout != VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL ||
+        barriers[1].subresourceRange.baseMipLevel != 1 || barriers[1].subresourceRange.levelCount != 3 ||
+        barriers[1].subresourceRange.layerCount != 2 ||
+        dstStageMask != VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT)
+    {
+        printf("\tMixed transition produced %u unexpected barriers\n", barrierCount);
+        testPassed = 0;
+    }
+
+    // Everything is now read in the same way, so nothing further is needed
+    barrierCount = thsvsTransitionImageSubresources(&map, wholeImage, 1, &fragmentRead, THSVS_IMAGE_LAYOUT_OPTIMAL, VK_FALSE,
+                                                    &srcStageMask, &dstStageMask, barriers);
+    if (barrierCount != 0)
+    {
+        printf("\tRead after read produced a barrier\n");
+        testPassed = 0;
+    }
+
+    // Batching clamps the remaining levels to the map rather than underflowing
+    ThsvsBarrierBatch batch;
+    thsvsInitBarrierBatch(&batch, VK_NULL_HANDLE, 0, NULL, 8, barriers);
+    VkImageSubresourceRange pastLastMip = {VK_IMAGE_ASPECT_COLOR_BIT, 5, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS};
+    VkImageSubresourceRange lastMip = {VK_IMAGE_ASPECT_COLOR_BIT, 3, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS};
+    thsvsBatchImageSubresources(&batch, &map, pastLastMip, 1, &transferWrite, THSVS_IMAGE_LAYOUT_OPTIMAL, VK_FALSE);
+    thsvsBatchImageSubresources(&batch, &map, lastMip, 1, &transferWrite, THSVS_IMAGE_LAYOUT_OPTIMAL, VK_FALSE);
+    if (batch.imageBarrierCount != 1 ||
+        batch.pImageBarriers[0].subresourceRange.baseMipLevel != 3 ||
+        batch.pImageBarriers[0].subresourceRange.levelCount != 1)
+    {
+        printf("\tBatched remaining levels produced unexpected barriers\n");
+        testPassed = 0;
+    }
+
+    if (testPassed == 1)
+        printf("\tPASSED\n");
+    else
+        printf("\tFAILED\n");
+}
+
+void barrier_needed_test(const char* testName)
+{
+    VkPipelineStageFlags srcStageMask = 0;
+    VkPipelineStageFlags dstStageMask = 0;
+    VkMemoryBarrier memoryBarrier;
+    VkImageMemoryBarrier imageBarrier;
     unsigned int testPassed = 1;
-    
-    thsvsGetVulkanMemoryBarrier(barrier, &srcStages, &dstStages, &vkBarrier);
 
     printf("Test: %s\n", testName);
-    
-    if (srcStages != expectedSrcStageMask)
+
+    ThsvsAccessType computeWrite = THSVS_ACCESS_COMPUTE_SHADER_WRITE;
+    ThsvsAccessType computeRead = THSVS_ACCESS_COMPUTE_SHADER_READ_OTHER;
+    ThsvsAccessType fragmentRead = THSVS_ACCESS_FRAGMENT_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER;
+    ThsvsAccessType transferRead = THSVS_ACCESS_TRANSFER_READ;
+
+    ThsvsGlobalBarrier readAfterRead = {1, &computeRead, 1, &fragmentRead};
+    ThsvsGlobalBarrier readAfterWrite = {1, &computeWrite, 1, &computeRead};
+    ThsvsGlobalBarrier writeAfterRead = {1, &computeRead, 1, &computeWrite};
+
+    if (thsvsGetVulkanMemoryBarrier(readAfterRead, &srcStageMask, &dstStageMask, &memoryBarrier) != VK_FALSE ||
+        thsvsGetVulkanMemoryBarrier(readAfterWrite, &srcStageMask, &dstStageMask, &memoryBarrier) != VK_TRUE ||
+        thsvsGetVulkanMemoryBarrier(writeAfterRead, &srcStageMask, &dstStageMask, &memoryBarrier) != VK_TRUE)
     {
-        printf("\tUnexpected source stage %0#10X\n", srcStages);
+        printf("\tUnexpected result for a global barrier\n");
         testPassed = 0;
     }
 
-    if (dstStages != expectedDstStageMask)
+    ThsvsImageBarrier sameLayout = {
+        1, &fragmentRead, 1, &fragmentRead,
+        THSVS_IMAGE_LAYOUT_OPTIMAL, THSVS_IMAGE_LAYOUT_OPTIMAL,
+        VK_FALSE, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, VK_NULL_HANDLE,
+        {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}};
+
+    ThsvsImageBarrier layoutTransition = sameLayout;
+    layoutTransition.pNextAccesses = &transferRead;
+
+    if (thsvsGetVulkanImageMemoryBarrier(sameLayout, &srcStageMask, &dstStageMask, &imageBarrier) != VK_FALSE ||
+        thsvsGetVulkanImageMemoryBarrier(layoutTransition, &srcStageMask, &dstStageMask, &imageBarrier) != VK_TRUE)
     {
-        printf("\tUnexpected destination stage %0#10X\n", dstStages);
+        printf("\tUnexpected result for an image barrier\n");
         testPassed = 0;
     }
-    
-    if (vkBarrier.srcAccessMask != expectedSrcAccessMask)
+
+    if (testPassed == 1)
+        printf("\tPASSED\n");
+    else
+        printf("\tFAILED\n");
+}
+
+void execution_barrier_test(const char* testName)
+{
+    VkPipelineStageFlags srcStageMask = 0;
+    VkPipelineStageFlags dstStageMask = 0;
+    unsigned int testPassed = 1;
+
+    printf("Test: %s\n", testName);
+
+    ThsvsAccessType transferWrite = THSVS_ACCESS_TRANSFER_WRITE;
+    ThsvsAccessType computeRead = THSVS_ACCESS_COMPUTE_SHADER_READ_OTHER;
+
+    ThsvsExecutionBarrier barrier = {1, &transferWrite, 1, &computeRead};
+    thsvsGetVulkanExecutionDependency(barrier, &srcStageMask, &dstStageMask);
+
+    if (srcStageMask != VK_PIPELINE_STAGE_TRANSFER_BIT ||
+        dstStageMask != VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT)
     {
-        printf("\tUnexpected source access mask %0#10X\n", vkBarrier.srcAccessMask);
+        printf("\tUnexpected stage masks: %u, %u\n", srcStageMask, dstStageMask);
         testPassed = 0;
     }
-    
-    if (vkBarrier.dstAccessMask != expectedDstAccessMask)
+
+    ThsvsExecutionBarrier emptyBarrier = {0, NULL, 0, NULL};
+    thsvsGetVulkanExecutionDependency(emptyBarrier, &srcStageMask, &dstStageMask);
+
+    if (srcStageMask != VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT ||
+        dstStageMask != VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT)
     {
-        printf("\tUnexpected destination access mask %0#10X\n", vkBarrier.dstAccessMask);
+        printf("\tUnexpected stage masks for an empty barrier: %u, %u\n", srcStageMask, dstStageMask);
         testPassed = 0;
     }
-    
+
     if (testPassed == 1)
         printf("\tPASSED\n");
     else
         printf("\tFAILED\n");
 }
 
-void global_barrier_test(const char* testName,
-                         ThsvsAccessType prevAccess,
-                         ThsvsAccessType nextAccess,
-                         VkPipelineStageFlags expectedSrcStageMask,
-                         VkPipelineStageFlags expectedDstStageMask,
-                         VkAccessFlags expectedSrcAccessMask,
-                         VkAccessFlags expectedDstAccessMask)
+void access_mask_test(const char* testName)
 {
-    global_barrier_test_array(testName, 1, &prevAccess, 1, &nextAccess, expectedSrcStageMask, expectedDstStageMask, expectedSrcAccessMask, expectedDstAccessMask);
+    unsigned int testPassed = 1;
+
+    printf("Test: %s\n", testName);
+
+    ThsvsAccessType prevAccesses[] = {THSVS_ACCESS_COMPUTE_SHADER_WRITE};
+    ThsvsAccessType nextAccesses[] = {THSVS_ACCESS_INDIRECT_BUFFER,
+                                      THSVS_ACCESS_FRAGMENT_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER,
+                                      THSVS_ACCESS_COMPUTE_SHADER_READ_OTHER};
+
+    VkImageSubresourceRange range = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+
+    ThsvsImageBarrier barrier = {1, prevAccesses, 1, &nextAccesses[1],
+                                 THSVS_IMAGE_LAYOUT_OPTIMAL, THSVS_IMAGE_LAYOUT_OPTIMAL, VK_FALSE,
+                                 VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, 0, range};
+
+    ThsvsMaskImageBarrier maskBarrier = {};
+    thsvsMakeAccessMask(1, prevAccesses, &maskBarrier.prevAccesses);
+    thsvsMakeAccessMask(1, &nextAccesses[1], &maskBarrier.nextAccesses);
+    maskBarrier.prevLayout          = THSVS_IMAGE_LAYOUT_OPTIMAL;
+    maskBarrier.nextLayout          = THSVS_IMAGE_LAYOUT_OPTIMAL;
+    maskBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    maskBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    maskBarrier.subresourceRange    = range;
+
+    VkPipelineStageFlags expectedSrcStages = 0;
+    VkPipelineStageFlags expectedDstStages = 0;
+    VkImageMemoryBarrier expected;
+    thsvsGetVulkanImageMemoryBarrier(barrier, &expectedSrcStages, &expectedDstStages, &expected);
+
+    VkPipelineStageFlags srcStages = 0;
+    VkPipelineStageFlags dstStages = 0;
+    VkImageMemoryBarrier actual;
+    thsvsGetVulkanMaskImageMemoryBarrier(maskBarrier, &srcStages, &dstStages, &actual);
+
+    if (srcStages != expectedSrcStages ||
+        dstStages != expectedDstStages ||
+        actual.srcAccessMask != expected.srcAccessMask ||
+        actual.dstAccessMask != expected.dstAccessMask ||
+        actual.oldLayout != expected.oldLayout ||
+        actual.newLayout != expected.newLayout)
+    {
+        printf("\tMask image barrier differs from the array one\n");
+        testPassed = 0;
+    }
+
+    // Host writes are in the second word of the mask
+    ThsvsAccessType hostWrite = THSVS_ACCESS_HOST_WRITE;
+    ThsvsGlobalBarrier globalBarrier = {1, &hostWrite, 3, nextAccesses};
+    ThsvsMaskGlobalBarrier maskGlobalBarrier;
+    thsvsMakeAccessMask(1, &hostWrite, &maskGlobalBarrier.prevAccesses);
+    thsvsMakeAccessMask(3, nextAccesses, &maskGlobalBarrier.nextAccesses);
+
+    VkMemoryBarrier expectedMemoryBarrier;
+    VkMemoryBarrier actualMemoryBarrier;
+    thsvsGetVulkanMemoryBarrier(globalBarrier, &expectedSrcStages, &expectedDstStages, &expectedMemoryBarrier);
+    thsvsGetVulkanMaskMemoryBarrier(maskGlobalBarrier, &srcStages, &dstStages, &actualMemoryBarrier);
+
+    if (maskGlobalBarrier.prevAccesses.bits[1] == 0 ||
+        srcStages != expectedSrcStages ||
+        dstStages != expectedDstStages ||
+        actualMemoryBarrier.srcAccessMask != expectedMemoryBarrier.srcAccessMask ||
+        actualMemoryBarrier.dstAccessMask != expectedMemoryBarrier.dstAccessMask)
+    {
+        printf("\tMask global barrier differs from the array one\n");
+        testPassed = 0;
+    }
+
+    if (testPassed == 1)
+        printf("\tPASSED\n");
+    else
+        printf("\tFAILED\n");
 }
 
-void image_barrier_test_array(const char* testName,
-                              unsigned int numPrevAccesses,
-                              ThsvsAccessType* prevAccesses,
-                              unsigned int numNextAccesses,
-                              ThsvsAccessType* nextAccesses,
-                              VkPipelineStageFlags expectedSrcStageMask,
-                              VkPipelineStageFlags expectedDstStageMask,
-                              VkAccessFlags expectedSrcAccessMask,
-                              VkAccessFlags expectedDstAccessMask,
-                              VkImageLayout expectedOldLayout,
-                              VkImageLayout expectedNewLayout)
+void image_barrier_array_test(const char* testName)
 {
-    ThsvsImageBarrier barrier = {numPrevAccesses, prevAccesses, numNextAccesses, nextAccesses};
-    
-    VkImageMemoryBarrier vkBarrier = { 0 };
+    unsigned int testPassed = 1;
+
+    printf("Test: %s\n", testName);
+
+    ThsvsAccessType accesses[] = {THSVS_ACCESS_COLOR_ATTACHMENT_WRITE,
+                                  THSVS_ACCESS_FRAGMENT_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER,
+                                  THSVS_ACCESS_COMPUTE_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER,
+                                  THSVS_ACCESS_TRANSFER_WRITE,
+                                  THSVS_ACCESS_PRESENT};
+
+    // A mix of access lists, layouts and discards
+    ThsvsImageBarrier barriers[45];
+    for (uint32_t i = 0; i < 45; ++i)
+    {
+        ThsvsImageBarrier barrier = {1, &accesses[i % 5], (i % 3 == 0) ? 2u : 1u, (i % 3 == 0) ? &accesses[1] : &accesses[(i + 1) % 5],
+                                     THSVS_IMAGE_LAYOUT_OPTIMAL, (i % 7 == 0) ? THSVS_IMAGE_LAYOUT_GENERAL : THSVS_IMAGE_LAYOUT_OPTIMAL,
+                                     (i % 4 == 0) ? VK_TRUE : VK_FALSE,
+                                     VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, 0,
+                                     {VK_IMAGE_ASPECT_COLOR_BIT, i, 1, 0, 1}};
+        barriers[i] = barrier;
+    }
+
     VkPipelineStageFlags srcStages = 0;
     VkPipelineStageFlags dstStages = 0;
+    VkImageMemoryBarrier vkBarriers[45];
+    VkBool32 needed = thsvsGetVulkanImageMemoryBarriers(45, barriers, &srcStages, &dstStages, vkBarriers);
+
+    VkPipelineStageFlags expectedSrcStages = 0;
+    VkPipelineStageFlags expectedDstStages = 0;
+    VkBool32 expectedNeeded = VK_FALSE;
+    for (uint32_t i = 0; i < 45; ++i)
+    {
+        VkPipelineStageFlags tempSrcStages = 0;
+        VkPipelineStageFlags tempDstStages = 0;
+        VkImageMemoryBarrier expected;
+        if (thsvsGetVulkanImageMemoryBarrier(barriers[i], &tempSrcStages, &tempDstStages, &expected) == VK_TRUE)
+            expectedNeeded = VK_TRUE;
+        expectedSrcStages |= tempSrcStages;
+        expectedDstStages |= tempDstStages;
+
+        if (vkBarriers[i].srcAccessMask != expected.srcAccessMask ||
+            vkBarriers[i].dstAccessMask != expected.dstAccessMask ||
+            vkBarriers[i].oldLayout != expected.oldLayout ||
+            vkBarriers[i].newLayout != expected.newLayout ||
+            vkBarriers[i].subresourceRange.baseMipLevel != i)
+        {
+            printf("\tBarrier %u differs from thsvsGetVulkanImageMemoryBarrier\n", i);
+            testPassed = 0;
+        }
+    }
+
+    if (srcStages != expectedSrcStages ||
+        dstStages != expectedDstStages ||
+        needed != expectedNeeded)
+    {
+        printf("\tUnexpected combined stage masks: %u, %u\n", srcStages, dstStages);
+        testPassed = 0;
+    }
+
+    if (testPassed == 1)
+        printf("\tPASSED\n");
+    else
+        printf("\tFAILED\n");
+}
+
+#ifdef THSVS_HAS_CONSTEXPR_BARRIERS
+void constexpr_barrier_test(const char* testName)
+{
     unsigned int testPassed = 1;
-    
-    thsvsGetVulkanImageMemoryBarrier(barrier, &srcStages, &dstStages, &vkBarrier);
 
     printf("Test: %s\n", testName);
-    
-    if (srcStages != expectedSrcStageMask)
+
+    // Evaluated by the compiler, or this doesn't compile
+    static_assert(thsvsGetStaticSrcStages(ThsvsAccessList<THSVS_ACCESS_TRANSFER_WRITE>::accessSet) == VK_PIPELINE_STAGE_TRANSFER_BIT,
+                  "Compile-time source stages");
+    static_assert(thsvsMakeAccessSet<THSVS_ACCESS_PRESENT>().imageLayouts[THSVS_IMAGE_LAYOUT_OPTIMAL] == VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+                  "Compile-time image layout");
+
+    const ThsvsAccessSet& prevAccessSet = ThsvsAccessList<THSVS_ACCESS_COLOR_ATTACHMENT_WRITE>::accessSet;
+    const ThsvsAccessSet& nextAccessSet = ThsvsAccessList<THSVS_ACCESS_FRAGMENT_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER,
+                                                          THSVS_ACCESS_COMPUTE_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER>::accessSet;
+
+    ThsvsAccessType prevAccesses[] = {THSVS_ACCESS_COLOR_ATTACHMENT_WRITE};
+    ThsvsAccessType nextAccesses[] = {THSVS_ACCESS_FRAGMENT_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER,
+                                      THSVS_ACCESS_COMPUTE_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER};
+
+    VkImageSubresourceRange range = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+
+    ThsvsImageBarrier barrier = {1, prevAccesses, 2, nextAccesses,
+                                 THSVS_IMAGE_LAYOUT_OPTIMAL, THSVS_IMAGE_LAYOUT_OPTIMAL, VK_FALSE,
+                                 VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, 0, range};
+
+    VkPipelineStageFlags srcStages = 0;
+    VkPipelineStageFlags dstStages = 0;
+    VkImageMemoryBarrier expected;
+    thsvsGetVulkanImageMemoryBarrier(barrier, &srcStages, &dstStages, &expected);
+
+    VkImageMemoryBarrier actual = thsvsGetStaticImageMemoryBarrier(
+        prevAccessSet, nextAccessSet, THSVS_IMAGE_LAYOUT_OPTIMAL, THSVS_IMAGE_LAYOUT_OPTIMAL, VK_FALSE,
+        VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, 0, range);
+
+    if (thsvsGetStaticSrcStages(prevAccessSet) != srcStages ||
+        thsvsGetStaticDstStages(nextAccessSet) != dstStages)
     {
-        printf("\tUnexpected source stage %0#10X\n", srcStages);
+        printf("\tUnexpected stage masks: %u, %u\n", thsvsGetStaticSrcStages(prevAccessSet), thsvsGetStaticDstStages(nextAccessSet));
         testPassed = 0;
     }
 
-    if (dstStages != expectedDstStageMask)
+    if (actual.srcAccessMask != expected.srcAccessMask ||
+        actual.dstAccessMask != expected.dstAccessMask ||
+        actual.oldLayout != expected.oldLayout ||
+        actual.newLayout != expected.newLayout)
     {
-        printf("\tUnexpected destination stage %0#10X\n", dstStages);
+        printf("\tCompile-time image barrier differs from the runtime one\n");
         testPassed = 0;
     }
-    
-    if (vkBarrier.srcAccessMask != expectedSrcAccessMask)
+
+    if (testPassed == 1)
+        printf("\tPASSED\n");
+    else
+        printf("\tFAILED\n");
+}
+#endif
+
+#ifdef VK_VERSION_1_2
+void separate_depth_stencil_test(const char* testName)
+{
+    unsigned int testPassed = 1;
+
+    printf("Test: %s\n", testName);
+
+    ThsvsAccessType fragmentRead = THSVS_ACCESS_FRAGMENT_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER;
+    ThsvsAccessType depthRead = THSVS_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ;
+    ThsvsAccessType depthWrite = THSVS_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE;
+    ThsvsAccessType depthWriteStencilRead = THSVS_ACCESS_DEPTH_ATTACHMENT_WRITE_STENCIL_READ_ONLY;
+
+    VkImageSubresourceRange color = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    VkImageSubresourceRange depth = {VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, 1};
+    VkImageSubresourceRange stencil = {VK_IMAGE_ASPECT_STENCIL_BIT, 0, 1, 0, 1};
+    VkImageSubresourceRange depthStencil = {VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT, 0, 1, 0, 1};
+
+    VkPipelineStageFlags srcStageMask = 0;
+    VkPipelineStageFlags dstStageMask = 0;
+    VkImageMemoryBarrier imageBarrier;
+
+    // Sampling a depth buffer and depth testing against it share a layout, so need no barrier on any path
+    ThsvsImageBarrier pingPongBarrier = {
+        1, &fragmentRead, 1, &depthRead,
+        THSVS_IMAGE_LAYOUT_OPTIMAL_SEPARATE_DEPTH_STENCIL, THSVS_IMAGE_LAYOUT_OPTIMAL_SEPARATE_DEPTH_STENCIL,
+        VK_FALSE, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, VK_NULL_HANDLE, depth};
+
+    ThsvsAccessSet fragmentReadSet;
+    ThsvsAccessSet depthReadSet;
+    thsvsCompileAccessSet(1, &fragmentRead, &fragmentReadSet);
+    thsvsCompileAccessSet(1, &depthRead, &depthReadSet);
+    ThsvsCompiledImageBarrier compiledPingPongBarrier = {
+        &fragmentReadSet, &depthReadSet,
+        THSVS_IMAGE_LAYOUT_OPTIMAL_SEPARATE_DEPTH_STENCIL, THSVS_IMAGE_LAYOUT_OPTIMAL_SEPARATE_DEPTH_STENCIL,
+        VK_FALSE, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, VK_NULL_HANDLE, depth};
+
+    for (uint32_t path = 0; path < 3; ++path)
     {
-        printf("\tUnexpected source access mask %0#10X\n", vkBarrier.srcAccessMask);
-        testPassed = 0;
+        VkBool32 needed;
+        if (path == 0)
+            needed = thsvsGetVulkanImageMemoryBarrier(pingPongBarrier, &srcStageMask, &dstStageMask, &imageBarrier);
+        else if (path == 1)
+            needed = thsvsGetVulkanImageMemoryBarrierFast(pingPongBarrier, &srcStageMask, &dstStageMask, &imageBarrier);
+        else
+            needed = thsvsGetVulkanCompiledImageMemoryBarrier(compiledPingPongBarrier, &srcStageMask, &dstStageMask, &imageBarrier);
+
+        if (needed != VK_FALSE ||
+            imageBarrier.oldLayout != VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_OPTIMAL ||
+            imageBarrier.newLayout != VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_OPTIMAL)
+        {
+            printf("\tSampled and depth test reads don't share a layout on path %u\n", path);
+            testPassed = 0;
+        }
     }
-    
-    if (vkBarrier.dstAccessMask != expectedDstAccessMask)
+
+    // Each aspect a barrier covers selects its own layout
+    struct {
+        ThsvsAccessType         access;
+        VkImageSubresourceRange range;
+        VkImageLayout           layout;
+    } aspectLayouts[] = {
+        {fragmentRead,          color,        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL},
+        {fragmentRead,          depthStencil, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL},
+        {fragmentRead,          stencil,      VK_IMAGE_LAYOUT_STENCIL_READ_ONLY_OPTIMAL},
+        {depthRead,             stencil,      VK_IMAGE_LAYOUT_STENCIL_READ_ONLY_OPTIMAL},
+        {depthWrite,            depth,        VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL},
+        {depthWrite,            stencil,      VK_IMAGE_LAYOUT_STENCIL_ATTACHMENT_OPTIMAL},
+        {depthWrite,            depthStencil, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL},
+        {depthWriteStencilRead, depthStencil, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_STENCIL_READ_ONLY_OPTIMAL},
+        {depthWriteStencilRead, depth,        VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL},
+        {depthWriteStencilRead, stencil,      VK_IMAGE_LAYOUT_STENCIL_READ_ONLY_OPTIMAL}};
+
+    for (uint32_t i = 0; i < sizeof(aspectLayouts) / sizeof(aspectLayouts[0]); ++i)
     {
-        printf("\tUnexpected destination access mask %0#10X\n", vkBarrier.dstAccessMask);
-        testPassed = 0;
+        ThsvsImageBarrier aspectBarrier = {
+            0, NULL, 1, &aspectLayouts[i].access,
+            THSVS_IMAGE_LAYOUT_OPTIMAL_SEPARATE_DEPTH_STENCIL, THSVS_IMAGE_LAYOUT_OPTIMAL_SEPARATE_DEPTH_STENCIL,
+            VK_FALSE, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, VK_NULL_HANDLE, aspectLayouts[i].range};
+        thsvsGetVulkanImageMemoryBarrier(aspectBarrier, &srcStageMask, &dstStageMask, &imageBarrier);
+
+        if (imageBarrier.newLayout != aspectLayouts[i].layout)
+        {
+            printf("\tUnexpected layout %u for access %u on aspects %u\n",
+                   imageBarrier.newLayout, aspectLayouts[i].access, aspectLayouts[i].range.aspectMask);
+            testPassed = 0;
+        }
     }
-    
-    if (vkBarrier.oldLayout != expectedOldLayout)
+
+    // Subresource maps keep the aspects in their own layouts until a barrier covers both
+    ThsvsSubresourceState states[2];
+    ThsvsImageSubresourceMap map;
+    VkImageMemoryBarrier barriers[2];
+    thsvsInitImageSubresourceMap(&map, VK_NULL_HANDLE, depthStencil.aspectMask, 1, 1, states, VK_IMAGE_LAYOUT_UNDEFINED);
+
+    uint32_t barrierCount = thsvsTransitionImageSubresources(&map, stencil, 1, &depthRead,
+                                                             THSVS_IMAGE_LAYOUT_OPTIMAL_SEPARATE_DEPTH_STENCIL, VK_TRUE,
+                                                             &srcStageMask, &dstStageMask, barriers);
+    if (barrierCount != 1 ||
+        barriers[0].subresourceRange.aspectMask != VK_IMAGE_ASPECT_STENCIL_BIT ||
+        barriers[0].newLayout != VK_IMAGE_LAYOUT_STENCIL_READ_ONLY_OPTIMAL)
     {
-        printf("\tUnexpected old layout %d\n", vkBarrier.oldLayout);
+        printf("\tStencil only transition produced unexpected barriers\n");
         testPassed = 0;
     }
-    
-    if (vkBarrier.newLayout != expectedNewLayout)
+
+    barrierCount = thsvsTransitionImageSubresources(&map, depthStencil, 1, &depthRead,
+                                                    THSVS_IMAGE_LAYOUT_OPTIMAL_SEPARATE_DEPTH_STENCIL, VK_FALSE,
+                                                    &srcStageMask, &dstStageMask, barriers);
+    if (barrierCount != 2 ||
+        barriers[0].subresourceRange.aspectMask != VK_IMAGE_ASPECT_DEPTH_BIT ||
+        barriers[0].oldLayout != VK_IMAGE_LAYOUT_UNDEFINED ||
+        barriers[1].subresourceRange.aspectMask != VK_IMAGE_ASPECT_STENCIL_BIT ||
+        barriers[1].oldLayout != VK_IMAGE_LAYOUT_STENCIL_READ_ONLY_OPTIMAL ||
+        barriers[1].newLayout != VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL)
     {
-        printf("\tUnexpected new layout %d\n", vkBarrier.newLayout);
+        printf("\tCombined transition produced %u unexpected barriers\n", barrierCount);
         testPassed = 0;
     }
-    
+
     if (testPassed == 1)
         printf("\tPASSED\n");
     else
         printf("\tFAILED\n");
 }
+#endif
 
-void image_barrier_test(const char* testName,
-                        ThsvsAccessType prevAccess,
-                        ThsvsAccessType nextAccess,
-                        VkPipelineStageFlags expectedSrcStageMask,
-                        VkPipelineStageFlags expectedDstStageMask,
-                        VkAccessFlags expectedSrcAccessMask,
-                        VkAccessFlags expectedDstAccessMask,
-                        VkImageLayout expectedOldLayout,
-                        VkImageLayout expectedNewLayout)
+#ifdef VK_VERSION_1_3
+void synchronization2_test(const char* testName)
 {
-    image_barrier_test_array(testName, 1, &prevAccess, 1, &nextAccess, expectedSrcStageMask, expectedDstStageMask, expectedSrcAccessMask, expectedDstAccessMask, expectedOldLayout, expectedNewLayout);
+    VkMemoryBarrier2 memoryBarrier;
+    VkImageMemoryBarrier2 imageBarrier;
+    unsigned int testPassed = 1;
+
+    printf("Test: %s\n", testName);
+
+    ThsvsAccessType computeWrite = THSVS_ACCESS_COMPUTE_SHADER_WRITE;
+    ThsvsAccessType indexBuffer = THSVS_ACCESS_INDEX_BUFFER;
+    ThsvsAccessType fragmentRead = THSVS_ACCESS_FRAGMENT_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER;
+
+    ThsvsGlobalBarrier globalBarrier = {1, &computeWrite, 1, &indexBuffer};
+    thsvsGetVulkanMemoryBarrier2(globalBarrier, &memoryBarrier);
+
+    if (memoryBarrier.srcStageMask != VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT ||
+        memoryBarrier.dstStageMask != VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT ||
+        memoryBarrier.srcAccessMask != VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT ||
+        memoryBarrier.dstAccessMask != VK_ACCESS_2_INDEX_READ_BIT)
+    {
+        printf("\tUnexpected global barrier\n");
+        testPassed = 0;
+    }
+
+    ThsvsImageBarrier thImageBarrier = {
+        0, NULL, 1, &fragmentRead,
+        THSVS_IMAGE_LAYOUT_OPTIMAL, THSVS_IMAGE_LAYOUT_OPTIMAL,
+        VK_FALSE, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, VK_NULL_HANDLE,
+        {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}};
+    thsvsGetVulkanImageMemoryBarrier2(thImageBarrier, &imageBarrier);
+
+    if (imageBarrier.srcStageMask != VK_PIPELINE_STAGE_2_NONE ||
+        imageBarrier.dstStageMask != VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT ||
+        imageBarrier.srcAccessMask != VK_ACCESS_2_NONE ||
+        imageBarrier.dstAccessMask != VK_ACCESS_2_NONE ||
+        imageBarrier.oldLayout != VK_IMAGE_LAYOUT_UNDEFINED ||
+        imageBarrier.newLayout != VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+    {
+        printf("\tUnexpected image barrier\n");
+        testPassed = 0;
+    }
+
+    // Sampling a depth buffer and depth testing against it share a layout, so need no barrier
+    ThsvsAccessType depthRead = THSVS_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ;
+    ThsvsImageBarrier depthBarrier = {
+        1, &fragmentRead, 1, &depthRead,
+        THSVS_IMAGE_LAYOUT_OPTIMAL_SYNCHRONIZATION2, THSVS_IMAGE_LAYOUT_OPTIMAL_SYNCHRONIZATION2,
+        VK_FALSE, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, VK_NULL_HANDLE,
+        {VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, 1}};
+    VkPipelineStageFlags srcStageMask = 0;
+    VkPipelineStageFlags dstStageMask = 0;
+    VkImageMemoryBarrier depthImageBarrier;
+
+    if (thsvsGetVulkanImageMemoryBarrier(depthBarrier, &srcStageMask, &dstStageMask, &depthImageBarrier) != VK_FALSE ||
+        depthImageBarrier.oldLayout != VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL ||
+        depthImageBarrier.newLayout != VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL)
+    {
+        printf("\tSampled and depth test reads don't share a layout\n");
+        testPassed = 0;
+    }
+
+    if (testPassed == 1)
+        printf("\tPASSED\n");
+    else
+        printf("\tFAILED\n");
 }
+#endif
 
 int main(int argc, char* argv[])
 {
@@ -354,4 +2972,71 @@ int main(int argc, char* argv[])
                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
                         VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT,
                         VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT);
+
+    scratch_test("Scratch allocations are aligned, bounded, and released on reset");
+
+    barrier_batch_test("Batched barriers merge stages and global barriers");
+
+    state_tracker_test("Tracked buffer state only produces necessary barriers");
+    state_tracker_hazard_test("Tracked state waits on writes made by read/write accesses");
+
+    split_barrier_test("Split barriers wait on pooled events, falling back to pipeline barriers once they run out");
+
+    context_test("Per-thread context and local state merge");
+
+    queue_transfer_test("Queue ownership transfers produce matching release and acquire barriers");
+
+    subpass_dependency_test("Subpass dependencies are by region only for framebuffer local accesses");
+
+    attachment_barrier_test("Attachment barriers account for load operations");
+
+    barrier_stats_test("Barrier stats count transitions and over-broad stage masks");
+
+    aliasing_barrier_test("Aliasing barriers discard the outgoing resource without a full pipeline barrier");
+
+    semaphore_test("Semaphore stage masks only cover the accesses on either side");
+
+    reverse_lookup_test("Vulkan masks and layouts map back to the access types that produce them");
+
+    event_barrier_test("Bulk event commands set and wait on every event at once");
+
+    reference_barrier_test("Every access list translates as the reference does, within valid usage rules");
+
+    fast_barrier_test("Fast mapping functions match the error checked ones");
+
+    frame_graph_test("Frame graphs schedule independent passes between the same barriers");
+
+#ifdef THSVS_DIAGNOSTICS
+    diagnostics_test("Diagnostics report over-synchronized barriers");
+#endif
+
+#ifdef THSVS_CAPTURE
+    capture_test("Captures record the barriers emitted and what they were translated to");
+#endif
+
+#ifdef THSVS_PROFILE
+    profiler_test("Profiling reports the GPU time of each transition once its frame is recycled");
+#endif
+
+    subresource_map_test("Subresource maps merge subresources with the same transition");
+
+    barrier_needed_test("Mapping functions report read-after-read in the same layout as having no effect");
+
+    execution_barrier_test("Execution barriers only determine pipeline stages");
+
+    access_mask_test("Barriers defined with access masks match those defined with access lists");
+
+    image_barrier_array_test("Translating image barriers as an array matches translating them one at a time");
+
+#ifdef THSVS_HAS_CONSTEXPR_BARRIERS
+    constexpr_barrier_test("Compile-time barriers match their runtime equivalents");
+#endif
+
+#ifdef VK_VERSION_1_2
+    separate_depth_stencil_test("Separate depth/stencil layouts follow the aspects each barrier covers");
+#endif
+
+#ifdef VK_VERSION_1_3
+    synchronization2_test("Synchronization2 barriers use per-barrier, fine grained stages and accesses");
+#endif
 }
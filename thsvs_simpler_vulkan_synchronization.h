@@ -29,8 +29,10 @@ combinations of which are invalid or nonsensical - this library collapses
 this to a much shorter list of 40 distinct usage types, and a couple of
 options for handling image layouts.
 
-Use of other synchronization mechanisms such as semaphores, fences and render
-passes are not addressed in this API at present.
+Fences are not addressed in this API at present, though semaphore wait
+stage masks can be generated from access types with
+thsvsGetSemaphoreWaitStageMask; for render passes, subpass dependencies
+can be generated from access types with thsvsGetVulkanSubpassDependency.
 
 USAGE
 
@@ -120,9 +122,60 @@ MEMORY ALLOCATION
     in before #include-ing the header file with
     THSVS_SIMPLER_VULKAN_SYNCHRONIZATION_IMPLEMENTATION defined.
 
-    I'd rather avoid the need for these allocations in what are likely to be
-    high-traffic commands, but currently just want to ship something - may
-    revisit this at a future date based on feedback.
+    Alternatively, the thsvsCmdPipelineBarrierScratch and
+    thsvsCmdWaitEventsScratch variants take a ThsvsScratch - a linear
+    allocator over memory provided by the application - and allocate their
+    temporary barriers from that instead.
+    A scratch allocator would typically be owned by a single recording thread
+    or command buffer, so these variants avoid any allocator traffic and keep
+    stack usage bounded regardless of the number of barriers.
+    If a scratch allocator runs out of space, these fall back to
+    THSVS_TEMP_ALLOC; define THSVS_ERROR_CHECK_SCRATCH_OVERFLOW to catch this.
+
+MULTITHREADED RECORDING
+
+    A ThsvsContext bundles a scratch allocator with a cache of compiled
+    access sets and some stats, for use by a single recording thread.
+    Secondary command buffers recorded on other threads can track resources with
+    ThsvsLocalBufferState and ThsvsLocalImageState, which are merged into
+    the primary's tracked state on the submitting thread once recording has
+    finished - producing the barriers needed before each secondary executes.
+
+FRAME GRAPHS
+
+    thsvsScheduleFrameGraph takes the passes of a frame, each declaring the
+    tracked states it accesses, and groups passes that don't depend on each
+    other into levels. thsvsCmdExecuteFrameGraph then records each level
+    after a single merged barrier, rather than one barrier per pass.
+
+INSTRUMENTATION
+
+    Defining THSVS_STATS counts every pipeline barrier and event wait
+    recorded by this library in thread local stats returned by
+    thsvsGetThreadStats - including layout transitions, queue family
+    transfers, and commands that wait on or block all commands or all
+    graphics stages, which are a common source of over-synchronization.
+    Setting an event isn't counted; its barriers are counted by the wait.
+    Defining THSVS_INSERT_DEBUG_LABEL as well inserts a VK_EXT_debug_utils
+    label before each of them. Neither adds any cost when not defined.
+
+    Defining THSVS_DIAGNOSTICS checks each barrier for over-synchronization,
+    reporting to a callback set with thsvsSetDiagnosticCallback when a more
+    specific access type than THSVS_ACCESS_GENERAL or THSVS_ACCESS_ANY_SHADER_*
+    would do, when a global barrier could replace a buffer or image barrier,
+    or when a pipeline barrier directly follows another one.
+
+    Defining THSVS_CAPTURE appends a compact binary record of each barrier -
+    its access types, what they were translated to, and a timestamp - to a
+    ring buffer set with thsvsSetThreadCapture. Batched, aliasing and ownership
+    transfer barriers are only recorded as what they were translated to.
+    thsvsGetCaptureData copies it out to be written to disk, and test/replay.c
+    summarizes it per pass.
+
+    Defining THSVS_PROFILE brackets each pipeline barrier with timestamp
+    queries from a profiler set with thsvsSetThreadProfiler, which recycles
+    a query pool per frame in flight. thsvsGetTransitionCosts then reports
+    the GPU time spent on each kind of transition, most expensive first.
 
 EXPRESSIVENESS COMPARED TO RAW VULKAN
 
@@ -132,18 +185,25 @@ EXPRESSIVENESS COMPARED TO RAW VULKAN
     which didn't seem worth the trade off - however I would consider adding
     something for them in future if it becomes an issue.
 
+    Execution only dependencies can be expressed with a
+    ThsvsExecutionBarrier, which uses access types only to determine the
+    pipeline stages to wait on - no memory is made available or visible.
+    These are occasionally useful in conjunction with semaphores, or when
+    trying to be clever with scheduling - but their usage is both limited
+    and fairly tricky to get right anyway.
+
     Here's a list of known things you can't express:
 
-    * Execution only dependencies cannot be expressed.
-      These are occasionally useful in conjunction with semaphores, or when
-      trying to be clever with scheduling - but their usage is both limited
-      and fairly tricky to get right anyway.
     * Depth/Stencil Input Attachments can be read in a shader using either
       VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL or
       VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL - this library
       *always* uses VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL.
       It's possible (though highly unlikely) when aliasing images that this
       results in unnecessary transitions.
+      With THSVS_IMAGE_LAYOUT_OPTIMAL_SYNCHRONIZATION2, both use
+      VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL instead, and with
+      THSVS_IMAGE_LAYOUT_OPTIMAL_SEPARATE_DEPTH_STENCIL, sampled reads of
+      depth/stencil images also use the depth/stencil read-only layouts.
 
 ERROR CHECKS
 
@@ -155,6 +215,8 @@ ERROR CHECKS
     and do not output an error message.
     I certainly do not claim they capture *all* possible errors, but they
     capture what should be some of the more common ones.
+    The *Fast variants of the mapping functions skip them even when
+    they're defined, for hot paths whose barriers have already been checked.
     Use of the Vulkan Validation Layers in tandem with this library is
     strongly recommended:
         https://github.com/KhronosGroup/Vulkan-LoaderAndValidationLayers
@@ -165,8 +227,8 @@ ISSUES
     on both gcc 4.8.4 and clang 3.5, using the c99 standard.
 
     There's a potential pitfall in thsvsCmdPipelineBarrier and thsvsCmdWaitEvents
-    where alloca is used for temporary allocations. See MEMORY ALLOCATION
-    for more information.
+    where alloca is used for temporary allocations; the *Scratch variants can
+    be used to avoid this. See MEMORY ALLOCATION for more information.
 
     Testing of this library is so far extremely limited with no immediate
     plans to add to that - so there's bound to be some amount of bugs.
@@ -178,6 +240,7 @@ ISSUES
 #define THSVS_SIMPLER_VULKAN_SYNCHRONIZATION_H 1
 
 #include <stdint.h>
+#include <stddef.h>
 
 /*
 ThsvsAccessType defines all potential resource usages in the Vulkan API.
@@ -289,13 +352,45 @@ ThsvsImageLayout defines a handful of layout options for images.
 Rather than a list of all possible image layouts, this reduced list is
 correlated with the access types to map to the correct Vulkan layouts.
 THSVS_IMAGE_LAYOUT_OPTIMAL is usually preferred.
+
+THSVS_IMAGE_LAYOUT_OPTIMAL_SYNCHRONIZATION2 avoids transitions between
+different kinds of read-only access - e.g. a depth buffer alternating between
+being sampled and being read by depth tests - which otherwise use
+VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL and
+VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL respectively.
+As these layouts apply to whichever aspects a barrier covers, they're also
+suitable for transitioning the depth and stencil aspects of an image
+separately (with VK_KHR_separate_depth_stencil_layouts) - e.g. an image
+barrier covering only the stencil aspect with
+THSVS_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ transitions it to
+VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL, leaving the depth aspect untouched.
+
+THSVS_IMAGE_LAYOUT_OPTIMAL_SEPARATE_DEPTH_STENCIL is the equivalent for
+devices without synchronization2, keyed on the aspects in the subresource
+range of each image barrier. Sampled reads of a depth or stencil aspect use
+the same read-only layout as depth/stencil tests, and a barrier covering only
+the depth or only the stencil aspect uses the per-aspect layouts from
+VK_KHR_separate_depth_stencil_layouts - e.g. the same stencil-only barrier
+transitions to VK_IMAGE_LAYOUT_STENCIL_READ_ONLY_OPTIMAL, and a
+depth-only barrier for THSVS_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE
+transitions to VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL.
+Barriers on other aspects use the same layouts as THSVS_IMAGE_LAYOUT_OPTIMAL.
 */
 typedef enum ThsvsImageLayout {
     THSVS_IMAGE_LAYOUT_OPTIMAL,                 // Choose the most optimal layout for each usage. Performs layout transitions as appropriate for the access.
     THSVS_IMAGE_LAYOUT_GENERAL,                 // Layout accessible by all Vulkan access types on a device - no layout transitions except for presentation
 
     // Requires VK_KHR_shared_presentable_image to be enabled. Can only be used for shared presentable images (i.e. single-buffered swap chains).
-    THSVS_IMAGE_LAYOUT_GENERAL_AND_PRESENTATION // As GENERAL, but also allows presentation engines to access it - no layout transitions
+    THSVS_IMAGE_LAYOUT_GENERAL_AND_PRESENTATION, // As GENERAL, but also allows presentation engines to access it - no layout transitions
+
+    // Requires Vulkan 1.3 or VK_KHR_synchronization2 to be enabled. Falls back to THSVS_IMAGE_LAYOUT_OPTIMAL if the headers don't define VK_VERSION_1_3.
+    THSVS_IMAGE_LAYOUT_OPTIMAL_SYNCHRONIZATION2, // As OPTIMAL, but all attachment and read-only usages share VK_IMAGE_LAYOUT_ATTACHMENT_OPTIMAL and VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL respectively, regardless of aspect
+
+    // Requires Vulkan 1.2 or VK_KHR_separate_depth_stencil_layouts to be enabled. Falls back to THSVS_IMAGE_LAYOUT_OPTIMAL if the headers don't define VK_VERSION_1_2.
+    THSVS_IMAGE_LAYOUT_OPTIMAL_SEPARATE_DEPTH_STENCIL, // As OPTIMAL, but depth/stencil aspects share read-only layouts between sampling and testing, and use per-aspect layouts for barriers covering only one of them
+
+// Number of image layouts
+    THSVS_NUM_IMAGE_LAYOUTS
 } ThsvsImageLayout;
 
 /*
@@ -326,6 +421,8 @@ A buffer barrier defining a queue ownership transfer needs to be executed
 twice - once by a queue in the source queue family, and then once again by a
 queue in the destination queue family, with a semaphore guaranteeing
 execution order between them.
+ThsvsBufferTransfer can be used to generate both halves from a single
+description instead.
 */
 typedef struct ThsvsBufferBarrier {
     uint32_t                prevAccessCount;
@@ -357,6 +454,8 @@ An image barrier defining a queue ownership transfer needs to be executed
 twice - once by a queue in the source queue family, and then once again by a
 queue in the destination queue family, with a semaphore guaranteeing
 execution order between them.
+ThsvsImageTransfer can be used to generate both halves from a single
+description instead.
 
 If discardContents is set to true, the contents of the image become
 undefined after the barrier is executed, which can result in a performance
@@ -391,12 +490,44 @@ void thsvsGetAccessInfo(
     VkImageLayout*         pImageLayout,
     bool*                  pHasWriteAccess);
 
+/*
+Reverse mapping function that finds a set of access types equivalent to
+raw Vulkan stages, access flags, and image layout - e.g. the state of a
+resource handed over by other code - so that they can be used as the
+previous accesses of a barrier, rather than THSVS_ACCESS_GENERAL.
+
+The access types chosen between them cover every stage and access flag
+given, without adding any - other than VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT
+and VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, which are ignored - and every one
+of them uses imageLayout with the image layout option written to pLayout.
+imageLayout should be VK_IMAGE_LAYOUT_UNDEFINED for buffers, or for images
+whose contents can be discarded.
+
+On input, pAccessCount is the number of access types pAccesses has space
+for; on output it's the number written. Returns VK_FALSE if no set of access
+types (that fits in pAccesses) is equivalent - in which case the caller
+should fall back to THSVS_ACCESS_GENERAL and a general image layout.
+Note that the result can include a write alongside other accesses, so it
+should not be used with THSVS_ERROR_CHECK_POTENTIAL_HAZARD.
+*/
+VkBool32 thsvsGetAccessTypes(
+    VkPipelineStageFlags   stageMask,
+    VkAccessFlags          accessMask,
+    VkImageLayout          imageLayout,
+    uint32_t*              pAccessCount,
+    ThsvsAccessType*       pAccesses,
+    ThsvsImageLayout*      pLayout);
+
 /*
 Mapping function that translates a global barrier into a set of source and
 destination pipeline stages, and a VkMemoryBarrier, that can be used with
 Vulkan's synchronization methods.
+
+This and the other mapping functions return VK_FALSE if the barrier would
+have no effect - e.g. a read followed by another read - and VK_TRUE
+otherwise. The outputs are written either way.
 */
-void thsvsGetVulkanMemoryBarrier(
+VkBool32 thsvsGetVulkanMemoryBarrier(
     const ThsvsGlobalBarrier& thBarrier,
     VkPipelineStageFlags*     pSrcStages,
     VkPipelineStageFlags*     pDstStages,
@@ -407,7 +538,7 @@ Mapping function that translates a buffer barrier into a set of source and
 destination pipeline stages, and a VkBufferMemoryBarrier, that can be used
 with Vulkan's synchronization methods.
 */
-void thsvsGetVulkanBufferMemoryBarrier(
+VkBool32 thsvsGetVulkanBufferMemoryBarrier(
     const ThsvsBufferBarrier& thBarrier,
     VkPipelineStageFlags*     pSrcStages,
     VkPipelineStageFlags*     pDstStages,
@@ -418,12 +549,225 @@ Mapping function that translates an image barrier into a set of source and
 destination pipeline stages, and a VkBufferMemoryBarrier, that can be used
 with Vulkan's synchronization methods.
 */
-void thsvsGetVulkanImageMemoryBarrier(
+VkBool32 thsvsGetVulkanImageMemoryBarrier(
+    const ThsvsImageBarrier& thBarrier,
+    VkPipelineStageFlags*    pSrcStages,
+    VkPipelineStageFlags*    pDstStages,
+    VkImageMemoryBarrier*    pVkBarrier);
+
+/*
+Mapping function equivalent to calling thsvsGetVulkanImageMemoryBarrier for
+each of an array of image barriers, with the stages of every barrier
+combined into pSrcStages and pDstStages.
+This is intended for large numbers of transitions at once - e.g. a whole
+G-buffer or mip chain - and is used by thsvsCmdPipelineBarrier.
+Returns VK_TRUE if any of the barriers are needed.
+*/
+VkBool32 thsvsGetVulkanImageMemoryBarriers(
+    uint32_t                 imageBarrierCount,
+    const ThsvsImageBarrier* pImageBarriers,
+    VkPipelineStageFlags*    pSrcStages,
+    VkPipelineStageFlags*    pDstStages,
+    VkImageMemoryBarrier*    pVkBarriers);
+
+/*
+Fast variants of the mapping functions above, producing identical results
+but skipping every THSVS_ERROR_CHECK_* check even when those are defined -
+for hot paths whose access lists have already been validated, e.g. by
+running the same frame with the checked functions.
+All of the mapping functions share one translator: accesses are
+accumulated from lookup tables without branching on the access type, and
+each image layout is looked up once per list.
+*/
+VkBool32 thsvsGetVulkanMemoryBarrierFast(
+    const ThsvsGlobalBarrier& thBarrier,
+    VkPipelineStageFlags*     pSrcStages,
+    VkPipelineStageFlags*     pDstStages,
+    VkMemoryBarrier*          pVkBarrier);
+
+VkBool32 thsvsGetVulkanBufferMemoryBarrierFast(
+    const ThsvsBufferBarrier& thBarrier,
+    VkPipelineStageFlags*     pSrcStages,
+    VkPipelineStageFlags*     pDstStages,
+    VkBufferMemoryBarrier*    pVkBarrier);
+
+VkBool32 thsvsGetVulkanImageMemoryBarrierFast(
     const ThsvsImageBarrier& thBarrier,
     VkPipelineStageFlags*    pSrcStages,
     VkPipelineStageFlags*    pDstStages,
     VkImageMemoryBarrier*    pVkBarrier);
 
+VkBool32 thsvsGetVulkanImageMemoryBarriersFast(
+    uint32_t                 imageBarrierCount,
+    const ThsvsImageBarrier* pImageBarriers,
+    VkPipelineStageFlags*    pSrcStages,
+    VkPipelineStageFlags*    pDstStages,
+    VkImageMemoryBarrier*    pVkBarriers);
+
+/*
+ThsvsAccessSet is a precompiled form of a list of access types, created by
+thsvsCompileAccessSet.
+If the same handful of access lists are used repeatedly, compiling them once
+up front means translating a barrier no longer needs to walk the list or
+look anything up - it's reduced to a few loads and ORs.
+
+The contents should be treated as opaque; the only valid way to fill one in
+is via thsvsCompileAccessSet.
+*/
+typedef struct ThsvsAccessSet {
+    VkPipelineStageFlags    stageMask;
+    VkAccessFlags           accessMask;
+    VkAccessFlags           writeAccessMask;
+    VkImageLayout           imageLayouts[THSVS_NUM_IMAGE_LAYOUTS];
+    VkBool32                hasWriteAccess;
+} ThsvsAccessSet;
+
+/*
+Compiled barriers are identical to their uncompiled counterparts, except
+that the previous and next accesses are defined by precompiled access sets.
+The access sets must remain valid until the barrier has been translated.
+*/
+typedef struct ThsvsCompiledGlobalBarrier {
+    const ThsvsAccessSet*   pPrevAccessSet;
+    const ThsvsAccessSet*   pNextAccessSet;
+} ThsvsCompiledGlobalBarrier;
+
+typedef struct ThsvsCompiledBufferBarrier {
+    const ThsvsAccessSet*   pPrevAccessSet;
+    const ThsvsAccessSet*   pNextAccessSet;
+    uint32_t                srcQueueFamilyIndex;
+    uint32_t                dstQueueFamilyIndex;
+    VkBuffer                buffer;
+    VkDeviceSize            offset;
+    VkDeviceSize            size;
+} ThsvsCompiledBufferBarrier;
+
+typedef struct ThsvsCompiledImageBarrier {
+    const ThsvsAccessSet*   pPrevAccessSet;
+    const ThsvsAccessSet*   pNextAccessSet;
+    ThsvsImageLayout        prevLayout;
+    ThsvsImageLayout        nextLayout;
+    VkBool32                discardContents;
+    uint32_t                srcQueueFamilyIndex;
+    uint32_t                dstQueueFamilyIndex;
+    VkImage                 image;
+    VkImageSubresourceRange subresourceRange;
+} ThsvsCompiledImageBarrier;
+
+/*
+Compiles a list of accesses into an access set, which can then be used with
+the compiled barrier mapping functions below.
+*/
+void thsvsCompileAccessSet(
+    uint32_t               accessCount,
+    const ThsvsAccessType* pAccesses,
+    ThsvsAccessSet*        pAccessSet);
+
+/*
+Mapping functions equivalent to thsvsGetVulkanMemoryBarrier,
+thsvsGetVulkanBufferMemoryBarrier, and thsvsGetVulkanImageMemoryBarrier
+respectively, but taking compiled barriers.
+Results are identical to the uncompiled versions given the same accesses.
+*/
+VkBool32 thsvsGetVulkanCompiledMemoryBarrier(
+    const ThsvsCompiledGlobalBarrier& thBarrier,
+    VkPipelineStageFlags*             pSrcStages,
+    VkPipelineStageFlags*             pDstStages,
+    VkMemoryBarrier*                  pVkBarrier);
+
+VkBool32 thsvsGetVulkanCompiledBufferMemoryBarrier(
+    const ThsvsCompiledBufferBarrier& thBarrier,
+    VkPipelineStageFlags*             pSrcStages,
+    VkPipelineStageFlags*             pDstStages,
+    VkBufferMemoryBarrier*            pVkBarrier);
+
+VkBool32 thsvsGetVulkanCompiledImageMemoryBarrier(
+    const ThsvsCompiledImageBarrier& thBarrier,
+    VkPipelineStageFlags*            pSrcStages,
+    VkPipelineStageFlags*            pDstStages,
+    VkImageMemoryBarrier*            pVkBarrier);
+
+/*
+ThsvsAccessMask is an alternative to an array of access types, with one bit
+per access type - access type N is bit (N % 64) of bits[N / 64].
+Barriers defined with masks (ThsvsMask*Barrier) are plain values, with no
+arrays that need to be kept alive until translation, so they can be freely
+copied and stored - e.g. passed between threads, or kept with the resources
+they apply to.
+
+As with access lists, a write access should only appear on its own.
+*/
+typedef struct ThsvsAccessMask {
+    uint64_t                bits[2];
+} ThsvsAccessMask;
+
+typedef struct ThsvsMaskGlobalBarrier {
+    ThsvsAccessMask         prevAccesses;
+    ThsvsAccessMask         nextAccesses;
+} ThsvsMaskGlobalBarrier;
+
+typedef struct ThsvsMaskBufferBarrier {
+    ThsvsAccessMask         prevAccesses;
+    ThsvsAccessMask         nextAccesses;
+    uint32_t                srcQueueFamilyIndex;
+    uint32_t                dstQueueFamilyIndex;
+    VkBuffer                buffer;
+    VkDeviceSize            offset;
+    VkDeviceSize            size;
+} ThsvsMaskBufferBarrier;
+
+typedef struct ThsvsMaskImageBarrier {
+    ThsvsAccessMask         prevAccesses;
+    ThsvsAccessMask         nextAccesses;
+    ThsvsImageLayout        prevLayout;
+    ThsvsImageLayout        nextLayout;
+    VkBool32                discardContents;
+    uint32_t                srcQueueFamilyIndex;
+    uint32_t                dstQueueFamilyIndex;
+    VkImage                 image;
+    VkImageSubresourceRange subresourceRange;
+} ThsvsMaskImageBarrier;
+
+/*
+Converts a list of accesses into an access mask.
+*/
+void thsvsMakeAccessMask(
+    uint32_t               accessCount,
+    const ThsvsAccessType* pAccesses,
+    ThsvsAccessMask*       pAccessMask);
+
+/*
+Compiles an access mask into an access set, visiting only the accesses that
+are set in the mask.
+Accesses are visited in the order they are declared in ThsvsAccessType.
+*/
+void thsvsCompileAccessMask(
+    const ThsvsAccessMask& accessMask,
+    ThsvsAccessSet*        pAccessSet);
+
+/*
+Mapping functions equivalent to thsvsGetVulkanMemoryBarrier,
+thsvsGetVulkanBufferMemoryBarrier, and thsvsGetVulkanImageMemoryBarrier
+respectively, but taking barriers defined with access masks.
+*/
+VkBool32 thsvsGetVulkanMaskMemoryBarrier(
+    const ThsvsMaskGlobalBarrier& thBarrier,
+    VkPipelineStageFlags*         pSrcStages,
+    VkPipelineStageFlags*         pDstStages,
+    VkMemoryBarrier*              pVkBarrier);
+
+VkBool32 thsvsGetVulkanMaskBufferMemoryBarrier(
+    const ThsvsMaskBufferBarrier& thBarrier,
+    VkPipelineStageFlags*         pSrcStages,
+    VkPipelineStageFlags*         pDstStages,
+    VkBufferMemoryBarrier*        pVkBarrier);
+
+VkBool32 thsvsGetVulkanMaskImageMemoryBarrier(
+    const ThsvsMaskImageBarrier&  thBarrier,
+    VkPipelineStageFlags*         pSrcStages,
+    VkPipelineStageFlags*         pDstStages,
+    VkImageMemoryBarrier*         pVkBarrier);
+
 /*
 Simplified wrapper around vkCmdPipelineBarrier.
 
@@ -487,701 +831,7525 @@ void thsvsCmdWaitEvents(
     uint32_t                  imageBarrierCount,
     const ThsvsImageBarrier*  pImageBarriers);
 
-#endif // THSVS_SIMPLER_VULKAN_SYNCHRONIZATION_H
-
-#ifdef THSVS_SIMPLER_VULKAN_SYNCHRONIZATION_IMPLEMENTATION
+/*
+ThsvsScratch is a simple linear allocator over application provided memory,
+which the *Scratch variants of the command functions use to allocate their
+temporary Vulkan barriers instead of THSVS_TEMP_ALLOC.
+
+A scratch allocator is not thread safe, and is intended to be owned by a
+single recording thread or command buffer.
+Memory used by the command functions is given back before they return, so
+the memory only needs to be large enough for the largest single call - any
+other allocations made via thsvsScratchAlloc persist until the scratch is
+reset with thsvsResetScratch (e.g. once per frame).
+*/
+typedef struct ThsvsScratch {
+    void*                   pMemory;
+    size_t                  size;
+    size_t                  offset;
+} ThsvsScratch;
 
-#include <stdlib.h>
+/*
+Initializes a scratch allocator to allocate from the size bytes at pMemory.
+The memory must remain valid for as long as the scratch allocator is used.
+*/
+void thsvsInitScratch(
+    ThsvsScratch*             pScratch,
+    void*                     pMemory,
+    size_t                    size);
 
-//// Optional Error Checking ////
 /*
-Checks for barriers defining multiple usages that have different layouts
+Releases all allocations made from a scratch allocator.
 */
-// #define THSVS_ERROR_CHECK_MIXED_IMAGE_LAYOUT
+void thsvsResetScratch(
+    ThsvsScratch*             pScratch);
 
 /*
-Checks if an image/buffer barrier is used when a global barrier would suffice
+Allocates size bytes from a scratch allocator.
+Returns NULL if there is not enough space remaining.
 */
-// #define THSVS_ERROR_CHECK_COULD_USE_GLOBAL_BARRIER
+void* thsvsScratchAlloc(
+    ThsvsScratch*             pScratch,
+    size_t                    size);
 
 /*
-Checks if a write access is listed alongside any other access - if so it
-points to a potential data hazard that you need to synchronize separately.
-In some cases it may simply be over-synchronization however, but it's usually
-worth checking.
+Equivalent to thsvsCmdPipelineBarrier, except that temporary barriers are
+allocated from pScratch.
+If pScratch is NULL or does not have enough space remaining, this falls
+back to THSVS_TEMP_ALLOC.
 */
-// #define THSVS_ERROR_CHECK_POTENTIAL_HAZARD
+void thsvsCmdPipelineBarrierScratch(
+    VkCommandBuffer           commandBuffer,
+    ThsvsScratch*             pScratch,
+    const ThsvsGlobalBarrier* pGlobalBarrier,
+    uint32_t                  bufferBarrierCount,
+    const ThsvsBufferBarrier* pBufferBarriers,
+    uint32_t                  imageBarrierCount,
+    const ThsvsImageBarrier*  pImageBarriers);
 
 /*
-Checks if a variety of table lookups (like the access map) are within
-a valid range.
+Equivalent to thsvsCmdWaitEvents, except that temporary barriers are
+allocated from pScratch.
+If pScratch is NULL or does not have enough space remaining, this falls
+back to THSVS_TEMP_ALLOC.
 */
-// #define THSVS_ERROR_CHECK_ACCESS_TYPE_IN_RANGE
+void thsvsCmdWaitEventsScratch(
+    VkCommandBuffer           commandBuffer,
+    ThsvsScratch*             pScratch,
+    uint32_t                  eventCount,
+    const VkEvent*            pEvents,
+    const ThsvsGlobalBarrier* pGlobalBarrier,
+    uint32_t                  bufferBarrierCount,
+    const ThsvsBufferBarrier* pBufferBarriers,
+    uint32_t                  imageBarrierCount,
+    const ThsvsImageBarrier*  pImageBarriers);
 
-//// Temporary Memory Allocation ////
 /*
-Override these if you can't afford the stack space or just want to use a
-custom temporary allocator.
-These are currently used exclusively to allocate Vulkan memory barriers in
-the API, one for each Buffer or Image barrier passed into the pipeline and
-event functions.
-May consider other allocation strategies in future.
+ThsvsEventBarrier pairs an event with the barriers that waiting on it
+resolves - the previous accesses being the ones the event is set after.
 */
+typedef struct ThsvsEventBarrier {
+    VkEvent                   event;
+    const ThsvsGlobalBarrier* pGlobalBarrier;
+    uint32_t                  bufferBarrierCount;
+    const ThsvsBufferBarrier* pBufferBarriers;
+    uint32_t                  imageBarrierCount;
+    const ThsvsImageBarrier*  pImageBarriers;
+} ThsvsEventBarrier;
 
-// Alloca inclusion code below copied from
-// https://github.com/nothings/stb/blob/master/stb_vorbis.c
+/*
+Sets each of an array of events, with vkCmdSetEvent, once the previous
+accesses of its own barriers have completed - so each event only waits on
+the stages it actually covers, rather than those of every event.
+*/
+void thsvsCmdSetEvents(
+    VkCommandBuffer           commandBuffer,
+    uint32_t                  eventBarrierCount,
+    const ThsvsEventBarrier*  pEventBarriers);
 
-// find definition of alloca if it's not in stdlib.h:
-#if defined(_MSC_VER) || defined(__MINGW32__)
-  #include <malloc.h>
-#endif
-#if defined(__linux__) || defined(__linux) || defined(__EMSCRIPTEN__)
-  #include <alloca.h>
-#endif
+/*
+Waits on every event in an array with a single vkCmdWaitEvents, executing
+all of their barriers.
+vkCmdWaitEvents only takes one source stage mask, so this is the union of
+the stages each event was set with; thsvsCmdWaitEvents2 keeps them
+separate.
+Temporary barriers are allocated from pScratch, which may be NULL, as with
+thsvsCmdWaitEventsScratch.
+*/
+void thsvsCmdWaitEventBarriers(
+    VkCommandBuffer           commandBuffer,
+    ThsvsScratch*             pScratch,
+    uint32_t                  eventBarrierCount,
+    const ThsvsEventBarrier*  pEventBarriers);
 
-#if defined(THSVS_ERROR_CHECK_ACCESS_TYPE_IN_RANGE) || \
-    defined(THSVS_ERROR_CHECK_COULD_USE_GLOBAL_BARRIER) || \
-    defined(THSVS_ERROR_CHECK_MIXED_IMAGE_LAYOUT) || \
-    defined(THSVS_ERROR_CHECK_POTENTIAL_HAZARD)
-  #include <assert.h>
-#endif
+/*
+ThsvsBarrierBatch accumulates barriers so that several consecutive barriers,
+with no work recorded between them, can be executed as a single
+vkCmdPipelineBarrier call - avoiding a separate pipeline drain for each.
+
+Barriers are translated as soon as they're added; the stage masks of all
+of them are unioned, and all global barriers are combined into a single
+VkMemoryBarrier.
+Storage for the translated buffer and image barriers is provided by the
+application when the batch is initialized.
+
+The batch is flushed automatically if it runs out of storage, or if a
+buffer or image barrier is added that overlaps with one already in the
+batch (as Vulkan doesn't define an order between barriers in a single
+command).
+Otherwise, the application must call thsvsCmdFlushBarrierBatch before
+recording any commands that depend on the batched barriers.
+*/
+typedef struct ThsvsBarrierBatch {
+    VkCommandBuffer         commandBuffer;
+    VkPipelineStageFlags    srcStageMask;
+    VkPipelineStageFlags    dstStageMask;
+    VkMemoryBarrier         memoryBarrier;
+    uint32_t                bufferBarrierCapacity;
+    uint32_t                bufferBarrierCount;
+    VkBufferMemoryBarrier*  pBufferBarriers;
+    uint32_t                imageBarrierCapacity;
+    uint32_t                imageBarrierCount;
+    VkImageMemoryBarrier*   pImageBarriers;
+} ThsvsBarrierBatch;
 
-#if !defined(THSVS_TEMP_ALLOC)
-#define THSVS_TEMP_ALLOC(size)              (alloca(size))
-#endif
+/*
+Initializes an empty barrier batch that records into commandBuffer.
+pBufferBarrierStorage and pImageBarrierStorage must have space for
+bufferBarrierCapacity and imageBarrierCapacity barriers respectively, and
+remain valid for as long as the batch is used. Either may be NULL if the
+corresponding capacity is 0.
+*/
+void thsvsInitBarrierBatch(
+    ThsvsBarrierBatch*        pBatch,
+    VkCommandBuffer           commandBuffer,
+    uint32_t                  bufferBarrierCapacity,
+    VkBufferMemoryBarrier*    pBufferBarrierStorage,
+    uint32_t                  imageBarrierCapacity,
+    VkImageMemoryBarrier*     pImageBarrierStorage);
 
-#if !defined(THSVS_TEMP_FREE)
-#define THSVS_TEMP_FREE(x)                  ((void)(x))
-#endif
+/*
+Adds a set of barriers to a batch, with the same parameters as
+thsvsCmdPipelineBarrier.
+*/
+void thsvsBatchPipelineBarrier(
+    ThsvsBarrierBatch*        pBatch,
+    const ThsvsGlobalBarrier* pGlobalBarrier,
+    uint32_t                  bufferBarrierCount,
+    const ThsvsBufferBarrier* pBufferBarriers,
+    uint32_t                  imageBarrierCount,
+    const ThsvsImageBarrier*  pImageBarriers);
 
-typedef struct ThsvsVkAccessInfo {
-    VkPipelineStageFlags    stageMask;
-    VkAccessFlags           accessMask;
-    VkImageLayout           imageLayout;
-} ThsvsVkAccessInfo;
+/*
+Records all barriers in the batch with a single call to
+vkCmdPipelineBarrier, and empties the batch.
+Does nothing if the batch is empty.
+*/
+void thsvsCmdFlushBarrierBatch(
+    ThsvsBarrierBatch*        pBatch);
 
-const ThsvsVkAccessInfo ThsvsAccessMap[THSVS_NUM_ACCESS_TYPES] = {
-    // THSVS_ACCESS_NONE
-    {   0,
-        0,
-        VK_IMAGE_LAYOUT_UNDEFINED},
+/*
+ThsvsBufferState and ThsvsImageState track the accesses made to a buffer
+range or image subresource range, so that the application only has to
+declare each new access, rather than remembering the previous one.
+
+Each state records the stages and accesses of the last write, the stages
+and accesses of any reads since that write, and for images the current
+layout. Transitioning a state to a new set of accesses produces only the
+barrier that is actually required:
+
+* Reads following other reads in the same layout need no barrier at all,
+  as long as the stages doing the reading have already been made to wait
+  for the last write. Their stages are merged into the state, so that a
+  later write waits for all of them.
+* Writes, or layout transitions, wait on the last write and every read
+  since.
+
+Queue family ownership transfers are not handled by the tracker - use an
+explicit barrier for those.
+The application is responsible for storing one state object per tracked
+range, initializing it once, and making sure ranges do not overlap.
+*/
+typedef struct ThsvsBufferState {
+    VkBuffer                buffer;
+    VkDeviceSize            offset;
+    VkDeviceSize            size;
+    VkPipelineStageFlags    writeStageMask;
+    VkAccessFlags           writeAccessMask;
+    VkPipelineStageFlags    readStageMask;
+    VkAccessFlags           readAccessMask;
+} ThsvsBufferState;
 
-// Read Access
-    // THSVS_ACCESS_COMMAND_BUFFER_READ_NV
-    {   VK_PIPELINE_STAGE_COMMAND_PREPROCESS_BIT_NV,
-        VK_ACCESS_COMMAND_PREPROCESS_READ_BIT_NV,
-        VK_IMAGE_LAYOUT_UNDEFINED},
-    // THSVS_ACCESS_INDIRECT_BUFFER
-    {   VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
-        VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
-        VK_IMAGE_LAYOUT_UNDEFINED},
+typedef struct ThsvsImageState {
+    VkImage                 image;
+    VkImageSubresourceRange subresourceRange;
+    VkPipelineStageFlags    writeStageMask;
+    VkAccessFlags           writeAccessMask;
+    VkPipelineStageFlags    readStageMask;
+    VkAccessFlags           readAccessMask;
+    VkImageLayout           layout;
+} ThsvsImageState;
 
-    // THSVS_ACCESS_INDEX_BUFFER
-    {   VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
-        VK_ACCESS_INDEX_READ_BIT,
-        VK_IMAGE_LAYOUT_UNDEFINED},
-    // THSVS_ACCESS_VERTEX_BUFFER
-    {   VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
-        VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT,
-        VK_IMAGE_LAYOUT_UNDEFINED},
-    // THSVS_ACCESS_VERTEX_SHADER_READ_UNIFORM_BUFFER
-    {   VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
-        VK_ACCESS_UNIFORM_READ_BIT,
-        VK_IMAGE_LAYOUT_UNDEFINED},
-    // THSVS_ACCESS_VERTEX_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER
-    {   VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
-        VK_ACCESS_SHADER_READ_BIT,
-        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL},
-    // THSVS_ACCESS_VERTEX_SHADER_READ_OTHER
-    {   VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
-        VK_ACCESS_SHADER_READ_BIT,
-        VK_IMAGE_LAYOUT_GENERAL},
+/*
+Initializes a buffer state for a range that hasn't yet been accessed.
+*/
+void thsvsInitBufferState(
+    ThsvsBufferState*       pState,
+    VkBuffer                buffer,
+    VkDeviceSize            offset,
+    VkDeviceSize            size);
 
-    // THSVS_ACCESS_TESSELLATION_CONTROL_SHADER_READ_UNIFORM_BUFFER
-    {   VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT,
-        VK_ACCESS_UNIFORM_READ_BIT,
-        VK_IMAGE_LAYOUT_UNDEFINED},
-    // THSVS_ACCESS_TESSELLATION_CONTROL_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER
-    {   VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT,
-        VK_ACCESS_SHADER_READ_BIT,
-        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL},
-    // THSVS_ACCESS_TESSELLATION_CONTROL_SHADER_READ_OTHER
-    {   VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT,
-        VK_ACCESS_SHADER_READ_BIT,
-        VK_IMAGE_LAYOUT_GENERAL},
+/*
+Initializes an image state for a subresource range that hasn't yet been
+accessed on the device. layout is the image's current layout - normally
+VK_IMAGE_LAYOUT_UNDEFINED, or VK_IMAGE_LAYOUT_PREINITIALIZED.
+*/
+void thsvsInitImageState(
+    ThsvsImageState*        pState,
+    VkImage                 image,
+    VkImageSubresourceRange subresourceRange,
+    VkImageLayout           layout);
 
-    // THSVS_ACCESS_TESSELLATION_EVALUATION_SHADER_READ_UNIFORM_BUFFER
-    {   VK_PIPELINE_STAGE_TESSELLATION_EVALUATION_SHADER_BIT,
-        VK_ACCESS_UNIFORM_READ_BIT,
-        VK_IMAGE_LAYOUT_UNDEFINED},
-    // THSVS_ACCESS_TESSELLATION_EVALUATION_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER
-    {   VK_PIPELINE_STAGE_TESSELLATION_EVALUATION_SHADER_BIT,
-        VK_ACCESS_SHADER_READ_BIT,
-        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL},
-    // THSVS_ACCESS_TESSELLATION_EVALUATION_SHADER_READ_OTHER
-    {   VK_PIPELINE_STAGE_TESSELLATION_EVALUATION_SHADER_BIT,
-        VK_ACCESS_SHADER_READ_BIT,
-        VK_IMAGE_LAYOUT_GENERAL},
+/*
+Updates a tracked state to reflect the accesses in pNextAccesses.
+If a barrier is required before those accesses, it's written to pVkBarrier
+along with the stage masks to use for it, and VK_TRUE is returned.
+Otherwise VK_FALSE is returned and the outputs are not written.
 
-    // THSVS_ACCESS_GEOMETRY_SHADER_READ_UNIFORM_BUFFER
-    {   VK_PIPELINE_STAGE_GEOMETRY_SHADER_BIT,
-        VK_ACCESS_UNIFORM_READ_BIT,
-        VK_IMAGE_LAYOUT_UNDEFINED},
-    // THSVS_ACCESS_GEOMETRY_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER
-    {   VK_PIPELINE_STAGE_GEOMETRY_SHADER_BIT,
-        VK_ACCESS_SHADER_READ_BIT,
-        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL},
-    // THSVS_ACCESS_GEOMETRY_SHADER_READ_OTHER
-    {   VK_PIPELINE_STAGE_GEOMETRY_SHADER_BIT,
-        VK_ACCESS_SHADER_READ_BIT,
-        VK_IMAGE_LAYOUT_GENERAL},
+For images, discardContents has the same meaning as in ThsvsImageBarrier.
+*/
+VkBool32 thsvsTransitionBufferState(
+    ThsvsBufferState*       pState,
+    uint32_t                nextAccessCount,
+    const ThsvsAccessType*  pNextAccesses,
+    VkPipelineStageFlags*   pSrcStages,
+    VkPipelineStageFlags*   pDstStages,
+    VkBufferMemoryBarrier*  pVkBarrier);
+
+VkBool32 thsvsTransitionImageState(
+    ThsvsImageState*        pState,
+    uint32_t                nextAccessCount,
+    const ThsvsAccessType*  pNextAccesses,
+    ThsvsImageLayout        nextLayout,
+    VkBool32                discardContents,
+    VkPipelineStageFlags*   pSrcStages,
+    VkPipelineStageFlags*   pDstStages,
+    VkImageMemoryBarrier*   pVkBarrier);
 
-    // THSVS_ACCESS_TASK_SHADER_READ_UNIFORM_BUFFER_NV
-    {   VK_PIPELINE_STAGE_TASK_SHADER_BIT_NV,
-        VK_ACCESS_UNIFORM_READ_BIT,
-        VK_IMAGE_LAYOUT_UNDEFINED},
-    // THSVS_ACCESS_TASK_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER_NV
-    {   VK_PIPELINE_STAGE_TASK_SHADER_BIT_NV,
-        VK_ACCESS_SHADER_READ_BIT,
-        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL},
-    // THSVS_ACCESS_TASK_SHADER_READ_OTHER_NV
-    {   VK_PIPELINE_STAGE_TASK_SHADER_BIT_NV,
-        VK_ACCESS_SHADER_READ_BIT,
-        VK_IMAGE_LAYOUT_GENERAL},
+/*
+Convenience functions that transition a tracked state, adding any barrier
+that's required to a barrier batch.
+*/
+void thsvsBatchBufferState(
+    ThsvsBarrierBatch*      pBatch,
+    ThsvsBufferState*       pState,
+    uint32_t                nextAccessCount,
+    const ThsvsAccessType*  pNextAccesses);
+
+void thsvsBatchImageState(
+    ThsvsBarrierBatch*      pBatch,
+    ThsvsImageState*        pState,
+    uint32_t                nextAccessCount,
+    const ThsvsAccessType*  pNextAccesses,
+    ThsvsImageLayout        nextLayout,
+    VkBool32                discardContents);
 
-    // THSVS_ACCESS_MESH_SHADER_READ_UNIFORM_BUFFER_NV
-    {   VK_PIPELINE_STAGE_MESH_SHADER_BIT_NV,
-        VK_ACCESS_UNIFORM_READ_BIT,
-        VK_IMAGE_LAYOUT_UNDEFINED},
-    // THSVS_ACCESS_MESH_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER_NV
-    {   VK_PIPELINE_STAGE_MESH_SHADER_BIT_NV,
-        VK_ACCESS_SHADER_READ_BIT,
-        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL},
-    // THSVS_ACCESS_MESH_SHADER_READ_OTHER_NV
-    {   VK_PIPELINE_STAGE_MESH_SHADER_BIT_NV,
-        VK_ACCESS_SHADER_READ_BIT,
-        VK_IMAGE_LAYOUT_GENERAL},
+/*
+ThsvsImageSubresourceMap tracks the same state as ThsvsImageState, but for
+every subresource (aspect, mip level and array layer) of an image
+separately - so that e.g. during mip generation, each mip level can be in a
+different layout, and have been last accessed differently.
+
+Transitioning a subresource range produces one barrier for each distinct
+transition in that range, with adjacent subresources that share the same
+transition merged into a single VkImageSubresourceRange - first across mip
+levels, then array layers, then aspects.
+
+Storage for the states is provided by the application, and must have space
+for thsvsGetImageSubresourceCount states.
+*/
+typedef struct ThsvsSubresourceState {
+    VkPipelineStageFlags    writeStageMask;
+    VkAccessFlags           writeAccessMask;
+    VkPipelineStageFlags    readStageMask;
+    VkAccessFlags           readAccessMask;
+    VkImageLayout           layout;
+} ThsvsSubresourceState;
+
+typedef struct ThsvsImageSubresourceMap {
+    VkImage                 image;
+    VkImageAspectFlags      aspectMask;
+    uint32_t                mipLevelCount;
+    uint32_t                arrayLayerCount;
+    ThsvsSubresourceState*  pStates;
+} ThsvsImageSubresourceMap;
 
-    // THSVS_ACCESS_TRANSFORM_FEEDBACK_COUNTER_READ_EXT
-    {   VK_PIPELINE_STAGE_TRANSFORM_FEEDBACK_BIT_EXT,
-        VK_ACCESS_TRANSFORM_FEEDBACK_COUNTER_READ_BIT_EXT,
-        VK_IMAGE_LAYOUT_UNDEFINED},
-    // THSVS_ACCESS_FRAGMENT_DENSITY_MAP_READ_EXT
-    {   VK_PIPELINE_STAGE_FRAGMENT_DENSITY_PROCESS_BIT_EXT,
-        VK_ACCESS_FRAGMENT_DENSITY_MAP_READ_BIT_EXT,
-        VK_IMAGE_LAYOUT_FRAGMENT_DENSITY_MAP_OPTIMAL_EXT},
-    // THSVS_ACCESS_SHADING_RATE_READ_NV
-    {   VK_PIPELINE_STAGE_SHADING_RATE_IMAGE_BIT_NV,
-        VK_ACCESS_SHADING_RATE_IMAGE_READ_BIT_NV,
-        VK_IMAGE_LAYOUT_SHADING_RATE_OPTIMAL_NV},
+/*
+Returns the number of subresources in an image with the given aspects,
+mip levels and array layers.
+*/
+uint32_t thsvsGetImageSubresourceCount(
+    VkImageAspectFlags      aspectMask,
+    uint32_t                mipLevelCount,
+    uint32_t                arrayLayerCount);
 
-    // THSVS_ACCESS_FRAGMENT_SHADER_READ_UNIFORM_BUFFER
-    {   VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-        VK_ACCESS_UNIFORM_READ_BIT,
-        VK_IMAGE_LAYOUT_UNDEFINED},
-    // THSVS_ACCESS_FRAGMENT_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER
-    {   VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-        VK_ACCESS_SHADER_READ_BIT,
-        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL},
-    // THSVS_ACCESS_FRAGMENT_SHADER_READ_COLOR_INPUT_ATTACHMENT
-    {   VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-        VK_ACCESS_INPUT_ATTACHMENT_READ_BIT,
-        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL},
-    // THSVS_ACCESS_FRAGMENT_SHADER_READ_DEPTH_STENCIL_INPUT_ATTACHMENT
-    {   VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-        VK_ACCESS_INPUT_ATTACHMENT_READ_BIT,
-        VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL},
-    // THSVS_ACCESS_FRAGMENT_SHADER_READ_OTHER
-    {   VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-        VK_ACCESS_SHADER_READ_BIT,
-        VK_IMAGE_LAYOUT_GENERAL},
-    // THSVS_ACCESS_COLOR_ATTACHMENT_READ
-    {   VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-        VK_ACCESS_COLOR_ATTACHMENT_READ_BIT,
-        VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL},
-    // THSVS_ACCESS_COLOR_ATTACHMENT_ADVANCED_BLENDING_EXT
-    {   VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-        VK_ACCESS_COLOR_ATTACHMENT_READ_NONCOHERENT_BIT_EXT,
-        VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL},
-    // THSVS_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ
-    {   VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
-        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
-        VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL},
+/*
+Initializes a subresource map for an image that hasn't yet been accessed on
+the device, with every subresource in the given layout - as with
+thsvsInitImageState.
+aspectMask should include every aspect of the image's format.
+*/
+void thsvsInitImageSubresourceMap(
+    ThsvsImageSubresourceMap* pMap,
+    VkImage                   image,
+    VkImageAspectFlags        aspectMask,
+    uint32_t                  mipLevelCount,
+    uint32_t                  arrayLayerCount,
+    ThsvsSubresourceState*    pStateStorage,
+    VkImageLayout             layout);
 
-    // THSVS_ACCESS_COMPUTE_SHADER_READ_UNIFORM_BUFFER
-    {   VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-        VK_ACCESS_UNIFORM_READ_BIT,
-        VK_IMAGE_LAYOUT_UNDEFINED},
-    // THSVS_ACCESS_COMPUTE_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER
-    {   VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-        VK_ACCESS_SHADER_READ_BIT,
-        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL},
-    // THSVS_ACCESS_COMPUTE_SHADER_READ_OTHER
-    {   VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-        VK_ACCESS_SHADER_READ_BIT,
-        VK_IMAGE_LAYOUT_GENERAL},
+/*
+Updates every subresource of a map in subresourceRange to reflect the
+accesses in pNextAccesses, in the same way as thsvsTransitionImageState.
+Any barriers required are written to pVkBarriers, and the number written is
+returned - pVkBarriers must have space for one barrier per subresource in
+the range, which is the worst case.
+pSrcStages and pDstStages are set to the stage masks to use for all of the
+barriers, and are only written if any barriers are returned.
+*/
+uint32_t thsvsTransitionImageSubresources(
+    ThsvsImageSubresourceMap* pMap,
+    VkImageSubresourceRange   subresourceRange,
+    uint32_t                  nextAccessCount,
+    const ThsvsAccessType*    pNextAccesses,
+    ThsvsImageLayout          nextLayout,
+    VkBool32                  discardContents,
+    VkPipelineStageFlags*     pSrcStages,
+    VkPipelineStageFlags*     pDstStages,
+    VkImageMemoryBarrier*     pVkBarriers);
 
-    // THSVS_ACCESS_ANY_SHADER_READ_UNIFORM_BUFFER
-    {   VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-        VK_ACCESS_UNIFORM_READ_BIT,
-        VK_IMAGE_LAYOUT_UNDEFINED},
-    // THSVS_ACCESS_ANY_SHADER_READ_UNIFORM_BUFFER_OR_VERTEX_BUFFER
-    {   VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-        VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT,
-        VK_IMAGE_LAYOUT_UNDEFINED},
-    // THSVS_ACCESS_ANY_SHADER_READ_SAMPLED_IMAGE
-    {   VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-        VK_ACCESS_SHADER_READ_BIT,
-        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL},
-    // THSVS_ACCESS_ANY_SHADER_READ_OTHER
-    {   VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-        VK_ACCESS_SHADER_READ_BIT,
-        VK_IMAGE_LAYOUT_GENERAL},
+/*
+Convenience function that transitions a range of a subresource map, adding
+any barriers that are required to a barrier batch.
+Temporary storage for the barriers is allocated with THSVS_TEMP_ALLOC.
+*/
+void thsvsBatchImageSubresources(
+    ThsvsBarrierBatch*        pBatch,
+    ThsvsImageSubresourceMap* pMap,
+    VkImageSubresourceRange   subresourceRange,
+    uint32_t                  nextAccessCount,
+    const ThsvsAccessType*    pNextAccesses,
+    ThsvsImageLayout          nextLayout,
+    VkBool32                  discardContents);
 
-    // THSVS_ACCESS_TRANSFER_READ
-    {   VK_PIPELINE_STAGE_TRANSFER_BIT,
-        VK_ACCESS_TRANSFER_READ_BIT,
-        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL},
-    // THSVS_ACCESS_HOST_READ
-    {   VK_PIPELINE_STAGE_HOST_BIT,
-        VK_ACCESS_HOST_READ_BIT,
-        VK_IMAGE_LAYOUT_GENERAL},
-    // THSVS_ACCESS_PRESENT
-    {   0,
-        0,
-        VK_IMAGE_LAYOUT_PRESENT_SRC_KHR},
-    // THSVS_ACCESS_CONDITIONAL_RENDERING_READ_EXT
-    {   VK_PIPELINE_STAGE_CONDITIONAL_RENDERING_BIT_EXT,
-        VK_ACCESS_CONDITIONAL_RENDERING_READ_BIT_EXT,
-        VK_IMAGE_LAYOUT_UNDEFINED},
+/*
+ThsvsEventPool is a fixed size set of VkEvents, which split barriers are
+allocated from.
+Storage for the events is provided by the application.
+A pool would typically be owned by one recording thread per frame in flight;
+once the GPU has finished executing everything recorded with it, call
+thsvsResetEventPool to make all of its events available again.
+*/
+typedef struct ThsvsEventPool {
+    VkDevice                device;
+    uint32_t                eventCount;
+    uint32_t                usedEventCount;
+    VkEvent*                pEvents;
+} ThsvsEventPool;
+
+/*
+Creates eventCount events in pEventStorage with vkCreateEvent, and
+initializes a pool with them.
+If creating any event fails, any events already created are destroyed and
+the error is returned.
+*/
+VkResult thsvsCreateEventPool(
+    ThsvsEventPool*           pPool,
+    VkDevice                  device,
+    uint32_t                  eventCount,
+    VkEvent*                  pEventStorage);
+
+/*
+Destroys all events in a pool. None of them may still be in use.
+*/
+void thsvsDestroyEventPool(
+    ThsvsEventPool*           pPool);
+
+/*
+Resets every event used since the last reset from the host, so that they
+can be used again. None of them may still be in use by the device.
+*/
+VkResult thsvsResetEventPool(
+    ThsvsEventPool*           pPool);
+
+/*
+A split barrier separates a barrier into two halves - the first recorded
+straight after the previous accesses, and the second just before the next
+accesses - so that any unrelated work recorded between them can overlap
+with the barrier, rather than stalling.
+
+thsvsCmdBeginSplitBarrier takes an event from pPool and sets it once the
+previous accesses of all the barriers are complete; thsvsCmdEndSplitBarrier
+waits on it with the same barriers, performing any memory dependencies and
+layout transitions.
+Both halves must be passed identical barriers, and must be recorded on the
+same queue - events cannot be used to synchronize across queues.
+
+If the pool has no events left, ThsvsSplitBarrier::event is set to
+VK_NULL_HANDLE, the first half records nothing, and the second half
+records an equivalent pipeline barrier instead.
+*/
+typedef struct ThsvsSplitBarrier {
+    VkEvent                   event;
+    VkPipelineStageFlags      srcStageMask;
+} ThsvsSplitBarrier;
+
+void thsvsCmdBeginSplitBarrier(
+    VkCommandBuffer           commandBuffer,
+    ThsvsEventPool*           pPool,
+    const ThsvsGlobalBarrier* pGlobalBarrier,
+    uint32_t                  bufferBarrierCount,
+    const ThsvsBufferBarrier* pBufferBarriers,
+    uint32_t                  imageBarrierCount,
+    const ThsvsImageBarrier*  pImageBarriers,
+    ThsvsSplitBarrier*        pSplitBarrier);
+
+void thsvsCmdEndSplitBarrier(
+    VkCommandBuffer           commandBuffer,
+    const ThsvsSplitBarrier*  pSplitBarrier,
+    const ThsvsGlobalBarrier* pGlobalBarrier,
+    uint32_t                  bufferBarrierCount,
+    const ThsvsBufferBarrier* pBufferBarriers,
+    uint32_t                  imageBarrierCount,
+    const ThsvsImageBarrier*  pImageBarriers);
+
+/*
+Execution barriers define an execution dependency only - commands executing
+the next accesses wait for commands executing the previous accesses, but no
+memory accesses are made available or visible, and no caches are flushed or
+invalidated.
+The access types are used only to determine the pipeline stages involved.
+
+This is only safe if memory visibility is already guaranteed by some other
+means - e.g. by a semaphore wait, or because the previous accesses were
+reads (a write-after-read hazard only needs an execution dependency).
+*/
+typedef struct ThsvsExecutionBarrier {
+    uint32_t                prevAccessCount;
+    const ThsvsAccessType*  pPrevAccesses;
+    uint32_t                nextAccessCount;
+    const ThsvsAccessType*  pNextAccesses;
+} ThsvsExecutionBarrier;
+
+/*
+Mapping function that translates an execution barrier into a set of source
+and destination pipeline stages.
+*/
+void thsvsGetVulkanExecutionDependency(
+    const ThsvsExecutionBarrier& thBarrier,
+    VkPipelineStageFlags*        pSrcStages,
+    VkPipelineStageFlags*        pDstStages);
+
+/*
+Records an execution barrier with vkCmdPipelineBarrier, with no memory
+barriers.
+*/
+void thsvsCmdExecutionBarrier(
+    VkCommandBuffer              commandBuffer,
+    const ThsvsExecutionBarrier* pExecutionBarrier);
+
+/*
+Waits on a set of events with vkCmdWaitEvents, with no memory barriers.
+*/
+void thsvsCmdWaitEventsExecution(
+    VkCommandBuffer              commandBuffer,
+    uint32_t                     eventCount,
+    const VkEvent*               pEvents,
+    const ThsvsExecutionBarrier* pExecutionBarrier);
+
+/*
+Adds an execution barrier to a barrier batch, so it can be merged with
+other barriers.
+*/
+void thsvsBatchExecutionBarrier(
+    ThsvsBarrierBatch*           pBatch,
+    const ThsvsExecutionBarrier* pExecutionBarrier);
+
+/*
+Returns the image layout that an image is in for a set of accesses - i.e.
+the newLayout of an image barrier with those next accesses.
+This is the layout to pass to anything else that needs to know it, such as
+VkRenderingAttachmentInfo::imageLayout or a descriptor write, so that it
+always matches what the barriers transition to.
+With THSVS_IMAGE_LAYOUT_OPTIMAL_SEPARATE_DEPTH_STENCIL, barriers on depth or
+stencil aspects also depend on the aspects covered - pass the result through
+thsvsSelectAspectImageLayout with the same aspect mask to match them.
+*/
+VkImageLayout thsvsGetVulkanImageLayout(
+    uint32_t               accessCount,
+    const ThsvsAccessType* pAccesses,
+    ThsvsImageLayout       layout);
+
+/*
+Attachment barriers are image barriers for the attachments of a render pass
+instance begun with vkCmdBeginRendering, taking the attachment's load
+operation into account.
+nextAccesses are the attachment accesses made while rendering, and the
+barrier's newLayout (or thsvsGetVulkanImageLayout) is the layout to render
+with.
+
+The load operation itself reads or writes the attachment, which the barrier
+waits for along with the next accesses.
+The load operation only applies inside the render area, so by default the
+previous contents are always preserved.
+If discardContents is set, the render area must cover the whole of
+subresourceRange; then with VK_ATTACHMENT_LOAD_OP_CLEAR or
+VK_ATTACHMENT_LOAD_OP_DONT_CARE the previous contents are not needed, so any
+transition is done from VK_IMAGE_LAYOUT_UNDEFINED, but no barrier is added
+just to discard them.
+discardContents has no effect with VK_ATTACHMENT_LOAD_OP_LOAD.
+*/
+typedef struct ThsvsAttachmentBarrier {
+    uint32_t                prevAccessCount;
+    const ThsvsAccessType*  pPrevAccesses;
+    uint32_t                nextAccessCount;
+    const ThsvsAccessType*  pNextAccesses;
+    ThsvsImageLayout        prevLayout;
+    ThsvsImageLayout        nextLayout;
+    VkAttachmentLoadOp      loadOp;
+    VkBool32                discardContents;
+    VkImage                 image;
+    VkImageSubresourceRange subresourceRange;
+} ThsvsAttachmentBarrier;
+
+/*
+Mapping function that translates an attachment barrier into a set of source
+and destination pipeline stages, and a VkImageMemoryBarrier to record before
+vkCmdBeginRendering.
+Returns VK_TRUE if the barrier is needed.
+*/
+VkBool32 thsvsGetVulkanAttachmentBarrier(
+    const ThsvsAttachmentBarrier& thBarrier,
+    VkPipelineStageFlags*         pSrcStages,
+    VkPipelineStageFlags*         pDstStages,
+    VkImageMemoryBarrier*         pVkBarrier);
+
+/*
+Mapping function that translates a global barrier between two subpasses
+into a VkSubpassDependency, with the same stages and access masks as
+thsvsGetVulkanMemoryBarrier.
+srcSubpass and dstSubpass are passed unmodified into the dependency, and
+either may be VK_SUBPASS_EXTERNAL.
+
+VK_DEPENDENCY_BY_REGION_BIT is set if both subpasses are in the render pass
+and every previous and next access is framebuffer local - i.e. an
+attachment or input attachment access - which allows tile based GPUs to keep
+attachments on chip between the subpasses.
+Any other access can touch memory outside of the current region, so needs a
+full dependency.
+The exception is a self-dependency (srcSubpass equal to dstSubpass) where
+both stage masks include framebuffer-space stages, which valid usage requires
+to be by region, so VK_DEPENDENCY_BY_REGION_BIT is always set for those.
+*/
+void thsvsGetVulkanSubpassDependency(
+    const ThsvsGlobalBarrier& thBarrier,
+    uint32_t                  srcSubpass,
+    uint32_t                  dstSubpass,
+    VkSubpassDependency*      pDependency);
+
+#ifdef VK_VERSION_1_2
+/*
+Equivalent to thsvsGetVulkanSubpassDependency, but for
+vkCreateRenderPass2; viewOffset is set to 0.
+*/
+void thsvsGetVulkanSubpassDependency2(
+    const ThsvsGlobalBarrier& thBarrier,
+    uint32_t                  srcSubpass,
+    uint32_t                  dstSubpass,
+    VkSubpassDependency2*     pDependency);
+#endif
+
+/*
+Queue family ownership transfers describe a single logical hand over of a
+buffer range or image subresource range from one queue family to another,
+from which both halves of the transfer are generated - a release barrier
+to execute on a queue in the source queue family, and an acquire barrier to
+execute on a queue in the destination queue family, with a semaphore
+guaranteeing execution order between them.
+
+prevAccesses are the accesses made on the source queue family before the
+transfer, and nextAccesses those made on the destination queue family
+after it; layouts and discardContents have the same meaning as in
+ThsvsImageBarrier.
+
+No ownership transfer is needed for resources created with
+VK_SHARING_MODE_CONCURRENT, or if both queue family indices are the same
+(or either is VK_QUEUE_FAMILY_IGNORED).
+In that case no release barrier is generated, and the acquire barrier is a
+regular barrier between the previous and next accesses - which is still
+needed for any layout transition.
+*/
+typedef struct ThsvsBufferTransfer {
+    uint32_t                prevAccessCount;
+    const ThsvsAccessType*  pPrevAccesses;
+    uint32_t                nextAccessCount;
+    const ThsvsAccessType*  pNextAccesses;
+    uint32_t                srcQueueFamilyIndex;
+    uint32_t                dstQueueFamilyIndex;
+    VkSharingMode           sharingMode;
+    VkBuffer                buffer;
+    VkDeviceSize            offset;
+    VkDeviceSize            size;
+} ThsvsBufferTransfer;
+
+typedef struct ThsvsImageTransfer {
+    uint32_t                prevAccessCount;
+    const ThsvsAccessType*  pPrevAccesses;
+    uint32_t                nextAccessCount;
+    const ThsvsAccessType*  pNextAccesses;
+    ThsvsImageLayout        prevLayout;
+    ThsvsImageLayout        nextLayout;
+    VkBool32                discardContents;
+    uint32_t                srcQueueFamilyIndex;
+    uint32_t                dstQueueFamilyIndex;
+    VkSharingMode           sharingMode;
+    VkImage                 image;
+    VkImageSubresourceRange subresourceRange;
+} ThsvsImageTransfer;
+
+/*
+Mapping functions that translate one half of a queue family ownership
+transfer into a set of pipeline stages and a Vulkan barrier.
+Returns VK_TRUE if the barrier needs to be recorded, and VK_FALSE if this
+half of the transfer can be skipped.
+*/
+VkBool32 thsvsGetVulkanBufferReleaseBarrier(
+    const ThsvsBufferTransfer& thTransfer,
+    VkPipelineStageFlags*      pSrcStages,
+    VkPipelineStageFlags*      pDstStages,
+    VkBufferMemoryBarrier*     pVkBarrier);
+
+VkBool32 thsvsGetVulkanBufferAcquireBarrier(
+    const ThsvsBufferTransfer& thTransfer,
+    VkPipelineStageFlags*      pSrcStages,
+    VkPipelineStageFlags*      pDstStages,
+    VkBufferMemoryBarrier*     pVkBarrier);
+
+VkBool32 thsvsGetVulkanImageReleaseBarrier(
+    const ThsvsImageTransfer&  thTransfer,
+    VkPipelineStageFlags*      pSrcStages,
+    VkPipelineStageFlags*      pDstStages,
+    VkImageMemoryBarrier*      pVkBarrier);
+
+VkBool32 thsvsGetVulkanImageAcquireBarrier(
+    const ThsvsImageTransfer&  thTransfer,
+    VkPipelineStageFlags*      pSrcStages,
+    VkPipelineStageFlags*      pDstStages,
+    VkImageMemoryBarrier*      pVkBarrier);
+
+/*
+Records the release or acquire halves of a set of queue family ownership
+transfers with a single call to vkCmdPipelineBarrier each.
+commandBuffer must be executed on a queue in the source queue family for
+thsvsCmdReleaseOwnership, and in the destination queue family for
+thsvsCmdAcquireOwnership.
+Nothing is recorded if none of the transfers need a barrier.
+*/
+void thsvsCmdReleaseOwnership(
+    VkCommandBuffer            commandBuffer,
+    uint32_t                   bufferTransferCount,
+    const ThsvsBufferTransfer* pBufferTransfers,
+    uint32_t                   imageTransferCount,
+    const ThsvsImageTransfer*  pImageTransfers);
+
+void thsvsCmdAcquireOwnership(
+    VkCommandBuffer            commandBuffer,
+    uint32_t                   bufferTransferCount,
+    const ThsvsBufferTransfer* pBufferTransfers,
+    uint32_t                   imageTransferCount,
+    const ThsvsImageTransfer*  pImageTransfers);
+
+/*
+Aliasing barriers hand memory over from one resource to another bound to
+the same memory - e.g. transient render targets sharing a heap.
+prevAccesses are the last accesses made to the outgoing resource, and
+nextAccesses are the first accesses made to the incoming resource. The
+contents of the outgoing resource are discarded.
+
+As the outgoing resource's writes are to a different resource than the one
+accessed next, they're made available with a VkMemoryBarrier, and an
+incoming image is transitioned from VK_IMAGE_LAYOUT_UNDEFINED to the layout
+of its first accesses - as if discardContents was set.
+Nothing waits on more than the outgoing resource's stages, so unlike using
+THSVS_ACCESS_GENERAL, this doesn't drain the whole pipeline.
+
+image should be VK_NULL_HANDLE if the incoming resource is a buffer, as no
+buffer barrier is needed.
+*/
+typedef struct ThsvsAliasingBarrier {
+    uint32_t                prevAccessCount;
+    const ThsvsAccessType*  pPrevAccesses;
+    uint32_t                nextAccessCount;
+    const ThsvsAccessType*  pNextAccesses;
+    ThsvsImageLayout        nextLayout;
+    VkImage                 image;
+    VkImageSubresourceRange subresourceRange;
+} ThsvsAliasingBarrier;
+
+/*
+Mapping function that translates an aliasing barrier into a set of source
+and destination pipeline stages, a VkMemoryBarrier, and - if the incoming
+resource is an image - a VkImageMemoryBarrier. pImageBarrier may be NULL if
+it isn't.
+*/
+VkBool32 thsvsGetVulkanAliasingBarrier(
+    const ThsvsAliasingBarrier& thBarrier,
+    VkPipelineStageFlags*       pSrcStages,
+    VkPipelineStageFlags*       pDstStages,
+    VkMemoryBarrier*            pMemoryBarrier,
+    VkImageMemoryBarrier*       pImageBarrier);
+
+/*
+Records a set of aliasing barriers with a single call to
+vkCmdPipelineBarrier, combining their memory barriers into one.
+*/
+void thsvsCmdAliasingBarrier(
+    VkCommandBuffer             commandBuffer,
+    uint32_t                    aliasingBarrierCount,
+    const ThsvsAliasingBarrier* pAliasingBarriers);
+
+/*
+Returns the pipeline stages that should wait on a semaphore before the
+accesses in pNextAccesses - i.e. the pWaitDstStageMask entry for it in a
+VkSubmitInfo - so that a queue waiting on another only stalls the stages
+that consume what it produced.
+A semaphore wait makes all memory visible to the waiting stages, so no
+access flags are needed.
+If nextAccessCount is 0, this returns VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT.
+*/
+VkPipelineStageFlags thsvsGetSemaphoreWaitStageMask(
+    uint32_t                    nextAccessCount,
+    const ThsvsAccessType*      pNextAccesses);
+
+/*
+ThsvsContext bundles the per thread state used when recording command
+buffers - a scratch allocator, a cache of compiled access sets, and some
+simple stats - so that none of it has to be shared between threads.
+
+A context is not thread safe, and is intended to be owned by a single
+recording thread; with one context per thread, recording takes no locks
+and touches no shared memory.
+Storage for the scratch allocator and the access set cache is provided by
+the application when the context is initialized.
+
+Access sets are cached by the set of accesses they contain, so each
+distinct access list only has to be compiled once per thread.
+The cache treats access lists as unordered, in the same way as
+thsvsCompileAccessMask.
+
+Stats count the Vulkan commands and barriers actually recorded, after any
+elision. Of those, layout transitions and queue family ownership transfers
+are counted separately, as are commands that wait on or block
+VK_PIPELINE_STAGE_ALL_COMMANDS_BIT or VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT -
+typically the result of THSVS_ACCESS_GENERAL or THSVS_ACCESS_ANY_SHADER_*
+accesses, which serialize far more work than is usually necessary.
+*/
+typedef struct ThsvsContextStats {
+    uint32_t                pipelineBarrierCount;
+    uint32_t                waitEventsCount;
+    uint32_t                memoryBarrierCount;
+    uint32_t                bufferMemoryBarrierCount;
+    uint32_t                imageMemoryBarrierCount;
+    uint32_t                layoutTransitionCount;
+    uint32_t                queueTransferCount;
+    uint32_t                broadStageMaskCount;
+    uint32_t                accessSetCacheHitCount;
+    uint32_t                accessSetCacheMissCount;
+} ThsvsContextStats;
+
+typedef struct ThsvsCachedAccessSet {
+    ThsvsAccessMask         accesses;
+    ThsvsAccessSet          accessSet;
+} ThsvsCachedAccessSet;
+
+typedef struct ThsvsContext {
+    ThsvsScratch            scratch;
+    uint32_t                accessSetCacheCapacity;
+    uint32_t                accessSetCacheCount;
+    ThsvsCachedAccessSet*   pAccessSetCache;
+    ThsvsContextStats       stats;
+} ThsvsContext;
+
+/*
+Initializes a context, with scratchSize bytes of scratch memory at
+pScratchMemory, and an access set cache of accessSetCacheCapacity entries
+at pAccessSetCache.
+The cache is indexed by masking a hash, so accessSetCacheCapacity should be
+a power of two, or 0 to disable the cache - any other capacity is rounded
+down to the largest power of two below it, leaving the remaining entries
+unused.
+Both must remain valid for as long as the context is used.
+*/
+void thsvsInitContext(
+    ThsvsContext*             pContext,
+    void*                     pScratchMemory,
+    size_t                    scratchSize,
+    uint32_t                  accessSetCacheCapacity,
+    ThsvsCachedAccessSet*     pAccessSetCache);
+
+/*
+Resets the scratch allocator of a context, e.g. once per command buffer.
+The access set cache and stats are kept - the stats can be read or cleared
+directly by the application.
+*/
+void thsvsResetContext(
+    ThsvsContext*             pContext);
+
+/*
+Returns a compiled access set for the passed in list of accesses, compiling
+it and adding it to the cache if it's not there already.
+If the cache is full, the set is compiled into the context's scratch memory
+instead; the returned set is only guaranteed to remain valid until the next
+call to thsvsResetContext.
+Returns NULL only if the cache is full and there is no scratch memory left.
+*/
+const ThsvsAccessSet* thsvsContextGetAccessSet(
+    ThsvsContext*             pContext,
+    uint32_t                  accessCount,
+    const ThsvsAccessType*    pAccesses);
+
+/*
+Equivalent to thsvsCmdPipelineBarrierScratch using the context's scratch
+allocator, additionally counting what was recorded in the context's stats.
+*/
+void thsvsContextCmdPipelineBarrier(
+    ThsvsContext*             pContext,
+    VkCommandBuffer           commandBuffer,
+    const ThsvsGlobalBarrier* pGlobalBarrier,
+    uint32_t                  bufferBarrierCount,
+    const ThsvsBufferBarrier* pBufferBarriers,
+    uint32_t                  imageBarrierCount,
+    const ThsvsImageBarrier*  pImageBarriers);
+
+/*
+Adds the stats of a context to pTotalStats and clears them, e.g. to gather
+the stats of all recording threads once per frame.
+*/
+void thsvsMergeContextStats(
+    ThsvsContext*             pContext,
+    ThsvsContextStats*        pTotalStats);
+
+/*
+Returns the stats for every command recorded by this library on the calling
+thread, if the implementation is built with THSVS_STATS - NULL otherwise.
+These are thread local, so they can be read or cleared by the application
+without synchronization.
+*/
+ThsvsContextStats* thsvsGetThreadStats();
+
+/*
+If the implementation is built with THSVS_DIAGNOSTICS, each barrier recorded
+or batched by this library is checked for over-synchronization, and anything
+found is reported to a diagnostic callback with a message. Unlike the
+THSVS_ERROR_CHECK_* asserts, none of these are errors - they point to
+barriers that likely serialize more work than they need to.
+*/
+typedef enum ThsvsDiagnosticType {
+    THSVS_DIAGNOSTIC_NARROWER_ACCESS_TYPE,  // THSVS_ACCESS_GENERAL or a THSVS_ACCESS_ANY_SHADER_* access, where a more specific access type would wait on or block fewer stages
+    THSVS_DIAGNOSTIC_GLOBAL_BARRIER,        // A buffer or image barrier with no layout transition or queue family ownership transfer, which a global barrier could replace
+    THSVS_DIAGNOSTIC_MERGEABLE_BARRIERS,    // A pipeline barrier recorded directly after another one in the same command buffer, which could have been merged with it
+
+    THSVS_NUM_DIAGNOSTIC_TYPES
+} ThsvsDiagnosticType;
+
+typedef void (*ThsvsDiagnosticCallback)(
+    ThsvsDiagnosticType       type,
+    const char*               pMessage,
+    void*                     pUserData);
+
+/*
+Sets the callback that diagnostics are reported to, or NULL to ignore them.
+This is shared by all threads, so it should be set before recording starts.
+Does nothing if the implementation is not built with THSVS_DIAGNOSTICS.
+*/
+void thsvsSetDiagnosticCallback(
+    ThsvsDiagnosticCallback   callback,
+    void*                     pUserData);
+
+/*
+Tells the diagnostics that a command other than a barrier has been recorded
+to commandBuffer on the calling thread.
+As the library can't see other commands, mergeable barriers are only
+reported once this has been called on a thread - and then it must be called
+after every other command that's recorded between barriers.
+Does nothing if the implementation is not built with THSVS_DIAGNOSTICS.
+*/
+void thsvsDiagnoseCommand(
+    VkCommandBuffer           commandBuffer);
+
+/*
+If the implementation is built with THSVS_CAPTURE, each barrier recorded by
+thsvsCmdPipelineBarrier, thsvsCmdWaitEvents and their variants - including
+thsvsCmdWaitEventBarriers and the synchronization2 commands - is appended to
+the calling thread's capture as a compact binary record - its access type
+lists, the masks and layouts they were translated to, and a timestamp - so
+that a frame's barriers can be analyzed offline without a full API capture.
+Synchronization2 barriers are captured with their legacy translation, as
+that's what replay checks against.
+
+thsvsCmdFlushBarrierBatch (and so thsvsCmdExecuteFrameGraph),
+thsvsCmdAliasingBarrier, thsvsCmdReleaseOwnership and
+thsvsCmdAcquireOwnership only have the Vulkan barriers they record by then,
+so those are captured with no access types and
+THSVS_CAPTURE_BARRIER_NO_ACCESS_TYPES_BIT set.
+thsvsCmdExecutionBarrier and thsvsCmdWaitEventsExecution are captured with
+their stage masks and no barriers.
+Setting an event isn't captured; its barriers are captured by the wait.
+
+A capture is a ring buffer over application provided memory; once it's full,
+the oldest records are overwritten. thsvsGetCaptureData copies the records
+out in order, to be written to disk and read back by e.g. test/replay.c,
+which re-runs the translation and summarizes barriers per pass.
+
+The data starts with a ThsvsCaptureHeader, followed by recordCount records.
+Each record starts with a ThsvsCaptureRecord, whose size includes everything
+up to the next record. Barrier records are followed by barrierCount
+ThsvsCaptureBarriers, each followed by its previous and then next access
+types, one byte each, padded to 4 bytes. Pass records are followed by the
+pass name, nul terminated. Records are padded to 8 bytes.
+*/
+#define THSVS_CAPTURE_MAGIC   0x43565354u // "TSVC" as bytes, on little endian machines
+#define THSVS_CAPTURE_VERSION 1u
+
+typedef enum ThsvsCaptureRecordType {
+    THSVS_CAPTURE_RECORD_PIPELINE_BARRIER = 1,  // thsvsCmdPipelineBarrier or a variant
+    THSVS_CAPTURE_RECORD_WAIT_EVENTS      = 2,  // thsvsCmdWaitEvents or a variant
+    THSVS_CAPTURE_RECORD_PASS             = 3   // thsvsCaptureBeginPass
+} ThsvsCaptureRecordType;
+
+typedef enum ThsvsCaptureBarrierType {
+    THSVS_CAPTURE_BARRIER_GLOBAL = 0,
+    THSVS_CAPTURE_BARRIER_BUFFER = 1,
+    THSVS_CAPTURE_BARRIER_IMAGE  = 2
+} ThsvsCaptureBarrierType;
+
+#define THSVS_CAPTURE_BARRIER_NEEDED_BIT           0x1u  // The mapping function returned VK_TRUE
+#define THSVS_CAPTURE_BARRIER_DISCARD_CONTENTS_BIT 0x2u
+#define THSVS_CAPTURE_BARRIER_NO_ACCESS_TYPES_BIT  0x4u  // Captured from the Vulkan barrier alone, so can't be translated again
+
+typedef struct ThsvsCaptureHeader {
+    uint32_t                magic;
+    uint32_t                version;
+    uint32_t                recordCount;
+    uint32_t                droppedRecordCount;
+} ThsvsCaptureHeader;
+
+typedef struct ThsvsCaptureRecord {
+    uint32_t                size;
+    uint32_t                type;
+    uint64_t                timestamp;
+    VkPipelineStageFlags    srcStageMask;   // For a pass record, the pass index
+    VkPipelineStageFlags    dstStageMask;
+    uint32_t                barrierCount;
+    VkBool32                recorded;       // VK_FALSE if every barrier was elided, so nothing was recorded
+} ThsvsCaptureRecord;
+
+typedef struct ThsvsCaptureBarrier {
+    uint8_t                 type;
+    uint8_t                 flags;
+    uint8_t                 prevAccessCount;  // Access lists longer than 255 are truncated
+    uint8_t                 nextAccessCount;
+    uint8_t                 prevLayout;
+    uint8_t                 nextLayout;
+    uint16_t                reserved;
+    uint32_t                srcQueueFamilyIndex;
+    uint32_t                dstQueueFamilyIndex;
+    VkAccessFlags           srcAccessMask;
+    VkAccessFlags           dstAccessMask;
+    VkImageLayout           oldLayout;
+    VkImageLayout           newLayout;
+} ThsvsCaptureBarrier;
+
+typedef struct ThsvsCapture {
+    uint8_t*                pMemory;
+    size_t                  size;
+    size_t                  writeOffset;
+    size_t                  oldestOffset;
+    size_t                  wrapOffset;
+    uint32_t                recordCount;
+    uint32_t                droppedRecordCount;
+} ThsvsCapture;
+
+/*
+Initializes an empty capture that records into the size bytes at pMemory,
+which must remain valid for as long as the capture is used.
+*/
+void thsvsInitCapture(
+    ThsvsCapture*             pCapture,
+    void*                     pMemory,
+    size_t                    size);
+
+/*
+Discards every record in a capture, e.g. at the start of a frame.
+*/
+void thsvsResetCapture(
+    ThsvsCapture*             pCapture);
+
+/*
+Sets the capture that barriers recorded on the calling thread are appended
+to, or NULL to stop capturing.
+Does nothing if the implementation is not built with THSVS_CAPTURE.
+*/
+void thsvsSetThreadCapture(
+    ThsvsCapture*             pCapture);
+
+/*
+Appends a pass record to the calling thread's capture, so that the barriers
+that follow it are attributed to the pass. pPassName may be NULL.
+Does nothing if the implementation is not built with THSVS_CAPTURE.
+*/
+void thsvsCaptureBeginPass(
+    uint32_t                  passIndex,
+    const char*               pPassName);
+
+/*
+Copies the contents of a capture, oldest record first, to pData.
+Returns the number of bytes needed; if pData is NULL or dataSize is less
+than that, nothing is copied.
+*/
+size_t thsvsGetCaptureData(
+    const ThsvsCapture*       pCapture,
+    void*                     pData,
+    size_t                    dataSize);
+
+/*
+If the implementation is built with THSVS_PROFILE, each pipeline barrier
+recorded on a thread with a profiler set - by thsvsCmdPipelineBarrier,
+thsvsCmdPipelineBarrier2 or their variants, thsvsCmdFlushBarrierBatch (and so
+each level of thsvsCmdExecuteFrameGraph), thsvsCmdAliasingBarrier, or
+thsvsCmdReleaseOwnership and thsvsCmdAcquireOwnership - is bracketed by a pair
+of timestamp queries, and tagged with the transition it makes, so that the
+GPU cost of each kind of transition can be measured. Execution-only barriers
+and event waits are not timed.
+
+A profiler has a timestamp query pool for each frame in flight, with two
+queries for each barrier. thsvsCmdBeginProfilerFrame recycles the pool of the
+oldest frame once its results have been added to the profiler's transition
+costs, so like an event pool, a profiler would typically be owned by one
+recording thread, with a frame for each frame in flight.
+
+Each barrier command is tagged with the last previous and next access types -
+which determine the image layouts - of the first image barrier that
+transitions its layout, or otherwise of its first image, buffer or global
+barrier. Batched, aliasing and ownership transfer barriers no longer have
+their access types, so they're tagged with THSVS_ACCESS_NONE and the layouts
+of their first image barrier that changes layout, or otherwise of their first
+image barrier. Both timestamps are written at
+VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, so the time between them is what the
+barrier costs once earlier work has completed - cache flushes, invalidates
+and layout transitions.
+*/
+typedef struct ThsvsProfileTag {
+    ThsvsAccessType         prevAccess;
+    ThsvsAccessType         nextAccess;
+    VkImageLayout           oldLayout;      // VK_IMAGE_LAYOUT_UNDEFINED for buffer and global barriers
+    VkImageLayout           newLayout;
+} ThsvsProfileTag;
+
+typedef struct ThsvsProfilerFrame {
+    VkQueryPool             queryPool;
+    uint32_t                barrierCount;   // Barriers timed in the frame, whose results haven't been read
+    ThsvsProfileTag*        pTags;
+} ThsvsProfilerFrame;
+
+typedef struct ThsvsTransitionCost {
+    ThsvsProfileTag         tag;
+    uint32_t                count;
+    double                  totalMicroseconds;
+    double                  maxMicroseconds;
+} ThsvsTransitionCost;
+
+typedef struct ThsvsProfiler {
+    VkDevice                device;
+    float                   timestampPeriod;
+    uint32_t                maxBarrierCount;
+    uint32_t                frameCount;
+    uint32_t                frameIndex;
+    VkBool32                frameBegun;
+    ThsvsProfilerFrame*     pFrames;
+    uint32_t                transitionCapacity;
+    uint32_t                transitionCount;
+    ThsvsTransitionCost*    pTransitions;
+    uint32_t                droppedBarrierCount;  // Barriers not timed as a frame or the transition costs were full
+} ThsvsProfiler;
+
+/*
+Creates a timestamp query pool for each of frameCount frames in
+pFrameStorage, with room to time maxBarrierCount barriers a frame, and
+initializes a profiler with them.
+timestampPeriod is VkPhysicalDeviceLimits::timestampPeriod, and barriers
+must be recorded on queues with non-zero timestampValidBits.
+pTagStorage must have space for frameCount * maxBarrierCount tags, and
+pTransitionStorage for transitionCapacity distinct transitions.
+If creating any query pool fails, any already created are destroyed and the
+error is returned.
+*/
+VkResult thsvsCreateProfiler(
+    ThsvsProfiler*            pProfiler,
+    VkDevice                  device,
+    float                     timestampPeriod,
+    uint32_t                  frameCount,
+    uint32_t                  maxBarrierCount,
+    ThsvsProfilerFrame*       pFrameStorage,
+    ThsvsProfileTag*          pTagStorage,
+    uint32_t                  transitionCapacity,
+    ThsvsTransitionCost*      pTransitionStorage);
+
+/*
+Destroys all query pools in a profiler. None of them may still be in use.
+*/
+void thsvsDestroyProfiler(
+    ThsvsProfiler*            pProfiler);
+
+/*
+Moves a profiler on to its next frame, adding the results of the barriers
+timed when that frame was last used to the transition costs, and recording a
+reset of its query pool to commandBuffer - outside of any render pass, and
+before any barriers are timed in the frame.
+The device must have finished executing everything recorded in that frame;
+if reading its results fails, the error is returned and they're discarded.
+*/
+VkResult thsvsCmdBeginProfilerFrame(
+    ThsvsProfiler*            pProfiler,
+    VkCommandBuffer           commandBuffer);
+
+/*
+Sets the profiler that barriers recorded on the calling thread are timed
+with, or NULL to stop timing them.
+Does nothing if the implementation is not built with THSVS_PROFILE.
+*/
+void thsvsSetThreadProfiler(
+    ThsvsProfiler*            pProfiler);
+
+/*
+Sorts a profiler's transition costs from the highest total time to the
+lowest, returning the number of distinct transitions timed so far and
+setting *ppCosts to point at them.
+*/
+uint32_t thsvsGetTransitionCosts(
+    ThsvsProfiler*              pProfiler,
+    const ThsvsTransitionCost** ppCosts);
+
+/*
+Discards a profiler's transition costs, e.g. to measure a different scene.
+*/
+void thsvsResetTransitionCosts(
+    ThsvsProfiler*            pProfiler);
+
+/*
+ThsvsLocalBufferState and ThsvsLocalImageState are thread local versions of
+ThsvsBufferState and ThsvsImageState, for resources accessed in secondary
+command buffers recorded on other threads.
+
+A recording thread can't know what the primary command buffer will have
+done with a resource by the time its secondary executes, so a local state
+starts out knowing nothing, and records no barrier for the first accesses
+made to the resource - any reads up until the first write or layout change
+are gathered together instead.
+Any accesses after that are tracked as normal.
+
+Once recording has finished, each local state is merged into the primary's
+tracked state with thsvsMergeBufferState or thsvsMergeImageState, in the
+order the secondaries will be executed.
+This produces the barrier to record in the primary command buffer before
+the secondary executes - which makes the first accesses in the secondary
+wait on whatever the primary did before - and leaves the primary's state as
+it will be after the secondary executes.
+As each thread only writes its own local states, and merging happens on the
+submitting thread after recording has finished, none of this needs locks.
+
+Local states for a range must match the range of the primary's state they
+are merged into.
+*/
+typedef struct ThsvsLocalBufferState {
+    ThsvsBufferState        state;
+    ThsvsAccessSet          firstAccessSet;
+    VkBool32                modified;
+} ThsvsLocalBufferState;
+
+typedef struct ThsvsLocalImageState {
+    ThsvsImageState         state;
+    ThsvsAccessSet          firstAccessSet;
+    VkImageLayout           firstLayout;
+    VkBool32                firstDiscardContents;
+    VkBool32                modified;
+} ThsvsLocalImageState;
+
+/*
+Initializes a local state for a range that hasn't yet been accessed in the
+recording command buffer.
+*/
+void thsvsInitLocalBufferState(
+    ThsvsLocalBufferState*  pLocalState,
+    VkBuffer                buffer,
+    VkDeviceSize            offset,
+    VkDeviceSize            size);
+
+void thsvsInitLocalImageState(
+    ThsvsLocalImageState*   pLocalState,
+    VkImage                 image,
+    VkImageSubresourceRange subresourceRange);
+
+/*
+Equivalent to thsvsTransitionBufferState and thsvsTransitionImageState,
+except that no barrier is returned for the first accesses to the range.
+*/
+VkBool32 thsvsTransitionLocalBufferState(
+    ThsvsLocalBufferState*  pLocalState,
+    uint32_t                nextAccessCount,
+    const ThsvsAccessType*  pNextAccesses,
+    VkPipelineStageFlags*   pSrcStages,
+    VkPipelineStageFlags*   pDstStages,
+    VkBufferMemoryBarrier*  pVkBarrier);
+
+VkBool32 thsvsTransitionLocalImageState(
+    ThsvsLocalImageState*   pLocalState,
+    uint32_t                nextAccessCount,
+    const ThsvsAccessType*  pNextAccesses,
+    ThsvsImageLayout        nextLayout,
+    VkBool32                discardContents,
+    VkPipelineStageFlags*   pSrcStages,
+    VkPipelineStageFlags*   pDstStages,
+    VkImageMemoryBarrier*   pVkBarrier);
+
+/*
+Merges a local state into the state tracked by the primary command buffer.
+If a barrier is required before the secondary command buffer executes, it's
+written to pVkBarrier along with the stage masks to use for it, and VK_TRUE
+is returned.
+Otherwise VK_FALSE is returned and the outputs are not written.
+Local states that weren't accessed have no effect.
+*/
+VkBool32 thsvsMergeBufferState(
+    ThsvsBufferState*            pState,
+    const ThsvsLocalBufferState* pLocalState,
+    VkPipelineStageFlags*        pSrcStages,
+    VkPipelineStageFlags*        pDstStages,
+    VkBufferMemoryBarrier*       pVkBarrier);
+
+VkBool32 thsvsMergeImageState(
+    ThsvsImageState*             pState,
+    const ThsvsLocalImageState*  pLocalState,
+    VkPipelineStageFlags*        pSrcStages,
+    VkPipelineStageFlags*        pDstStages,
+    VkImageMemoryBarrier*        pVkBarrier);
+
+/*
+Convenience functions that merge a local state, adding any barrier that's
+required to a barrier batch - so that all the barriers needed before a
+secondary executes can be recorded with a single call.
+*/
+void thsvsBatchMergeBufferState(
+    ThsvsBarrierBatch*           pBatch,
+    ThsvsBufferState*            pState,
+    const ThsvsLocalBufferState* pLocalState);
+
+void thsvsBatchMergeImageState(
+    ThsvsBarrierBatch*           pBatch,
+    ThsvsImageState*             pState,
+    const ThsvsLocalImageState*  pLocalState);
+
+/*
+A frame graph describes the passes of a frame up front, each declaring the
+tracked buffer and image states it accesses, so that barriers can be placed
+for the whole frame rather than one pass at a time.
+
+thsvsScheduleFrameGraph assigns each pass to a level - the earliest point it
+can execute, after every earlier pass it depends on. A pass depends on an
+earlier one if they access the same state and either of them writes to it,
+or they use it in different image layouts; passes that don't depend on each
+other keep their relative order.
+thsvsCmdExecuteFrameGraph then records the passes level by level, with a
+single vkCmdPipelineBarrier before each level covering every pass in it -
+where recording the passes in their original order may need a barrier (and
+a pipeline drain) between each of them.
+
+The application is responsible for making sure that the states accessed do
+not overlap, as with tracked states generally, and for pass storage.
+*/
+typedef struct ThsvsPassAccess {
+    ThsvsBufferState*       pBufferState;       // The buffer state accessed, or NULL if an image state is accessed
+    ThsvsImageState*        pImageState;        // The image state accessed, or NULL if a buffer state is accessed
+    uint32_t                accessCount;
+    const ThsvsAccessType*  pAccesses;
+    ThsvsImageLayout        layout;             // Unused for buffers
+    VkBool32                discardContents;    // Unused for buffers
+} ThsvsPassAccess;
+
+typedef struct ThsvsPass {
+    uint32_t                accessCount;
+    const ThsvsPassAccess*  pAccesses;
+} ThsvsPass;
+
+/*
+Called by thsvsCmdExecuteFrameGraph to record the commands of a pass, with
+the index of the pass in pPasses.
+The callback must not record any barriers for the states the pass accesses.
+*/
+typedef void (*ThsvsRecordPassCallback)(
+    VkCommandBuffer           commandBuffer,
+    uint32_t                  passIndex,
+    void*                     pUserData);
+
+/*
+Schedules passCount passes, given in the order the application would record
+them, and returns the number of levels.
+pPassOrder receives the indices of the passes in the order to record them,
+sorted by level, and pPassLevels receives the level of each pass.
+Both must have space for passCount elements.
+*/
+uint32_t thsvsScheduleFrameGraph(
+    uint32_t                  passCount,
+    const ThsvsPass*          pPasses,
+    uint32_t*                 pPassOrder,
+    uint32_t*                 pPassLevels);
+
+/*
+Records scheduled passes with recordPass, transitioning their states with
+pBatch - which is flushed before the passes of each level are recorded.
+Access lists for states used by several passes of a level are combined in
+memory allocated from pScratch, falling back to THSVS_TEMP_ALLOC if pScratch
+is NULL or does not have enough space.
+*/
+void thsvsCmdExecuteFrameGraph(
+    ThsvsBarrierBatch*        pBatch,
+    ThsvsScratch*             pScratch,
+    uint32_t                  passCount,
+    const ThsvsPass*          pPasses,
+    const uint32_t*           pPassOrder,
+    const uint32_t*           pPassLevels,
+    ThsvsRecordPassCallback   recordPass,
+    void*                     pUserData);
+
+/*
+THSVS_CONSTEXPR marks the functions that translate access types as
+constexpr when compiling as C++14 or later, so that access types known at
+compile time can be translated by the compiler - see thsvsMakeAccessSet.
+It expands to nothing otherwise.
+*/
+#if defined(__cplusplus) && (__cplusplus >= 201402L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201402L))
+#define THSVS_CONSTEXPR constexpr
+#define THSVS_HAS_CONSTEXPR_BARRIERS
+#else
+#define THSVS_CONSTEXPR
+#endif
+
+/*
+ThsvsVkAccessInfo is the Vulkan equivalent of a single access type.
+THSVS_ACCESS_MAP_ENTRIES lists one for every access type, in the order of
+ThsvsAccessType, as X(accessType, stageMask, accessMask, imageLayout).
+ThsvsAccessMap in the implementation and the copy the C++14 layer evaluates at
+compile time are both generated from it, so they can't disagree. These are
+exposed in the header only for that copy; use thsvsGetAccessInfo to translate
+accesses at runtime.
+*/
+typedef struct ThsvsVkAccessInfo {
+    VkPipelineStageFlags    stageMask;
+    VkAccessFlags           accessMask;
+    VkImageLayout           imageLayout;
+} ThsvsVkAccessInfo;
+
+#define THSVS_ACCESS_MAP_ENTRIES(X)                                                                 \
+    X(THSVS_ACCESS_NONE,                                                                            \
+        0,                                                                                          \
+        0,                                                                                          \
+        VK_IMAGE_LAYOUT_UNDEFINED)                                                                  \
+    /* Read Access */                                                                               \
+    X(THSVS_ACCESS_COMMAND_BUFFER_READ_NV,                                                          \
+        VK_PIPELINE_STAGE_COMMAND_PREPROCESS_BIT_NV,                                                \
+        VK_ACCESS_COMMAND_PREPROCESS_READ_BIT_NV,                                                   \
+        VK_IMAGE_LAYOUT_UNDEFINED)                                                                  \
+    X(THSVS_ACCESS_INDIRECT_BUFFER,                                                                 \
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,                                                        \
+        VK_ACCESS_INDIRECT_COMMAND_READ_BIT,                                                        \
+        VK_IMAGE_LAYOUT_UNDEFINED)                                                                  \
+    X(THSVS_ACCESS_INDEX_BUFFER,                                                                    \
+        VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,                                                         \
+        VK_ACCESS_INDEX_READ_BIT,                                                                   \
+        VK_IMAGE_LAYOUT_UNDEFINED)                                                                  \
+    X(THSVS_ACCESS_VERTEX_BUFFER,                                                                   \
+        VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,                                                         \
+        VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT,                                                        \
+        VK_IMAGE_LAYOUT_UNDEFINED)                                                                  \
+    X(THSVS_ACCESS_VERTEX_SHADER_READ_UNIFORM_BUFFER,                                               \
+        VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,                                                        \
+        VK_ACCESS_UNIFORM_READ_BIT,                                                                 \
+        VK_IMAGE_LAYOUT_UNDEFINED)                                                                  \
+    X(THSVS_ACCESS_VERTEX_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER,                        \
+        VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,                                                        \
+        VK_ACCESS_SHADER_READ_BIT,                                                                  \
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)                                                   \
+    X(THSVS_ACCESS_VERTEX_SHADER_READ_OTHER,                                                        \
+        VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,                                                        \
+        VK_ACCESS_SHADER_READ_BIT,                                                                  \
+        VK_IMAGE_LAYOUT_GENERAL)                                                                    \
+    X(THSVS_ACCESS_TESSELLATION_CONTROL_SHADER_READ_UNIFORM_BUFFER,                                 \
+        VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT,                                          \
+        VK_ACCESS_UNIFORM_READ_BIT,                                                                 \
+        VK_IMAGE_LAYOUT_UNDEFINED)                                                                  \
+    X(THSVS_ACCESS_TESSELLATION_CONTROL_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER,          \
+        VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT,                                          \
+        VK_ACCESS_SHADER_READ_BIT,                                                                  \
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)                                                   \
+    X(THSVS_ACCESS_TESSELLATION_CONTROL_SHADER_READ_OTHER,                                          \
+        VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT,                                          \
+        VK_ACCESS_SHADER_READ_BIT,                                                                  \
+        VK_IMAGE_LAYOUT_GENERAL)                                                                    \
+    X(THSVS_ACCESS_TESSELLATION_EVALUATION_SHADER_READ_UNIFORM_BUFFER,                              \
+        VK_PIPELINE_STAGE_TESSELLATION_EVALUATION_SHADER_BIT,                                       \
+        VK_ACCESS_UNIFORM_READ_BIT,                                                                 \
+        VK_IMAGE_LAYOUT_UNDEFINED)                                                                  \
+    X(THSVS_ACCESS_TESSELLATION_EVALUATION_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER,       \
+        VK_PIPELINE_STAGE_TESSELLATION_EVALUATION_SHADER_BIT,                                       \
+        VK_ACCESS_SHADER_READ_BIT,                                                                  \
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)                                                   \
+    X(THSVS_ACCESS_TESSELLATION_EVALUATION_SHADER_READ_OTHER,                                       \
+        VK_PIPELINE_STAGE_TESSELLATION_EVALUATION_SHADER_BIT,                                       \
+        VK_ACCESS_SHADER_READ_BIT,                                                                  \
+        VK_IMAGE_LAYOUT_GENERAL)                                                                    \
+    X(THSVS_ACCESS_GEOMETRY_SHADER_READ_UNIFORM_BUFFER,                                             \
+        VK_PIPELINE_STAGE_GEOMETRY_SHADER_BIT,                                                      \
+        VK_ACCESS_UNIFORM_READ_BIT,                                                                 \
+        VK_IMAGE_LAYOUT_UNDEFINED)                                                                  \
+    X(THSVS_ACCESS_GEOMETRY_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER,                      \
+        VK_PIPELINE_STAGE_GEOMETRY_SHADER_BIT,                                                      \
+        VK_ACCESS_SHADER_READ_BIT,                                                                  \
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)                                                   \
+    X(THSVS_ACCESS_GEOMETRY_SHADER_READ_OTHER,                                                      \
+        VK_PIPELINE_STAGE_GEOMETRY_SHADER_BIT,                                                      \
+        VK_ACCESS_SHADER_READ_BIT,                                                                  \
+        VK_IMAGE_LAYOUT_GENERAL)                                                                    \
+    X(THSVS_ACCESS_TASK_SHADER_READ_UNIFORM_BUFFER_NV,                                              \
+        VK_PIPELINE_STAGE_TASK_SHADER_BIT_NV,                                                       \
+        VK_ACCESS_UNIFORM_READ_BIT,                                                                 \
+        VK_IMAGE_LAYOUT_UNDEFINED)                                                                  \
+    X(THSVS_ACCESS_TASK_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER_NV,                       \
+        VK_PIPELINE_STAGE_TASK_SHADER_BIT_NV,                                                       \
+        VK_ACCESS_SHADER_READ_BIT,                                                                  \
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)                                                   \
+    X(THSVS_ACCESS_TASK_SHADER_READ_OTHER_NV,                                                       \
+        VK_PIPELINE_STAGE_TASK_SHADER_BIT_NV,                                                       \
+        VK_ACCESS_SHADER_READ_BIT,                                                                  \
+        VK_IMAGE_LAYOUT_GENERAL)                                                                    \
+    X(THSVS_ACCESS_MESH_SHADER_READ_UNIFORM_BUFFER_NV,                                              \
+        VK_PIPELINE_STAGE_MESH_SHADER_BIT_NV,                                                       \
+        VK_ACCESS_UNIFORM_READ_BIT,                                                                 \
+        VK_IMAGE_LAYOUT_UNDEFINED)                                                                  \
+    X(THSVS_ACCESS_MESH_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER_NV,                       \
+        VK_PIPELINE_STAGE_MESH_SHADER_BIT_NV,                                                       \
+        VK_ACCESS_SHADER_READ_BIT,                                                                  \
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)                                                   \
+    X(THSVS_ACCESS_MESH_SHADER_READ_OTHER_NV,                                                       \
+        VK_PIPELINE_STAGE_MESH_SHADER_BIT_NV,                                                       \
+        VK_ACCESS_SHADER_READ_BIT,                                                                  \
+        VK_IMAGE_LAYOUT_GENERAL)                                                                    \
+    X(THSVS_ACCESS_TRANSFORM_FEEDBACK_COUNTER_READ_EXT,                                             \
+        VK_PIPELINE_STAGE_TRANSFORM_FEEDBACK_BIT_EXT,                                               \
+        VK_ACCESS_TRANSFORM_FEEDBACK_COUNTER_READ_BIT_EXT,                                          \
+        VK_IMAGE_LAYOUT_UNDEFINED)                                                                  \
+    X(THSVS_ACCESS_FRAGMENT_DENSITY_MAP_READ_EXT,                                                   \
+        VK_PIPELINE_STAGE_FRAGMENT_DENSITY_PROCESS_BIT_EXT,                                         \
+        VK_ACCESS_FRAGMENT_DENSITY_MAP_READ_BIT_EXT,                                                \
+        VK_IMAGE_LAYOUT_FRAGMENT_DENSITY_MAP_OPTIMAL_EXT)                                           \
+    X(THSVS_ACCESS_SHADING_RATE_READ_NV,                                                            \
+        VK_PIPELINE_STAGE_SHADING_RATE_IMAGE_BIT_NV,                                                \
+        VK_ACCESS_SHADING_RATE_IMAGE_READ_BIT_NV,                                                   \
+        VK_IMAGE_LAYOUT_SHADING_RATE_OPTIMAL_NV)                                                    \
+    X(THSVS_ACCESS_FRAGMENT_SHADER_READ_UNIFORM_BUFFER,                                             \
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,                                                      \
+        VK_ACCESS_UNIFORM_READ_BIT,                                                                 \
+        VK_IMAGE_LAYOUT_UNDEFINED)                                                                  \
+    X(THSVS_ACCESS_FRAGMENT_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER,                      \
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,                                                      \
+        VK_ACCESS_SHADER_READ_BIT,                                                                  \
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)                                                   \
+    X(THSVS_ACCESS_FRAGMENT_SHADER_READ_COLOR_INPUT_ATTACHMENT,                                     \
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,                                                      \
+        VK_ACCESS_INPUT_ATTACHMENT_READ_BIT,                                                        \
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)                                                   \
+    X(THSVS_ACCESS_FRAGMENT_SHADER_READ_DEPTH_STENCIL_INPUT_ATTACHMENT,                             \
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,                                                      \
+        VK_ACCESS_INPUT_ATTACHMENT_READ_BIT,                                                        \
+        VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL)                                            \
+    X(THSVS_ACCESS_FRAGMENT_SHADER_READ_OTHER,                                                      \
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,                                                      \
+        VK_ACCESS_SHADER_READ_BIT,                                                                  \
+        VK_IMAGE_LAYOUT_GENERAL)                                                                    \
+    X(THSVS_ACCESS_COLOR_ATTACHMENT_READ,                                                           \
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,                                              \
+        VK_ACCESS_COLOR_ATTACHMENT_READ_BIT,                                                        \
+        VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL)                                                   \
+    X(THSVS_ACCESS_COLOR_ATTACHMENT_ADVANCED_BLENDING_EXT,                                          \
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,                                              \
+        VK_ACCESS_COLOR_ATTACHMENT_READ_NONCOHERENT_BIT_EXT,                                        \
+        VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL)                                                   \
+    X(THSVS_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ,                                                   \
+        VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,     \
+        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,                                                \
+        VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL)                                            \
+    X(THSVS_ACCESS_COMPUTE_SHADER_READ_UNIFORM_BUFFER,                                              \
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,                                                       \
+        VK_ACCESS_UNIFORM_READ_BIT,                                                                 \
+        VK_IMAGE_LAYOUT_UNDEFINED)                                                                  \
+    X(THSVS_ACCESS_COMPUTE_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER,                       \
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,                                                       \
+        VK_ACCESS_SHADER_READ_BIT,                                                                  \
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)                                                   \
+    X(THSVS_ACCESS_COMPUTE_SHADER_READ_OTHER,                                                       \
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,                                                       \
+        VK_ACCESS_SHADER_READ_BIT,                                                                  \
+        VK_IMAGE_LAYOUT_GENERAL)                                                                    \
+    X(THSVS_ACCESS_ANY_SHADER_READ_UNIFORM_BUFFER,                                                  \
+        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,                                                         \
+        VK_ACCESS_UNIFORM_READ_BIT,                                                                 \
+        VK_IMAGE_LAYOUT_UNDEFINED)                                                                  \
+    X(THSVS_ACCESS_ANY_SHADER_READ_UNIFORM_BUFFER_OR_VERTEX_BUFFER,                                 \
+        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,                                                         \
+        VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT,                           \
+        VK_IMAGE_LAYOUT_UNDEFINED)                                                                  \
+    X(THSVS_ACCESS_ANY_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER,                           \
+        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,                                                         \
+        VK_ACCESS_SHADER_READ_BIT,                                                                  \
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)                                                   \
+    X(THSVS_ACCESS_ANY_SHADER_READ_OTHER,                                                           \
+        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,                                                         \
+        VK_ACCESS_SHADER_READ_BIT,                                                                  \
+        VK_IMAGE_LAYOUT_GENERAL)                                                                    \
+    X(THSVS_ACCESS_TRANSFER_READ,                                                                   \
+        VK_PIPELINE_STAGE_TRANSFER_BIT,                                                             \
+        VK_ACCESS_TRANSFER_READ_BIT,                                                                \
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL)                                                       \
+    X(THSVS_ACCESS_HOST_READ,                                                                       \
+        VK_PIPELINE_STAGE_HOST_BIT,                                                                 \
+        VK_ACCESS_HOST_READ_BIT,                                                                    \
+        VK_IMAGE_LAYOUT_GENERAL)                                                                    \
+    X(THSVS_ACCESS_PRESENT,                                                                         \
+        0,                                                                                          \
+        0,                                                                                          \
+        VK_IMAGE_LAYOUT_PRESENT_SRC_KHR)                                                            \
+    X(THSVS_ACCESS_CONDITIONAL_RENDERING_READ_EXT,                                                  \
+        VK_PIPELINE_STAGE_CONDITIONAL_RENDERING_BIT_EXT,                                            \
+        VK_ACCESS_CONDITIONAL_RENDERING_READ_BIT_EXT,                                               \
+        VK_IMAGE_LAYOUT_UNDEFINED)                                                                  \
+    X(THSVS_ACCESS_RAY_TRACING_SHADER_ACCELERATION_STRUCTURE_READ_NV,                               \
+        VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_NV,                                                \
+        VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_NV,                                               \
+        VK_IMAGE_LAYOUT_UNDEFINED)                                                                  \
+    X(THSVS_ACCESS_ACCELERATION_STRUCTURE_BUILD_READ_NV,                                            \
+        VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_NV,                                      \
+        VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_NV,                                               \
+        VK_IMAGE_LAYOUT_UNDEFINED)                                                                  \
+    X(THSVS_END_OF_READ_ACCESS,                                                                     \
+        0,                                                                                          \
+        0,                                                                                          \
+        VK_IMAGE_LAYOUT_UNDEFINED)                                                                  \
+    /* Write access */                                                                              \
+    X(THSVS_ACCESS_COMMAND_BUFFER_WRITE_NV,                                                         \
+        VK_PIPELINE_STAGE_COMMAND_PREPROCESS_BIT_NV,                                                \
+        VK_ACCESS_COMMAND_PREPROCESS_WRITE_BIT_NV,                                                  \
+        VK_IMAGE_LAYOUT_UNDEFINED)                                                                  \
+    X(THSVS_ACCESS_VERTEX_SHADER_WRITE,                                                             \
+        VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,                                                        \
+        VK_ACCESS_SHADER_WRITE_BIT,                                                                 \
+        VK_IMAGE_LAYOUT_GENERAL)                                                                    \
+    X(THSVS_ACCESS_TESSELLATION_CONTROL_SHADER_WRITE,                                               \
+        VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT,                                          \
+        VK_ACCESS_SHADER_WRITE_BIT,                                                                 \
+        VK_IMAGE_LAYOUT_GENERAL)                                                                    \
+    X(THSVS_ACCESS_TESSELLATION_EVALUATION_SHADER_WRITE,                                            \
+        VK_PIPELINE_STAGE_TESSELLATION_EVALUATION_SHADER_BIT,                                       \
+        VK_ACCESS_SHADER_WRITE_BIT,                                                                 \
+        VK_IMAGE_LAYOUT_GENERAL)                                                                    \
+    X(THSVS_ACCESS_GEOMETRY_SHADER_WRITE,                                                           \
+        VK_PIPELINE_STAGE_GEOMETRY_SHADER_BIT,                                                      \
+        VK_ACCESS_SHADER_WRITE_BIT,                                                                 \
+        VK_IMAGE_LAYOUT_GENERAL)                                                                    \
+    X(THSVS_ACCESS_TASK_SHADER_WRITE_NV,                                                            \
+        VK_PIPELINE_STAGE_TASK_SHADER_BIT_NV,                                                       \
+        VK_ACCESS_SHADER_WRITE_BIT,                                                                 \
+        VK_IMAGE_LAYOUT_GENERAL)                                                                    \
+    X(THSVS_ACCESS_MESH_SHADER_WRITE_NV,                                                            \
+        VK_PIPELINE_STAGE_MESH_SHADER_BIT_NV,                                                       \
+        VK_ACCESS_SHADER_WRITE_BIT,                                                                 \
+        VK_IMAGE_LAYOUT_GENERAL)                                                                    \
+    X(THSVS_ACCESS_TRANSFORM_FEEDBACK_WRITE_EXT,                                                    \
+        VK_PIPELINE_STAGE_TRANSFORM_FEEDBACK_BIT_EXT,                                               \
+        VK_ACCESS_TRANSFORM_FEEDBACK_WRITE_BIT_EXT,                                                 \
+        VK_IMAGE_LAYOUT_UNDEFINED)                                                                  \
+    X(THSVS_ACCESS_TRANSFORM_FEEDBACK_COUNTER_WRITE_EXT,                                            \
+        VK_PIPELINE_STAGE_TRANSFORM_FEEDBACK_BIT_EXT,                                               \
+        VK_ACCESS_TRANSFORM_FEEDBACK_COUNTER_WRITE_BIT_EXT,                                         \
+        VK_IMAGE_LAYOUT_UNDEFINED)                                                                  \
+    X(THSVS_ACCESS_FRAGMENT_SHADER_WRITE,                                                           \
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,                                                      \
+        VK_ACCESS_SHADER_WRITE_BIT,                                                                 \
+        VK_IMAGE_LAYOUT_GENERAL)                                                                    \
+    X(THSVS_ACCESS_COLOR_ATTACHMENT_WRITE,                                                          \
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,                                              \
+        VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,                                                       \
+        VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL)                                                   \
+    X(THSVS_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE,                                                  \
+        VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,     \
+        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,                                               \
+        VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL)                                           \
+    X(THSVS_ACCESS_DEPTH_ATTACHMENT_WRITE_STENCIL_READ_ONLY,                                        \
+        VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,     \
+        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT, \
+        VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_STENCIL_READ_ONLY_OPTIMAL_KHR)                             \
+    X(THSVS_ACCESS_STENCIL_ATTACHMENT_WRITE_DEPTH_READ_ONLY,                                        \
+        VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,     \
+        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT, \
+        VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_STENCIL_ATTACHMENT_OPTIMAL_KHR)                             \
+    X(THSVS_ACCESS_COMPUTE_SHADER_WRITE,                                                            \
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,                                                       \
+        VK_ACCESS_SHADER_WRITE_BIT,                                                                 \
+        VK_IMAGE_LAYOUT_GENERAL)                                                                    \
+    X(THSVS_ACCESS_ANY_SHADER_WRITE,                                                                \
+        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,                                                         \
+        VK_ACCESS_SHADER_WRITE_BIT,                                                                 \
+        VK_IMAGE_LAYOUT_GENERAL)                                                                    \
+    X(THSVS_ACCESS_TRANSFER_WRITE,                                                                  \
+        VK_PIPELINE_STAGE_TRANSFER_BIT,                                                             \
+        VK_ACCESS_TRANSFER_WRITE_BIT,                                                               \
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)                                                       \
+    X(THSVS_ACCESS_HOST_PREINITIALIZED,                                                             \
+        VK_PIPELINE_STAGE_HOST_BIT,                                                                 \
+        VK_ACCESS_HOST_WRITE_BIT,                                                                   \
+        VK_IMAGE_LAYOUT_PREINITIALIZED)                                                             \
+    X(THSVS_ACCESS_HOST_WRITE,                                                                      \
+        VK_PIPELINE_STAGE_HOST_BIT,                                                                 \
+        VK_ACCESS_HOST_WRITE_BIT,                                                                   \
+        VK_IMAGE_LAYOUT_GENERAL)                                                                    \
+    X(THSVS_ACCESS_ACCELERATION_STRUCTURE_BUILD_WRITE_NV,                                           \
+        VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_NV,                                      \
+        VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_NV,                                              \
+        VK_IMAGE_LAYOUT_UNDEFINED)                                                                  \
+    X(THSVS_ACCESS_COLOR_ATTACHMENT_READ_WRITE,                                                     \
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,                                              \
+        VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,                 \
+        VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL)                                                   \
+    X(THSVS_ACCESS_GENERAL,                                                                         \
+        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,                                                         \
+        VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT,                                     \
+        VK_IMAGE_LAYOUT_GENERAL)
+
+#define THSVS_ACCESS_MAP_INFO(accessType, stageMask, accessMask, imageLayout) {stageMask, accessMask, imageLayout},
+
+// Selects the image layout used for an access in the given layout mode, from its THSVS_IMAGE_LAYOUT_OPTIMAL layout
+static inline THSVS_CONSTEXPR VkImageLayout thsvsSelectImageLayout(
+    ThsvsAccessType  access,
+    VkImageLayout    optimalLayout,
+    ThsvsImageLayout imageLayout)
+{
+    switch(imageLayout)
+    {
+        case THSVS_IMAGE_LAYOUT_GENERAL:
+            if (access == THSVS_ACCESS_PRESENT)
+                return VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+            else
+                return VK_IMAGE_LAYOUT_GENERAL;
+        case THSVS_IMAGE_LAYOUT_OPTIMAL:
+        case THSVS_IMAGE_LAYOUT_OPTIMAL_SEPARATE_DEPTH_STENCIL:
+            return optimalLayout;
+        case THSVS_IMAGE_LAYOUT_GENERAL_AND_PRESENTATION:
+            return VK_IMAGE_LAYOUT_SHARED_PRESENT_KHR;
+        case THSVS_IMAGE_LAYOUT_OPTIMAL_SYNCHRONIZATION2:
+#ifdef VK_VERSION_1_3
+            switch (optimalLayout)
+            {
+                case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
+                case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
+                    return VK_IMAGE_LAYOUT_ATTACHMENT_OPTIMAL;
+                case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+                case VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL:
+                    return VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
+                default:
+                    return optimalLayout;
+            }
+#else
+            return optimalLayout;
+#endif
+        default:
+            return VK_IMAGE_LAYOUT_UNDEFINED;
+    }
+}
+
+/*
+Adapts the layout selected for an access to the aspects an image barrier
+covers - only THSVS_IMAGE_LAYOUT_OPTIMAL_SEPARATE_DEPTH_STENCIL depends on
+them, for barriers on the depth and/or stencil aspects.
+*/
+static inline THSVS_CONSTEXPR VkImageLayout thsvsSelectAspectImageLayout(
+    VkImageLayout      layout,
+    ThsvsImageLayout   imageLayout,
+    VkImageAspectFlags aspectMask)
+{
+#ifdef VK_VERSION_1_2
+    if (imageLayout != THSVS_IMAGE_LAYOUT_OPTIMAL_SEPARATE_DEPTH_STENCIL)
+        return layout;
+
+    bool depth   = (aspectMask & VK_IMAGE_ASPECT_DEPTH_BIT) != 0;
+    bool stencil = (aspectMask & VK_IMAGE_ASPECT_STENCIL_BIT) != 0;
+    if (!depth && !stencil)
+        return layout;
+
+    switch (layout)
+    {
+        case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+        case VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL:
+            return (depth && stencil) ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL :
+                   depth ? VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_STENCIL_READ_ONLY_OPTIMAL;
+        case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
+            return (depth && stencil) ? layout :
+                   depth ? VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_STENCIL_ATTACHMENT_OPTIMAL;
+        case VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_STENCIL_READ_ONLY_OPTIMAL:
+            return (depth && stencil) ? layout :
+                   depth ? VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_STENCIL_READ_ONLY_OPTIMAL;
+        case VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_STENCIL_ATTACHMENT_OPTIMAL:
+            return (depth && stencil) ? layout :
+                   depth ? VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_STENCIL_ATTACHMENT_OPTIMAL;
+        default:
+            return layout;
+    }
+#else
+    (void)imageLayout;
+    (void)aspectMask;
+    return layout;
+#endif
+}
+
+#ifdef THSVS_HAS_CONSTEXPR_BARRIERS
+/*
+Compile-time Barriers
+
+When the accesses of a barrier are known at compile time, they can be given
+as template parameters rather than as an array; the resulting pipeline
+stages, access masks and image layouts are then computed by the compiler, and
+emitting a barrier is reduced to filling in a struct from constants.
+This is only available when compiling as C++14 or later.
+
+    const ThsvsAccessSet& prev = ThsvsAccessList<THSVS_ACCESS_COLOR_ATTACHMENT_WRITE>::accessSet;
+    const ThsvsAccessSet& next = ThsvsAccessList<THSVS_ACCESS_FRAGMENT_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER>::accessSet;
+
+    VkImageMemoryBarrier barrier = thsvsGetStaticImageMemoryBarrier(
+        prev, next, THSVS_IMAGE_LAYOUT_OPTIMAL, THSVS_IMAGE_LAYOUT_OPTIMAL, VK_FALSE,
+        VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, image, range);
+
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        thsvsGetStaticSrcStages(prev),
+        thsvsGetStaticDstStages(next),
+        0, 0, NULL, 0, NULL, 1, &barrier);
+
+Results are identical to thsvsCompileAccessSet and the compiled barrier
+functions given the same accesses, and the access sets can equally be used
+with compiled barriers.
+An access type outside of the valid range is a compile error.
+*/
+
+/*
+Compile-time copy of ThsvsAccessMap, since the implementation's copy can't be
+evaluated by the compiler in other translation units. Like ThsvsAccessMap, it's
+only defined in storage by the implementation.
+*/
+struct ThsvsStaticAccessMap {
+    static constexpr ThsvsVkAccessInfo accessInfos[THSVS_NUM_ACCESS_TYPES] = {
+        THSVS_ACCESS_MAP_ENTRIES(THSVS_ACCESS_MAP_INFO)
+    };
+};
+
+/*
+Compile-time equivalent of thsvsCompileAccessSet.
+*/
+template <ThsvsAccessType... Accesses>
+constexpr ThsvsAccessSet thsvsMakeAccessSet()
+{
+    // The leading THSVS_ACCESS_NONE allows the list to be empty, and contributes nothing to the set
+    const ThsvsAccessType accesses[] = { THSVS_ACCESS_NONE, Accesses... };
+
+    ThsvsAccessSet accessSet = { 0, 0, 0, { VK_IMAGE_LAYOUT_UNDEFINED }, VK_FALSE };
+
+    for (uint32_t i = 1; i < sizeof(accesses) / sizeof(accesses[0]); ++i)
+    {
+        ThsvsAccessType access = accesses[i];
+        const ThsvsVkAccessInfo& accessInfo = ThsvsStaticAccessMap::accessInfos[access];
+
+        accessSet.stageMask  |= accessInfo.stageMask;
+        accessSet.accessMask |= accessInfo.accessMask;
+
+        if (access > THSVS_END_OF_READ_ACCESS)
+        {
+            accessSet.writeAccessMask |= accessInfo.accessMask;
+            accessSet.hasWriteAccess = VK_TRUE;
+        }
+
+        for (uint32_t layout = 0; layout < THSVS_NUM_IMAGE_LAYOUTS; ++layout)
+            accessSet.imageLayouts[layout] = thsvsSelectImageLayout(access, accessInfo.imageLayout, (ThsvsImageLayout)layout);
+    }
+
+    return accessSet;
+}
+
+/*
+Holds the access set for a list of accesses in static storage, so that it can
+be referenced by compiled barriers.
+*/
+template <ThsvsAccessType... Accesses>
+struct ThsvsAccessList {
+    static constexpr ThsvsAccessSet accessSet = thsvsMakeAccessSet<Accesses...>();
+};
+
+template <ThsvsAccessType... Accesses>
+constexpr ThsvsAccessSet ThsvsAccessList<Accesses...>::accessSet;
+
+/*
+Compile-time equivalents of the compiled barrier functions.
+The source and destination stages are returned separately, so that barriers
+can be initialized directly.
+*/
+constexpr VkPipelineStageFlags thsvsGetStaticSrcStages(
+    const ThsvsAccessSet& prevAccessSet)
+{
+    // Ensure that the stage mask is valid if no stages were determined
+    return (prevAccessSet.stageMask != 0) ? prevAccessSet.stageMask : (VkPipelineStageFlags)VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+}
+
+constexpr VkPipelineStageFlags thsvsGetStaticDstStages(
+    const ThsvsAccessSet& nextAccessSet)
+{
+    return (nextAccessSet.stageMask != 0) ? nextAccessSet.stageMask : (VkPipelineStageFlags)VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+}
+
+constexpr VkMemoryBarrier thsvsGetStaticMemoryBarrier(
+    const ThsvsAccessSet& prevAccessSet,
+    const ThsvsAccessSet& nextAccessSet)
+{
+    // Availability operations for writes only, and visibility operations only if something was made available
+    return VkMemoryBarrier{
+        VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        NULL,
+        prevAccessSet.writeAccessMask,
+        (prevAccessSet.writeAccessMask != 0) ? nextAccessSet.accessMask : 0};
+}
+
+constexpr VkBufferMemoryBarrier thsvsGetStaticBufferMemoryBarrier(
+    const ThsvsAccessSet& prevAccessSet,
+    const ThsvsAccessSet& nextAccessSet,
+    uint32_t              srcQueueFamilyIndex,
+    uint32_t              dstQueueFamilyIndex,
+    VkBuffer              buffer,
+    VkDeviceSize          offset,
+    VkDeviceSize          size)
+{
+    return VkBufferMemoryBarrier{
+        VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        NULL,
+        prevAccessSet.writeAccessMask,
+        (prevAccessSet.writeAccessMask != 0) ? nextAccessSet.accessMask : 0,
+        srcQueueFamilyIndex,
+        dstQueueFamilyIndex,
+        buffer,
+        offset,
+        size};
+}
+
+constexpr VkImageMemoryBarrier thsvsGetStaticImageMemoryBarrier(
+    const ThsvsAccessSet&   prevAccessSet,
+    const ThsvsAccessSet&   nextAccessSet,
+    ThsvsImageLayout        prevLayout,
+    ThsvsImageLayout        nextLayout,
+    VkBool32                discardContents,
+    uint32_t                srcQueueFamilyIndex,
+    uint32_t                dstQueueFamilyIndex,
+    VkImage                 image,
+    VkImageSubresourceRange subresourceRange)
+{
+    return VkImageMemoryBarrier{
+        VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        NULL,
+        prevAccessSet.writeAccessMask,
+        (prevAccessSet.writeAccessMask != 0) ? nextAccessSet.accessMask : 0,
+        (discardContents == VK_TRUE) ? VK_IMAGE_LAYOUT_UNDEFINED :
+            thsvsSelectAspectImageLayout(prevAccessSet.imageLayouts[prevLayout], prevLayout, subresourceRange.aspectMask),
+        thsvsSelectAspectImageLayout(nextAccessSet.imageLayouts[nextLayout], nextLayout, subresourceRange.aspectMask),
+        srcQueueFamilyIndex,
+        dstQueueFamilyIndex,
+        image,
+        subresourceRange};
+}
+#endif // THSVS_HAS_CONSTEXPR_BARRIERS
+
+#ifdef VK_VERSION_1_3
+/*
+Synchronization2 (VK_KHR_synchronization2, core in Vulkan 1.3) equivalents
+of the mapping functions and thsvsCmdPipelineBarrier.
+
+Each Vulkan barrier produced carries its own stage masks, so a barrier only
+waits on and blocks the stages of its own accesses, rather than the union
+of every barrier in the call. The masks also use the finer grained
+synchronization2 flags - e.g. index input is separate from vertex attribute
+input, and sampled reads are separate from storage reads - and no longer
+need padding out with TOP_OF_PIPE or BOTTOM_OF_PIPE when empty.
+
+These are only available if the Vulkan headers define VK_VERSION_1_3, and
+can only be used on devices with the synchronization2 feature enabled.
+*/
+void thsvsGetAccessInfo2(
+    uint32_t               accessCount,
+    const ThsvsAccessType* pAccesses,
+    VkPipelineStageFlags2* pStageMask,
+    VkAccessFlags2*        pAccessMask,
+    VkImageLayout*         pImageLayout,
+    bool*                  pHasWriteAccess);
+
+VkBool32 thsvsGetVulkanMemoryBarrier2(
+    const ThsvsGlobalBarrier& thBarrier,
+    VkMemoryBarrier2*         pVkBarrier);
+
+VkBool32 thsvsGetVulkanBufferMemoryBarrier2(
+    const ThsvsBufferBarrier& thBarrier,
+    VkBufferMemoryBarrier2*   pVkBarrier);
+
+VkBool32 thsvsGetVulkanImageMemoryBarrier2(
+    const ThsvsImageBarrier&  thBarrier,
+    VkImageMemoryBarrier2*    pVkBarrier);
+
+/*
+Execution barriers are expressed in synchronization2 as a VkMemoryBarrier2
+with no access flags.
+*/
+void thsvsGetVulkanExecutionDependency2(
+    const ThsvsExecutionBarrier& thBarrier,
+    VkMemoryBarrier2*            pVkBarrier);
+
+/*
+Fill in a VkSemaphoreSubmitInfo for vkQueueSubmit2, with the narrowest
+stage mask for the accesses on either side of a semaphore.
+A signal waits for the stages of pPrevAccesses - the last accesses made by
+the signalling submission to anything the waiting queue uses - and a wait
+blocks only the stages of pNextAccesses.
+value is the value to signal or wait for on a timeline semaphore, and is
+ignored for binary semaphores.
+*/
+void thsvsGetSemaphoreSignalInfo(
+    VkSemaphore                  semaphore,
+    uint64_t                     value,
+    uint32_t                     prevAccessCount,
+    const ThsvsAccessType*       pPrevAccesses,
+    VkSemaphoreSubmitInfo*       pSubmitInfo);
+
+void thsvsGetSemaphoreWaitInfo(
+    VkSemaphore                  semaphore,
+    uint64_t                     value,
+    uint32_t                     nextAccessCount,
+    const ThsvsAccessType*       pNextAccesses,
+    VkSemaphoreSubmitInfo*       pSubmitInfo);
+
+void thsvsCmdPipelineBarrier2(
+    VkCommandBuffer           commandBuffer,
+    const ThsvsGlobalBarrier* pGlobalBarrier,
+    uint32_t                  bufferBarrierCount,
+    const ThsvsBufferBarrier* pBufferBarriers,
+    uint32_t                  imageBarrierCount,
+    const ThsvsImageBarrier*  pImageBarriers);
+
+void thsvsCmdPipelineBarrier2Scratch(
+    VkCommandBuffer           commandBuffer,
+    ThsvsScratch*             pScratch,
+    const ThsvsGlobalBarrier* pGlobalBarrier,
+    uint32_t                  bufferBarrierCount,
+    const ThsvsBufferBarrier* pBufferBarriers,
+    uint32_t                  imageBarrierCount,
+    const ThsvsImageBarrier*  pImageBarriers);
+
+/*
+Synchronization2 equivalents of thsvsCmdSetEvents and
+thsvsCmdWaitEventBarriers.
+Each event is set with vkCmdSetEvent2 and a VkDependencyInfo built from its
+own barriers, and all of them are waited on with a single vkCmdWaitEvents2,
+which is given an identical VkDependencyInfo per event. Every event's
+barriers then carry their own stage masks, rather than one mask covering
+every event.
+The same event barriers must be passed to both, and must not change in
+between.
+*/
+void thsvsCmdSetEvents2(
+    VkCommandBuffer           commandBuffer,
+    ThsvsScratch*             pScratch,
+    uint32_t                  eventBarrierCount,
+    const ThsvsEventBarrier*  pEventBarriers);
+
+void thsvsCmdWaitEvents2(
+    VkCommandBuffer           commandBuffer,
+    ThsvsScratch*             pScratch,
+    uint32_t                  eventBarrierCount,
+    const ThsvsEventBarrier*  pEventBarriers);
+#endif // VK_VERSION_1_3
+
+#endif // THSVS_SIMPLER_VULKAN_SYNCHRONIZATION_H
+
+#ifdef THSVS_SIMPLER_VULKAN_SYNCHRONIZATION_IMPLEMENTATION
+
+#include <stdlib.h>
+
+//// Optional Error Checking ////
+/*
+Checks for barriers defining multiple usages that have different layouts
+*/
+// #define THSVS_ERROR_CHECK_MIXED_IMAGE_LAYOUT
+
+/*
+Checks if an image/buffer barrier is used when a global barrier would suffice
+*/
+// #define THSVS_ERROR_CHECK_COULD_USE_GLOBAL_BARRIER
+
+/*
+Checks if a write access is listed alongside any other access - if so it
+points to a potential data hazard that you need to synchronize separately.
+In some cases it may simply be over-synchronization however, but it's usually
+worth checking.
+*/
+// #define THSVS_ERROR_CHECK_POTENTIAL_HAZARD
+
+/*
+Checks if a variety of table lookups (like the access map) are within
+a valid range.
+*/
+// #define THSVS_ERROR_CHECK_ACCESS_TYPE_IN_RANGE
+
+/*
+Checks that a scratch allocator passed to one of the *Scratch command
+functions has enough space, rather than silently falling back to
+THSVS_TEMP_ALLOC.
+*/
+// #define THSVS_ERROR_CHECK_SCRATCH_OVERFLOW
+
+/*
+Checks that subresource ranges passed to the subresource map functions are
+within the image the map was initialized for.
+*/
+// #define THSVS_ERROR_CHECK_SUBRESOURCE_RANGE
+
+//// Optional Barrier Elision ////
+/*
+Drops barriers that the mapping functions report as having no effect
+(e.g. read-after-read in the same layout) from thsvsCmdPipelineBarrier,
+thsvsCmdWaitEvents and thsvsBatchPipelineBarrier, skipping the call to
+vkCmdPipelineBarrier entirely if nothing remains.
+Buffer and image barriers that don't transition a layout or transfer queue
+family ownership are folded into the global memory barrier.
+*/
+// #define THSVS_ELIDE_REDUNDANT_BARRIERS
+
+//// Optional Instrumentation ////
+/*
+Counts every pipeline barrier and event wait recorded by this library -
+including thsvsCmdPipelineBarrier, thsvsCmdWaitEvents and their variants,
+their synchronization2 equivalents, and barrier batches - in thread local
+stats returned by thsvsGetThreadStats.
+thsvsCmdSetEvent, thsvsCmdSetEvents and thsvsCmdSetEvents2 aren't counted,
+as the barriers an event carries are counted once by the command waiting on
+it.
+When not defined, none of this is compiled in.
+*/
+// #define THSVS_STATS
+
+/*
+When THSVS_STATS is defined, defining THSVS_INSERT_DEBUG_LABEL as well
+inserts a VK_EXT_debug_utils label before each recorded command, so that they
+can be identified in a capture. Labels for commands that wait on or block
+all commands or all graphics stages are colored orange.
+As vkCmdInsertDebugUtilsLabelEXT has to be loaded at runtime, this should
+call it through a function pointer the application has loaded - e.g.
+*/
+// #define THSVS_INSERT_DEBUG_LABEL(commandBuffer, pLabelInfo) pfnCmdInsertDebugUtilsLabelEXT(commandBuffer, pLabelInfo)
+
+/*
+Checks each barrier for over-synchronization, reporting anything found to
+the callback set by thsvsSetDiagnosticCallback.
+When not defined, none of this is compiled in.
+*/
+// #define THSVS_DIAGNOSTICS
+
+/*
+Appends a record of each pipeline barrier and event wait recorded by this
+library to the capture set by thsvsSetThreadCapture. Barrier batches,
+aliasing barriers and ownership transfers are captured as the Vulkan
+barriers they record, without access types, and setting an event isn't
+captured - see thsvsSetThreadCapture for details.
+When not defined, none of this is compiled in.
+*/
+// #define THSVS_CAPTURE
+
+/*
+When THSVS_CAPTURE is defined, this returns the uint64_t timestamp given to
+each record. By default it's a monotonic CPU clock in nanoseconds.
+*/
+// #define THSVS_CAPTURE_TIMESTAMP() myGetTimestamp()
+
+/*
+Brackets each pipeline barrier the library records, other than execution-only
+ones, with timestamp queries from the profiler set by thsvsSetThreadProfiler.
+When not defined, none of this is compiled in.
+*/
+// #define THSVS_PROFILE
+
+//// Temporary Memory Allocation ////
+/*
+Override these if you can't afford the stack space or just want to use a
+custom temporary allocator.
+These are currently used exclusively to allocate Vulkan memory barriers in
+the API, one for each Buffer or Image barrier passed into the pipeline and
+event functions.
+May consider other allocation strategies in future.
+*/
+
+// Alloca inclusion code below copied from
+// https://github.com/nothings/stb/blob/master/stb_vorbis.c
+
+// find definition of alloca if it's not in stdlib.h:
+#if defined(_MSC_VER) || defined(__MINGW32__)
+  #include <malloc.h>
+#endif
+#if defined(__linux__) || defined(__linux) || defined(__EMSCRIPTEN__)
+  #include <alloca.h>
+#endif
+
+// _BitScanForward64, used to iterate over access masks
+#if defined(_MSC_VER)
+  #include <intrin.h>
+#endif
+
+#if defined(THSVS_ERROR_CHECK_ACCESS_TYPE_IN_RANGE) || \
+    defined(THSVS_ERROR_CHECK_COULD_USE_GLOBAL_BARRIER) || \
+    defined(THSVS_ERROR_CHECK_MIXED_IMAGE_LAYOUT) || \
+    defined(THSVS_ERROR_CHECK_POTENTIAL_HAZARD) || \
+    defined(THSVS_ERROR_CHECK_SCRATCH_OVERFLOW) || \
+    defined(THSVS_ERROR_CHECK_SUBRESOURCE_RANGE)
+  #include <assert.h>
+#endif
+
+// memcpy, used to copy records in and out of a capture
+#include <string.h>
+
+// clock_gettime or timespec_get, for the default capture timestamps
+#if defined(THSVS_CAPTURE) && !defined(THSVS_CAPTURE_TIMESTAMP)
+  #include <time.h>
+#endif
+
+#if !defined(THSVS_TEMP_ALLOC)
+#define THSVS_TEMP_ALLOC(size)              (alloca(size))
+#endif
+
+#if !defined(THSVS_TEMP_FREE)
+#define THSVS_TEMP_FREE(x)                  ((void)(x))
+#endif
+
+const ThsvsVkAccessInfo ThsvsAccessMap[THSVS_NUM_ACCESS_TYPES] = {
+    THSVS_ACCESS_MAP_ENTRIES(THSVS_ACCESS_MAP_INFO)
+};
+
+#ifdef THSVS_HAS_CONSTEXPR_BARRIERS
+constexpr ThsvsVkAccessInfo ThsvsStaticAccessMap::accessInfos[THSVS_NUM_ACCESS_TYPES];
+#endif
+
+/*
+Alignment of allocations made from a ThsvsScratch, which must be a power of
+two and suitable for any Vulkan barrier structure.
+*/
+#if !defined(THSVS_SCRATCH_ALIGNMENT)
+#define THSVS_SCRATCH_ALIGNMENT             16
+#endif
+
+/*
+Allocates count barriers of the given type from pScratch if possible,
+falling back to THSVS_TEMP_ALLOC otherwise - in which case pTempBarriers is
+set so it can be passed to THSVS_TEMP_FREE.
+This has to be a macro, as THSVS_TEMP_ALLOC defaults to alloca.
+*/
+#ifdef THSVS_ERROR_CHECK_SCRATCH_OVERFLOW
+  #define THSVS_SCRATCH_OVERFLOW_CHECK(pScratch, pBarriers) assert((pScratch) == NULL || (pBarriers) != NULL)
+#else
+  #define THSVS_SCRATCH_OVERFLOW_CHECK(pScratch, pBarriers) ((void)0)
+#endif
+
+#define THSVS_ALLOC_BARRIERS(type, count, pScratch, pBarriers, pTempBarriers)                  \
+    do {                                                                                       \
+        if ((pScratch) != NULL)                                                                \
+            (pBarriers) = (type*)thsvsScratchAlloc((pScratch), sizeof(type) * (count));        \
+        THSVS_SCRATCH_OVERFLOW_CHECK(pScratch, pBarriers);                                     \
+        if ((pBarriers) == NULL)                                                               \
+        {                                                                                      \
+            (pBarriers) = (type*)THSVS_TEMP_ALLOC(sizeof(type) * (count));                     \
+            (pTempBarriers) = (pBarriers);                                                     \
+        }                                                                                      \
+    } while (0)
+
+/*
+Structure of arrays copy of ThsvsAccessMap, so that each translator only
+loads the fields it actually uses - e.g. thsvsCmdSetEvent only touches the
+stage masks, and nothing translating a global barrier touches the layouts.
+writeAccessMasks holds the access mask of each write access, and 0 for
+reads, so that availability operations can be accumulated without having to
+branch on the access type.
+
+Each array is generated from THSVS_ACCESS_MAP_ENTRIES, the same source as
+ThsvsAccessMap, so that the two can't disagree - and as plain aggregate
+arrays, they're constant initialized whichever C++ standard is used.
+*/
+typedef struct ThsvsAccessTable {
+    VkPipelineStageFlags    stageMasks[THSVS_NUM_ACCESS_TYPES];
+    VkAccessFlags           accessMasks[THSVS_NUM_ACCESS_TYPES];
+    VkAccessFlags           writeAccessMasks[THSVS_NUM_ACCESS_TYPES];
+    VkImageLayout           imageLayouts[THSVS_NUM_ACCESS_TYPES];
+} ThsvsAccessTable;
+
+#define THSVS_ACCESS_TABLE_STAGE_MASK(accessType, stageMask, accessMask, imageLayout)        (stageMask),
+#define THSVS_ACCESS_TABLE_ACCESS_MASK(accessType, stageMask, accessMask, imageLayout)       (accessMask),
+#define THSVS_ACCESS_TABLE_WRITE_ACCESS_MASK(accessType, stageMask, accessMask, imageLayout) ((accessType) > THSVS_END_OF_READ_ACCESS ? (accessMask) : 0),
+#define THSVS_ACCESS_TABLE_IMAGE_LAYOUT(accessType, stageMask, accessMask, imageLayout)      (imageLayout),
+
+static const ThsvsAccessTable ThsvsAccessTables = {
+    {THSVS_ACCESS_MAP_ENTRIES(THSVS_ACCESS_TABLE_STAGE_MASK)},
+    {THSVS_ACCESS_MAP_ENTRIES(THSVS_ACCESS_TABLE_ACCESS_MASK)},
+    {THSVS_ACCESS_MAP_ENTRIES(THSVS_ACCESS_TABLE_WRITE_ACCESS_MASK)},
+    {THSVS_ACCESS_MAP_ENTRIES(THSVS_ACCESS_TABLE_IMAGE_LAYOUT)}
+};
+
+#define THSVS_TABLE_STAGE_MASK(access)          (ThsvsAccessTables.stageMasks[access])
+#define THSVS_TABLE_ACCESS_MASK(access)         (ThsvsAccessTables.accessMasks[access])
+#define THSVS_TABLE_WRITE_ACCESS_MASK(access)   (ThsvsAccessTables.writeAccessMasks[access])
+#define THSVS_TABLE_IMAGE_LAYOUT(access)        (ThsvsAccessTables.imageLayouts[access])
+
+// Translates a single access into the image layout used for it in the given layout mode
+static inline VkImageLayout thsvsGetImageLayout(
+    ThsvsAccessType  access,
+    ThsvsImageLayout imageLayout)
+{
+    return thsvsSelectImageLayout(access, THSVS_TABLE_IMAGE_LAYOUT(access), imageLayout);
+}
+
+#ifdef VK_VERSION_1_3
+typedef struct ThsvsVkAccessInfo2 {
+    VkPipelineStageFlags2   stageMask;
+    VkAccessFlags2          accessMask;
+} ThsvsVkAccessInfo2;
+
+/*
+Equivalent of ThsvsAccessMap for VK_KHR_synchronization2 (core in Vulkan
+1.3). Image layouts are the same as in ThsvsAccessMap, so aren't repeated.
+The finer grained stages and accesses are used where they apply - index and
+vertex input are separate stages, and shader reads are split into sampled
+and storage reads.
+*/
+const ThsvsVkAccessInfo2 ThsvsAccessMap2[THSVS_NUM_ACCESS_TYPES] = {
+    // THSVS_ACCESS_NONE
+    {   VK_PIPELINE_STAGE_2_NONE,
+        VK_ACCESS_2_NONE},
+
+// Read Access
+    // THSVS_ACCESS_COMMAND_BUFFER_READ_NV
+    {   VK_PIPELINE_STAGE_2_COMMAND_PREPROCESS_BIT_NV,
+        VK_ACCESS_2_COMMAND_PREPROCESS_READ_BIT_NV},
+    // THSVS_ACCESS_INDIRECT_BUFFER
+    {   VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT,
+        VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT},
+
+    // THSVS_ACCESS_INDEX_BUFFER
+    {   VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT,
+        VK_ACCESS_2_INDEX_READ_BIT},
+    // THSVS_ACCESS_VERTEX_BUFFER
+    {   VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT,
+        VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT},
+    // THSVS_ACCESS_VERTEX_SHADER_READ_UNIFORM_BUFFER
+    {   VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT,
+        VK_ACCESS_2_UNIFORM_READ_BIT},
+    // THSVS_ACCESS_VERTEX_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER
+    {   VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT,
+        VK_ACCESS_2_SHADER_SAMPLED_READ_BIT},
+    // THSVS_ACCESS_VERTEX_SHADER_READ_OTHER
+    {   VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_READ_BIT},
+
+    // THSVS_ACCESS_TESSELLATION_CONTROL_SHADER_READ_UNIFORM_BUFFER
+    {   VK_PIPELINE_STAGE_2_TESSELLATION_CONTROL_SHADER_BIT,
+        VK_ACCESS_2_UNIFORM_READ_BIT},
+    // THSVS_ACCESS_TESSELLATION_CONTROL_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER
+    {   VK_PIPELINE_STAGE_2_TESSELLATION_CONTROL_SHADER_BIT,
+        VK_ACCESS_2_SHADER_SAMPLED_READ_BIT},
+    // THSVS_ACCESS_TESSELLATION_CONTROL_SHADER_READ_OTHER
+    {   VK_PIPELINE_STAGE_2_TESSELLATION_CONTROL_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_READ_BIT},
+
+    // THSVS_ACCESS_TESSELLATION_EVALUATION_SHADER_READ_UNIFORM_BUFFER
+    {   VK_PIPELINE_STAGE_2_TESSELLATION_EVALUATION_SHADER_BIT,
+        VK_ACCESS_2_UNIFORM_READ_BIT},
+    // THSVS_ACCESS_TESSELLATION_EVALUATION_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER
+    {   VK_PIPELINE_STAGE_2_TESSELLATION_EVALUATION_SHADER_BIT,
+        VK_ACCESS_2_SHADER_SAMPLED_READ_BIT},
+    // THSVS_ACCESS_TESSELLATION_EVALUATION_SHADER_READ_OTHER
+    {   VK_PIPELINE_STAGE_2_TESSELLATION_EVALUATION_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_READ_BIT},
+
+    // THSVS_ACCESS_GEOMETRY_SHADER_READ_UNIFORM_BUFFER
+    {   VK_PIPELINE_STAGE_2_GEOMETRY_SHADER_BIT,
+        VK_ACCESS_2_UNIFORM_READ_BIT},
+    // THSVS_ACCESS_GEOMETRY_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER
+    {   VK_PIPELINE_STAGE_2_GEOMETRY_SHADER_BIT,
+        VK_ACCESS_2_SHADER_SAMPLED_READ_BIT},
+    // THSVS_ACCESS_GEOMETRY_SHADER_READ_OTHER
+    {   VK_PIPELINE_STAGE_2_GEOMETRY_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_READ_BIT},
+
+    // THSVS_ACCESS_TASK_SHADER_READ_UNIFORM_BUFFER_NV
+    {   VK_PIPELINE_STAGE_2_TASK_SHADER_BIT_NV,
+        VK_ACCESS_2_UNIFORM_READ_BIT},
+    // THSVS_ACCESS_TASK_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER_NV
+    {   VK_PIPELINE_STAGE_2_TASK_SHADER_BIT_NV,
+        VK_ACCESS_2_SHADER_SAMPLED_READ_BIT},
+    // THSVS_ACCESS_TASK_SHADER_READ_OTHER_NV
+    {   VK_PIPELINE_STAGE_2_TASK_SHADER_BIT_NV,
+        VK_ACCESS_2_SHADER_STORAGE_READ_BIT},
+
+    // THSVS_ACCESS_MESH_SHADER_READ_UNIFORM_BUFFER_NV
+    {   VK_PIPELINE_STAGE_2_MESH_SHADER_BIT_NV,
+        VK_ACCESS_2_UNIFORM_READ_BIT},
+    // THSVS_ACCESS_MESH_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER_NV
+    {   VK_PIPELINE_STAGE_2_MESH_SHADER_BIT_NV,
+        VK_ACCESS_2_SHADER_SAMPLED_READ_BIT},
+    // THSVS_ACCESS_MESH_SHADER_READ_OTHER_NV
+    {   VK_PIPELINE_STAGE_2_MESH_SHADER_BIT_NV,
+        VK_ACCESS_2_SHADER_STORAGE_READ_BIT},
+
+    // THSVS_ACCESS_TRANSFORM_FEEDBACK_COUNTER_READ_EXT
+    {   VK_PIPELINE_STAGE_2_TRANSFORM_FEEDBACK_BIT_EXT,
+        VK_ACCESS_2_TRANSFORM_FEEDBACK_COUNTER_READ_BIT_EXT},
+    // THSVS_ACCESS_FRAGMENT_DENSITY_MAP_READ_EXT
+    {   VK_PIPELINE_STAGE_2_FRAGMENT_DENSITY_PROCESS_BIT_EXT,
+        VK_ACCESS_2_FRAGMENT_DENSITY_MAP_READ_BIT_EXT},
+    // THSVS_ACCESS_SHADING_RATE_READ_NV
+    {   VK_PIPELINE_STAGE_2_SHADING_RATE_IMAGE_BIT_NV,
+        VK_ACCESS_2_SHADING_RATE_IMAGE_READ_BIT_NV},
+
+    // THSVS_ACCESS_FRAGMENT_SHADER_READ_UNIFORM_BUFFER
+    {   VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+        VK_ACCESS_2_UNIFORM_READ_BIT},
+    // THSVS_ACCESS_FRAGMENT_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER
+    {   VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+        VK_ACCESS_2_SHADER_SAMPLED_READ_BIT},
+    // THSVS_ACCESS_FRAGMENT_SHADER_READ_COLOR_INPUT_ATTACHMENT
+    {   VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+        VK_ACCESS_2_INPUT_ATTACHMENT_READ_BIT},
+    // THSVS_ACCESS_FRAGMENT_SHADER_READ_DEPTH_STENCIL_INPUT_ATTACHMENT
+    {   VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+        VK_ACCESS_2_INPUT_ATTACHMENT_READ_BIT},
+    // THSVS_ACCESS_FRAGMENT_SHADER_READ_OTHER
+    {   VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_READ_BIT},
+    // THSVS_ACCESS_COLOR_ATTACHMENT_READ
+    {   VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+        VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT},
+    // THSVS_ACCESS_COLOR_ATTACHMENT_ADVANCED_BLENDING_EXT
+    {   VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+        VK_ACCESS_2_COLOR_ATTACHMENT_READ_NONCOHERENT_BIT_EXT},
+    // THSVS_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ
+    {   VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+        VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT},
+
+    // THSVS_ACCESS_COMPUTE_SHADER_READ_UNIFORM_BUFFER
+    {   VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_UNIFORM_READ_BIT},
+    // THSVS_ACCESS_COMPUTE_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER
+    {   VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_SAMPLED_READ_BIT},
+    // THSVS_ACCESS_COMPUTE_SHADER_READ_OTHER
+    {   VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_READ_BIT},
+
+    // THSVS_ACCESS_ANY_SHADER_READ_UNIFORM_BUFFER
+    {   VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+        VK_ACCESS_2_UNIFORM_READ_BIT},
+    // THSVS_ACCESS_ANY_SHADER_READ_UNIFORM_BUFFER_OR_VERTEX_BUFFER
+    {   VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+        VK_ACCESS_2_UNIFORM_READ_BIT | VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT},
+    // THSVS_ACCESS_ANY_SHADER_READ_SAMPLED_IMAGE
+    {   VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+        VK_ACCESS_2_SHADER_SAMPLED_READ_BIT},
+    // THSVS_ACCESS_ANY_SHADER_READ_OTHER
+    {   VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_READ_BIT},
+
+    // THSVS_ACCESS_TRANSFER_READ
+    {   VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+        VK_ACCESS_2_TRANSFER_READ_BIT},
+    // THSVS_ACCESS_HOST_READ
+    {   VK_PIPELINE_STAGE_2_HOST_BIT,
+        VK_ACCESS_2_HOST_READ_BIT},
+    // THSVS_ACCESS_PRESENT
+    {   VK_PIPELINE_STAGE_2_NONE,
+        VK_ACCESS_2_NONE},
+    // THSVS_ACCESS_CONDITIONAL_RENDERING_READ_EXT
+    {   VK_PIPELINE_STAGE_2_CONDITIONAL_RENDERING_BIT_EXT,
+        VK_ACCESS_2_CONDITIONAL_RENDERING_READ_BIT_EXT},
 
     // THSVS_ACCESS_RAY_TRACING_SHADER_ACCELERATION_STRUCTURE_READ_NV
-    {   VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_NV,
-        VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_NV,
-        VK_IMAGE_LAYOUT_UNDEFINED},
+    {   VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_NV,
+        VK_ACCESS_2_ACCELERATION_STRUCTURE_READ_BIT_NV},
     // THSVS_ACCESS_ACCELERATION_STRUCTURE_BUILD_READ_NV
-    {   VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_NV,
-        VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_NV,
-        VK_IMAGE_LAYOUT_UNDEFINED},
+    {   VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_NV,
+        VK_ACCESS_2_ACCELERATION_STRUCTURE_READ_BIT_NV},
     // THSVS_END_OF_READ_ACCESS
-    {   0,
+    {   VK_PIPELINE_STAGE_2_NONE,
+        VK_ACCESS_2_NONE},
+
+// Write access
+    // THSVS_ACCESS_COMMAND_BUFFER_WRITE_NV
+    {   VK_PIPELINE_STAGE_2_COMMAND_PREPROCESS_BIT_NV,
+        VK_ACCESS_2_COMMAND_PREPROCESS_WRITE_BIT_NV},
+    // THSVS_ACCESS_VERTEX_SHADER_WRITE
+    {   VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT},
+    // THSVS_ACCESS_TESSELLATION_CONTROL_SHADER_WRITE
+    {   VK_PIPELINE_STAGE_2_TESSELLATION_CONTROL_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT},
+    // THSVS_ACCESS_TESSELLATION_EVALUATION_SHADER_WRITE
+    {   VK_PIPELINE_STAGE_2_TESSELLATION_EVALUATION_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT},
+    // THSVS_ACCESS_GEOMETRY_SHADER_WRITE
+    {   VK_PIPELINE_STAGE_2_GEOMETRY_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT},
+    // THSVS_ACCESS_TASK_SHADER_WRITE_NV
+    {   VK_PIPELINE_STAGE_2_TASK_SHADER_BIT_NV,
+        VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT},
+    // THSVS_ACCESS_MESH_SHADER_WRITE_NV
+    {   VK_PIPELINE_STAGE_2_MESH_SHADER_BIT_NV,
+        VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT},
+    // THSVS_ACCESS_TRANSFORM_FEEDBACK_WRITE_EXT
+    {   VK_PIPELINE_STAGE_2_TRANSFORM_FEEDBACK_BIT_EXT,
+        VK_ACCESS_2_TRANSFORM_FEEDBACK_WRITE_BIT_EXT},
+    // THSVS_ACCESS_TRANSFORM_FEEDBACK_COUNTER_WRITE_EXT
+    {   VK_PIPELINE_STAGE_2_TRANSFORM_FEEDBACK_BIT_EXT,
+        VK_ACCESS_2_TRANSFORM_FEEDBACK_COUNTER_WRITE_BIT_EXT},
+    // THSVS_ACCESS_FRAGMENT_SHADER_WRITE
+    {   VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT},
+    // THSVS_ACCESS_COLOR_ATTACHMENT_WRITE
+    {   VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+        VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT},
+    // THSVS_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE
+    {   VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+        VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT},
+    // THSVS_ACCESS_DEPTH_ATTACHMENT_WRITE_STENCIL_READ_ONLY
+    {   VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+        VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT},
+    // THSVS_ACCESS_STENCIL_ATTACHMENT_WRITE_DEPTH_READ_ONLY
+    {   VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+        VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT},
+
+    // THSVS_ACCESS_COMPUTE_SHADER_WRITE
+    {   VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT},
+
+    // THSVS_ACCESS_ANY_SHADER_WRITE
+    {   VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT},
+
+    // THSVS_ACCESS_TRANSFER_WRITE
+    {   VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+        VK_ACCESS_2_TRANSFER_WRITE_BIT},
+    // THSVS_ACCESS_HOST_PREINITIALIZED
+    {   VK_PIPELINE_STAGE_2_HOST_BIT,
+        VK_ACCESS_2_HOST_WRITE_BIT},
+    // THSVS_ACCESS_HOST_WRITE
+    {   VK_PIPELINE_STAGE_2_HOST_BIT,
+        VK_ACCESS_2_HOST_WRITE_BIT},
+    // THSVS_ACCESS_ACCELERATION_STRUCTURE_BUILD_WRITE_NV
+    {   VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_NV,
+        VK_ACCESS_2_ACCELERATION_STRUCTURE_WRITE_BIT_NV},
+
+    // THSVS_ACCESS_COLOR_ATTACHMENT_READ_WRITE
+    {   VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+        VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT},
+    // THSVS_ACCESS_GENERAL
+    {   VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+        VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT}
+};
+#endif // VK_VERSION_1_3
+
+/*
+Determines whether a barrier has any effect.
+One is needed to make writes available, to stop writes overtaking earlier
+accesses, or to transition a layout or queue family ownership; anything
+else (e.g. read-after-read) does nothing.
+*/
+static VkBool32 thsvsIsBarrierNeeded(
+    bool prevHasWriteAccess,
+    bool prevHasStages,
+    bool nextHasWriteAccess,
+    bool transition)
+{
+    return (prevHasWriteAccess || (nextHasWriteAccess && prevHasStages) || transition) ? VK_TRUE : VK_FALSE;
+}
+
+void thsvsGetAccessInfo(
+    uint32_t               accessCount,
+    const ThsvsAccessType* pAccesses,
+    VkPipelineStageFlags*  pStageMask,
+    VkAccessFlags*         pAccessMask,
+    VkImageLayout*         pImageLayout,
+    bool*                  pHasWriteAccess)
+{
+    *pStageMask   = 0;
+    *pAccessMask  = 0;
+    *pImageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    *pHasWriteAccess = false;
+
+    for (uint32_t i = 0; i < accessCount; ++i)
+    {
+        ThsvsAccessType access = pAccesses[i];
+
+#ifdef THSVS_ERROR_CHECK_ACCESS_TYPE_IN_RANGE
+        // Asserts that the previous access index is a valid range for the lookup
+        assert(access < THSVS_NUM_ACCESS_TYPES);
+#endif
+
+#ifdef THSVS_ERROR_CHECK_POTENTIAL_HAZARD
+        // Asserts that the access is a read, else it's a write and it should appear on its own.
+        assert(access < THSVS_END_OF_READ_ACCESS || accessCount == 1);
+#endif
+
+        *pStageMask |= THSVS_TABLE_STAGE_MASK(access);
+
+        if (access > THSVS_END_OF_READ_ACCESS)
+            *pHasWriteAccess = true;
+
+        *pAccessMask |= THSVS_TABLE_ACCESS_MASK(access);
+
+        VkImageLayout layout = THSVS_TABLE_IMAGE_LAYOUT(access);
+
+#ifdef THSVS_ERROR_CHECK_MIXED_IMAGE_LAYOUT
+        assert(*pImageLayout == VK_IMAGE_LAYOUT_UNDEFINED ||
+               *pImageLayout == layout);
+#endif
+
+        *pImageLayout = layout;
+    }
+}
+
+// Counts the bits set in a stage or access mask
+static uint32_t thsvsCountBits(
+    uint32_t mask)
+{
+    uint32_t bitCount = 0;
+    for (; mask != 0; mask &= mask - 1)
+        ++bitCount;
+    return bitCount;
+}
+
+// Greedily covers the stages and accesses given with access types that use imageLayout with the layout option given
+static bool thsvsCoverAccessTypes(
+    VkPipelineStageFlags   stageMask,
+    VkAccessFlags          accessMask,
+    VkImageLayout          imageLayout,
+    ThsvsImageLayout       layout,
+    uint32_t*              pAccessCount,
+    ThsvsAccessType*       pAccesses)
+{
+    VkPipelineStageFlags remainingStageMask  = stageMask;
+    VkAccessFlags        remainingAccessMask = accessMask;
+    uint32_t             accessCount         = 0;
+
+    while (remainingStageMask != 0 || remainingAccessMask != 0 ||
+           (accessCount == 0 && imageLayout != VK_IMAGE_LAYOUT_UNDEFINED))
+    {
+        ThsvsAccessType bestAccess   = THSVS_ACCESS_NONE;
+        uint32_t        bestCoverage = 0;
+
+        for (uint32_t access = THSVS_ACCESS_NONE + 1; access < THSVS_NUM_ACCESS_TYPES; ++access)
+        {
+            VkPipelineStageFlags accessStageMask = THSVS_TABLE_STAGE_MASK(access);
+            VkAccessFlags        accessFlags     = THSVS_TABLE_ACCESS_MASK(access);
+
+            if (access == THSVS_END_OF_READ_ACCESS ||
+                (accessStageMask & ~stageMask) != 0 ||
+                (accessFlags & ~accessMask) != 0 ||
+                (imageLayout != VK_IMAGE_LAYOUT_UNDEFINED && thsvsGetImageLayout((ThsvsAccessType)access, layout) != imageLayout))
+                continue;
+
+            // An access with no stages or accesses (e.g. presentation) only matters for its layout
+            uint32_t coverage = thsvsCountBits(accessStageMask & remainingStageMask) +
+                                thsvsCountBits(accessFlags & remainingAccessMask) +
+                                ((accessCount == 0) ? 1 : 0);
+
+            if (coverage > bestCoverage)
+            {
+                bestAccess   = (ThsvsAccessType)access;
+                bestCoverage = coverage;
+            }
+        }
+
+        if (bestAccess == THSVS_ACCESS_NONE || accessCount == *pAccessCount)
+            return false;
+
+        pAccesses[accessCount++] = bestAccess;
+        remainingStageMask  &= ~THSVS_TABLE_STAGE_MASK(bestAccess);
+        remainingAccessMask &= ~THSVS_TABLE_ACCESS_MASK(bestAccess);
+    }
+
+    *pAccessCount = accessCount;
+    return true;
+}
+
+VkBool32 thsvsGetAccessTypes(
+    VkPipelineStageFlags   stageMask,
+    VkAccessFlags          accessMask,
+    VkImageLayout          imageLayout,
+    uint32_t*              pAccessCount,
+    ThsvsAccessType*       pAccesses,
+    ThsvsImageLayout*      pLayout)
+{
+    stageMask &= ~(VkPipelineStageFlags)(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT | VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+
+    // Layout options are tried in the order they're declared, so THSVS_IMAGE_LAYOUT_OPTIMAL is preferred
+    for (uint32_t layout = 0; layout < THSVS_NUM_IMAGE_LAYOUTS; ++layout)
+    {
+        uint32_t accessCount = *pAccessCount;
+
+        if (thsvsCoverAccessTypes(stageMask, accessMask, imageLayout, (ThsvsImageLayout)layout, &accessCount, pAccesses))
+        {
+            *pAccessCount = accessCount;
+            *pLayout      = (ThsvsImageLayout)layout;
+            return VK_TRUE;
+        }
+    }
+
+    *pAccessCount = 0;
+    return VK_FALSE;
+}
+
+/*
+Accumulated translation of a list of access types, shared by each of the
+barrier mapping functions.
+*/
+typedef struct ThsvsTranslatedAccesses {
+    VkPipelineStageFlags stageMask;
+    VkAccessFlags        accessMask;
+    VkAccessFlags        writeAccessMask;
+    uint32_t             hasWriteAccess;
+} ThsvsTranslatedAccesses;
+
+/*
+Translates a list of access types without branching on the access type -
+write access masks come from the table rather than a comparison per access.
+errorChecks is always a constant, so the THSVS_ERROR_CHECK_* asserts are
+compiled out of the fast variants entirely.
+*/
+static inline void thsvsTranslateAccesses(
+    uint32_t                 accessCount,
+    const ThsvsAccessType*   pAccesses,
+    bool                     errorChecks,
+    ThsvsTranslatedAccesses* pTranslated)
+{
+    VkPipelineStageFlags stageMask       = 0;
+    VkAccessFlags        accessMask      = 0;
+    VkAccessFlags        writeAccessMask = 0;
+    uint32_t             hasWriteAccess  = 0;
+
+    (void)errorChecks;
+
+    for (uint32_t i = 0; i < accessCount; ++i)
+    {
+        ThsvsAccessType access = pAccesses[i];
+
+#ifdef THSVS_ERROR_CHECK_ACCESS_TYPE_IN_RANGE
+        // Asserts that the access index is a valid range for the lookup
+        assert(!errorChecks || access < THSVS_NUM_ACCESS_TYPES);
+#endif
+
+#ifdef THSVS_ERROR_CHECK_POTENTIAL_HAZARD
+        // Asserts that the access is a read, else it's a write and it should appear on its own.
+        assert(!errorChecks || access < THSVS_END_OF_READ_ACCESS || accessCount == 1);
+#endif
+
+        stageMask       |= THSVS_TABLE_STAGE_MASK(access);
+        accessMask      |= THSVS_TABLE_ACCESS_MASK(access);
+        writeAccessMask |= THSVS_TABLE_WRITE_ACCESS_MASK(access);
+        hasWriteAccess  |= (access > THSVS_END_OF_READ_ACCESS) ? 1 : 0;
+    }
+
+    pTranslated->stageMask       = stageMask;
+    pTranslated->accessMask      = accessMask;
+    pTranslated->writeAccessMask = writeAccessMask;
+    pTranslated->hasWriteAccess  = hasWriteAccess;
+}
+
+/*
+Every access in a list must share an image layout, so it's determined by the
+last access alone; the others are only looked up to check for mixed layouts.
+*/
+static inline VkImageLayout thsvsTranslateImageLayout(
+    uint32_t               accessCount,
+    const ThsvsAccessType* pAccesses,
+    ThsvsImageLayout       layout,
+    VkImageAspectFlags     aspectMask,
+    bool                   errorChecks)
+{
+    (void)errorChecks;
+
+    if (accessCount == 0)
+        return VK_IMAGE_LAYOUT_UNDEFINED;
+
+#ifdef THSVS_ERROR_CHECK_MIXED_IMAGE_LAYOUT
+    for (uint32_t i = 1; i < accessCount; ++i)
+        assert(!errorChecks ||
+               thsvsSelectAspectImageLayout(thsvsGetImageLayout(pAccesses[i], layout), layout, aspectMask) ==
+               thsvsSelectAspectImageLayout(thsvsGetImageLayout(pAccesses[0], layout), layout, aspectMask));
+#endif
+
+    return thsvsSelectAspectImageLayout(thsvsGetImageLayout(pAccesses[accessCount - 1], layout), layout, aspectMask);
+}
+
+/*
+Combines translated previous and next accesses into stages and access masks,
+returning whether the barrier is needed as per thsvsIsBarrierNeeded.
+Visibility operations are only added if something was made available - if
+the src access mask is zero, this is a WAR hazard (or for some reason a
+"RAR"), so the dst access mask can be safely zeroed.
+*/
+static inline VkBool32 thsvsTranslateBarrier(
+    const ThsvsTranslatedAccesses& prev,
+    const ThsvsTranslatedAccesses& next,
+    bool                           transition,
+    VkPipelineStageFlags*          pSrcStages,
+    VkPipelineStageFlags*          pDstStages,
+    VkAccessFlags*                 pSrcAccessMask,
+    VkAccessFlags*                 pDstAccessMask)
+{
+    *pSrcAccessMask = prev.writeAccessMask;
+    *pDstAccessMask = (prev.writeAccessMask != 0) ? next.accessMask : 0;
+
+    // Ensure that the stage masks are valid if no stages were determined
+    *pSrcStages = (prev.stageMask != 0) ? prev.stageMask : (VkPipelineStageFlags)VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    *pDstStages = (next.stageMask != 0) ? next.stageMask : (VkPipelineStageFlags)VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+    return thsvsIsBarrierNeeded(prev.hasWriteAccess != 0, prev.stageMask != 0, next.hasWriteAccess != 0,
+                                transition);
+}
+
+static inline VkBool32 thsvsTranslateMemoryBarrier(
+    const ThsvsGlobalBarrier& thBarrier,
+    bool                      errorChecks,
+    VkPipelineStageFlags*     pSrcStages,
+    VkPipelineStageFlags*     pDstStages,
+    VkMemoryBarrier*          pVkBarrier)
+{
+    ThsvsTranslatedAccesses prev;
+    ThsvsTranslatedAccesses next;
+    thsvsTranslateAccesses(thBarrier.prevAccessCount, thBarrier.pPrevAccesses, errorChecks, &prev);
+    thsvsTranslateAccesses(thBarrier.nextAccessCount, thBarrier.pNextAccesses, errorChecks, &next);
+
+    pVkBarrier->sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    pVkBarrier->pNext = NULL;
+
+    return thsvsTranslateBarrier(prev, next, false, pSrcStages, pDstStages,
+                                 &pVkBarrier->srcAccessMask, &pVkBarrier->dstAccessMask);
+}
+
+static inline VkBool32 thsvsTranslateBufferMemoryBarrier(
+    const ThsvsBufferBarrier& thBarrier,
+    bool                      errorChecks,
+    VkPipelineStageFlags*     pSrcStages,
+    VkPipelineStageFlags*     pDstStages,
+    VkBufferMemoryBarrier*    pVkBarrier)
+{
+    (void)errorChecks;
+
+#ifdef THSVS_ERROR_CHECK_COULD_USE_GLOBAL_BARRIER
+    assert(!errorChecks || thBarrier.srcQueueFamilyIndex != thBarrier.dstQueueFamilyIndex);
+#endif
+
+    ThsvsTranslatedAccesses prev;
+    ThsvsTranslatedAccesses next;
+    thsvsTranslateAccesses(thBarrier.prevAccessCount, thBarrier.pPrevAccesses, errorChecks, &prev);
+    thsvsTranslateAccesses(thBarrier.nextAccessCount, thBarrier.pNextAccesses, errorChecks, &next);
+
+    pVkBarrier->sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    pVkBarrier->pNext               = NULL;
+    pVkBarrier->srcQueueFamilyIndex = thBarrier.srcQueueFamilyIndex;
+    pVkBarrier->dstQueueFamilyIndex = thBarrier.dstQueueFamilyIndex;
+    pVkBarrier->buffer              = thBarrier.buffer;
+    pVkBarrier->offset              = thBarrier.offset;
+    pVkBarrier->size                = thBarrier.size;
+
+    return thsvsTranslateBarrier(prev, next, thBarrier.srcQueueFamilyIndex != thBarrier.dstQueueFamilyIndex,
+                                 pSrcStages, pDstStages,
+                                 &pVkBarrier->srcAccessMask, &pVkBarrier->dstAccessMask);
+}
+
+static inline VkBool32 thsvsTranslateImageMemoryBarrier(
+    const ThsvsImageBarrier& thBarrier,
+    bool                     errorChecks,
+    VkPipelineStageFlags*    pSrcStages,
+    VkPipelineStageFlags*    pDstStages,
+    VkImageMemoryBarrier*    pVkBarrier)
+{
+    ThsvsTranslatedAccesses prev;
+    ThsvsTranslatedAccesses next;
+    thsvsTranslateAccesses(thBarrier.prevAccessCount, thBarrier.pPrevAccesses, errorChecks, &prev);
+    thsvsTranslateAccesses(thBarrier.nextAccessCount, thBarrier.pNextAccesses, errorChecks, &next);
+
+    VkImageLayout oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    if (thBarrier.discardContents != VK_TRUE)
+        oldLayout = thsvsTranslateImageLayout(thBarrier.prevAccessCount, thBarrier.pPrevAccesses,
+                                              thBarrier.prevLayout, thBarrier.subresourceRange.aspectMask, errorChecks);
+    VkImageLayout newLayout = thsvsTranslateImageLayout(thBarrier.nextAccessCount, thBarrier.pNextAccesses,
+                                                        thBarrier.nextLayout, thBarrier.subresourceRange.aspectMask, errorChecks);
+
+    pVkBarrier->sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    pVkBarrier->pNext               = NULL;
+    pVkBarrier->oldLayout           = oldLayout;
+    pVkBarrier->newLayout           = newLayout;
+    pVkBarrier->srcQueueFamilyIndex = thBarrier.srcQueueFamilyIndex;
+    pVkBarrier->dstQueueFamilyIndex = thBarrier.dstQueueFamilyIndex;
+    pVkBarrier->image               = thBarrier.image;
+    pVkBarrier->subresourceRange    = thBarrier.subresourceRange;
+
+#ifdef THSVS_ERROR_CHECK_COULD_USE_GLOBAL_BARRIER
+    assert(!errorChecks || newLayout != oldLayout ||
+           thBarrier.srcQueueFamilyIndex != thBarrier.dstQueueFamilyIndex);
+#endif
+
+    return thsvsTranslateBarrier(prev, next,
+                                 oldLayout != newLayout ||
+                                 thBarrier.srcQueueFamilyIndex != thBarrier.dstQueueFamilyIndex,
+                                 pSrcStages, pDstStages,
+                                 &pVkBarrier->srcAccessMask, &pVkBarrier->dstAccessMask);
+}
+
+static inline VkBool32 thsvsTranslateImageMemoryBarriers(
+    uint32_t                 imageBarrierCount,
+    const ThsvsImageBarrier* pImageBarriers,
+    bool                     errorChecks,
+    VkPipelineStageFlags*    pSrcStages,
+    VkPipelineStageFlags*    pDstStages,
+    VkImageMemoryBarrier*    pVkBarriers)
+{
+    VkPipelineStageFlags srcStageMask = 0;
+    VkPipelineStageFlags dstStageMask = 0;
+    VkBool32             needed       = VK_FALSE;
+
+    for (uint32_t i = 0; i < imageBarrierCount; ++i)
+    {
+        VkPipelineStageFlags srcStages;
+        VkPipelineStageFlags dstStages;
+        needed |= thsvsTranslateImageMemoryBarrier(pImageBarriers[i], errorChecks, &srcStages, &dstStages,
+                                                   &pVkBarriers[i]);
+        srcStageMask |= srcStages;
+        dstStageMask |= dstStages;
+    }
+
+    // Ensure that the stage masks are valid if there were no barriers
+    *pSrcStages = (srcStageMask != 0) ? srcStageMask : (VkPipelineStageFlags)VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    *pDstStages = (dstStageMask != 0) ? dstStageMask : (VkPipelineStageFlags)VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+    return needed;
+}
+
+VkBool32 thsvsGetVulkanMemoryBarrier(
+    const ThsvsGlobalBarrier& thBarrier,
+    VkPipelineStageFlags*     pSrcStages,
+    VkPipelineStageFlags*     pDstStages,
+    VkMemoryBarrier*          pVkBarrier)
+{
+    return thsvsTranslateMemoryBarrier(thBarrier, true, pSrcStages, pDstStages, pVkBarrier);
+}
+
+VkBool32 thsvsGetVulkanBufferMemoryBarrier(
+    const ThsvsBufferBarrier& thBarrier,
+    VkPipelineStageFlags*     pSrcStages,
+    VkPipelineStageFlags*     pDstStages,
+    VkBufferMemoryBarrier*    pVkBarrier)
+{
+    return thsvsTranslateBufferMemoryBarrier(thBarrier, true, pSrcStages, pDstStages, pVkBarrier);
+}
+
+VkBool32 thsvsGetVulkanImageMemoryBarrier(
+    const ThsvsImageBarrier& thBarrier,
+    VkPipelineStageFlags*    pSrcStages,
+    VkPipelineStageFlags*    pDstStages,
+    VkImageMemoryBarrier*    pVkBarrier)
+{
+    return thsvsTranslateImageMemoryBarrier(thBarrier, true, pSrcStages, pDstStages, pVkBarrier);
+}
+
+VkBool32 thsvsGetVulkanImageMemoryBarriers(
+    uint32_t                 imageBarrierCount,
+    const ThsvsImageBarrier* pImageBarriers,
+    VkPipelineStageFlags*    pSrcStages,
+    VkPipelineStageFlags*    pDstStages,
+    VkImageMemoryBarrier*    pVkBarriers)
+{
+    return thsvsTranslateImageMemoryBarriers(imageBarrierCount, pImageBarriers, true, pSrcStages, pDstStages,
+                                             pVkBarriers);
+}
+
+VkBool32 thsvsGetVulkanMemoryBarrierFast(
+    const ThsvsGlobalBarrier& thBarrier,
+    VkPipelineStageFlags*     pSrcStages,
+    VkPipelineStageFlags*     pDstStages,
+    VkMemoryBarrier*          pVkBarrier)
+{
+    return thsvsTranslateMemoryBarrier(thBarrier, false, pSrcStages, pDstStages, pVkBarrier);
+}
+
+VkBool32 thsvsGetVulkanBufferMemoryBarrierFast(
+    const ThsvsBufferBarrier& thBarrier,
+    VkPipelineStageFlags*     pSrcStages,
+    VkPipelineStageFlags*     pDstStages,
+    VkBufferMemoryBarrier*    pVkBarrier)
+{
+    return thsvsTranslateBufferMemoryBarrier(thBarrier, false, pSrcStages, pDstStages, pVkBarrier);
+}
+
+VkBool32 thsvsGetVulkanImageMemoryBarrierFast(
+    const ThsvsImageBarrier& thBarrier,
+    VkPipelineStageFlags*    pSrcStages,
+    VkPipelineStageFlags*    pDstStages,
+    VkImageMemoryBarrier*    pVkBarrier)
+{
+    return thsvsTranslateImageMemoryBarrier(thBarrier, false, pSrcStages, pDstStages, pVkBarrier);
+}
+
+VkBool32 thsvsGetVulkanImageMemoryBarriersFast(
+    uint32_t                 imageBarrierCount,
+    const ThsvsImageBarrier* pImageBarriers,
+    VkPipelineStageFlags*    pSrcStages,
+    VkPipelineStageFlags*    pDstStages,
+    VkImageMemoryBarrier*    pVkBarriers)
+{
+    return thsvsTranslateImageMemoryBarriers(imageBarrierCount, pImageBarriers, false, pSrcStages, pDstStages,
+                                             pVkBarriers);
+}
+
+void thsvsCompileAccessSet(
+    uint32_t               accessCount,
+    const ThsvsAccessType* pAccesses,
+    ThsvsAccessSet*        pAccessSet)
+{
+    for (uint32_t layout = 0; layout < THSVS_NUM_IMAGE_LAYOUTS; ++layout)
+        pAccessSet->imageLayouts[layout] = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    ThsvsTranslatedAccesses translated;
+    thsvsTranslateAccesses(accessCount, pAccesses, true, &translated);
+
+    pAccessSet->stageMask       = translated.stageMask;
+    pAccessSet->accessMask      = translated.accessMask;
+    pAccessSet->writeAccessMask = translated.writeAccessMask;
+    pAccessSet->hasWriteAccess  = (translated.hasWriteAccess != 0) ? VK_TRUE : VK_FALSE;
+
+    for (uint32_t i = 0; i < accessCount; ++i)
+    {
+        ThsvsAccessType access = pAccesses[i];
+
+#ifdef THSVS_ERROR_CHECK_MIXED_IMAGE_LAYOUT
+        // The set may yet be used for buffers, so only accesses that actually have a layout are checked
+        assert(THSVS_TABLE_IMAGE_LAYOUT(access) == VK_IMAGE_LAYOUT_UNDEFINED ||
+               pAccessSet->imageLayouts[THSVS_IMAGE_LAYOUT_OPTIMAL] == VK_IMAGE_LAYOUT_UNDEFINED ||
+               pAccessSet->imageLayouts[THSVS_IMAGE_LAYOUT_OPTIMAL] == THSVS_TABLE_IMAGE_LAYOUT(access));
+#endif
+
+        for (uint32_t layout = 0; layout < THSVS_NUM_IMAGE_LAYOUTS; ++layout)
+            pAccessSet->imageLayouts[layout] = thsvsGetImageLayout(access, (ThsvsImageLayout)layout);
+    }
+}
+
+VkBool32 thsvsGetVulkanCompiledMemoryBarrier(
+    const ThsvsCompiledGlobalBarrier& thBarrier,
+    VkPipelineStageFlags*             pSrcStages,
+    VkPipelineStageFlags*             pDstStages,
+    VkMemoryBarrier*                  pVkBarrier)
+{
+    const ThsvsAccessSet* pPrevAccessSet = thBarrier.pPrevAccessSet;
+    const ThsvsAccessSet* pNextAccessSet = thBarrier.pNextAccessSet;
+
+    pVkBarrier->sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    pVkBarrier->pNext         = NULL;
+
+    // Availability operations for writes only, and visibility operations only if something was made available
+    pVkBarrier->srcAccessMask = pPrevAccessSet->writeAccessMask;
+    pVkBarrier->dstAccessMask = (pPrevAccessSet->writeAccessMask != 0) ? pNextAccessSet->accessMask : 0;
+
+    // Ensure that the stage masks are valid if no stages were determined
+    *pSrcStages = (pPrevAccessSet->stageMask != 0) ? pPrevAccessSet->stageMask : (VkPipelineStageFlags)VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    *pDstStages = (pNextAccessSet->stageMask != 0) ? pNextAccessSet->stageMask : (VkPipelineStageFlags)VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+    return thsvsIsBarrierNeeded(pPrevAccessSet->hasWriteAccess == VK_TRUE, pPrevAccessSet->stageMask != 0,
+                                pNextAccessSet->hasWriteAccess == VK_TRUE,
+                                false);
+}
+
+VkBool32 thsvsGetVulkanCompiledBufferMemoryBarrier(
+    const ThsvsCompiledBufferBarrier& thBarrier,
+    VkPipelineStageFlags*             pSrcStages,
+    VkPipelineStageFlags*             pDstStages,
+    VkBufferMemoryBarrier*            pVkBarrier)
+{
+    const ThsvsAccessSet* pPrevAccessSet = thBarrier.pPrevAccessSet;
+    const ThsvsAccessSet* pNextAccessSet = thBarrier.pNextAccessSet;
+
+    pVkBarrier->sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    pVkBarrier->pNext               = NULL;
+    pVkBarrier->srcAccessMask       = pPrevAccessSet->writeAccessMask;
+    pVkBarrier->dstAccessMask       = (pPrevAccessSet->writeAccessMask != 0) ? pNextAccessSet->accessMask : 0;
+    pVkBarrier->srcQueueFamilyIndex = thBarrier.srcQueueFamilyIndex;
+    pVkBarrier->dstQueueFamilyIndex = thBarrier.dstQueueFamilyIndex;
+    pVkBarrier->buffer              = thBarrier.buffer;
+    pVkBarrier->offset              = thBarrier.offset;
+    pVkBarrier->size                = thBarrier.size;
+
+#ifdef THSVS_ERROR_CHECK_COULD_USE_GLOBAL_BARRIER
+    assert(pVkBarrier->srcQueueFamilyIndex != pVkBarrier->dstQueueFamilyIndex);
+#endif
+
+    *pSrcStages = (pPrevAccessSet->stageMask != 0) ? pPrevAccessSet->stageMask : (VkPipelineStageFlags)VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    *pDstStages = (pNextAccessSet->stageMask != 0) ? pNextAccessSet->stageMask : (VkPipelineStageFlags)VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+    return thsvsIsBarrierNeeded(pPrevAccessSet->hasWriteAccess == VK_TRUE, pPrevAccessSet->stageMask != 0,
+                                pNextAccessSet->hasWriteAccess == VK_TRUE,
+                                pVkBarrier->srcQueueFamilyIndex != pVkBarrier->dstQueueFamilyIndex);
+}
+
+VkBool32 thsvsGetVulkanCompiledImageMemoryBarrier(
+    const ThsvsCompiledImageBarrier& thBarrier,
+    VkPipelineStageFlags*            pSrcStages,
+    VkPipelineStageFlags*            pDstStages,
+    VkImageMemoryBarrier*            pVkBarrier)
+{
+    const ThsvsAccessSet* pPrevAccessSet = thBarrier.pPrevAccessSet;
+    const ThsvsAccessSet* pNextAccessSet = thBarrier.pNextAccessSet;
+
+    pVkBarrier->sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    pVkBarrier->pNext               = NULL;
+    pVkBarrier->srcAccessMask       = pPrevAccessSet->writeAccessMask;
+    pVkBarrier->dstAccessMask       = (pPrevAccessSet->writeAccessMask != 0) ? pNextAccessSet->accessMask : 0;
+    pVkBarrier->srcQueueFamilyIndex = thBarrier.srcQueueFamilyIndex;
+    pVkBarrier->dstQueueFamilyIndex = thBarrier.dstQueueFamilyIndex;
+    pVkBarrier->image               = thBarrier.image;
+    pVkBarrier->subresourceRange    = thBarrier.subresourceRange;
+    pVkBarrier->oldLayout           = (thBarrier.discardContents == VK_TRUE) ? VK_IMAGE_LAYOUT_UNDEFINED :
+                                      thsvsSelectAspectImageLayout(pPrevAccessSet->imageLayouts[thBarrier.prevLayout], thBarrier.prevLayout, thBarrier.subresourceRange.aspectMask);
+    pVkBarrier->newLayout           = thsvsSelectAspectImageLayout(pNextAccessSet->imageLayouts[thBarrier.nextLayout], thBarrier.nextLayout, thBarrier.subresourceRange.aspectMask);
+
+#ifdef THSVS_ERROR_CHECK_COULD_USE_GLOBAL_BARRIER
+    assert(pVkBarrier->newLayout != pVkBarrier->oldLayout ||
+           pVkBarrier->srcQueueFamilyIndex != pVkBarrier->dstQueueFamilyIndex);
+#endif
+
+    *pSrcStages = (pPrevAccessSet->stageMask != 0) ? pPrevAccessSet->stageMask : (VkPipelineStageFlags)VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    *pDstStages = (pNextAccessSet->stageMask != 0) ? pNextAccessSet->stageMask : (VkPipelineStageFlags)VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+    return thsvsIsBarrierNeeded(pPrevAccessSet->hasWriteAccess == VK_TRUE, pPrevAccessSet->stageMask != 0,
+                                pNextAccessSet->hasWriteAccess == VK_TRUE,
+                                pVkBarrier->oldLayout != pVkBarrier->newLayout ||
+                                pVkBarrier->srcQueueFamilyIndex != pVkBarrier->dstQueueFamilyIndex);
+}
+
+// Returns the index of the lowest set bit; bits must not be 0
+static uint32_t thsvsFindLowestBit(
+    uint64_t bits)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return (uint32_t)__builtin_ctzll(bits);
+#elif defined(_MSC_VER) && defined(_WIN64)
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return (uint32_t)index;
+#else
+    uint32_t index = 0;
+    while ((bits & 1) == 0)
+    {
+        bits >>= 1;
+        ++index;
+    }
+    return index;
+#endif
+}
+
+// Accumulates the stages and accesses of each access set in a mask, returning the number of accesses visited
+static uint32_t thsvsAccumulateAccessMask(
+    const ThsvsAccessMask& accessMask,
+    VkPipelineStageFlags*  pStageMask,
+    VkAccessFlags*         pAccessMask,
+    VkAccessFlags*         pWriteAccessMask,
+    bool*                  pHasWriteAccess,
+    ThsvsAccessType*       pLastAccess)
+{
+    // Accumulated locally so that nothing is written back until all the accesses have been visited
+    uint32_t             accessCount     = 0;
+    VkPipelineStageFlags stageMask       = 0;
+    VkAccessFlags        accessFlags     = 0;
+    VkAccessFlags        writeAccessMask = 0;
+    bool                 hasWriteAccess  = false;
+    ThsvsAccessType      lastAccess      = THSVS_ACCESS_NONE;
+
+#ifdef THSVS_ERROR_CHECK_ACCESS_TYPE_IN_RANGE
+    // Asserts that no bits are set beyond the last access type
+    assert((accessMask.bits[1] >> (THSVS_NUM_ACCESS_TYPES - 64)) == 0);
+#endif
+
+#ifdef THSVS_ERROR_CHECK_MIXED_IMAGE_LAYOUT
+    VkImageLayout imageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+#endif
+
+    for (uint32_t word = 0; word < 2; ++word)
+    {
+        // Visit each set bit in turn, clearing it once done
+        for (uint64_t bits = accessMask.bits[word]; bits != 0; bits &= bits - 1)
+        {
+            ThsvsAccessType access = (ThsvsAccessType)(word * 64 + thsvsFindLowestBit(bits));
+
+            stageMask   |= THSVS_TABLE_STAGE_MASK(access);
+            accessFlags |= THSVS_TABLE_ACCESS_MASK(access);
+
+            if (access > THSVS_END_OF_READ_ACCESS)
+            {
+                writeAccessMask |= THSVS_TABLE_ACCESS_MASK(access);
+                hasWriteAccess = true;
+            }
+
+            ++accessCount;
+
+#ifdef THSVS_ERROR_CHECK_POTENTIAL_HAZARD
+            // Asserts that any write access appears on its own
+            assert(!hasWriteAccess || accessCount == 1);
+#endif
+
+#ifdef THSVS_ERROR_CHECK_MIXED_IMAGE_LAYOUT
+            // The mask may yet be used for buffers, so only accesses that actually have a layout are checked
+            assert(THSVS_TABLE_IMAGE_LAYOUT(access) == VK_IMAGE_LAYOUT_UNDEFINED ||
+                   imageLayout == VK_IMAGE_LAYOUT_UNDEFINED ||
+                   imageLayout == THSVS_TABLE_IMAGE_LAYOUT(access));
+            if (THSVS_TABLE_IMAGE_LAYOUT(access) != VK_IMAGE_LAYOUT_UNDEFINED)
+                imageLayout = THSVS_TABLE_IMAGE_LAYOUT(access);
+#endif
+
+            // Only the last access determines the image layout, as with access lists
+            lastAccess = access;
+        }
+    }
+
+    *pStageMask       = stageMask;
+    *pAccessMask      = accessFlags;
+    *pWriteAccessMask = writeAccessMask;
+    *pHasWriteAccess  = hasWriteAccess;
+    *pLastAccess      = lastAccess;
+
+    return accessCount;
+}
+
+void thsvsMakeAccessMask(
+    uint32_t               accessCount,
+    const ThsvsAccessType* pAccesses,
+    ThsvsAccessMask*       pAccessMask)
+{
+    pAccessMask->bits[0] = 0;
+    pAccessMask->bits[1] = 0;
+
+    for (uint32_t i = 0; i < accessCount; ++i)
+    {
+        ThsvsAccessType access = pAccesses[i];
+
+#ifdef THSVS_ERROR_CHECK_ACCESS_TYPE_IN_RANGE
+        // Asserts that the access index is a valid range for the lookup
+        assert(access < THSVS_NUM_ACCESS_TYPES);
+#endif
+
+        pAccessMask->bits[access / 64] |= (uint64_t)1 << (access % 64);
+    }
+}
+
+void thsvsCompileAccessMask(
+    const ThsvsAccessMask& accessMask,
+    ThsvsAccessSet*        pAccessSet)
+{
+    bool hasWriteAccess;
+    ThsvsAccessType lastAccess;
+    uint32_t accessCount = thsvsAccumulateAccessMask(accessMask, &pAccessSet->stageMask, &pAccessSet->accessMask,
+                                                     &pAccessSet->writeAccessMask, &hasWriteAccess, &lastAccess);
+
+    pAccessSet->hasWriteAccess = hasWriteAccess ? VK_TRUE : VK_FALSE;
+    for (uint32_t layout = 0; layout < THSVS_NUM_IMAGE_LAYOUTS; ++layout)
+        pAccessSet->imageLayouts[layout] = (accessCount > 0) ? thsvsGetImageLayout(lastAccess, (ThsvsImageLayout)layout) : VK_IMAGE_LAYOUT_UNDEFINED;
+}
+
+VkBool32 thsvsGetVulkanMaskMemoryBarrier(
+    const ThsvsMaskGlobalBarrier& thBarrier,
+    VkPipelineStageFlags*         pSrcStages,
+    VkPipelineStageFlags*         pDstStages,
+    VkMemoryBarrier*              pVkBarrier)
+{
+    VkPipelineStageFlags prevStageMask, nextStageMask;
+    VkAccessFlags prevAccessMask, nextAccessMask;
+    VkAccessFlags prevWriteAccessMask, nextWriteAccessMask;
+    bool prevHasWriteAccess, nextHasWriteAccess;
+    ThsvsAccessType prevLastAccess, nextLastAccess;
+    thsvsAccumulateAccessMask(thBarrier.prevAccesses, &prevStageMask, &prevAccessMask, &prevWriteAccessMask, &prevHasWriteAccess, &prevLastAccess);
+    thsvsAccumulateAccessMask(thBarrier.nextAccesses, &nextStageMask, &nextAccessMask, &nextWriteAccessMask, &nextHasWriteAccess, &nextLastAccess);
+
+    pVkBarrier->sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    pVkBarrier->pNext         = NULL;
+
+    // Availability operations for writes only, and visibility operations only if something was made available
+    pVkBarrier->srcAccessMask = prevWriteAccessMask;
+    pVkBarrier->dstAccessMask = (prevWriteAccessMask != 0) ? nextAccessMask : 0;
+
+    // Ensure that the stage masks are valid if no stages were determined
+    *pSrcStages = (prevStageMask != 0) ? prevStageMask : (VkPipelineStageFlags)VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    *pDstStages = (nextStageMask != 0) ? nextStageMask : (VkPipelineStageFlags)VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+    return thsvsIsBarrierNeeded(prevHasWriteAccess, prevStageMask != 0, nextHasWriteAccess, false);
+}
+
+VkBool32 thsvsGetVulkanMaskBufferMemoryBarrier(
+    const ThsvsMaskBufferBarrier& thBarrier,
+    VkPipelineStageFlags*         pSrcStages,
+    VkPipelineStageFlags*         pDstStages,
+    VkBufferMemoryBarrier*        pVkBarrier)
+{
+    VkPipelineStageFlags prevStageMask, nextStageMask;
+    VkAccessFlags prevAccessMask, nextAccessMask;
+    VkAccessFlags prevWriteAccessMask, nextWriteAccessMask;
+    bool prevHasWriteAccess, nextHasWriteAccess;
+    ThsvsAccessType prevLastAccess, nextLastAccess;
+    thsvsAccumulateAccessMask(thBarrier.prevAccesses, &prevStageMask, &prevAccessMask, &prevWriteAccessMask, &prevHasWriteAccess, &prevLastAccess);
+    thsvsAccumulateAccessMask(thBarrier.nextAccesses, &nextStageMask, &nextAccessMask, &nextWriteAccessMask, &nextHasWriteAccess, &nextLastAccess);
+
+    pVkBarrier->sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    pVkBarrier->pNext               = NULL;
+    pVkBarrier->srcAccessMask       = prevWriteAccessMask;
+    pVkBarrier->dstAccessMask       = (prevWriteAccessMask != 0) ? nextAccessMask : 0;
+    pVkBarrier->srcQueueFamilyIndex = thBarrier.srcQueueFamilyIndex;
+    pVkBarrier->dstQueueFamilyIndex = thBarrier.dstQueueFamilyIndex;
+    pVkBarrier->buffer              = thBarrier.buffer;
+    pVkBarrier->offset              = thBarrier.offset;
+    pVkBarrier->size                = thBarrier.size;
+
+#ifdef THSVS_ERROR_CHECK_COULD_USE_GLOBAL_BARRIER
+    assert(pVkBarrier->srcQueueFamilyIndex != pVkBarrier->dstQueueFamilyIndex);
+#endif
+
+    *pSrcStages = (prevStageMask != 0) ? prevStageMask : (VkPipelineStageFlags)VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    *pDstStages = (nextStageMask != 0) ? nextStageMask : (VkPipelineStageFlags)VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+    return thsvsIsBarrierNeeded(prevHasWriteAccess, prevStageMask != 0, nextHasWriteAccess,
+                                pVkBarrier->srcQueueFamilyIndex != pVkBarrier->dstQueueFamilyIndex);
+}
+
+VkBool32 thsvsGetVulkanMaskImageMemoryBarrier(
+    const ThsvsMaskImageBarrier&  thBarrier,
+    VkPipelineStageFlags*         pSrcStages,
+    VkPipelineStageFlags*         pDstStages,
+    VkImageMemoryBarrier*         pVkBarrier)
+{
+    VkPipelineStageFlags prevStageMask, nextStageMask;
+    VkAccessFlags prevAccessMask, nextAccessMask;
+    VkAccessFlags prevWriteAccessMask, nextWriteAccessMask;
+    bool prevHasWriteAccess, nextHasWriteAccess;
+    ThsvsAccessType prevLastAccess, nextLastAccess;
+    uint32_t prevAccessCount = thsvsAccumulateAccessMask(thBarrier.prevAccesses, &prevStageMask, &prevAccessMask, &prevWriteAccessMask, &prevHasWriteAccess, &prevLastAccess);
+    uint32_t nextAccessCount = thsvsAccumulateAccessMask(thBarrier.nextAccesses, &nextStageMask, &nextAccessMask, &nextWriteAccessMask, &nextHasWriteAccess, &nextLastAccess);
+
+    pVkBarrier->sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    pVkBarrier->pNext               = NULL;
+    pVkBarrier->srcAccessMask       = prevWriteAccessMask;
+    pVkBarrier->dstAccessMask       = (prevWriteAccessMask != 0) ? nextAccessMask : 0;
+    pVkBarrier->srcQueueFamilyIndex = thBarrier.srcQueueFamilyIndex;
+    pVkBarrier->dstQueueFamilyIndex = thBarrier.dstQueueFamilyIndex;
+    pVkBarrier->image               = thBarrier.image;
+    pVkBarrier->subresourceRange    = thBarrier.subresourceRange;
+    pVkBarrier->oldLayout           = (thBarrier.discardContents == VK_TRUE || prevAccessCount == 0) ? VK_IMAGE_LAYOUT_UNDEFINED :
+                                      thsvsSelectAspectImageLayout(thsvsGetImageLayout(prevLastAccess, thBarrier.prevLayout), thBarrier.prevLayout, thBarrier.subresourceRange.aspectMask);
+    pVkBarrier->newLayout           = (nextAccessCount == 0) ? VK_IMAGE_LAYOUT_UNDEFINED :
+                                      thsvsSelectAspectImageLayout(thsvsGetImageLayout(nextLastAccess, thBarrier.nextLayout), thBarrier.nextLayout, thBarrier.subresourceRange.aspectMask);
+
+#ifdef THSVS_ERROR_CHECK_COULD_USE_GLOBAL_BARRIER
+    assert(pVkBarrier->newLayout != pVkBarrier->oldLayout ||
+           pVkBarrier->srcQueueFamilyIndex != pVkBarrier->dstQueueFamilyIndex);
+#endif
+
+    *pSrcStages = (prevStageMask != 0) ? prevStageMask : (VkPipelineStageFlags)VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    *pDstStages = (nextStageMask != 0) ? nextStageMask : (VkPipelineStageFlags)VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+    return thsvsIsBarrierNeeded(prevHasWriteAccess, prevStageMask != 0, nextHasWriteAccess,
+                                pVkBarrier->oldLayout != pVkBarrier->newLayout ||
+                                pVkBarrier->srcQueueFamilyIndex != pVkBarrier->dstQueueFamilyIndex);
+}
+
+void thsvsInitScratch(
+    ThsvsScratch*             pScratch,
+    void*                     pMemory,
+    size_t                    size)
+{
+    pScratch->pMemory = pMemory;
+    pScratch->size    = size;
+    pScratch->offset  = 0;
+}
+
+void thsvsResetScratch(
+    ThsvsScratch*             pScratch)
+{
+    pScratch->offset = 0;
+}
+
+void* thsvsScratchAlloc(
+    ThsvsScratch*             pScratch,
+    size_t                    size)
+{
+    // Align the address rather than the offset, as there's no guarantee about the alignment of pMemory
+    uintptr_t base    = (uintptr_t)pScratch->pMemory;
+    uintptr_t aligned = (base + pScratch->offset + (THSVS_SCRATCH_ALIGNMENT - 1)) & ~(uintptr_t)(THSVS_SCRATCH_ALIGNMENT - 1);
+    size_t    offset  = (size_t)(aligned - base);
+
+    if (offset > pScratch->size || size > pScratch->size - offset)
+        return NULL;
+
+    pScratch->offset = offset + size;
+    return (void*)aligned;
+}
+
+// Determines the pipeline stages of a list of accesses, regardless of what they access or how
+static VkPipelineStageFlags thsvsGetStageMask(
+    uint32_t               accessCount,
+    const ThsvsAccessType* pAccesses)
+{
+    VkPipelineStageFlags stageMask = 0;
+
+    for (uint32_t i = 0; i < accessCount; ++i)
+    {
+        ThsvsAccessType access = pAccesses[i];
+
+#ifdef THSVS_ERROR_CHECK_ACCESS_TYPE_IN_RANGE
+        // Asserts that the access index is a valid range for the lookup
+        assert(access < THSVS_NUM_ACCESS_TYPES);
+#endif
+
+        stageMask |= THSVS_TABLE_STAGE_MASK(access);
+    }
+
+    return stageMask;
+}
+
+/*
+Determines the stages of all previous accesses in a set of barriers, which
+is what has to be passed to vkCmdSetEvent, and the srcStageMask of the
+matching vkCmdWaitEvents.
+*/
+static VkPipelineStageFlags thsvsGetBarriersSrcStageMask(
+    const ThsvsGlobalBarrier* pGlobalBarrier,
+    uint32_t                  bufferBarrierCount,
+    const ThsvsBufferBarrier* pBufferBarriers,
+    uint32_t                  imageBarrierCount,
+    const ThsvsImageBarrier*  pImageBarriers)
+{
+    VkPipelineStageFlags stageMask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+
+    if (pGlobalBarrier != NULL)
+        stageMask |= thsvsGetStageMask(pGlobalBarrier->prevAccessCount, pGlobalBarrier->pPrevAccesses);
+
+    for (uint32_t i = 0; i < bufferBarrierCount; ++i)
+        stageMask |= thsvsGetStageMask(pBufferBarriers[i].prevAccessCount, pBufferBarriers[i].pPrevAccesses);
+
+    for (uint32_t i = 0; i < imageBarrierCount; ++i)
+        stageMask |= thsvsGetStageMask(pImageBarriers[i].prevAccessCount, pImageBarriers[i].pPrevAccesses);
+
+    return stageMask;
+}
+
+/*
+Translates a set of barriers into the Vulkan equivalent, writing into caller
+allocated storage - pMemoryBarrier must always be valid, and the buffer and
+image barrier arrays must have space for every barrier passed in.
+The number of each type of Vulkan barrier actually written is returned in
+the count parameters.
+Returns false if there is nothing that needs recording.
+*/
+static bool thsvsTranslateBarriers(
+    const ThsvsGlobalBarrier* pGlobalBarrier,
+    uint32_t                  bufferBarrierCount,
+    const ThsvsBufferBarrier* pBufferBarriers,
+    uint32_t                  imageBarrierCount,
+    const ThsvsImageBarrier*  pImageBarriers,
+    VkPipelineStageFlags*     pSrcStageMask,
+    VkPipelineStageFlags*     pDstStageMask,
+    uint32_t*                 pMemoryBarrierCount,
+    VkMemoryBarrier*          pMemoryBarrier,
+    uint32_t*                 pBufferMemoryBarrierCount,
+    VkBufferMemoryBarrier*    pBufferMemoryBarriers,
+    uint32_t*                 pImageMemoryBarrierCount,
+    VkImageMemoryBarrier*     pImageMemoryBarriers)
+{
+    *pSrcStageMask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    *pDstStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+#ifdef THSVS_ELIDE_REDUNDANT_BARRIERS
+    bool needed = false;
+
+    pMemoryBarrier->sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    pMemoryBarrier->pNext         = NULL;
+    pMemoryBarrier->srcAccessMask = 0;
+    pMemoryBarrier->dstAccessMask = 0;
+    *pBufferMemoryBarrierCount    = 0;
+    *pImageMemoryBarrierCount     = 0;
+
+    // Global memory barrier
+    if (pGlobalBarrier != NULL)
+    {
+        VkPipelineStageFlags tempSrcStageMask = 0;
+        VkPipelineStageFlags tempDstStageMask = 0;
+        VkMemoryBarrier      tempMemoryBarrier;
+        if (thsvsGetVulkanMemoryBarrier(*pGlobalBarrier, &tempSrcStageMask, &tempDstStageMask, &tempMemoryBarrier) == VK_TRUE)
+        {
+            *pSrcStageMask |= tempSrcStageMask;
+            *pDstStageMask |= tempDstStageMask;
+            pMemoryBarrier->srcAccessMask |= tempMemoryBarrier.srcAccessMask;
+            pMemoryBarrier->dstAccessMask |= tempMemoryBarrier.dstAccessMask;
+            needed = true;
+        }
+    }
+
+    // Buffer memory barriers - anything not transferring ownership only needs the global barrier
+    for (uint32_t i = 0; i < bufferBarrierCount; ++i)
+    {
+        VkPipelineStageFlags   tempSrcStageMask = 0;
+        VkPipelineStageFlags   tempDstStageMask = 0;
+        VkBufferMemoryBarrier* pBarrier         = &pBufferMemoryBarriers[*pBufferMemoryBarrierCount];
+        if (thsvsGetVulkanBufferMemoryBarrier(pBufferBarriers[i], &tempSrcStageMask, &tempDstStageMask, pBarrier) == VK_TRUE)
+        {
+            *pSrcStageMask |= tempSrcStageMask;
+            *pDstStageMask |= tempDstStageMask;
+            if (pBarrier->srcQueueFamilyIndex != pBarrier->dstQueueFamilyIndex)
+            {
+                ++*pBufferMemoryBarrierCount;
+            }
+            else
+            {
+                pMemoryBarrier->srcAccessMask |= pBarrier->srcAccessMask;
+                pMemoryBarrier->dstAccessMask |= pBarrier->dstAccessMask;
+            }
+            needed = true;
+        }
+    }
+
+    // Image memory barriers - anything without a layout transition or ownership transfer only needs the global barrier
+    for (uint32_t i = 0; i < imageBarrierCount; ++i)
+    {
+        VkPipelineStageFlags  tempSrcStageMask = 0;
+        VkPipelineStageFlags  tempDstStageMask = 0;
+        VkImageMemoryBarrier* pBarrier         = &pImageMemoryBarriers[*pImageMemoryBarrierCount];
+        if (thsvsGetVulkanImageMemoryBarrier(pImageBarriers[i], &tempSrcStageMask, &tempDstStageMask, pBarrier) == VK_TRUE)
+        {
+            *pSrcStageMask |= tempSrcStageMask;
+            *pDstStageMask |= tempDstStageMask;
+            if (pBarrier->oldLayout != pBarrier->newLayout ||
+                pBarrier->srcQueueFamilyIndex != pBarrier->dstQueueFamilyIndex)
+            {
+                ++*pImageMemoryBarrierCount;
+            }
+            else
+            {
+                pMemoryBarrier->srcAccessMask |= pBarrier->srcAccessMask;
+                pMemoryBarrier->dstAccessMask |= pBarrier->dstAccessMask;
+            }
+            needed = true;
+        }
+    }
+
+    // An execution dependency on its own doesn't need a memory barrier
+    *pMemoryBarrierCount = (pMemoryBarrier->srcAccessMask != 0 || pMemoryBarrier->dstAccessMask != 0) ? 1 : 0;
+
+    return needed;
+#else
+    *pMemoryBarrierCount       = (pGlobalBarrier != NULL) ? 1 : 0;
+    *pBufferMemoryBarrierCount = bufferBarrierCount;
+    *pImageMemoryBarrierCount  = imageBarrierCount;
+
+    // Global memory barrier
+    if (pGlobalBarrier != NULL)
+    {
+        VkPipelineStageFlags tempSrcStageMask = 0;
+        VkPipelineStageFlags tempDstStageMask = 0;
+        thsvsGetVulkanMemoryBarrier(*pGlobalBarrier, &tempSrcStageMask, &tempDstStageMask, pMemoryBarrier);
+        *pSrcStageMask |= tempSrcStageMask;
+        *pDstStageMask |= tempDstStageMask;
+    }
+
+    // Buffer memory barriers
+    for (uint32_t i = 0; i < bufferBarrierCount; ++i)
+    {
+        VkPipelineStageFlags tempSrcStageMask = 0;
+        VkPipelineStageFlags tempDstStageMask = 0;
+        thsvsGetVulkanBufferMemoryBarrier(pBufferBarriers[i], &tempSrcStageMask, &tempDstStageMask, &pBufferMemoryBarriers[i]);
+        *pSrcStageMask |= tempSrcStageMask;
+        *pDstStageMask |= tempDstStageMask;
+    }
+
+    // Image memory barriers
+    if (imageBarrierCount > 0)
+    {
+        VkPipelineStageFlags tempSrcStageMask = 0;
+        VkPipelineStageFlags tempDstStageMask = 0;
+        thsvsGetVulkanImageMemoryBarriers(imageBarrierCount, pImageBarriers, &tempSrcStageMask, &tempDstStageMask, pImageMemoryBarriers);
+        *pSrcStageMask |= tempSrcStageMask;
+        *pDstStageMask |= tempDstStageMask;
+    }
+
+    return true;
+#endif
+}
+
+void thsvsCmdPipelineBarrier(
+    VkCommandBuffer           commandBuffer,
+    const ThsvsGlobalBarrier* pGlobalBarrier,
+    uint32_t                  bufferBarrierCount,
+    const ThsvsBufferBarrier* pBufferBarriers,
+    uint32_t                  imageBarrierCount,
+    const ThsvsImageBarrier*  pImageBarriers)
+{
+    thsvsCmdPipelineBarrierScratch(
+        commandBuffer,
+        NULL,
+        pGlobalBarrier,
+        bufferBarrierCount,
+        pBufferBarriers,
+        imageBarrierCount,
+        pImageBarriers);
+}
+
+/*
+Counts a recorded command and its barriers into pStats.
+Returns true if the command waits on or blocks all commands or all graphics
+stages.
+*/
+static bool thsvsCountBarriers(
+    ThsvsContextStats*           pStats,
+    bool                         waitEvents,
+    VkPipelineStageFlags         srcStageMask,
+    VkPipelineStageFlags         dstStageMask,
+    uint32_t                     memoryBarrierCount,
+    uint32_t                     bufferMemoryBarrierCount,
+    const VkBufferMemoryBarrier* pBufferMemoryBarriers,
+    uint32_t                     imageMemoryBarrierCount,
+    const VkImageMemoryBarrier*  pImageMemoryBarriers)
+{
+    if (waitEvents)
+        pStats->waitEventsCount++;
+    else
+        pStats->pipelineBarrierCount++;
+
+    pStats->memoryBarrierCount       += memoryBarrierCount;
+    pStats->bufferMemoryBarrierCount += bufferMemoryBarrierCount;
+    pStats->imageMemoryBarrierCount  += imageMemoryBarrierCount;
+
+    for (uint32_t i = 0; i < bufferMemoryBarrierCount; ++i)
+    {
+        if (pBufferMemoryBarriers[i].srcQueueFamilyIndex != pBufferMemoryBarriers[i].dstQueueFamilyIndex)
+            pStats->queueTransferCount++;
+    }
+
+    for (uint32_t i = 0; i < imageMemoryBarrierCount; ++i)
+    {
+        if (pImageMemoryBarriers[i].oldLayout != pImageMemoryBarriers[i].newLayout)
+            pStats->layoutTransitionCount++;
+        if (pImageMemoryBarriers[i].srcQueueFamilyIndex != pImageMemoryBarriers[i].dstQueueFamilyIndex)
+            pStats->queueTransferCount++;
+    }
+
+    const VkPipelineStageFlags broadStageMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT | VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT;
+    bool broad = ((srcStageMask | dstStageMask) & broadStageMask) != 0;
+    if (broad)
+        pStats->broadStageMaskCount++;
+
+    return broad;
+}
+
+#if defined(THSVS_STATS) || defined(THSVS_DIAGNOSTICS) || defined(THSVS_CAPTURE) || defined(THSVS_PROFILE)
+  #if __cplusplus >= 201103L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201103L)
+    #define THSVS_THREAD_LOCAL thread_local
+  #elif defined(_MSC_VER)
+    #define THSVS_THREAD_LOCAL __declspec(thread)
+  #else
+    #define THSVS_THREAD_LOCAL __thread
+  #endif
+#endif
+
+#ifdef THSVS_STATS
+static THSVS_THREAD_LOCAL ThsvsContextStats thsvsThreadStats;
+
+// Labels each barrier command counted on this thread, if THSVS_INSERT_DEBUG_LABEL is defined
+static void thsvsInsertBarrierLabel(
+    VkCommandBuffer              commandBuffer,
+    const char*                  pLabelName,
+    bool                         broad)
+{
+#ifdef THSVS_INSERT_DEBUG_LABEL
+    VkDebugUtilsLabelEXT label;
+    label.sType      = VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT;
+    label.pNext      = NULL;
+    label.pLabelName = pLabelName;
+
+    // A color of all zeroes is ignored
+    label.color[0]   = broad ? 1.0f : 0.0f;
+    label.color[1]   = broad ? 0.5f : 0.0f;
+    label.color[2]   = 0.0f;
+    label.color[3]   = broad ? 1.0f : 0.0f;
+
+    THSVS_INSERT_DEBUG_LABEL(commandBuffer, &label);
+#else
+    (void)commandBuffer;
+    (void)pLabelName;
+    (void)broad;
+#endif
+}
+
+// Called immediately before each vkCmdPipelineBarrier or vkCmdWaitEvents recorded by the library
+static void thsvsInstrumentBarrier(
+    VkCommandBuffer              commandBuffer,
+    const char*                  pLabelName,
+    bool                         waitEvents,
+    VkPipelineStageFlags         srcStageMask,
+    VkPipelineStageFlags         dstStageMask,
+    uint32_t                     memoryBarrierCount,
+    uint32_t                     bufferMemoryBarrierCount,
+    const VkBufferMemoryBarrier* pBufferMemoryBarriers,
+    uint32_t                     imageMemoryBarrierCount,
+    const VkImageMemoryBarrier*  pImageMemoryBarriers)
+{
+    bool broad = thsvsCountBarriers(&thsvsThreadStats, waitEvents, srcStageMask, dstStageMask, memoryBarrierCount,
+                                    bufferMemoryBarrierCount, pBufferMemoryBarriers,
+                                    imageMemoryBarrierCount, pImageMemoryBarriers);
+
+    thsvsInsertBarrierLabel(commandBuffer, pLabelName, broad);
+}
+#endif
+
+ThsvsContextStats* thsvsGetThreadStats()
+{
+#ifdef THSVS_STATS
+    return &thsvsThreadStats;
+#else
+    return NULL;
+#endif
+}
+
+#ifdef THSVS_DIAGNOSTICS
+static ThsvsDiagnosticCallback thsvsDiagnosticCallback = NULL;
+static void*                   thsvsDiagnosticUserData = NULL;
+
+// The last command recorded on this thread, and whether it was a pipeline barrier
+static THSVS_THREAD_LOCAL bool            thsvsTrackBarrierSequence = false;
+static THSVS_THREAD_LOCAL bool            thsvsLastCommandIsBarrier = false;
+static THSVS_THREAD_LOCAL VkCommandBuffer thsvsLastCommandBuffer    = VK_NULL_HANDLE;
+
+static void thsvsReportDiagnostic(
+    ThsvsDiagnosticType    type,
+    const char*            pMessage)
+{
+    if (thsvsDiagnosticCallback != NULL)
+        thsvsDiagnosticCallback(type, pMessage, thsvsDiagnosticUserData);
+}
+
+static void thsvsDiagnoseAccesses(
+    uint32_t               accessCount,
+    const ThsvsAccessType* pAccesses)
+{
+    bool general   = false;
+    bool anyShader = false;
+
+    for (uint32_t i = 0; i < accessCount; ++i)
+    {
+        switch (pAccesses[i])
+        {
+            case THSVS_ACCESS_GENERAL:
+                general = true;
+                break;
+            case THSVS_ACCESS_ANY_SHADER_READ_UNIFORM_BUFFER:
+            case THSVS_ACCESS_ANY_SHADER_READ_UNIFORM_BUFFER_OR_VERTEX_BUFFER:
+            case THSVS_ACCESS_ANY_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER:
+            case THSVS_ACCESS_ANY_SHADER_READ_OTHER:
+            case THSVS_ACCESS_ANY_SHADER_WRITE:
+                anyShader = true;
+                break;
+            default:
+                break;
+        }
+    }
+
+    if (general)
+        thsvsReportDiagnostic(THSVS_DIAGNOSTIC_NARROWER_ACCESS_TYPE,
+                              "THSVS_ACCESS_GENERAL waits on or blocks all commands - "
+                              "a more specific access type would avoid serializing unrelated work");
+    if (anyShader)
+        thsvsReportDiagnostic(THSVS_DIAGNOSTIC_NARROWER_ACCESS_TYPE,
+                              "THSVS_ACCESS_ANY_SHADER_* accesses wait on or block every shader stage - "
+                              "a stage specific access type would avoid serializing graphics and compute work");
+}
+
+static void thsvsDiagnoseBarriers(
+    const ThsvsGlobalBarrier* pGlobalBarrier,
+    uint32_t                  bufferBarrierCount,
+    const ThsvsBufferBarrier* pBufferBarriers,
+    uint32_t                  imageBarrierCount,
+    const ThsvsImageBarrier*  pImageBarriers)
+{
+    bool couldUseGlobalBarrier = false;
+
+    if (pGlobalBarrier != NULL)
+    {
+        thsvsDiagnoseAccesses(pGlobalBarrier->prevAccessCount, pGlobalBarrier->pPrevAccesses);
+        thsvsDiagnoseAccesses(pGlobalBarrier->nextAccessCount, pGlobalBarrier->pNextAccesses);
+    }
+
+    for (uint32_t i = 0; i < bufferBarrierCount; ++i)
+    {
+        const ThsvsBufferBarrier& barrier = pBufferBarriers[i];
+
+        thsvsDiagnoseAccesses(barrier.prevAccessCount, barrier.pPrevAccesses);
+        thsvsDiagnoseAccesses(barrier.nextAccessCount, barrier.pNextAccesses);
+
+        if (barrier.srcQueueFamilyIndex == barrier.dstQueueFamilyIndex)
+            couldUseGlobalBarrier = true;
+    }
+
+    for (uint32_t i = 0; i < imageBarrierCount; ++i)
+    {
+        const ThsvsImageBarrier& barrier = pImageBarriers[i];
+
+        thsvsDiagnoseAccesses(barrier.prevAccessCount, barrier.pPrevAccesses);
+        thsvsDiagnoseAccesses(barrier.nextAccessCount, barrier.pNextAccesses);
+
+        // Matches the layouts thsvsGetVulkanImageMemoryBarrier transitions between
+        VkImageAspectFlags aspectMask = barrier.subresourceRange.aspectMask;
+        VkImageLayout oldLayout = barrier.discardContents ? VK_IMAGE_LAYOUT_UNDEFINED :
+                                  thsvsSelectAspectImageLayout(thsvsGetVulkanImageLayout(barrier.prevAccessCount, barrier.pPrevAccesses, barrier.prevLayout),
+                                                               barrier.prevLayout, aspectMask);
+        VkImageLayout newLayout = thsvsSelectAspectImageLayout(thsvsGetVulkanImageLayout(barrier.nextAccessCount, barrier.pNextAccesses, barrier.nextLayout),
+                                                               barrier.nextLayout, aspectMask);
+
+        if (oldLayout == newLayout && barrier.srcQueueFamilyIndex == barrier.dstQueueFamilyIndex)
+            couldUseGlobalBarrier = true;
+    }
+
+    if (couldUseGlobalBarrier)
+        thsvsReportDiagnostic(THSVS_DIAGNOSTIC_GLOBAL_BARRIER,
+                              "A buffer or image barrier has no layout transition or queue family ownership transfer - "
+                              "a global barrier would be equivalent, and is cheaper on most implementations");
+}
+
+// Called for each command recorded, reporting pipeline barriers that directly follow another in the same command buffer
+static void thsvsDiagnoseSequence(
+    VkCommandBuffer           commandBuffer,
+    bool                      pipelineBarrier)
+{
+    if (pipelineBarrier && thsvsTrackBarrierSequence && thsvsLastCommandIsBarrier && thsvsLastCommandBuffer == commandBuffer)
+        thsvsReportDiagnostic(THSVS_DIAGNOSTIC_MERGEABLE_BARRIERS,
+                              "A pipeline barrier was recorded directly after another one - "
+                              "both could be recorded as one, e.g. with a ThsvsBarrierBatch");
+
+    thsvsLastCommandIsBarrier = pipelineBarrier;
+    thsvsLastCommandBuffer    = commandBuffer;
+}
+#endif
+
+void thsvsSetDiagnosticCallback(
+    ThsvsDiagnosticCallback   callback,
+    void*                     pUserData)
+{
+#ifdef THSVS_DIAGNOSTICS
+    thsvsDiagnosticCallback = callback;
+    thsvsDiagnosticUserData = pUserData;
+#else
+    (void)callback;
+    (void)pUserData;
+#endif
+}
+
+void thsvsDiagnoseCommand(
+    VkCommandBuffer           commandBuffer)
+{
+#ifdef THSVS_DIAGNOSTICS
+    thsvsTrackBarrierSequence = true;
+    thsvsDiagnoseSequence(commandBuffer, false);
+#else
+    (void)commandBuffer;
+#endif
+}
+
+#ifdef THSVS_CAPTURE
+static THSVS_THREAD_LOCAL ThsvsCapture* thsvsThreadCapture = NULL;
+
+#if !defined(THSVS_CAPTURE_TIMESTAMP)
+static uint64_t thsvsCaptureTimestamp()
+{
+    struct timespec time;
+#if defined(_MSC_VER) || defined(__MINGW32__)
+    timespec_get(&time, TIME_UTC);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &time);
+#endif
+    return (uint64_t)time.tv_sec * 1000000000u + (uint64_t)time.tv_nsec;
+}
+#define THSVS_CAPTURE_TIMESTAMP() thsvsCaptureTimestamp()
+#endif
+
+// Drops the oldest records while they start in [writeOffset, endOffset)
+static void thsvsCaptureDropRecords(
+    ThsvsCapture*             pCapture,
+    size_t                    endOffset)
+{
+    while (pCapture->recordCount > 0 &&
+           pCapture->oldestOffset >= pCapture->writeOffset &&
+           pCapture->oldestOffset < endOffset)
+    {
+        pCapture->oldestOffset += ((const ThsvsCaptureRecord*)(pCapture->pMemory + pCapture->oldestOffset))->size;
+        if (pCapture->oldestOffset >= pCapture->wrapOffset)
+        {
+            pCapture->oldestOffset = 0;
+            pCapture->wrapOffset   = pCapture->size;
+        }
+        --pCapture->recordCount;
+        ++pCapture->droppedRecordCount;
+    }
+}
+
+/*
+Allocates a record from the calling thread's capture, overwriting the oldest
+records as needed. Records are never split across the end of the memory;
+if one doesn't fit, the capture wraps early and wrapOffset marks where the
+last record before the wrap ends.
+*/
+static ThsvsCaptureRecord* thsvsCaptureAllocRecord(
+    uint32_t                  type,
+    size_t                    size)
+{
+    ThsvsCapture* pCapture = thsvsThreadCapture;
+    if (pCapture == NULL)
+        return NULL;
+
+    size = (size + 7) & ~(size_t)7;
+    if (size > pCapture->size)
+    {
+        ++pCapture->droppedRecordCount;
+        return NULL;
+    }
+
+    if (pCapture->writeOffset + size > pCapture->size)
+    {
+        thsvsCaptureDropRecords(pCapture, pCapture->size);
+        pCapture->wrapOffset  = pCapture->writeOffset;
+        pCapture->writeOffset = 0;
+    }
+
+    thsvsCaptureDropRecords(pCapture, pCapture->writeOffset + size);
+
+    if (pCapture->recordCount == 0)
+    {
+        pCapture->oldestOffset = pCapture->writeOffset;
+        pCapture->wrapOffset   = pCapture->size;
+    }
+
+    ThsvsCaptureRecord* pRecord = (ThsvsCaptureRecord*)(pCapture->pMemory + pCapture->writeOffset);
+    pCapture->writeOffset += size;
+    ++pCapture->recordCount;
+
+    pRecord->size         = (uint32_t)size;
+    pRecord->type         = type;
+    pRecord->timestamp    = THSVS_CAPTURE_TIMESTAMP();
+    pRecord->srcStageMask = 0;
+    pRecord->dstStageMask = 0;
+    pRecord->barrierCount = 0;
+    pRecord->recorded     = VK_FALSE;
+    return pRecord;
+}
+
+static size_t thsvsCaptureBarrierSize(
+    uint32_t                  prevAccessCount,
+    uint32_t                  nextAccessCount)
+{
+    size_t accessCount = (prevAccessCount < 255 ? prevAccessCount : 255) + (nextAccessCount < 255 ? nextAccessCount : 255);
+    return sizeof(ThsvsCaptureBarrier) + ((accessCount + 3) & ~(size_t)3);
+}
+
+// Writes a barrier and its access lists at pData, returning the end of what was written
+static uint8_t* thsvsCaptureBarrier(
+    uint8_t*                  pData,
+    ThsvsCaptureBarrierType   type,
+    VkBool32                  needed,
+    uint32_t                  prevAccessCount,
+    const ThsvsAccessType*    pPrevAccesses,
+    uint32_t                  nextAccessCount,
+    const ThsvsAccessType*    pNextAccesses,
+    ThsvsImageLayout          prevLayout,
+    ThsvsImageLayout          nextLayout,
+    VkBool32                  discardContents,
+    uint32_t                  srcQueueFamilyIndex,
+    uint32_t                  dstQueueFamilyIndex,
+    VkAccessFlags             srcAccessMask,
+    VkAccessFlags             dstAccessMask,
+    VkImageLayout             oldLayout,
+    VkImageLayout             newLayout)
+{
+    ThsvsCaptureBarrier* pBarrier = (ThsvsCaptureBarrier*)pData;
+    pBarrier->type                = (uint8_t)type;
+    pBarrier->flags               = (uint8_t)(((needed == VK_TRUE) ? THSVS_CAPTURE_BARRIER_NEEDED_BIT : 0) |
+                                              ((discardContents == VK_TRUE) ? THSVS_CAPTURE_BARRIER_DISCARD_CONTENTS_BIT : 0));
+    pBarrier->prevAccessCount     = (uint8_t)(prevAccessCount < 255 ? prevAccessCount : 255);
+    pBarrier->nextAccessCount     = (uint8_t)(nextAccessCount < 255 ? nextAccessCount : 255);
+    pBarrier->prevLayout          = (uint8_t)prevLayout;
+    pBarrier->nextLayout          = (uint8_t)nextLayout;
+    pBarrier->reserved            = 0;
+    pBarrier->srcQueueFamilyIndex = srcQueueFamilyIndex;
+    pBarrier->dstQueueFamilyIndex = dstQueueFamilyIndex;
+    pBarrier->srcAccessMask       = srcAccessMask;
+    pBarrier->dstAccessMask       = dstAccessMask;
+    pBarrier->oldLayout           = oldLayout;
+    pBarrier->newLayout           = newLayout;
+
+    uint8_t* pAccesses = pData + sizeof(ThsvsCaptureBarrier);
+    uint32_t accessCount = 0;
+    for (uint32_t i = 0; i < pBarrier->prevAccessCount; ++i)
+        pAccesses[accessCount++] = (uint8_t)pPrevAccesses[i];
+    for (uint32_t i = 0; i < pBarrier->nextAccessCount; ++i)
+        pAccesses[accessCount++] = (uint8_t)pNextAccesses[i];
+    while ((accessCount & 3) != 0)
+        pAccesses[accessCount++] = 0;
+
+    return pAccesses + accessCount;
+}
+
+/*
+Appends a record of a barrier command to the calling thread's capture, with
+the barriers of every event it waits on.
+Each barrier is translated again on its own, so that the record shows what
+it was translated to even if it was merged or elided.
+Synchronization2 commands have no legacy stage masks to record, so pass 0
+for both, and are given the stages their barriers translate to instead.
+*/
+static void thsvsCaptureEventBarriers(
+    ThsvsCaptureRecordType    type,
+    bool                      recorded,
+    VkPipelineStageFlags      srcStageMask,
+    VkPipelineStageFlags      dstStageMask,
+    uint32_t                  eventBarrierCount,
+    const ThsvsEventBarrier*  pEventBarriers)
+{
+    if (thsvsThreadCapture == NULL)
+        return;
+
+    size_t   size         = sizeof(ThsvsCaptureRecord);
+    uint32_t barrierCount = 0;
+    for (uint32_t i = 0; i < eventBarrierCount; ++i)
+    {
+        const ThsvsEventBarrier& eventBarrier = pEventBarriers[i];
+
+        if (eventBarrier.pGlobalBarrier != NULL)
+            size += thsvsCaptureBarrierSize(eventBarrier.pGlobalBarrier->prevAccessCount, eventBarrier.pGlobalBarrier->nextAccessCount);
+        for (uint32_t j = 0; j < eventBarrier.bufferBarrierCount; ++j)
+            size += thsvsCaptureBarrierSize(eventBarrier.pBufferBarriers[j].prevAccessCount, eventBarrier.pBufferBarriers[j].nextAccessCount);
+        for (uint32_t j = 0; j < eventBarrier.imageBarrierCount; ++j)
+            size += thsvsCaptureBarrierSize(eventBarrier.pImageBarriers[j].prevAccessCount, eventBarrier.pImageBarriers[j].nextAccessCount);
+
+        barrierCount += ((eventBarrier.pGlobalBarrier != NULL) ? 1 : 0) + eventBarrier.bufferBarrierCount + eventBarrier.imageBarrierCount;
+    }
+
+    ThsvsCaptureRecord* pRecord = thsvsCaptureAllocRecord(type, size);
+    if (pRecord == NULL)
+        return;
+
+    pRecord->barrierCount = barrierCount;
+    pRecord->recorded     = recorded ? VK_TRUE : VK_FALSE;
+
+    uint8_t*             pData               = (uint8_t*)(pRecord + 1);
+    VkPipelineStageFlags translatedSrcStages = 0;
+    VkPipelineStageFlags translatedDstStages = 0;
+    VkPipelineStageFlags tempSrcStageMask;
+    VkPipelineStageFlags tempDstStageMask;
+
+    for (uint32_t i = 0; i < eventBarrierCount; ++i)
+    {
+        const ThsvsEventBarrier& eventBarrier = pEventBarriers[i];
+
+        if (eventBarrier.pGlobalBarrier != NULL)
+        {
+            const ThsvsGlobalBarrier& thBarrier = *eventBarrier.pGlobalBarrier;
+            VkMemoryBarrier           vkBarrier;
+            VkBool32                  needed = thsvsGetVulkanMemoryBarrierFast(thBarrier, &tempSrcStageMask, &tempDstStageMask, &vkBarrier);
+            pData = thsvsCaptureBarrier(pData, THSVS_CAPTURE_BARRIER_GLOBAL, needed,
+                                        thBarrier.prevAccessCount, thBarrier.pPrevAccesses, thBarrier.nextAccessCount, thBarrier.pNextAccesses,
+                                        THSVS_IMAGE_LAYOUT_OPTIMAL, THSVS_IMAGE_LAYOUT_OPTIMAL, VK_FALSE,
+                                        VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+                                        vkBarrier.srcAccessMask, vkBarrier.dstAccessMask,
+                                        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_UNDEFINED);
+            translatedSrcStages |= tempSrcStageMask;
+            translatedDstStages |= tempDstStageMask;
+        }
+
+        for (uint32_t j = 0; j < eventBarrier.bufferBarrierCount; ++j)
+        {
+            const ThsvsBufferBarrier& thBarrier = eventBarrier.pBufferBarriers[j];
+            VkBufferMemoryBarrier     vkBarrier;
+            VkBool32                  needed = thsvsGetVulkanBufferMemoryBarrierFast(thBarrier, &tempSrcStageMask, &tempDstStageMask, &vkBarrier);
+            pData = thsvsCaptureBarrier(pData, THSVS_CAPTURE_BARRIER_BUFFER, needed,
+                                        thBarrier.prevAccessCount, thBarrier.pPrevAccesses, thBarrier.nextAccessCount, thBarrier.pNextAccesses,
+                                        THSVS_IMAGE_LAYOUT_OPTIMAL, THSVS_IMAGE_LAYOUT_OPTIMAL, VK_FALSE,
+                                        thBarrier.srcQueueFamilyIndex, thBarrier.dstQueueFamilyIndex,
+                                        vkBarrier.srcAccessMask, vkBarrier.dstAccessMask,
+                                        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_UNDEFINED);
+            translatedSrcStages |= tempSrcStageMask;
+            translatedDstStages |= tempDstStageMask;
+        }
+
+        for (uint32_t j = 0; j < eventBarrier.imageBarrierCount; ++j)
+        {
+            const ThsvsImageBarrier& thBarrier = eventBarrier.pImageBarriers[j];
+            VkImageMemoryBarrier     vkBarrier;
+            VkBool32                 needed = thsvsGetVulkanImageMemoryBarrierFast(thBarrier, &tempSrcStageMask, &tempDstStageMask, &vkBarrier);
+            pData = thsvsCaptureBarrier(pData, THSVS_CAPTURE_BARRIER_IMAGE, needed,
+                                        thBarrier.prevAccessCount, thBarrier.pPrevAccesses, thBarrier.nextAccessCount, thBarrier.pNextAccesses,
+                                        thBarrier.prevLayout, thBarrier.nextLayout, thBarrier.discardContents,
+                                        thBarrier.srcQueueFamilyIndex, thBarrier.dstQueueFamilyIndex,
+                                        vkBarrier.srcAccessMask, vkBarrier.dstAccessMask,
+                                        vkBarrier.oldLayout, vkBarrier.newLayout);
+            translatedSrcStages |= tempSrcStageMask;
+            translatedDstStages |= tempDstStageMask;
+        }
+    }
+
+    bool synchronization2 = srcStageMask == 0 && dstStageMask == 0;
+    pRecord->srcStageMask = synchronization2 ? translatedSrcStages : srcStageMask;
+    pRecord->dstStageMask = synchronization2 ? translatedDstStages : dstStageMask;
+}
+
+// Appends a record of a barrier command that doesn't wait on events
+static void thsvsCaptureBarriers(
+    ThsvsCaptureRecordType    type,
+    bool                      recorded,
+    VkPipelineStageFlags      srcStageMask,
+    VkPipelineStageFlags      dstStageMask,
+    const ThsvsGlobalBarrier* pGlobalBarrier,
+    uint32_t                  bufferBarrierCount,
+    const ThsvsBufferBarrier* pBufferBarriers,
+    uint32_t                  imageBarrierCount,
+    const ThsvsImageBarrier*  pImageBarriers)
+{
+    ThsvsEventBarrier eventBarrier;
+    eventBarrier.event              = VK_NULL_HANDLE;
+    eventBarrier.pGlobalBarrier     = pGlobalBarrier;
+    eventBarrier.bufferBarrierCount = bufferBarrierCount;
+    eventBarrier.pBufferBarriers    = pBufferBarriers;
+    eventBarrier.imageBarrierCount  = imageBarrierCount;
+    eventBarrier.pImageBarriers     = pImageBarriers;
+
+    thsvsCaptureEventBarriers(type, recorded, srcStageMask, dstStageMask, 1, &eventBarrier);
+}
+
+/*
+Appends a record of a pipeline barrier built from Vulkan barriers alone -
+barrier batches, aliasing barriers and ownership transfers - so there are no
+access types to capture, only what was recorded.
+*/
+static void thsvsCaptureVulkanBarriers(
+    VkPipelineStageFlags         srcStageMask,
+    VkPipelineStageFlags         dstStageMask,
+    uint32_t                     memoryBarrierCount,
+    const VkMemoryBarrier*       pMemoryBarriers,
+    uint32_t                     bufferMemoryBarrierCount,
+    const VkBufferMemoryBarrier* pBufferMemoryBarriers,
+    uint32_t                     imageMemoryBarrierCount,
+    const VkImageMemoryBarrier*  pImageMemoryBarriers)
+{
+    if (thsvsThreadCapture == NULL)
+        return;
+
+    uint32_t barrierCount = memoryBarrierCount + bufferMemoryBarrierCount + imageMemoryBarrierCount;
+    ThsvsCaptureRecord* pRecord = thsvsCaptureAllocRecord(THSVS_CAPTURE_RECORD_PIPELINE_BARRIER,
+                                                          sizeof(ThsvsCaptureRecord) + barrierCount * thsvsCaptureBarrierSize(0, 0));
+    if (pRecord == NULL)
+        return;
+
+    pRecord->srcStageMask = srcStageMask;
+    pRecord->dstStageMask = dstStageMask;
+    pRecord->barrierCount = barrierCount;
+    pRecord->recorded     = VK_TRUE;
+
+    ThsvsCaptureBarrier* pBarriers = (ThsvsCaptureBarrier*)(pRecord + 1);
+    uint8_t*             pData     = (uint8_t*)pBarriers;
+
+    for (uint32_t i = 0; i < memoryBarrierCount; ++i)
+        pData = thsvsCaptureBarrier(pData, THSVS_CAPTURE_BARRIER_GLOBAL, VK_TRUE, 0, NULL, 0, NULL,
+                                    THSVS_IMAGE_LAYOUT_OPTIMAL, THSVS_IMAGE_LAYOUT_OPTIMAL, VK_FALSE,
+                                    VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+                                    pMemoryBarriers[i].srcAccessMask, pMemoryBarriers[i].dstAccessMask,
+                                    VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_UNDEFINED);
+
+    for (uint32_t i = 0; i < bufferMemoryBarrierCount; ++i)
+        pData = thsvsCaptureBarrier(pData, THSVS_CAPTURE_BARRIER_BUFFER, VK_TRUE, 0, NULL, 0, NULL,
+                                    THSVS_IMAGE_LAYOUT_OPTIMAL, THSVS_IMAGE_LAYOUT_OPTIMAL, VK_FALSE,
+                                    pBufferMemoryBarriers[i].srcQueueFamilyIndex, pBufferMemoryBarriers[i].dstQueueFamilyIndex,
+                                    pBufferMemoryBarriers[i].srcAccessMask, pBufferMemoryBarriers[i].dstAccessMask,
+                                    VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_UNDEFINED);
+
+    for (uint32_t i = 0; i < imageMemoryBarrierCount; ++i)
+        pData = thsvsCaptureBarrier(pData, THSVS_CAPTURE_BARRIER_IMAGE, VK_TRUE, 0, NULL, 0, NULL,
+                                    THSVS_IMAGE_LAYOUT_OPTIMAL, THSVS_IMAGE_LAYOUT_OPTIMAL, VK_FALSE,
+                                    pImageMemoryBarriers[i].srcQueueFamilyIndex, pImageMemoryBarriers[i].dstQueueFamilyIndex,
+                                    pImageMemoryBarriers[i].srcAccessMask, pImageMemoryBarriers[i].dstAccessMask,
+                                    pImageMemoryBarriers[i].oldLayout, pImageMemoryBarriers[i].newLayout);
+
+    for (uint32_t i = 0; i < barrierCount; ++i)
+        pBarriers[i].flags |= THSVS_CAPTURE_BARRIER_NO_ACCESS_TYPES_BIT;
+}
+#endif
+
+void thsvsInitCapture(
+    ThsvsCapture*             pCapture,
+    void*                     pMemory,
+    size_t                    size)
+{
+    // Records contain 64-bit timestamps, so start on an 8 byte boundary
+    uintptr_t base    = (uintptr_t)pMemory;
+    uintptr_t aligned = (base + 7) & ~(uintptr_t)7;
+    size_t    padding = (size_t)(aligned - base);
+
+    pCapture->pMemory = (uint8_t*)aligned;
+    pCapture->size    = (size > padding) ? ((size - padding) & ~(size_t)7) : 0;
+    thsvsResetCapture(pCapture);
+}
+
+void thsvsResetCapture(
+    ThsvsCapture*             pCapture)
+{
+    pCapture->writeOffset        = 0;
+    pCapture->oldestOffset       = 0;
+    pCapture->wrapOffset         = pCapture->size;
+    pCapture->recordCount        = 0;
+    pCapture->droppedRecordCount = 0;
+}
+
+void thsvsSetThreadCapture(
+    ThsvsCapture*             pCapture)
+{
+#ifdef THSVS_CAPTURE
+    thsvsThreadCapture = pCapture;
+#else
+    (void)pCapture;
+#endif
+}
+
+void thsvsCaptureBeginPass(
+    uint32_t                  passIndex,
+    const char*               pPassName)
+{
+#ifdef THSVS_CAPTURE
+    size_t nameLength = (pPassName != NULL) ? strlen(pPassName) : 0;
+
+    ThsvsCaptureRecord* pRecord = thsvsCaptureAllocRecord(THSVS_CAPTURE_RECORD_PASS, sizeof(ThsvsCaptureRecord) + nameLength + 1);
+    if (pRecord == NULL)
+        return;
+
+    pRecord->srcStageMask = passIndex;
+    char* pName = (char*)(pRecord + 1);
+    if (nameLength > 0)
+        memcpy(pName, pPassName, nameLength);
+    pName[nameLength] = '\0';
+#else
+    (void)passIndex;
+    (void)pPassName;
+#endif
+}
+
+size_t thsvsGetCaptureData(
+    const ThsvsCapture*       pCapture,
+    void*                     pData,
+    size_t                    dataSize)
+{
+    size_t size = sizeof(ThsvsCaptureHeader);
+    if (pCapture->recordCount > 0)
+    {
+        // Either a single run of records, or one up to wrapOffset followed by one from the start
+        if (pCapture->oldestOffset < pCapture->writeOffset)
+            size += pCapture->writeOffset - pCapture->oldestOffset;
+        else
+            size += (pCapture->wrapOffset - pCapture->oldestOffset) + pCapture->writeOffset;
+    }
+
+    if (pData == NULL || dataSize < size)
+        return size;
+
+    ThsvsCaptureHeader header;
+    header.magic              = THSVS_CAPTURE_MAGIC;
+    header.version            = THSVS_CAPTURE_VERSION;
+    header.recordCount        = pCapture->recordCount;
+    header.droppedRecordCount = pCapture->droppedRecordCount;
+
+    uint8_t* pBytes = (uint8_t*)pData;
+    memcpy(pBytes, &header, sizeof(header));
+    pBytes += sizeof(header);
+
+    if (pCapture->recordCount > 0)
+    {
+        if (pCapture->oldestOffset < pCapture->writeOffset)
+        {
+            memcpy(pBytes, pCapture->pMemory + pCapture->oldestOffset, pCapture->writeOffset - pCapture->oldestOffset);
+        }
+        else
+        {
+            memcpy(pBytes, pCapture->pMemory + pCapture->oldestOffset, pCapture->wrapOffset - pCapture->oldestOffset);
+            pBytes += pCapture->wrapOffset - pCapture->oldestOffset;
+            memcpy(pBytes, pCapture->pMemory, pCapture->writeOffset);
+        }
+    }
+
+    return size;
+}
+
+#ifdef THSVS_PROFILE
+static THSVS_THREAD_LOCAL ThsvsProfiler* thsvsThreadProfiler = NULL;
+
+static ThsvsAccessType thsvsProfileLastAccess(
+    uint32_t               accessCount,
+    const ThsvsAccessType* pAccesses)
+{
+    return (accessCount > 0) ? pAccesses[accessCount - 1] : THSVS_ACCESS_NONE;
+}
+
+static ThsvsProfileTag thsvsProfileTag(
+    const ThsvsGlobalBarrier* pGlobalBarrier,
+    uint32_t                  bufferBarrierCount,
+    const ThsvsBufferBarrier* pBufferBarriers,
+    uint32_t                  imageBarrierCount,
+    const ThsvsImageBarrier*  pImageBarriers)
+{
+    ThsvsProfileTag tag;
+    tag.prevAccess = THSVS_ACCESS_NONE;
+    tag.nextAccess = THSVS_ACCESS_NONE;
+    tag.oldLayout  = VK_IMAGE_LAYOUT_UNDEFINED;
+    tag.newLayout  = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    // Layout transitions are usually what's expensive, so the first one found is preferred
+    for (uint32_t i = 0; i < imageBarrierCount; ++i)
+    {
+        const ThsvsImageBarrier& barrier = pImageBarriers[i];
+
+        VkImageLayout oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        if (barrier.discardContents != VK_TRUE)
+            oldLayout = thsvsTranslateImageLayout(barrier.prevAccessCount, barrier.pPrevAccesses, barrier.prevLayout,
+                                                  barrier.subresourceRange.aspectMask, false);
+        VkImageLayout newLayout = thsvsTranslateImageLayout(barrier.nextAccessCount, barrier.pNextAccesses, barrier.nextLayout,
+                                                            barrier.subresourceRange.aspectMask, false);
+
+        if (i == 0 || oldLayout != newLayout)
+        {
+            tag.prevAccess = thsvsProfileLastAccess(barrier.prevAccessCount, barrier.pPrevAccesses);
+            tag.nextAccess = thsvsProfileLastAccess(barrier.nextAccessCount, barrier.pNextAccesses);
+            tag.oldLayout  = oldLayout;
+            tag.newLayout  = newLayout;
+        }
+
+        if (oldLayout != newLayout)
+            break;
+    }
+
+    if (imageBarrierCount == 0 && bufferBarrierCount > 0)
+    {
+        tag.prevAccess = thsvsProfileLastAccess(pBufferBarriers[0].prevAccessCount, pBufferBarriers[0].pPrevAccesses);
+        tag.nextAccess = thsvsProfileLastAccess(pBufferBarriers[0].nextAccessCount, pBufferBarriers[0].pNextAccesses);
+    }
+    else if (imageBarrierCount == 0 && pGlobalBarrier != NULL)
+    {
+        tag.prevAccess = thsvsProfileLastAccess(pGlobalBarrier->prevAccessCount, pGlobalBarrier->pPrevAccesses);
+        tag.nextAccess = thsvsProfileLastAccess(pGlobalBarrier->nextAccessCount, pGlobalBarrier->pNextAccesses);
+    }
+
+    return tag;
+}
+
+// Barriers that only exist as Vulkan barriers are tagged with the layouts of the first one that transitions
+static ThsvsProfileTag thsvsProfileVulkanTag(
+    uint32_t                    imageMemoryBarrierCount,
+    const VkImageMemoryBarrier* pImageMemoryBarriers)
+{
+    ThsvsProfileTag tag;
+    tag.prevAccess = THSVS_ACCESS_NONE;
+    tag.nextAccess = THSVS_ACCESS_NONE;
+    tag.oldLayout  = VK_IMAGE_LAYOUT_UNDEFINED;
+    tag.newLayout  = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    for (uint32_t i = 0; i < imageMemoryBarrierCount; ++i)
+    {
+        const VkImageMemoryBarrier& barrier = pImageMemoryBarriers[i];
+
+        if (i == 0 || barrier.oldLayout != barrier.newLayout)
+        {
+            tag.oldLayout = barrier.oldLayout;
+            tag.newLayout = barrier.newLayout;
+        }
+
+        if (barrier.oldLayout != barrier.newLayout)
+            break;
+    }
+
+    return tag;
+}
+
+// Returns the frame the next barrier is timed in, or NULL if it isn't timed
+static ThsvsProfilerFrame* thsvsProfileFrame()
+{
+    ThsvsProfiler* pProfiler = thsvsThreadProfiler;
+    if (pProfiler == NULL || pProfiler->frameBegun != VK_TRUE)
+        return NULL;
+
+    ThsvsProfilerFrame& frame = pProfiler->pFrames[pProfiler->frameIndex];
+    if (frame.barrierCount == pProfiler->maxBarrierCount)
+    {
+        pProfiler->droppedBarrierCount++;
+        return NULL;
+    }
+
+    return &frame;
+}
+
+// Called immediately before each vkCmdPipelineBarrier or vkCmdPipelineBarrier2 recorded from access types,
+// returning true if it's timed
+static bool thsvsProfileBeginBarrier(
+    VkCommandBuffer           commandBuffer,
+    const ThsvsGlobalBarrier* pGlobalBarrier,
+    uint32_t                  bufferBarrierCount,
+    const ThsvsBufferBarrier* pBufferBarriers,
+    uint32_t                  imageBarrierCount,
+    const ThsvsImageBarrier*  pImageBarriers)
+{
+    ThsvsProfilerFrame* pFrame = thsvsProfileFrame();
+    if (pFrame == NULL)
+        return false;
+
+    pFrame->pTags[pFrame->barrierCount] = thsvsProfileTag(pGlobalBarrier, bufferBarrierCount, pBufferBarriers,
+                                                          imageBarrierCount, pImageBarriers);
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, pFrame->queryPool, 2 * pFrame->barrierCount);
+    return true;
+}
+
+// Equivalent of thsvsProfileBeginBarrier for barrier batches, aliasing barriers and ownership transfers
+static bool thsvsProfileBeginVulkanBarrier(
+    VkCommandBuffer             commandBuffer,
+    uint32_t                    imageMemoryBarrierCount,
+    const VkImageMemoryBarrier* pImageMemoryBarriers)
+{
+    ThsvsProfilerFrame* pFrame = thsvsProfileFrame();
+    if (pFrame == NULL)
+        return false;
+
+    pFrame->pTags[pFrame->barrierCount] = thsvsProfileVulkanTag(imageMemoryBarrierCount, pImageMemoryBarriers);
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, pFrame->queryPool, 2 * pFrame->barrierCount);
+    return true;
+}
+
+// Called immediately after each barrier that thsvsProfileBeginBarrier or thsvsProfileBeginVulkanBarrier returned true for
+static void thsvsProfileEndBarrier(
+    VkCommandBuffer           commandBuffer)
+{
+    ThsvsProfiler*      pProfiler = thsvsThreadProfiler;
+    ThsvsProfilerFrame& frame     = pProfiler->pFrames[pProfiler->frameIndex];
+
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.queryPool, 2 * frame.barrierCount + 1);
+    frame.barrierCount++;
+}
+#endif
+
+static void thsvsAddTransitionCost(
+    ThsvsProfiler*            pProfiler,
+    const ThsvsProfileTag&    tag,
+    double                    microseconds)
+{
+    ThsvsTransitionCost* pCost = NULL;
+
+    for (uint32_t i = 0; i < pProfiler->transitionCount; ++i)
+    {
+        const ThsvsProfileTag& costTag = pProfiler->pTransitions[i].tag;
+        if (costTag.prevAccess == tag.prevAccess && costTag.nextAccess == tag.nextAccess &&
+            costTag.oldLayout == tag.oldLayout && costTag.newLayout == tag.newLayout)
+        {
+            pCost = &pProfiler->pTransitions[i];
+            break;
+        }
+    }
+
+    if (pCost == NULL)
+    {
+        if (pProfiler->transitionCount == pProfiler->transitionCapacity)
+        {
+            pProfiler->droppedBarrierCount++;
+            return;
+        }
+
+        pCost = &pProfiler->pTransitions[pProfiler->transitionCount++];
+        pCost->tag               = tag;
+        pCost->count             = 0;
+        pCost->totalMicroseconds = 0.0;
+        pCost->maxMicroseconds   = 0.0;
+    }
+
+    pCost->count++;
+    pCost->totalMicroseconds += microseconds;
+    if (microseconds > pCost->maxMicroseconds)
+        pCost->maxMicroseconds = microseconds;
+}
+
+VkResult thsvsCreateProfiler(
+    ThsvsProfiler*            pProfiler,
+    VkDevice                  device,
+    float                     timestampPeriod,
+    uint32_t                  frameCount,
+    uint32_t                  maxBarrierCount,
+    ThsvsProfilerFrame*       pFrameStorage,
+    ThsvsProfileTag*          pTagStorage,
+    uint32_t                  transitionCapacity,
+    ThsvsTransitionCost*      pTransitionStorage)
+{
+    pProfiler->device              = device;
+    pProfiler->timestampPeriod     = timestampPeriod;
+    pProfiler->maxBarrierCount     = maxBarrierCount;
+    pProfiler->frameCount          = frameCount;
+    pProfiler->frameIndex          = frameCount - 1;
+    pProfiler->frameBegun          = VK_FALSE;
+    pProfiler->pFrames             = pFrameStorage;
+    pProfiler->transitionCapacity  = transitionCapacity;
+    pProfiler->transitionCount     = 0;
+    pProfiler->pTransitions        = pTransitionStorage;
+    pProfiler->droppedBarrierCount = 0;
+
+    for (uint32_t i = 0; i < frameCount; ++i)
+    {
+        pFrameStorage[i].queryPool    = VK_NULL_HANDLE;
+        pFrameStorage[i].barrierCount = 0;
+        pFrameStorage[i].pTags        = pTagStorage + i * maxBarrierCount;
+    }
+
+    VkQueryPoolCreateInfo createInfo;
+    createInfo.sType              = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    createInfo.pNext              = NULL;
+    createInfo.flags              = 0;
+    createInfo.queryType          = VK_QUERY_TYPE_TIMESTAMP;
+    createInfo.queryCount         = 2 * maxBarrierCount;
+    createInfo.pipelineStatistics = 0;
+
+    for (uint32_t i = 0; i < frameCount; ++i)
+    {
+        VkResult result = vkCreateQueryPool(device, &createInfo, NULL, &pFrameStorage[i].queryPool);
+        if (result != VK_SUCCESS)
+        {
+            pFrameStorage[i].queryPool = VK_NULL_HANDLE;
+            thsvsDestroyProfiler(pProfiler);
+            return result;
+        }
+    }
+
+    return VK_SUCCESS;
+}
+
+void thsvsDestroyProfiler(
+    ThsvsProfiler*            pProfiler)
+{
+    for (uint32_t i = 0; i < pProfiler->frameCount; ++i)
+    {
+        if (pProfiler->pFrames[i].queryPool != VK_NULL_HANDLE)
+            vkDestroyQueryPool(pProfiler->device, pProfiler->pFrames[i].queryPool, NULL);
+        pProfiler->pFrames[i].queryPool    = VK_NULL_HANDLE;
+        pProfiler->pFrames[i].barrierCount = 0;
+    }
+
+    pProfiler->frameBegun = VK_FALSE;
+}
+
+VkResult thsvsCmdBeginProfilerFrame(
+    ThsvsProfiler*            pProfiler,
+    VkCommandBuffer           commandBuffer)
+{
+    pProfiler->frameIndex = (pProfiler->frameIndex + 1) % pProfiler->frameCount;
+    pProfiler->frameBegun = VK_TRUE;
+
+    ThsvsProfilerFrame& frame  = pProfiler->pFrames[pProfiler->frameIndex];
+    VkResult            result = VK_SUCCESS;
+
+    // Results are read back a batch at a time, to bound the stack space used
+    uint64_t       timestamps[128];
+    const uint32_t batchBarrierCount = (uint32_t)(sizeof(timestamps) / (2 * sizeof(uint64_t)));
+
+    for (uint32_t first = 0; first < frame.barrierCount; first += batchBarrierCount)
+    {
+        uint32_t count = frame.barrierCount - first;
+        if (count > batchBarrierCount)
+            count = batchBarrierCount;
+
+        result = vkGetQueryPoolResults(pProfiler->device, frame.queryPool, 2 * first, 2 * count,
+                                       sizeof(uint64_t) * 2 * count, timestamps, sizeof(uint64_t),
+                                       VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+        if (result != VK_SUCCESS)
+            break;
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            // Pairs where the counter wrapped around in between are ignored
+            if (timestamps[2 * i + 1] >= timestamps[2 * i])
+                thsvsAddTransitionCost(pProfiler, frame.pTags[first + i],
+                                       (double)(timestamps[2 * i + 1] - timestamps[2 * i]) * pProfiler->timestampPeriod / 1000.0);
+        }
+    }
+
+    frame.barrierCount = 0;
+    vkCmdResetQueryPool(commandBuffer, frame.queryPool, 0, 2 * pProfiler->maxBarrierCount);
+
+    return result;
+}
+
+void thsvsSetThreadProfiler(
+    ThsvsProfiler*            pProfiler)
+{
+#ifdef THSVS_PROFILE
+    thsvsThreadProfiler = pProfiler;
+#else
+    (void)pProfiler;
+#endif
+}
+
+uint32_t thsvsGetTransitionCosts(
+    ThsvsProfiler*              pProfiler,
+    const ThsvsTransitionCost** ppCosts)
+{
+    ThsvsTransitionCost* pCosts = pProfiler->pTransitions;
+
+    // There are only as many distinct transitions as access type pairs in use, so an insertion sort will do
+    for (uint32_t i = 1; i < pProfiler->transitionCount; ++i)
+    {
+        ThsvsTransitionCost cost = pCosts[i];
+        uint32_t j = i;
+        for (; j > 0 && pCosts[j - 1].totalMicroseconds < cost.totalMicroseconds; --j)
+            pCosts[j] = pCosts[j - 1];
+        pCosts[j] = cost;
+    }
+
+    *ppCosts = pCosts;
+    return pProfiler->transitionCount;
+}
+
+void thsvsResetTransitionCosts(
+    ThsvsProfiler*            pProfiler)
+{
+    pProfiler->transitionCount     = 0;
+    pProfiler->droppedBarrierCount = 0;
+}
+
+// Shared by thsvsCmdPipelineBarrierScratch and thsvsContextCmdPipelineBarrier, counting what's recorded if pStats is non-NULL
+static void thsvsRecordPipelineBarrier(
+    VkCommandBuffer           commandBuffer,
+    ThsvsScratch*             pScratch,
+    ThsvsContextStats*        pStats,
+    const ThsvsGlobalBarrier* pGlobalBarrier,
+    uint32_t                  bufferBarrierCount,
+    const ThsvsBufferBarrier* pBufferBarriers,
+    uint32_t                  imageBarrierCount,
+    const ThsvsImageBarrier*  pImageBarriers)
+{
+    VkMemoryBarrier        memoryBarrier;
+    size_t                 scratchOffset            = (pScratch != NULL) ? pScratch->offset : 0;
+    VkBufferMemoryBarrier* pTempBufferBarriers      = NULL;
+    VkImageMemoryBarrier*  pTempImageBarriers       = NULL;
+    // Vulkan pipeline barrier command parameters
+    //                     commandBuffer;
+    VkPipelineStageFlags   srcStageMask             = 0;
+    VkPipelineStageFlags   dstStageMask             = 0;
+    uint32_t               memoryBarrierCount       = 0;
+    uint32_t               bufferMemoryBarrierCount = 0;
+    VkBufferMemoryBarrier* pBufferMemoryBarriers    = NULL;
+    uint32_t               imageMemoryBarrierCount  = 0;
+    VkImageMemoryBarrier*  pImageMemoryBarriers     = NULL;
+
+    if (bufferBarrierCount > 0)
+        THSVS_ALLOC_BARRIERS(VkBufferMemoryBarrier, bufferBarrierCount, pScratch, pBufferMemoryBarriers, pTempBufferBarriers);
+
+    if (imageBarrierCount > 0)
+        THSVS_ALLOC_BARRIERS(VkImageMemoryBarrier, imageBarrierCount, pScratch, pImageMemoryBarriers, pTempImageBarriers);
+
+#ifdef THSVS_DIAGNOSTICS
+    thsvsDiagnoseBarriers(pGlobalBarrier, bufferBarrierCount, pBufferBarriers, imageBarrierCount, pImageBarriers);
+#endif
+
+    bool needed = thsvsTranslateBarriers(
+        pGlobalBarrier,
+        bufferBarrierCount,
+        pBufferBarriers,
+        imageBarrierCount,
+        pImageBarriers,
+        &srcStageMask,
+        &dstStageMask,
+        &memoryBarrierCount,
+        &memoryBarrier,
+        &bufferMemoryBarrierCount,
+        pBufferMemoryBarriers,
+        &imageMemoryBarrierCount,
+        pImageMemoryBarriers);
+
+#ifdef THSVS_CAPTURE
+    thsvsCaptureBarriers(THSVS_CAPTURE_RECORD_PIPELINE_BARRIER, needed, srcStageMask, dstStageMask,
+                         pGlobalBarrier, bufferBarrierCount, pBufferBarriers, imageBarrierCount, pImageBarriers);
+#endif
+
+    if (needed)
+    {
+#ifdef THSVS_STATS
+        thsvsInstrumentBarrier(commandBuffer, "thsvsCmdPipelineBarrier", false, srcStageMask, dstStageMask, memoryBarrierCount,
+                               bufferMemoryBarrierCount, pBufferMemoryBarriers, imageMemoryBarrierCount, pImageMemoryBarriers);
+#endif
+
+#ifdef THSVS_DIAGNOSTICS
+        thsvsDiagnoseSequence(commandBuffer, true);
+#endif
+
+#ifdef THSVS_PROFILE
+        bool profiled = thsvsProfileBeginBarrier(commandBuffer, pGlobalBarrier, bufferBarrierCount, pBufferBarriers,
+                                                 imageBarrierCount, pImageBarriers);
+#endif
+
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            srcStageMask,
+            dstStageMask,
+            0,
+            memoryBarrierCount,
+            (memoryBarrierCount > 0) ? &memoryBarrier : NULL,
+            bufferMemoryBarrierCount,
+            pBufferMemoryBarriers,
+            imageMemoryBarrierCount,
+            pImageMemoryBarriers);
+
+#ifdef THSVS_PROFILE
+        if (profiled)
+            thsvsProfileEndBarrier(commandBuffer);
+#endif
+
+        if (pStats != NULL)
+            thsvsCountBarriers(pStats, false, srcStageMask, dstStageMask, memoryBarrierCount,
+                               bufferMemoryBarrierCount, pBufferMemoryBarriers, imageMemoryBarrierCount, pImageMemoryBarriers);
+    }
+
+    THSVS_TEMP_FREE(pTempBufferBarriers);
+    THSVS_TEMP_FREE(pTempImageBarriers);
+
+    if (pScratch != NULL)
+        pScratch->offset = scratchOffset;
+}
+
+void thsvsCmdPipelineBarrierScratch(
+    VkCommandBuffer           commandBuffer,
+    ThsvsScratch*             pScratch,
+    const ThsvsGlobalBarrier* pGlobalBarrier,
+    uint32_t                  bufferBarrierCount,
+    const ThsvsBufferBarrier* pBufferBarriers,
+    uint32_t                  imageBarrierCount,
+    const ThsvsImageBarrier*  pImageBarriers)
+{
+    thsvsRecordPipelineBarrier(commandBuffer, pScratch, NULL, pGlobalBarrier, bufferBarrierCount, pBufferBarriers, imageBarrierCount, pImageBarriers);
+}
+
+void thsvsCmdSetEvent(
+    VkCommandBuffer           commandBuffer,
+    VkEvent                   event,
+    uint32_t                  prevAccessCount,
+    const ThsvsAccessType*    pPrevAccesses)
+{
+    VkPipelineStageFlags stageMask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+
+    for (uint32_t i = 0; i < prevAccessCount; ++i)
+    {
+        ThsvsAccessType prevAccess = pPrevAccesses[i];
+
+#ifdef THSVS_ERROR_CHECK_ACCESS_TYPE_IN_RANGE
+        // Asserts that the previous access index is a valid range for the lookup
+        assert(prevAccess < THSVS_NUM_ACCESS_TYPES);
+#endif
+
+        stageMask |= THSVS_TABLE_STAGE_MASK(prevAccess);
+    }
+
+#ifdef THSVS_DIAGNOSTICS
+    thsvsDiagnoseAccesses(prevAccessCount, pPrevAccesses);
+    thsvsDiagnoseSequence(commandBuffer, false);
+#endif
+
+    vkCmdSetEvent(
+        commandBuffer,
+        event,
+        stageMask);
+}
+
+void thsvsCmdResetEvent(
+    VkCommandBuffer           commandBuffer,
+    VkEvent                   event,
+    uint32_t                  prevAccessCount,
+    const ThsvsAccessType*    pPrevAccesses)
+{
+    VkPipelineStageFlags stageMask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+
+    for (uint32_t i = 0; i < prevAccessCount; ++i)
+    {
+        ThsvsAccessType prevAccess = pPrevAccesses[i];
+
+#ifdef THSVS_ERROR_CHECK_ACCESS_TYPE_IN_RANGE
+        // Asserts that the previous access index is a valid range for the lookup
+        assert(prevAccess < THSVS_NUM_ACCESS_TYPES);
+#endif
+
+        stageMask |= THSVS_TABLE_STAGE_MASK(prevAccess);
+    }
+
+    vkCmdResetEvent(
+        commandBuffer,
+        event,
+        stageMask);
+}
+
+void thsvsCmdWaitEvents(
+    VkCommandBuffer           commandBuffer,
+    uint32_t                  eventCount,
+    const VkEvent*            pEvents,
+    const ThsvsGlobalBarrier* pGlobalBarrier,
+    uint32_t                  bufferBarrierCount,
+    const ThsvsBufferBarrier* pBufferBarriers,
+    uint32_t                  imageBarrierCount,
+    const ThsvsImageBarrier*  pImageBarriers)
+{
+    thsvsCmdWaitEventsScratch(
+        commandBuffer,
+        NULL,
+        eventCount,
+        pEvents,
+        pGlobalBarrier,
+        bufferBarrierCount,
+        pBufferBarriers,
+        imageBarrierCount,
+        pImageBarriers);
+}
+
+void thsvsCmdWaitEventsScratch(
+    VkCommandBuffer           commandBuffer,
+    ThsvsScratch*             pScratch,
+    uint32_t                  eventCount,
+    const VkEvent*            pEvents,
+    const ThsvsGlobalBarrier* pGlobalBarrier,
+    uint32_t                  bufferBarrierCount,
+    const ThsvsBufferBarrier* pBufferBarriers,
+    uint32_t                  imageBarrierCount,
+    const ThsvsImageBarrier*  pImageBarriers)
+{
+    VkMemoryBarrier        memoryBarrier;
+    size_t                 scratchOffset            = (pScratch != NULL) ? pScratch->offset : 0;
+    VkBufferMemoryBarrier* pTempBufferBarriers      = NULL;
+    VkImageMemoryBarrier*  pTempImageBarriers       = NULL;
+    // Vulkan pipeline barrier command parameters
+    //                     commandBuffer;
+    //                     eventCount;
+    //                     pEvents;
+    VkPipelineStageFlags   srcStageMask             = 0;
+    VkPipelineStageFlags   dstStageMask             = 0;
+    uint32_t               memoryBarrierCount       = 0;
+    uint32_t               bufferMemoryBarrierCount = 0;
+    VkBufferMemoryBarrier* pBufferMemoryBarriers    = NULL;
+    uint32_t               imageMemoryBarrierCount  = 0;
+    VkImageMemoryBarrier*  pImageMemoryBarriers     = NULL;
+
+    if (bufferBarrierCount > 0)
+        THSVS_ALLOC_BARRIERS(VkBufferMemoryBarrier, bufferBarrierCount, pScratch, pBufferMemoryBarriers, pTempBufferBarriers);
+
+    if (imageBarrierCount > 0)
+        THSVS_ALLOC_BARRIERS(VkImageMemoryBarrier, imageBarrierCount, pScratch, pImageMemoryBarriers, pTempImageBarriers);
+
+    thsvsTranslateBarriers(
+        pGlobalBarrier,
+        bufferBarrierCount,
+        pBufferBarriers,
+        imageBarrierCount,
+        pImageBarriers,
+        &srcStageMask,
+        &dstStageMask,
+        &memoryBarrierCount,
+        &memoryBarrier,
+        &bufferMemoryBarrierCount,
+        pBufferMemoryBarriers,
+        &imageMemoryBarrierCount,
+        pImageMemoryBarriers);
+
+#ifdef THSVS_ELIDE_REDUNDANT_BARRIERS
+    // srcStageMask has to match the stages the events were set with, even if some barriers were elided
+    srcStageMask = thsvsGetBarriersSrcStageMask(pGlobalBarrier, bufferBarrierCount, pBufferBarriers, imageBarrierCount, pImageBarriers);
+#endif
+
+    // The wait is always recorded, even if every barrier was elided, in case the application relies on it
+
+#ifdef THSVS_STATS
+    thsvsInstrumentBarrier(commandBuffer, "thsvsCmdWaitEvents", true, srcStageMask, dstStageMask, memoryBarrierCount,
+                           bufferMemoryBarrierCount, pBufferMemoryBarriers, imageMemoryBarrierCount, pImageMemoryBarriers);
+#endif
+
+#ifdef THSVS_CAPTURE
+    thsvsCaptureBarriers(THSVS_CAPTURE_RECORD_WAIT_EVENTS, true, srcStageMask, dstStageMask,
+                         pGlobalBarrier, bufferBarrierCount, pBufferBarriers, imageBarrierCount, pImageBarriers);
+#endif
+
+#ifdef THSVS_DIAGNOSTICS
+    thsvsDiagnoseBarriers(pGlobalBarrier, bufferBarrierCount, pBufferBarriers, imageBarrierCount, pImageBarriers);
+    thsvsDiagnoseSequence(commandBuffer, false);
+#endif
+
+    vkCmdWaitEvents(
+        commandBuffer,
+        eventCount,
+        pEvents,
+        srcStageMask,
+        dstStageMask,
+        memoryBarrierCount,
+        (memoryBarrierCount > 0) ? &memoryBarrier : NULL,
+        bufferMemoryBarrierCount,
+        pBufferMemoryBarriers,
+        imageMemoryBarrierCount,
+        pImageMemoryBarriers);
+
+    THSVS_TEMP_FREE(pTempBufferBarriers);
+    THSVS_TEMP_FREE(pTempImageBarriers);
+
+    if (pScratch != NULL)
+        pScratch->offset = scratchOffset;
+}
+
+void thsvsCmdSetEvents(
+    VkCommandBuffer           commandBuffer,
+    uint32_t                  eventBarrierCount,
+    const ThsvsEventBarrier*  pEventBarriers)
+{
+#ifdef THSVS_DIAGNOSTICS
+    thsvsDiagnoseSequence(commandBuffer, false);
+#endif
+
+    for (uint32_t i = 0; i < eventBarrierCount; ++i)
+    {
+        const ThsvsEventBarrier& eventBarrier = pEventBarriers[i];
+
+        vkCmdSetEvent(
+            commandBuffer,
+            eventBarrier.event,
+            thsvsGetBarriersSrcStageMask(eventBarrier.pGlobalBarrier,
+                                         eventBarrier.bufferBarrierCount,
+                                         eventBarrier.pBufferBarriers,
+                                         eventBarrier.imageBarrierCount,
+                                         eventBarrier.pImageBarriers));
+    }
+}
+
+void thsvsCmdWaitEventBarriers(
+    VkCommandBuffer           commandBuffer,
+    ThsvsScratch*             pScratch,
+    uint32_t                  eventBarrierCount,
+    const ThsvsEventBarrier*  pEventBarriers)
+{
+    VkMemoryBarrier        memoryBarrier;
+    size_t                 scratchOffset            = (pScratch != NULL) ? pScratch->offset : 0;
+    VkEvent*               pTempEvents              = NULL;
+    VkBufferMemoryBarrier* pTempBufferBarriers      = NULL;
+    VkImageMemoryBarrier*  pTempImageBarriers       = NULL;
+    uint32_t               bufferBarrierCount       = 0;
+    uint32_t               imageBarrierCount        = 0;
+    // Vulkan pipeline barrier command parameters
+    //                     commandBuffer;
+    //                     eventBarrierCount;
+    VkEvent*               pEvents                  = NULL;
+    VkPipelineStageFlags   srcStageMask             = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    VkPipelineStageFlags   dstStageMask             = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+    uint32_t               memoryBarrierCount       = 0;
+    uint32_t               bufferMemoryBarrierCount = 0;
+    VkBufferMemoryBarrier* pBufferMemoryBarriers    = NULL;
+    uint32_t               imageMemoryBarrierCount  = 0;
+    VkImageMemoryBarrier*  pImageMemoryBarriers     = NULL;
+
+    for (uint32_t i = 0; i < eventBarrierCount; ++i)
+    {
+        bufferBarrierCount += pEventBarriers[i].bufferBarrierCount;
+        imageBarrierCount  += pEventBarriers[i].imageBarrierCount;
+    }
+
+    if (eventBarrierCount > 0)
+        THSVS_ALLOC_BARRIERS(VkEvent, eventBarrierCount, pScratch, pEvents, pTempEvents);
+
+    if (bufferBarrierCount > 0)
+        THSVS_ALLOC_BARRIERS(VkBufferMemoryBarrier, bufferBarrierCount, pScratch, pBufferMemoryBarriers, pTempBufferBarriers);
+
+    if (imageBarrierCount > 0)
+        THSVS_ALLOC_BARRIERS(VkImageMemoryBarrier, imageBarrierCount, pScratch, pImageMemoryBarriers, pTempImageBarriers);
+
+    memoryBarrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    memoryBarrier.pNext         = NULL;
+    memoryBarrier.srcAccessMask = 0;
+    memoryBarrier.dstAccessMask = 0;
+
+    // Each event's barriers are appended to the same arrays, with their global barriers merged into one
+    for (uint32_t i = 0; i < eventBarrierCount; ++i)
+    {
+        const ThsvsEventBarrier& eventBarrier = pEventBarriers[i];
+        VkPipelineStageFlags     tempSrcStageMask;
+        VkPipelineStageFlags     tempDstStageMask;
+        VkMemoryBarrier          tempMemoryBarrier;
+        uint32_t                 tempMemoryBarrierCount;
+        uint32_t                 tempBufferMemoryBarrierCount;
+        uint32_t                 tempImageMemoryBarrierCount;
+
+        pEvents[i] = eventBarrier.event;
+
+        thsvsTranslateBarriers(
+            eventBarrier.pGlobalBarrier,
+            eventBarrier.bufferBarrierCount,
+            eventBarrier.pBufferBarriers,
+            eventBarrier.imageBarrierCount,
+            eventBarrier.pImageBarriers,
+            &tempSrcStageMask,
+            &tempDstStageMask,
+            &tempMemoryBarrierCount,
+            &tempMemoryBarrier,
+            &tempBufferMemoryBarrierCount,
+            pBufferMemoryBarriers + bufferMemoryBarrierCount,
+            &tempImageMemoryBarrierCount,
+            pImageMemoryBarriers + imageMemoryBarrierCount);
+
+#ifdef THSVS_ELIDE_REDUNDANT_BARRIERS
+        // srcStageMask has to match the stages the events were set with, even if some barriers were elided
+        tempSrcStageMask = thsvsGetBarriersSrcStageMask(eventBarrier.pGlobalBarrier,
+                                                        eventBarrier.bufferBarrierCount,
+                                                        eventBarrier.pBufferBarriers,
+                                                        eventBarrier.imageBarrierCount,
+                                                        eventBarrier.pImageBarriers);
+#endif
+
+        srcStageMask |= tempSrcStageMask;
+        dstStageMask |= tempDstStageMask;
+
+        if (tempMemoryBarrierCount > 0)
+        {
+            memoryBarrier.srcAccessMask |= tempMemoryBarrier.srcAccessMask;
+            memoryBarrier.dstAccessMask |= tempMemoryBarrier.dstAccessMask;
+            memoryBarrierCount = 1;
+        }
+
+        bufferMemoryBarrierCount += tempBufferMemoryBarrierCount;
+        imageMemoryBarrierCount  += tempImageMemoryBarrierCount;
+
+#ifdef THSVS_DIAGNOSTICS
+        thsvsDiagnoseBarriers(eventBarrier.pGlobalBarrier, eventBarrier.bufferBarrierCount, eventBarrier.pBufferBarriers,
+                              eventBarrier.imageBarrierCount, eventBarrier.pImageBarriers);
+#endif
+    }
+
+    // The wait is always recorded, even if every barrier was elided, in case the application relies on it
+
+#ifdef THSVS_STATS
+    thsvsInstrumentBarrier(commandBuffer, "thsvsCmdWaitEventBarriers", true, srcStageMask, dstStageMask, memoryBarrierCount,
+                           bufferMemoryBarrierCount, pBufferMemoryBarriers, imageMemoryBarrierCount, pImageMemoryBarriers);
+#endif
+
+#ifdef THSVS_CAPTURE
+    thsvsCaptureEventBarriers(THSVS_CAPTURE_RECORD_WAIT_EVENTS, true, srcStageMask, dstStageMask, eventBarrierCount, pEventBarriers);
+#endif
+
+#ifdef THSVS_DIAGNOSTICS
+    thsvsDiagnoseSequence(commandBuffer, false);
+#endif
+
+    vkCmdWaitEvents(
+        commandBuffer,
+        eventBarrierCount,
+        pEvents,
+        srcStageMask,
+        dstStageMask,
+        memoryBarrierCount,
+        (memoryBarrierCount > 0) ? &memoryBarrier : NULL,
+        bufferMemoryBarrierCount,
+        pBufferMemoryBarriers,
+        imageMemoryBarrierCount,
+        pImageMemoryBarriers);
+
+    THSVS_TEMP_FREE(pTempEvents);
+    THSVS_TEMP_FREE(pTempBufferBarriers);
+    THSVS_TEMP_FREE(pTempImageBarriers);
+
+    if (pScratch != NULL)
+        pScratch->offset = scratchOffset;
+}
+
+void thsvsInitBarrierBatch(
+    ThsvsBarrierBatch*        pBatch,
+    VkCommandBuffer           commandBuffer,
+    uint32_t                  bufferBarrierCapacity,
+    VkBufferMemoryBarrier*    pBufferBarrierStorage,
+    uint32_t                  imageBarrierCapacity,
+    VkImageMemoryBarrier*     pImageBarrierStorage)
+{
+    pBatch->commandBuffer               = commandBuffer;
+    pBatch->srcStageMask                = 0;
+    pBatch->dstStageMask                = 0;
+    pBatch->memoryBarrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    pBatch->memoryBarrier.pNext         = NULL;
+    pBatch->memoryBarrier.srcAccessMask = 0;
+    pBatch->memoryBarrier.dstAccessMask = 0;
+    pBatch->bufferBarrierCapacity       = bufferBarrierCapacity;
+    pBatch->bufferBarrierCount          = 0;
+    pBatch->pBufferBarriers             = pBufferBarrierStorage;
+    pBatch->imageBarrierCapacity        = imageBarrierCapacity;
+    pBatch->imageBarrierCount           = 0;
+    pBatch->pImageBarriers              = pImageBarrierStorage;
+}
+
+// Returns the exclusive end of a range starting at base, accounting for VK_REMAINING_* style counts
+static uint64_t thsvsRangeEnd(
+    uint64_t base,
+    uint64_t count,
+    uint64_t remaining)
+{
+    return (count == remaining) ? UINT64_MAX : base + count;
+}
+
+static bool thsvsBufferRangesOverlap(
+    const VkBufferMemoryBarrier& a,
+    const VkBufferMemoryBarrier& b)
+{
+    return a.buffer == b.buffer &&
+           a.offset < thsvsRangeEnd(b.offset, b.size, VK_WHOLE_SIZE) &&
+           b.offset < thsvsRangeEnd(a.offset, a.size, VK_WHOLE_SIZE);
+}
+
+static bool thsvsSubresourceRangesOverlap(
+    const VkImageSubresourceRange& a,
+    const VkImageSubresourceRange& b)
+{
+    return (a.aspectMask & b.aspectMask) != 0 &&
+           a.baseMipLevel < thsvsRangeEnd(b.baseMipLevel, b.levelCount, VK_REMAINING_MIP_LEVELS) &&
+           b.baseMipLevel < thsvsRangeEnd(a.baseMipLevel, a.levelCount, VK_REMAINING_MIP_LEVELS) &&
+           a.baseArrayLayer < thsvsRangeEnd(b.baseArrayLayer, b.layerCount, VK_REMAINING_ARRAY_LAYERS) &&
+           b.baseArrayLayer < thsvsRangeEnd(a.baseArrayLayer, a.layerCount, VK_REMAINING_ARRAY_LAYERS);
+}
+
+// Makes space for a buffer barrier in the batch, overlapping the vkBarrier, flushing if necessary
+static VkBufferMemoryBarrier* thsvsBatchAllocBufferBarrier(
+    ThsvsBarrierBatch*           pBatch,
+    const VkBufferMemoryBarrier& vkBarrier)
+{
+    bool flush = pBatch->bufferBarrierCount == pBatch->bufferBarrierCapacity;
+    for (uint32_t i = 0; i < pBatch->bufferBarrierCount && !flush; ++i)
+        flush = thsvsBufferRangesOverlap(pBatch->pBufferBarriers[i], vkBarrier);
+
+    if (flush)
+        thsvsCmdFlushBarrierBatch(pBatch);
+
+    return &pBatch->pBufferBarriers[pBatch->bufferBarrierCount++];
+}
+
+// Makes space for an image barrier in the batch, overlapping the vkBarrier, flushing if necessary
+static VkImageMemoryBarrier* thsvsBatchAllocImageBarrier(
+    ThsvsBarrierBatch*          pBatch,
+    const VkImageMemoryBarrier& vkBarrier)
+{
+    bool flush = pBatch->imageBarrierCount == pBatch->imageBarrierCapacity;
+    for (uint32_t i = 0; i < pBatch->imageBarrierCount && !flush; ++i)
+        flush = pBatch->pImageBarriers[i].image == vkBarrier.image &&
+                thsvsSubresourceRangesOverlap(pBatch->pImageBarriers[i].subresourceRange, vkBarrier.subresourceRange);
+
+    if (flush)
+        thsvsCmdFlushBarrierBatch(pBatch);
+
+    return &pBatch->pImageBarriers[pBatch->imageBarrierCount++];
+}
+
+static void thsvsBatchMemoryBarrier(
+    ThsvsBarrierBatch*     pBatch,
+    VkPipelineStageFlags   srcStageMask,
+    VkPipelineStageFlags   dstStageMask,
+    const VkMemoryBarrier& vkBarrier)
+{
+    pBatch->srcStageMask                |= srcStageMask;
+    pBatch->dstStageMask                |= dstStageMask;
+    pBatch->memoryBarrier.srcAccessMask |= vkBarrier.srcAccessMask;
+    pBatch->memoryBarrier.dstAccessMask |= vkBarrier.dstAccessMask;
+}
+
+static void thsvsBatchBufferMemoryBarrier(
+    ThsvsBarrierBatch*           pBatch,
+    VkPipelineStageFlags         srcStageMask,
+    VkPipelineStageFlags         dstStageMask,
+    const VkBufferMemoryBarrier& vkBarrier)
+{
+    *thsvsBatchAllocBufferBarrier(pBatch, vkBarrier) = vkBarrier;
+    pBatch->srcStageMask |= srcStageMask;
+    pBatch->dstStageMask |= dstStageMask;
+}
+
+static void thsvsBatchImageMemoryBarrier(
+    ThsvsBarrierBatch*          pBatch,
+    VkPipelineStageFlags        srcStageMask,
+    VkPipelineStageFlags        dstStageMask,
+    const VkImageMemoryBarrier& vkBarrier)
+{
+    *thsvsBatchAllocImageBarrier(pBatch, vkBarrier) = vkBarrier;
+    pBatch->srcStageMask |= srcStageMask;
+    pBatch->dstStageMask |= dstStageMask;
+}
+
+void thsvsBatchPipelineBarrier(
+    ThsvsBarrierBatch*        pBatch,
+    const ThsvsGlobalBarrier* pGlobalBarrier,
+    uint32_t                  bufferBarrierCount,
+    const ThsvsBufferBarrier* pBufferBarriers,
+    uint32_t                  imageBarrierCount,
+    const ThsvsImageBarrier*  pImageBarriers)
+{
+    VkPipelineStageFlags srcStageMask = 0;
+    VkPipelineStageFlags dstStageMask = 0;
+
+#ifdef THSVS_DIAGNOSTICS
+    thsvsDiagnoseBarriers(pGlobalBarrier, bufferBarrierCount, pBufferBarriers, imageBarrierCount, pImageBarriers);
+#endif
+
+    if (pGlobalBarrier != NULL)
+    {
+        VkMemoryBarrier memoryBarrier;
+        VkBool32 needed = thsvsGetVulkanMemoryBarrier(*pGlobalBarrier, &srcStageMask, &dstStageMask, &memoryBarrier);
+#ifdef THSVS_ELIDE_REDUNDANT_BARRIERS
+        if (needed == VK_TRUE)
+#else
+        (void)needed;
+#endif
+            thsvsBatchMemoryBarrier(pBatch, srcStageMask, dstStageMask, memoryBarrier);
+    }
+
+    for (uint32_t i = 0; i < bufferBarrierCount; ++i)
+    {
+        VkBufferMemoryBarrier bufferMemoryBarrier;
+        VkBool32 needed = thsvsGetVulkanBufferMemoryBarrier(pBufferBarriers[i], &srcStageMask, &dstStageMask, &bufferMemoryBarrier);
+#ifdef THSVS_ELIDE_REDUNDANT_BARRIERS
+        if (needed == VK_FALSE)
+            continue;
+
+        if (bufferMemoryBarrier.srcQueueFamilyIndex == bufferMemoryBarrier.dstQueueFamilyIndex)
+        {
+            VkMemoryBarrier memoryBarrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER, NULL, bufferMemoryBarrier.srcAccessMask, bufferMemoryBarrier.dstAccessMask};
+            thsvsBatchMemoryBarrier(pBatch, srcStageMask, dstStageMask, memoryBarrier);
+            continue;
+        }
+#else
+        (void)needed;
+#endif
+        thsvsBatchBufferMemoryBarrier(pBatch, srcStageMask, dstStageMask, bufferMemoryBarrier);
+    }
+
+    for (uint32_t i = 0; i < imageBarrierCount; ++i)
+    {
+        VkImageMemoryBarrier imageMemoryBarrier;
+        VkBool32 needed = thsvsGetVulkanImageMemoryBarrier(pImageBarriers[i], &srcStageMask, &dstStageMask, &imageMemoryBarrier);
+#ifdef THSVS_ELIDE_REDUNDANT_BARRIERS
+        if (needed == VK_FALSE)
+            continue;
+
+        if (imageMemoryBarrier.oldLayout == imageMemoryBarrier.newLayout &&
+            imageMemoryBarrier.srcQueueFamilyIndex == imageMemoryBarrier.dstQueueFamilyIndex)
+        {
+            VkMemoryBarrier memoryBarrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER, NULL, imageMemoryBarrier.srcAccessMask, imageMemoryBarrier.dstAccessMask};
+            thsvsBatchMemoryBarrier(pBatch, srcStageMask, dstStageMask, memoryBarrier);
+            continue;
+        }
+#else
+        (void)needed;
+#endif
+        thsvsBatchImageMemoryBarrier(pBatch, srcStageMask, dstStageMask, imageMemoryBarrier);
+    }
+}
+
+void thsvsCmdFlushBarrierBatch(
+    ThsvsBarrierBatch*        pBatch)
+{
+    // Nothing has been added since the last flush
+    if (pBatch->srcStageMask == 0)
+        return;
+
+    // The memory barrier is only needed if it does anything beyond the execution dependency
+    bool hasMemoryBarrier = pBatch->memoryBarrier.srcAccessMask != 0 ||
+                            pBatch->memoryBarrier.dstAccessMask != 0;
+
+#ifdef THSVS_STATS
+    thsvsInstrumentBarrier(pBatch->commandBuffer, "thsvsCmdFlushBarrierBatch", false, pBatch->srcStageMask, pBatch->dstStageMask,
+                           hasMemoryBarrier ? 1 : 0, pBatch->bufferBarrierCount, pBatch->pBufferBarriers,
+                           pBatch->imageBarrierCount, pBatch->pImageBarriers);
+#endif
+
+#ifdef THSVS_CAPTURE
+    thsvsCaptureVulkanBarriers(pBatch->srcStageMask, pBatch->dstStageMask, hasMemoryBarrier ? 1 : 0, &pBatch->memoryBarrier,
+                               pBatch->bufferBarrierCount, pBatch->pBufferBarriers, pBatch->imageBarrierCount, pBatch->pImageBarriers);
+#endif
+
+#ifdef THSVS_DIAGNOSTICS
+    thsvsDiagnoseSequence(pBatch->commandBuffer, true);
+#endif
+
+#ifdef THSVS_PROFILE
+    bool profiled = thsvsProfileBeginVulkanBarrier(pBatch->commandBuffer, pBatch->imageBarrierCount, pBatch->pImageBarriers);
+#endif
+
+    vkCmdPipelineBarrier(
+        pBatch->commandBuffer,
+        pBatch->srcStageMask,
+        pBatch->dstStageMask,
+        0,
+        hasMemoryBarrier ? 1 : 0,
+        hasMemoryBarrier ? &pBatch->memoryBarrier : NULL,
+        pBatch->bufferBarrierCount,
+        pBatch->pBufferBarriers,
+        pBatch->imageBarrierCount,
+        pBatch->pImageBarriers);
+
+#ifdef THSVS_PROFILE
+    if (profiled)
+        thsvsProfileEndBarrier(pBatch->commandBuffer);
+#endif
+
+    pBatch->srcStageMask                = 0;
+    pBatch->dstStageMask                = 0;
+    pBatch->memoryBarrier.srcAccessMask = 0;
+    pBatch->memoryBarrier.dstAccessMask = 0;
+    pBatch->bufferBarrierCount          = 0;
+    pBatch->imageBarrierCount           = 0;
+}
+
+void thsvsInitBufferState(
+    ThsvsBufferState*       pState,
+    VkBuffer                buffer,
+    VkDeviceSize            offset,
+    VkDeviceSize            size)
+{
+    pState->buffer          = buffer;
+    pState->offset          = offset;
+    pState->size            = size;
+    pState->writeStageMask  = 0;
+    pState->writeAccessMask = 0;
+    pState->readStageMask   = 0;
+    pState->readAccessMask  = 0;
+}
+
+void thsvsInitImageState(
+    ThsvsImageState*        pState,
+    VkImage                 image,
+    VkImageSubresourceRange subresourceRange,
+    VkImageLayout           layout)
+{
+    pState->image            = image;
+    pState->subresourceRange = subresourceRange;
+    pState->writeStageMask   = 0;
+    pState->writeAccessMask  = 0;
+    pState->readStageMask    = 0;
+    pState->readAccessMask   = 0;
+    pState->layout           = layout;
+}
+
+/*
+Shared logic for buffer and image state transitions.
+Updates the tracked masks and returns true if a barrier is needed, in which
+case the stage and access masks for it are written out.
+*/
+static bool thsvsTransitionState(
+    VkPipelineStageFlags*   pWriteStageMask,
+    VkAccessFlags*          pWriteAccessMask,
+    VkPipelineStageFlags*   pReadStageMask,
+    VkAccessFlags*          pReadAccessMask,
+    const ThsvsAccessSet&   nextAccessSet,
+    bool                    layoutTransition,
+    VkPipelineStageFlags*   pSrcStages,
+    VkPipelineStageFlags*   pDstStages,
+    VkAccessFlags*          pSrcAccessMask,
+    VkAccessFlags*          pDstAccessMask)
+{
+    if (!nextAccessSet.hasWriteAccess && !layoutTransition)
+    {
+        // Read after read - nothing to do if nothing was written, or these stages already waited on the write
+        if (*pWriteStageMask == 0 ||
+            ((nextAccessSet.stageMask & ~*pReadStageMask) == 0 &&
+             (nextAccessSet.accessMask & ~*pReadAccessMask) == 0))
+        {
+            *pReadStageMask  |= nextAccessSet.stageMask;
+            *pReadAccessMask |= nextAccessSet.accessMask;
+            return false;
+        }
+
+        // Read after write, for stages that haven't waited on the write yet
+        *pSrcStages     = *pWriteStageMask;
+        *pDstStages     = nextAccessSet.stageMask;
+        *pSrcAccessMask = *pWriteAccessMask;
+        *pDstAccessMask = (*pWriteAccessMask != 0) ? nextAccessSet.accessMask : 0;
+
+        *pReadStageMask  |= nextAccessSet.stageMask;
+        *pReadAccessMask |= nextAccessSet.accessMask;
+        return true;
+    }
+
+    // The first access to a resource has nothing to wait on, unless it changes the layout.
+    // A write isn't visible to anything yet, not even to reads in its own stages.
+    if (!layoutTransition && *pWriteStageMask == 0 && *pReadStageMask == 0)
+    {
+        *pWriteStageMask  = nextAccessSet.stageMask;
+        *pWriteAccessMask = nextAccessSet.writeAccessMask;
+        *pReadStageMask   = nextAccessSet.hasWriteAccess ? 0 : nextAccessSet.stageMask;
+        *pReadAccessMask  = nextAccessSet.hasWriteAccess ? 0 : nextAccessSet.accessMask;
+        return false;
+    }
+
+    // Writes and layout transitions wait for the last write and everything that's read since
+    *pSrcStages     = *pWriteStageMask | *pReadStageMask;
+    *pDstStages     = nextAccessSet.stageMask;
+    *pSrcAccessMask = *pWriteAccessMask;
+    *pDstAccessMask = (*pWriteAccessMask != 0) ? nextAccessSet.accessMask : 0;
+
+    if (*pSrcStages == 0)
+        *pSrcStages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    if (*pDstStages == 0)
+        *pDstStages = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+    if (nextAccessSet.hasWriteAccess)
+    {
+        *pWriteStageMask  = nextAccessSet.stageMask;
+        *pWriteAccessMask = nextAccessSet.writeAccessMask;
+    }
+    else
+    {
+        // A layout transition behaves as a write completed by the destination stages of the barrier
+        *pWriteStageMask |= nextAccessSet.stageMask;
+    }
+
+    // Only reads that the barrier made the last write visible to are covered - a new write is visible to nothing
+    *pReadStageMask  = nextAccessSet.hasWriteAccess ? 0 : nextAccessSet.stageMask;
+    *pReadAccessMask = nextAccessSet.hasWriteAccess ? 0 : nextAccessSet.accessMask;
+    return true;
+}
+
+VkBool32 thsvsTransitionBufferState(
+    ThsvsBufferState*       pState,
+    uint32_t                nextAccessCount,
+    const ThsvsAccessType*  pNextAccesses,
+    VkPipelineStageFlags*   pSrcStages,
+    VkPipelineStageFlags*   pDstStages,
+    VkBufferMemoryBarrier*  pVkBarrier)
+{
+    ThsvsAccessSet nextAccessSet;
+    thsvsCompileAccessSet(nextAccessCount, pNextAccesses, &nextAccessSet);
+
+    VkAccessFlags srcAccessMask = 0;
+    VkAccessFlags dstAccessMask = 0;
+    if (!thsvsTransitionState(&pState->writeStageMask, &pState->writeAccessMask,
+                              &pState->readStageMask, &pState->readAccessMask,
+                              nextAccessSet, false,
+                              pSrcStages, pDstStages, &srcAccessMask, &dstAccessMask))
+        return VK_FALSE;
+
+    pVkBarrier->sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    pVkBarrier->pNext               = NULL;
+    pVkBarrier->srcAccessMask       = srcAccessMask;
+    pVkBarrier->dstAccessMask       = dstAccessMask;
+    pVkBarrier->srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    pVkBarrier->dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    pVkBarrier->buffer              = pState->buffer;
+    pVkBarrier->offset              = pState->offset;
+    pVkBarrier->size                = pState->size;
+
+    return VK_TRUE;
+}
+
+VkBool32 thsvsTransitionImageState(
+    ThsvsImageState*        pState,
+    uint32_t                nextAccessCount,
+    const ThsvsAccessType*  pNextAccesses,
+    ThsvsImageLayout        nextLayout,
+    VkBool32                discardContents,
+    VkPipelineStageFlags*   pSrcStages,
+    VkPipelineStageFlags*   pDstStages,
+    VkImageMemoryBarrier*   pVkBarrier)
+{
+    ThsvsAccessSet nextAccessSet;
+    thsvsCompileAccessSet(nextAccessCount, pNextAccesses, &nextAccessSet);
+
+    VkImageLayout oldLayout = (discardContents == VK_TRUE) ? VK_IMAGE_LAYOUT_UNDEFINED : pState->layout;
+    VkImageLayout newLayout = thsvsSelectAspectImageLayout(nextAccessSet.imageLayouts[nextLayout], nextLayout, pState->subresourceRange.aspectMask);
+
+    // Discarding always needs a barrier, as the transition from undefined is what discards
+    bool layoutTransition = (oldLayout != newLayout) || discardContents == VK_TRUE;
+
+    VkAccessFlags srcAccessMask = 0;
+    VkAccessFlags dstAccessMask = 0;
+    if (!thsvsTransitionState(&pState->writeStageMask, &pState->writeAccessMask,
+                              &pState->readStageMask, &pState->readAccessMask,
+                              nextAccessSet, layoutTransition,
+                              pSrcStages, pDstStages, &srcAccessMask, &dstAccessMask))
+        return VK_FALSE;
+
+    pState->layout = newLayout;
+
+    pVkBarrier->sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    pVkBarrier->pNext               = NULL;
+    pVkBarrier->srcAccessMask       = srcAccessMask;
+    pVkBarrier->dstAccessMask       = dstAccessMask;
+    pVkBarrier->oldLayout           = oldLayout;
+    pVkBarrier->newLayout           = newLayout;
+    pVkBarrier->srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    pVkBarrier->dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    pVkBarrier->image               = pState->image;
+    pVkBarrier->subresourceRange    = pState->subresourceRange;
+
+    return VK_TRUE;
+}
+
+void thsvsBatchBufferState(
+    ThsvsBarrierBatch*      pBatch,
+    ThsvsBufferState*       pState,
+    uint32_t                nextAccessCount,
+    const ThsvsAccessType*  pNextAccesses)
+{
+    VkPipelineStageFlags  srcStageMask = 0;
+    VkPipelineStageFlags  dstStageMask = 0;
+    VkBufferMemoryBarrier bufferMemoryBarrier;
+
+    if (thsvsTransitionBufferState(pState, nextAccessCount, pNextAccesses, &srcStageMask, &dstStageMask, &bufferMemoryBarrier) == VK_TRUE)
+        thsvsBatchBufferMemoryBarrier(pBatch, srcStageMask, dstStageMask, bufferMemoryBarrier);
+}
+
+void thsvsBatchImageState(
+    ThsvsBarrierBatch*      pBatch,
+    ThsvsImageState*        pState,
+    uint32_t                nextAccessCount,
+    const ThsvsAccessType*  pNextAccesses,
+    ThsvsImageLayout        nextLayout,
+    VkBool32                discardContents)
+{
+    VkPipelineStageFlags srcStageMask = 0;
+    VkPipelineStageFlags dstStageMask = 0;
+    VkImageMemoryBarrier imageMemoryBarrier;
+
+    if (thsvsTransitionImageState(pState, nextAccessCount, pNextAccesses, nextLayout, discardContents, &srcStageMask, &dstStageMask, &imageMemoryBarrier) == VK_TRUE)
+        thsvsBatchImageMemoryBarrier(pBatch, srcStageMask, dstStageMask, imageMemoryBarrier);
+}
+
+// Counts the aspects in an aspect mask
+static uint32_t thsvsGetAspectCount(
+    VkImageAspectFlags aspectMask)
+{
+    uint32_t aspectCount = 0;
+    for (; aspectMask != 0; aspectMask &= aspectMask - 1)
+        ++aspectCount;
+    return aspectCount;
+}
+
+uint32_t thsvsGetImageSubresourceCount(
+    VkImageAspectFlags      aspectMask,
+    uint32_t                mipLevelCount,
+    uint32_t                arrayLayerCount)
+{
+    return thsvsGetAspectCount(aspectMask) * mipLevelCount * arrayLayerCount;
+}
+
+void thsvsInitImageSubresourceMap(
+    ThsvsImageSubresourceMap* pMap,
+    VkImage                   image,
+    VkImageAspectFlags        aspectMask,
+    uint32_t                  mipLevelCount,
+    uint32_t                  arrayLayerCount,
+    ThsvsSubresourceState*    pStateStorage,
+    VkImageLayout             layout)
+{
+    pMap->image           = image;
+    pMap->aspectMask      = aspectMask;
+    pMap->mipLevelCount   = mipLevelCount;
+    pMap->arrayLayerCount = arrayLayerCount;
+    pMap->pStates         = pStateStorage;
+
+    uint32_t stateCount = thsvsGetImageSubresourceCount(aspectMask, mipLevelCount, arrayLayerCount);
+    for (uint32_t i = 0; i < stateCount; ++i)
+    {
+        pStateStorage[i].writeStageMask  = 0;
+        pStateStorage[i].writeAccessMask = 0;
+        pStateStorage[i].readStageMask   = 0;
+        pStateStorage[i].readAccessMask  = 0;
+        pStateStorage[i].layout          = layout;
+    }
+}
+
+// Whether two barriers generated for a subresource map can be merged, ignoring their ranges
+static bool thsvsSubresourceBarriersMatch(
+    const VkImageMemoryBarrier& a,
+    const VkImageMemoryBarrier& b)
+{
+    return a.srcAccessMask == b.srcAccessMask &&
+           a.dstAccessMask == b.dstAccessMask &&
+           a.oldLayout == b.oldLayout;
+}
+
+/*
+Adds a barrier for a run of mip levels in one layer of one aspect, extending
+a barrier for the same mip levels in the previous layer if there is one.
+Only barriers from firstBarrier onwards (i.e. the same aspect) are considered.
+*/
+static void thsvsAddSubresourceBarrier(
+    const VkImageMemoryBarrier& vkBarrier,
+    uint32_t                    firstBarrier,
+    uint32_t*                   pBarrierCount,
+    VkImageMemoryBarrier*       pVkBarriers)
+{
+    const VkImageSubresourceRange& range = vkBarrier.subresourceRange;
+
+    for (uint32_t i = firstBarrier; i < *pBarrierCount; ++i)
+    {
+        VkImageSubresourceRange& prevRange = pVkBarriers[i].subresourceRange;
+        if (prevRange.baseMipLevel == range.baseMipLevel &&
+            prevRange.levelCount == range.levelCount &&
+            prevRange.baseArrayLayer + prevRange.layerCount == range.baseArrayLayer &&
+            thsvsSubresourceBarriersMatch(pVkBarriers[i], vkBarrier))
+        {
+            ++prevRange.layerCount;
+            return;
+        }
+    }
+
+    pVkBarriers[(*pBarrierCount)++] = vkBarrier;
+}
+
+uint32_t thsvsTransitionImageSubresources(
+    ThsvsImageSubresourceMap* pMap,
+    VkImageSubresourceRange   subresourceRange,
+    uint32_t                  nextAccessCount,
+    const ThsvsAccessType*    pNextAccesses,
+    ThsvsImageLayout          nextLayout,
+    VkBool32                  discardContents,
+    VkPipelineStageFlags*     pSrcStages,
+    VkPipelineStageFlags*     pDstStages,
+    VkImageMemoryBarrier*     pVkBarriers)
+{
+    ThsvsAccessSet nextAccessSet;
+    thsvsCompileAccessSet(nextAccessCount, pNextAccesses, &nextAccessSet);
+
+    VkImageLayout newLayout = thsvsSelectAspectImageLayout(nextAccessSet.imageLayouts[nextLayout], nextLayout, subresourceRange.aspectMask);
+
+    uint32_t mipEnd   = (uint32_t)thsvsRangeEnd(subresourceRange.baseMipLevel, subresourceRange.levelCount, VK_REMAINING_MIP_LEVELS);
+    uint32_t layerEnd = (uint32_t)thsvsRangeEnd(subresourceRange.baseArrayLayer, subresourceRange.layerCount, VK_REMAINING_ARRAY_LAYERS);
+    if (mipEnd > pMap->mipLevelCount)
+        mipEnd = pMap->mipLevelCount;
+    if (layerEnd > pMap->arrayLayerCount)
+        layerEnd = pMap->arrayLayerCount;
+
+#ifdef THSVS_ERROR_CHECK_SUBRESOURCE_RANGE
+    // Asserts that the range only covers subresources that are in the map
+    assert((subresourceRange.aspectMask & ~pMap->aspectMask) == 0);
+    assert(subresourceRange.levelCount == VK_REMAINING_MIP_LEVELS ||
+           subresourceRange.baseMipLevel + subresourceRange.levelCount <= pMap->mipLevelCount);
+    assert(subresourceRange.layerCount == VK_REMAINING_ARRAY_LAYERS ||
+           subresourceRange.baseArrayLayer + subresourceRange.layerCount <= pMap->arrayLayerCount);
+#endif
+
+    VkImageMemoryBarrier vkBarrier;
+    vkBarrier.sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    vkBarrier.pNext               = NULL;
+    vkBarrier.newLayout           = newLayout;
+    vkBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    vkBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    vkBarrier.image               = pMap->image;
+
+    VkPipelineStageFlags srcStageMask = 0;
+    VkPipelineStageFlags dstStageMask = 0;
+    uint32_t             barrierCount = 0;
+
+    // States are stored with mip levels innermost, then array layers, then aspects
+    uint32_t aspectIndex = 0;
+    for (VkImageAspectFlags aspects = pMap->aspectMask; aspects != 0; aspects &= aspects - 1, ++aspectIndex)
+    {
+        VkImageAspectFlags aspect = aspects & (0 - aspects);
+        if ((subresourceRange.aspectMask & aspect) == 0)
+            continue;
+
+        uint32_t firstAspectBarrier = barrierCount;
+
+        for (uint32_t layer = subresourceRange.baseArrayLayer; layer < layerEnd; ++layer)
+        {
+            ThsvsSubresourceState* pLayerStates = &pMap->pStates[(aspectIndex * pMap->arrayLayerCount + layer) * pMap->mipLevelCount];
+            bool inRun = false;
+
+            for (uint32_t mip = subresourceRange.baseMipLevel; mip < mipEnd; ++mip)
+            {
+                ThsvsSubresourceState* pState = &pLayerStates[mip];
+
+                VkImageLayout oldLayout = (discardContents == VK_TRUE) ? VK_IMAGE_LAYOUT_UNDEFINED : pState->layout;
+
+                // Discarding always needs a barrier, as the transition from undefined is what discards
+                bool layoutTransition = (oldLayout != newLayout) || discardContents == VK_TRUE;
+
+                VkPipelineStageFlags tempSrcStageMask = 0;
+                VkPipelineStageFlags tempDstStageMask = 0;
+                VkAccessFlags        srcAccessMask    = 0;
+                VkAccessFlags        dstAccessMask    = 0;
+                bool needed = thsvsTransitionState(&pState->writeStageMask, &pState->writeAccessMask,
+                                                   &pState->readStageMask, &pState->readAccessMask,
+                                                   nextAccessSet, layoutTransition,
+                                                   &tempSrcStageMask, &tempDstStageMask, &srcAccessMask, &dstAccessMask);
+
+                if (needed)
+                {
+                    pState->layout = newLayout;
+                    srcStageMask |= tempSrcStageMask;
+                    dstStageMask |= tempDstStageMask;
+                }
+
+                // Extend the current run of mip levels if this one has the same transition, else end it
+                if (inRun && needed &&
+                    srcAccessMask == vkBarrier.srcAccessMask &&
+                    dstAccessMask == vkBarrier.dstAccessMask &&
+                    oldLayout == vkBarrier.oldLayout)
+                {
+                    ++vkBarrier.subresourceRange.levelCount;
+                    continue;
+                }
+
+                if (inRun)
+                    thsvsAddSubresourceBarrier(vkBarrier, firstAspectBarrier, &barrierCount, pVkBarriers);
+
+                inRun = needed;
+                vkBarrier.srcAccessMask                   = srcAccessMask;
+                vkBarrier.dstAccessMask                   = dstAccessMask;
+                vkBarrier.oldLayout                       = oldLayout;
+                vkBarrier.subresourceRange.aspectMask     = aspect;
+                vkBarrier.subresourceRange.baseMipLevel   = mip;
+                vkBarrier.subresourceRange.levelCount     = 1;
+                vkBarrier.subresourceRange.baseArrayLayer = layer;
+                vkBarrier.subresourceRange.layerCount     = 1;
+            }
+
+            if (inRun)
+                thsvsAddSubresourceBarrier(vkBarrier, firstAspectBarrier, &barrierCount, pVkBarriers);
+        }
+    }
+
+    // Merge barriers that only differ by aspect
+    uint32_t mergedBarrierCount = 0;
+    for (uint32_t i = 0; i < barrierCount; ++i)
+    {
+        const VkImageSubresourceRange& range = pVkBarriers[i].subresourceRange;
+        bool merged = false;
+
+        for (uint32_t j = 0; j < mergedBarrierCount && !merged; ++j)
+        {
+            VkImageSubresourceRange& mergedRange = pVkBarriers[j].subresourceRange;
+            if (mergedRange.baseMipLevel == range.baseMipLevel &&
+                mergedRange.levelCount == range.levelCount &&
+                mergedRange.baseArrayLayer == range.baseArrayLayer &&
+                mergedRange.layerCount == range.layerCount &&
+                thsvsSubresourceBarriersMatch(pVkBarriers[j], pVkBarriers[i]))
+            {
+                mergedRange.aspectMask |= range.aspectMask;
+                merged = true;
+            }
+        }
+
+        if (!merged)
+            pVkBarriers[mergedBarrierCount++] = pVkBarriers[i];
+    }
+
+    if (mergedBarrierCount > 0)
+    {
+        *pSrcStages = srcStageMask;
+        *pDstStages = dstStageMask;
+    }
+
+    return mergedBarrierCount;
+}
+
+void thsvsBatchImageSubresources(
+    ThsvsBarrierBatch*        pBatch,
+    ThsvsImageSubresourceMap* pMap,
+    VkImageSubresourceRange   subresourceRange,
+    uint32_t                  nextAccessCount,
+    const ThsvsAccessType*    pNextAccesses,
+    ThsvsImageLayout          nextLayout,
+    VkBool32                  discardContents)
+{
+    // Clamped to the map in the same way as thsvsTransitionImageSubresources, so a range past the end allocates nothing
+    uint32_t mipEnd   = (uint32_t)thsvsRangeEnd(subresourceRange.baseMipLevel, subresourceRange.levelCount, VK_REMAINING_MIP_LEVELS);
+    uint32_t layerEnd = (uint32_t)thsvsRangeEnd(subresourceRange.baseArrayLayer, subresourceRange.layerCount, VK_REMAINING_ARRAY_LAYERS);
+    if (mipEnd > pMap->mipLevelCount)
+        mipEnd = pMap->mipLevelCount;
+    if (layerEnd > pMap->arrayLayerCount)
+        layerEnd = pMap->arrayLayerCount;
+
+    uint32_t levelCount = (mipEnd > subresourceRange.baseMipLevel) ? mipEnd - subresourceRange.baseMipLevel : 0;
+    uint32_t layerCount = (layerEnd > subresourceRange.baseArrayLayer) ? layerEnd - subresourceRange.baseArrayLayer : 0;
+    uint32_t maxBarrierCount = thsvsGetImageSubresourceCount(subresourceRange.aspectMask & pMap->aspectMask, levelCount, layerCount);
+
+    if (maxBarrierCount == 0)
+        return;
+
+    VkImageMemoryBarrier* pVkBarriers = (VkImageMemoryBarrier*)THSVS_TEMP_ALLOC(sizeof(VkImageMemoryBarrier) * maxBarrierCount);
+
+    VkPipelineStageFlags srcStageMask = 0;
+    VkPipelineStageFlags dstStageMask = 0;
+    uint32_t barrierCount = thsvsTransitionImageSubresources(pMap, subresourceRange, nextAccessCount, pNextAccesses,
+                                                             nextLayout, discardContents,
+                                                             &srcStageMask, &dstStageMask, pVkBarriers);
+
+    for (uint32_t i = 0; i < barrierCount; ++i)
+        thsvsBatchImageMemoryBarrier(pBatch, srcStageMask, dstStageMask, pVkBarriers[i]);
+
+    THSVS_TEMP_FREE(pVkBarriers);
+}
+
+VkResult thsvsCreateEventPool(
+    ThsvsEventPool*           pPool,
+    VkDevice                  device,
+    uint32_t                  eventCount,
+    VkEvent*                  pEventStorage)
+{
+    pPool->device         = device;
+    pPool->eventCount     = 0;
+    pPool->usedEventCount = 0;
+    pPool->pEvents        = pEventStorage;
+
+    VkEventCreateInfo createInfo;
+    createInfo.sType = VK_STRUCTURE_TYPE_EVENT_CREATE_INFO;
+    createInfo.pNext = NULL;
+    createInfo.flags = 0;
+
+    for (uint32_t i = 0; i < eventCount; ++i)
+    {
+        VkResult result = vkCreateEvent(device, &createInfo, NULL, &pEventStorage[i]);
+        if (result != VK_SUCCESS)
+        {
+            thsvsDestroyEventPool(pPool);
+            return result;
+        }
+        ++pPool->eventCount;
+    }
+
+    return VK_SUCCESS;
+}
+
+void thsvsDestroyEventPool(
+    ThsvsEventPool*           pPool)
+{
+    for (uint32_t i = 0; i < pPool->eventCount; ++i)
+        vkDestroyEvent(pPool->device, pPool->pEvents[i], NULL);
+
+    pPool->eventCount     = 0;
+    pPool->usedEventCount = 0;
+}
+
+VkResult thsvsResetEventPool(
+    ThsvsEventPool*           pPool)
+{
+    for (uint32_t i = 0; i < pPool->usedEventCount; ++i)
+    {
+        VkResult result = vkResetEvent(pPool->device, pPool->pEvents[i]);
+        if (result != VK_SUCCESS)
+            return result;
+    }
+
+    pPool->usedEventCount = 0;
+    return VK_SUCCESS;
+}
+
+void thsvsCmdBeginSplitBarrier(
+    VkCommandBuffer           commandBuffer,
+    ThsvsEventPool*           pPool,
+    const ThsvsGlobalBarrier* pGlobalBarrier,
+    uint32_t                  bufferBarrierCount,
+    const ThsvsBufferBarrier* pBufferBarriers,
+    uint32_t                  imageBarrierCount,
+    const ThsvsImageBarrier*  pImageBarriers,
+    ThsvsSplitBarrier*        pSplitBarrier)
+{
+    pSplitBarrier->srcStageMask = thsvsGetBarriersSrcStageMask(pGlobalBarrier, bufferBarrierCount, pBufferBarriers, imageBarrierCount, pImageBarriers);
+
+    // Out of events, so the second half falls back to a pipeline barrier
+    if (pPool->usedEventCount == pPool->eventCount)
+    {
+        pSplitBarrier->event = VK_NULL_HANDLE;
+        return;
+    }
+
+    pSplitBarrier->event = pPool->pEvents[pPool->usedEventCount++];
+
+    vkCmdSetEvent(
+        commandBuffer,
+        pSplitBarrier->event,
+        pSplitBarrier->srcStageMask);
+}
+
+void thsvsCmdEndSplitBarrier(
+    VkCommandBuffer           commandBuffer,
+    const ThsvsSplitBarrier*  pSplitBarrier,
+    const ThsvsGlobalBarrier* pGlobalBarrier,
+    uint32_t                  bufferBarrierCount,
+    const ThsvsBufferBarrier* pBufferBarriers,
+    uint32_t                  imageBarrierCount,
+    const ThsvsImageBarrier*  pImageBarriers)
+{
+    if (pSplitBarrier->event == VK_NULL_HANDLE)
+    {
+        thsvsCmdPipelineBarrier(
+            commandBuffer,
+            pGlobalBarrier,
+            bufferBarrierCount,
+            pBufferBarriers,
+            imageBarrierCount,
+            pImageBarriers);
+    }
+    else
+    {
+        thsvsCmdWaitEvents(
+            commandBuffer,
+            1,
+            &pSplitBarrier->event,
+            pGlobalBarrier,
+            bufferBarrierCount,
+            pBufferBarriers,
+            imageBarrierCount,
+            pImageBarriers);
+    }
+}
+
+void thsvsGetVulkanExecutionDependency(
+    const ThsvsExecutionBarrier& thBarrier,
+    VkPipelineStageFlags*        pSrcStages,
+    VkPipelineStageFlags*        pDstStages)
+{
+    *pSrcStages = thsvsGetStageMask(thBarrier.prevAccessCount, thBarrier.pPrevAccesses);
+    *pDstStages = thsvsGetStageMask(thBarrier.nextAccessCount, thBarrier.pNextAccesses);
+
+    // Ensure that the stage masks are valid if no stages were determined
+    if (*pSrcStages == 0)
+        *pSrcStages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    if (*pDstStages == 0)
+        *pDstStages = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+}
+
+void thsvsCmdExecutionBarrier(
+    VkCommandBuffer              commandBuffer,
+    const ThsvsExecutionBarrier* pExecutionBarrier)
+{
+    VkPipelineStageFlags srcStageMask;
+    VkPipelineStageFlags dstStageMask;
+    thsvsGetVulkanExecutionDependency(*pExecutionBarrier, &srcStageMask, &dstStageMask);
+
+#ifdef THSVS_STATS
+    thsvsInstrumentBarrier(commandBuffer, "thsvsCmdExecutionBarrier", false, srcStageMask, dstStageMask, 0, 0, NULL, 0, NULL);
+#endif
+
+#ifdef THSVS_CAPTURE
+    thsvsCaptureBarriers(THSVS_CAPTURE_RECORD_PIPELINE_BARRIER, true, srcStageMask, dstStageMask, NULL, 0, NULL, 0, NULL);
+#endif
+
+#ifdef THSVS_DIAGNOSTICS
+    thsvsDiagnoseAccesses(pExecutionBarrier->prevAccessCount, pExecutionBarrier->pPrevAccesses);
+    thsvsDiagnoseAccesses(pExecutionBarrier->nextAccessCount, pExecutionBarrier->pNextAccesses);
+    thsvsDiagnoseSequence(commandBuffer, true);
+#endif
+
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        srcStageMask,
+        dstStageMask,
+        0,
+        0,
+        NULL,
+        0,
+        NULL,
         0,
-        VK_IMAGE_LAYOUT_UNDEFINED},
+        NULL);
+}
 
-// Write access
-    // THSVS_ACCESS_COMMAND_BUFFER_WRITE_NV
-    {   VK_PIPELINE_STAGE_COMMAND_PREPROCESS_BIT_NV,
-        VK_ACCESS_COMMAND_PREPROCESS_WRITE_BIT_NV,
-        VK_IMAGE_LAYOUT_UNDEFINED},
-    // THSVS_ACCESS_VERTEX_SHADER_WRITE
-    {   VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
-        VK_ACCESS_SHADER_WRITE_BIT,
-        VK_IMAGE_LAYOUT_GENERAL},
-    // THSVS_ACCESS_TESSELLATION_CONTROL_SHADER_WRITE
-    {   VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT,
-        VK_ACCESS_SHADER_WRITE_BIT,
-        VK_IMAGE_LAYOUT_GENERAL},
-    // THSVS_ACCESS_TESSELLATION_EVALUATION_SHADER_WRITE
-    {   VK_PIPELINE_STAGE_TESSELLATION_EVALUATION_SHADER_BIT,
-        VK_ACCESS_SHADER_WRITE_BIT,
-        VK_IMAGE_LAYOUT_GENERAL},
-    // THSVS_ACCESS_GEOMETRY_SHADER_WRITE
-    {   VK_PIPELINE_STAGE_GEOMETRY_SHADER_BIT,
-        VK_ACCESS_SHADER_WRITE_BIT,
-        VK_IMAGE_LAYOUT_GENERAL},
-    // THSVS_ACCESS_TASK_SHADER_WRITE_NV
-    {   VK_PIPELINE_STAGE_TASK_SHADER_BIT_NV,
-        VK_ACCESS_SHADER_WRITE_BIT,
-        VK_IMAGE_LAYOUT_GENERAL},
-    // THSVS_ACCESS_MESH_SHADER_WRITE_NV
-    {   VK_PIPELINE_STAGE_MESH_SHADER_BIT_NV,
-        VK_ACCESS_SHADER_WRITE_BIT,
-        VK_IMAGE_LAYOUT_GENERAL},
-    // THSVS_ACCESS_TRANSFORM_FEEDBACK_WRITE_EXT
-    {   VK_PIPELINE_STAGE_TRANSFORM_FEEDBACK_BIT_EXT,
-        VK_ACCESS_TRANSFORM_FEEDBACK_WRITE_BIT_EXT,
-        VK_IMAGE_LAYOUT_UNDEFINED},
-    // THSVS_ACCESS_TRANSFORM_FEEDBACK_COUNTER_WRITE_EXT
-    {   VK_PIPELINE_STAGE_TRANSFORM_FEEDBACK_BIT_EXT,
-        VK_ACCESS_TRANSFORM_FEEDBACK_COUNTER_WRITE_BIT_EXT,
-        VK_IMAGE_LAYOUT_UNDEFINED},
-    // THSVS_ACCESS_FRAGMENT_SHADER_WRITE
-    {   VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-        VK_ACCESS_SHADER_WRITE_BIT,
-        VK_IMAGE_LAYOUT_GENERAL},
-    // THSVS_ACCESS_COLOR_ATTACHMENT_WRITE
-    {   VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-        VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
-        VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL},
-    // THSVS_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE
-    {   VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
-        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
-        VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL},
-    // THSVS_ACCESS_DEPTH_ATTACHMENT_WRITE_STENCIL_READ_ONLY
-    {   VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
-        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
-        VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_STENCIL_READ_ONLY_OPTIMAL_KHR},
-    // THSVS_ACCESS_STENCIL_ATTACHMENT_WRITE_DEPTH_READ_ONLY
-    {   VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
-        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
-        VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_STENCIL_ATTACHMENT_OPTIMAL_KHR},
+void thsvsCmdWaitEventsExecution(
+    VkCommandBuffer              commandBuffer,
+    uint32_t                     eventCount,
+    const VkEvent*               pEvents,
+    const ThsvsExecutionBarrier* pExecutionBarrier)
+{
+    VkPipelineStageFlags srcStageMask;
+    VkPipelineStageFlags dstStageMask;
+    thsvsGetVulkanExecutionDependency(*pExecutionBarrier, &srcStageMask, &dstStageMask);
+
+    // Matches the stage mask thsvsCmdSetEvent would use for the same accesses
+    srcStageMask |= VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+
+#ifdef THSVS_STATS
+    thsvsInstrumentBarrier(commandBuffer, "thsvsCmdWaitEventsExecution", true, srcStageMask, dstStageMask, 0, 0, NULL, 0, NULL);
+#endif
+
+#ifdef THSVS_CAPTURE
+    thsvsCaptureBarriers(THSVS_CAPTURE_RECORD_WAIT_EVENTS, true, srcStageMask, dstStageMask, NULL, 0, NULL, 0, NULL);
+#endif
+
+#ifdef THSVS_DIAGNOSTICS
+    thsvsDiagnoseAccesses(pExecutionBarrier->prevAccessCount, pExecutionBarrier->pPrevAccesses);
+    thsvsDiagnoseAccesses(pExecutionBarrier->nextAccessCount, pExecutionBarrier->pNextAccesses);
+    thsvsDiagnoseSequence(commandBuffer, false);
+#endif
+
+    vkCmdWaitEvents(
+        commandBuffer,
+        eventCount,
+        pEvents,
+        srcStageMask,
+        dstStageMask,
+        0,
+        NULL,
+        0,
+        NULL,
+        0,
+        NULL);
+}
+
+void thsvsBatchExecutionBarrier(
+    ThsvsBarrierBatch*           pBatch,
+    const ThsvsExecutionBarrier* pExecutionBarrier)
+{
+    VkPipelineStageFlags srcStageMask;
+    VkPipelineStageFlags dstStageMask;
+    thsvsGetVulkanExecutionDependency(*pExecutionBarrier, &srcStageMask, &dstStageMask);
+
+    pBatch->srcStageMask |= srcStageMask;
+    pBatch->dstStageMask |= dstStageMask;
+}
+
+VkImageLayout thsvsGetVulkanImageLayout(
+    uint32_t               accessCount,
+    const ThsvsAccessType* pAccesses,
+    ThsvsImageLayout       layout)
+{
+    VkImageLayout imageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    for (uint32_t i = 0; i < accessCount; ++i)
+    {
+        ThsvsAccessType access = pAccesses[i];
+
+#ifdef THSVS_ERROR_CHECK_ACCESS_TYPE_IN_RANGE
+        // Asserts that the access index is a valid range for the lookup
+        assert(access < THSVS_NUM_ACCESS_TYPES);
+#endif
+
+        VkImageLayout accessLayout = thsvsGetImageLayout(access, layout);
+
+#ifdef THSVS_ERROR_CHECK_MIXED_IMAGE_LAYOUT
+        assert(imageLayout == VK_IMAGE_LAYOUT_UNDEFINED ||
+               imageLayout == accessLayout);
+#endif
+        imageLayout = accessLayout;
+    }
+
+    return imageLayout;
+}
+
+VkBool32 thsvsGetVulkanAttachmentBarrier(
+    const ThsvsAttachmentBarrier& thBarrier,
+    VkPipelineStageFlags*         pSrcStages,
+    VkPipelineStageFlags*         pDstStages,
+    VkImageMemoryBarrier*         pVkBarrier)
+{
+    ThsvsImageBarrier imageBarrier;
+    imageBarrier.prevAccessCount     = thBarrier.prevAccessCount;
+    imageBarrier.pPrevAccesses       = thBarrier.pPrevAccesses;
+    imageBarrier.nextAccessCount     = thBarrier.nextAccessCount;
+    imageBarrier.pNextAccesses       = thBarrier.pNextAccesses;
+    imageBarrier.prevLayout          = thBarrier.prevLayout;
+    imageBarrier.nextLayout          = thBarrier.nextLayout;
+    imageBarrier.discardContents     = VK_FALSE;
+    imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    imageBarrier.image               = thBarrier.image;
+    imageBarrier.subresourceRange    = thBarrier.subresourceRange;
+
+    VkBool32 needed = thsvsGetVulkanImageMemoryBarrier(imageBarrier, pSrcStages, pDstStages, pVkBarrier);
+
+    // The load operation is an attachment access of its own - a read when loading, and a write otherwise
+    bool color        = (thBarrier.subresourceRange.aspectMask & VK_IMAGE_ASPECT_COLOR_BIT) != 0;
+    bool loadWrites   = thBarrier.loadOp == VK_ATTACHMENT_LOAD_OP_CLEAR || thBarrier.loadOp == VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    ThsvsAccessType loadAccess = THSVS_ACCESS_NONE;
+    if (thBarrier.loadOp == VK_ATTACHMENT_LOAD_OP_LOAD)
+        loadAccess = color ? THSVS_ACCESS_COLOR_ATTACHMENT_READ : THSVS_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ;
+    else if (loadWrites)
+        loadAccess = color ? THSVS_ACCESS_COLOR_ATTACHMENT_WRITE : THSVS_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE;
+
+    *pDstStages |= THSVS_TABLE_STAGE_MASK(loadAccess);
+    if (pVkBarrier->srcAccessMask != 0)
+        pVkBarrier->dstAccessMask |= THSVS_TABLE_ACCESS_MASK(loadAccess);
+
+    // A write by the load operation still has to wait for the previous accesses
+    if (loadAccess > THSVS_END_OF_READ_ACCESS && thBarrier.prevAccessCount > 0)
+        needed = VK_TRUE;
+
+    // Only discard if there's a barrier anyway, and outside the render area is known not to need preserving
+    if (needed == VK_TRUE && loadWrites && thBarrier.discardContents == VK_TRUE)
+        pVkBarrier->oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    return needed;
+}
+
+// Whether every access in a list only touches the attachments at the current fragment location
+static bool thsvsIsFramebufferLocal(
+    uint32_t                  accessCount,
+    const ThsvsAccessType*    pAccesses)
+{
+    if (accessCount == 0)
+        return false;
+
+    for (uint32_t i = 0; i < accessCount; ++i)
+    {
+        switch (pAccesses[i])
+        {
+            case THSVS_ACCESS_FRAGMENT_SHADER_READ_COLOR_INPUT_ATTACHMENT:
+            case THSVS_ACCESS_FRAGMENT_SHADER_READ_DEPTH_STENCIL_INPUT_ATTACHMENT:
+            case THSVS_ACCESS_COLOR_ATTACHMENT_READ:
+            case THSVS_ACCESS_COLOR_ATTACHMENT_ADVANCED_BLENDING_EXT:
+            case THSVS_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ:
+            case THSVS_ACCESS_COLOR_ATTACHMENT_WRITE:
+            case THSVS_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE:
+            case THSVS_ACCESS_DEPTH_ATTACHMENT_WRITE_STENCIL_READ_ONLY:
+            case THSVS_ACCESS_STENCIL_ATTACHMENT_WRITE_DEPTH_READ_ONLY:
+            case THSVS_ACCESS_COLOR_ATTACHMENT_READ_WRITE:
+                break;
+            default:
+                return false;
+        }
+    }
+
+    return true;
+}
+
+void thsvsGetVulkanSubpassDependency(
+    const ThsvsGlobalBarrier& thBarrier,
+    uint32_t                  srcSubpass,
+    uint32_t                  dstSubpass,
+    VkSubpassDependency*      pDependency)
+{
+    VkMemoryBarrier memoryBarrier;
+    thsvsGetVulkanMemoryBarrier(thBarrier, &pDependency->srcStageMask, &pDependency->dstStageMask, &memoryBarrier);
+
+    pDependency->srcSubpass      = srcSubpass;
+    pDependency->dstSubpass      = dstSubpass;
+    pDependency->srcAccessMask   = memoryBarrier.srcAccessMask;
+    pDependency->dstAccessMask   = memoryBarrier.dstAccessMask;
+    pDependency->dependencyFlags = 0;
+
+    if (srcSubpass != VK_SUBPASS_EXTERNAL && dstSubpass != VK_SUBPASS_EXTERNAL &&
+        thsvsIsFramebufferLocal(thBarrier.prevAccessCount, thBarrier.pPrevAccesses) &&
+        thsvsIsFramebufferLocal(thBarrier.nextAccessCount, thBarrier.pNextAccesses))
+        pDependency->dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+
+    // A self-dependency between framebuffer-space stages must be by region, whatever the accesses
+    const VkPipelineStageFlags framebufferStages = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+                                                   VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+                                                   VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT |
+                                                   VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    if (srcSubpass == dstSubpass && srcSubpass != VK_SUBPASS_EXTERNAL &&
+        (pDependency->srcStageMask & framebufferStages) != 0 &&
+        (pDependency->dstStageMask & framebufferStages) != 0)
+        pDependency->dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+}
+
+#ifdef VK_VERSION_1_2
+void thsvsGetVulkanSubpassDependency2(
+    const ThsvsGlobalBarrier& thBarrier,
+    uint32_t                  srcSubpass,
+    uint32_t                  dstSubpass,
+    VkSubpassDependency2*     pDependency)
+{
+    VkSubpassDependency dependency;
+    thsvsGetVulkanSubpassDependency(thBarrier, srcSubpass, dstSubpass, &dependency);
+
+    pDependency->sType           = VK_STRUCTURE_TYPE_SUBPASS_DEPENDENCY_2;
+    pDependency->pNext           = NULL;
+    pDependency->srcSubpass      = dependency.srcSubpass;
+    pDependency->dstSubpass      = dependency.dstSubpass;
+    pDependency->srcStageMask    = dependency.srcStageMask;
+    pDependency->dstStageMask    = dependency.dstStageMask;
+    pDependency->srcAccessMask   = dependency.srcAccessMask;
+    pDependency->dstAccessMask   = dependency.dstAccessMask;
+    pDependency->dependencyFlags = dependency.dependencyFlags;
+    pDependency->viewOffset      = 0;
+}
+#endif
+
+// Whether a transfer between these queue families actually changes ownership
+static bool thsvsIsOwnershipTransfer(
+    VkSharingMode           sharingMode,
+    uint32_t                srcQueueFamilyIndex,
+    uint32_t                dstQueueFamilyIndex)
+{
+    return sharingMode == VK_SHARING_MODE_EXCLUSIVE &&
+           srcQueueFamilyIndex != dstQueueFamilyIndex &&
+           srcQueueFamilyIndex != VK_QUEUE_FAMILY_IGNORED &&
+           dstQueueFamilyIndex != VK_QUEUE_FAMILY_IGNORED;
+}
+
+static void thsvsGetTransferBufferBarrier(
+    const ThsvsBufferTransfer& thTransfer,
+    bool                       ownershipTransfer,
+    ThsvsBufferBarrier*        pBarrier)
+{
+    pBarrier->prevAccessCount     = thTransfer.prevAccessCount;
+    pBarrier->pPrevAccesses       = thTransfer.pPrevAccesses;
+    pBarrier->nextAccessCount     = thTransfer.nextAccessCount;
+    pBarrier->pNextAccesses       = thTransfer.pNextAccesses;
+    pBarrier->srcQueueFamilyIndex = ownershipTransfer ? thTransfer.srcQueueFamilyIndex : VK_QUEUE_FAMILY_IGNORED;
+    pBarrier->dstQueueFamilyIndex = ownershipTransfer ? thTransfer.dstQueueFamilyIndex : VK_QUEUE_FAMILY_IGNORED;
+    pBarrier->buffer              = thTransfer.buffer;
+    pBarrier->offset              = thTransfer.offset;
+    pBarrier->size                = thTransfer.size;
+}
+
+static void thsvsGetTransferImageBarrier(
+    const ThsvsImageTransfer&  thTransfer,
+    bool                       ownershipTransfer,
+    ThsvsImageBarrier*         pBarrier)
+{
+    pBarrier->prevAccessCount     = thTransfer.prevAccessCount;
+    pBarrier->pPrevAccesses       = thTransfer.pPrevAccesses;
+    pBarrier->nextAccessCount     = thTransfer.nextAccessCount;
+    pBarrier->pNextAccesses       = thTransfer.pNextAccesses;
+    pBarrier->prevLayout          = thTransfer.prevLayout;
+    pBarrier->nextLayout          = thTransfer.nextLayout;
+    pBarrier->discardContents     = thTransfer.discardContents;
+    pBarrier->srcQueueFamilyIndex = ownershipTransfer ? thTransfer.srcQueueFamilyIndex : VK_QUEUE_FAMILY_IGNORED;
+    pBarrier->dstQueueFamilyIndex = ownershipTransfer ? thTransfer.dstQueueFamilyIndex : VK_QUEUE_FAMILY_IGNORED;
+    pBarrier->image               = thTransfer.image;
+    pBarrier->subresourceRange    = thTransfer.subresourceRange;
+}
+
+/*
+Both halves of a transfer start out as the full barrier between the previous
+and next accesses - which gets the layouts right - and then drop the half of
+the dependency that doesn't apply to their queue.
+The release makes the previous writes available, and the acquire makes the
+transferred range visible to the next accesses; the semaphore between them
+handles the execution dependency.
+*/
+VkBool32 thsvsGetVulkanBufferReleaseBarrier(
+    const ThsvsBufferTransfer& thTransfer,
+    VkPipelineStageFlags*      pSrcStages,
+    VkPipelineStageFlags*      pDstStages,
+    VkBufferMemoryBarrier*     pVkBarrier)
+{
+    if (!thsvsIsOwnershipTransfer(thTransfer.sharingMode, thTransfer.srcQueueFamilyIndex, thTransfer.dstQueueFamilyIndex))
+        return VK_FALSE;
+
+    ThsvsBufferBarrier barrier;
+    thsvsGetTransferBufferBarrier(thTransfer, true, &barrier);
+    thsvsGetVulkanBufferMemoryBarrier(barrier, pSrcStages, pDstStages, pVkBarrier);
+
+    *pDstStages               = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+    pVkBarrier->dstAccessMask = 0;
+
+    return VK_TRUE;
+}
+
+VkBool32 thsvsGetVulkanBufferAcquireBarrier(
+    const ThsvsBufferTransfer& thTransfer,
+    VkPipelineStageFlags*      pSrcStages,
+    VkPipelineStageFlags*      pDstStages,
+    VkBufferMemoryBarrier*     pVkBarrier)
+{
+    bool ownershipTransfer = thsvsIsOwnershipTransfer(thTransfer.sharingMode, thTransfer.srcQueueFamilyIndex, thTransfer.dstQueueFamilyIndex);
+
+    ThsvsBufferBarrier barrier;
+    thsvsGetTransferBufferBarrier(thTransfer, ownershipTransfer, &barrier);
+    VkBool32 needed = thsvsGetVulkanBufferMemoryBarrier(barrier, pSrcStages, pDstStages, pVkBarrier);
+
+    if (!ownershipTransfer)
+        return needed;
+
+    // Everything the destination queue family reads has to be made visible, regardless of what the source wrote
+    ThsvsAccessSet nextAccessSet;
+    thsvsCompileAccessSet(thTransfer.nextAccessCount, thTransfer.pNextAccesses, &nextAccessSet);
+
+    *pSrcStages               = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    pVkBarrier->srcAccessMask = 0;
+    pVkBarrier->dstAccessMask = nextAccessSet.accessMask;
+
+    return VK_TRUE;
+}
+
+VkBool32 thsvsGetVulkanImageReleaseBarrier(
+    const ThsvsImageTransfer&  thTransfer,
+    VkPipelineStageFlags*      pSrcStages,
+    VkPipelineStageFlags*      pDstStages,
+    VkImageMemoryBarrier*      pVkBarrier)
+{
+    if (!thsvsIsOwnershipTransfer(thTransfer.sharingMode, thTransfer.srcQueueFamilyIndex, thTransfer.dstQueueFamilyIndex))
+        return VK_FALSE;
+
+    ThsvsImageBarrier barrier;
+    thsvsGetTransferImageBarrier(thTransfer, true, &barrier);
+    thsvsGetVulkanImageMemoryBarrier(barrier, pSrcStages, pDstStages, pVkBarrier);
+
+    *pDstStages               = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+    pVkBarrier->dstAccessMask = 0;
+
+    return VK_TRUE;
+}
+
+VkBool32 thsvsGetVulkanImageAcquireBarrier(
+    const ThsvsImageTransfer&  thTransfer,
+    VkPipelineStageFlags*      pSrcStages,
+    VkPipelineStageFlags*      pDstStages,
+    VkImageMemoryBarrier*      pVkBarrier)
+{
+    bool ownershipTransfer = thsvsIsOwnershipTransfer(thTransfer.sharingMode, thTransfer.srcQueueFamilyIndex, thTransfer.dstQueueFamilyIndex);
+
+    ThsvsImageBarrier barrier;
+    thsvsGetTransferImageBarrier(thTransfer, ownershipTransfer, &barrier);
+    VkBool32 needed = thsvsGetVulkanImageMemoryBarrier(barrier, pSrcStages, pDstStages, pVkBarrier);
+
+    if (!ownershipTransfer)
+        return needed;
+
+    // Everything the destination queue family reads has to be made visible, regardless of what the source wrote
+    ThsvsAccessSet nextAccessSet;
+    thsvsCompileAccessSet(thTransfer.nextAccessCount, thTransfer.pNextAccesses, &nextAccessSet);
+
+    *pSrcStages               = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    pVkBarrier->srcAccessMask = 0;
+    pVkBarrier->dstAccessMask = nextAccessSet.accessMask;
+
+    return VK_TRUE;
+}
+
+// Shared by thsvsCmdReleaseOwnership and thsvsCmdAcquireOwnership
+static void thsvsCmdOwnershipTransfer(
+    VkCommandBuffer            commandBuffer,
+    bool                       release,
+    uint32_t                   bufferTransferCount,
+    const ThsvsBufferTransfer* pBufferTransfers,
+    uint32_t                   imageTransferCount,
+    const ThsvsImageTransfer*  pImageTransfers)
+{
+    VkBufferMemoryBarrier* pBufferMemoryBarriers    = NULL;
+    VkImageMemoryBarrier*  pImageMemoryBarriers     = NULL;
+    VkPipelineStageFlags   srcStageMask             = 0;
+    VkPipelineStageFlags   dstStageMask             = 0;
+    uint32_t               bufferMemoryBarrierCount = 0;
+    uint32_t               imageMemoryBarrierCount  = 0;
+
+    if (bufferTransferCount > 0)
+        pBufferMemoryBarriers = (VkBufferMemoryBarrier*)THSVS_TEMP_ALLOC(sizeof(VkBufferMemoryBarrier) * bufferTransferCount);
+
+    if (imageTransferCount > 0)
+        pImageMemoryBarriers = (VkImageMemoryBarrier*)THSVS_TEMP_ALLOC(sizeof(VkImageMemoryBarrier) * imageTransferCount);
+
+    for (uint32_t i = 0; i < bufferTransferCount; ++i)
+    {
+        VkPipelineStageFlags tempSrcStageMask = 0;
+        VkPipelineStageFlags tempDstStageMask = 0;
+        VkBool32 needed = release ?
+            thsvsGetVulkanBufferReleaseBarrier(pBufferTransfers[i], &tempSrcStageMask, &tempDstStageMask, &pBufferMemoryBarriers[bufferMemoryBarrierCount]) :
+            thsvsGetVulkanBufferAcquireBarrier(pBufferTransfers[i], &tempSrcStageMask, &tempDstStageMask, &pBufferMemoryBarriers[bufferMemoryBarrierCount]);
+
+        if (needed == VK_TRUE)
+        {
+            srcStageMask |= tempSrcStageMask;
+            dstStageMask |= tempDstStageMask;
+            bufferMemoryBarrierCount++;
+        }
+    }
+
+    for (uint32_t i = 0; i < imageTransferCount; ++i)
+    {
+        VkPipelineStageFlags tempSrcStageMask = 0;
+        VkPipelineStageFlags tempDstStageMask = 0;
+        VkBool32 needed = release ?
+            thsvsGetVulkanImageReleaseBarrier(pImageTransfers[i], &tempSrcStageMask, &tempDstStageMask, &pImageMemoryBarriers[imageMemoryBarrierCount]) :
+            thsvsGetVulkanImageAcquireBarrier(pImageTransfers[i], &tempSrcStageMask, &tempDstStageMask, &pImageMemoryBarriers[imageMemoryBarrierCount]);
+
+        if (needed == VK_TRUE)
+        {
+            srcStageMask |= tempSrcStageMask;
+            dstStageMask |= tempDstStageMask;
+            imageMemoryBarrierCount++;
+        }
+    }
+
+    if (bufferMemoryBarrierCount > 0 || imageMemoryBarrierCount > 0)
+    {
+#ifdef THSVS_STATS
+        thsvsInstrumentBarrier(commandBuffer, release ? "thsvsCmdReleaseOwnership" : "thsvsCmdAcquireOwnership", false,
+                               srcStageMask, dstStageMask, 0, bufferMemoryBarrierCount, pBufferMemoryBarriers,
+                               imageMemoryBarrierCount, pImageMemoryBarriers);
+#endif
+
+#ifdef THSVS_CAPTURE
+        thsvsCaptureVulkanBarriers(srcStageMask, dstStageMask, 0, NULL, bufferMemoryBarrierCount, pBufferMemoryBarriers,
+                                   imageMemoryBarrierCount, pImageMemoryBarriers);
+#endif
+
+#ifdef THSVS_DIAGNOSTICS
+        thsvsDiagnoseSequence(commandBuffer, true);
+#endif
+
+#ifdef THSVS_PROFILE
+        bool profiled = thsvsProfileBeginVulkanBarrier(commandBuffer, imageMemoryBarrierCount, pImageMemoryBarriers);
+#endif
+
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            srcStageMask,
+            dstStageMask,
+            0,
+            0,
+            NULL,
+            bufferMemoryBarrierCount,
+            pBufferMemoryBarriers,
+            imageMemoryBarrierCount,
+            pImageMemoryBarriers);
+
+#ifdef THSVS_PROFILE
+        if (profiled)
+            thsvsProfileEndBarrier(commandBuffer);
+#endif
+    }
+
+    THSVS_TEMP_FREE(pBufferMemoryBarriers);
+    THSVS_TEMP_FREE(pImageMemoryBarriers);
+}
+
+void thsvsCmdReleaseOwnership(
+    VkCommandBuffer            commandBuffer,
+    uint32_t                   bufferTransferCount,
+    const ThsvsBufferTransfer* pBufferTransfers,
+    uint32_t                   imageTransferCount,
+    const ThsvsImageTransfer*  pImageTransfers)
+{
+    thsvsCmdOwnershipTransfer(commandBuffer, true, bufferTransferCount, pBufferTransfers, imageTransferCount, pImageTransfers);
+}
+
+void thsvsCmdAcquireOwnership(
+    VkCommandBuffer            commandBuffer,
+    uint32_t                   bufferTransferCount,
+    const ThsvsBufferTransfer* pBufferTransfers,
+    uint32_t                   imageTransferCount,
+    const ThsvsImageTransfer*  pImageTransfers)
+{
+    thsvsCmdOwnershipTransfer(commandBuffer, false, bufferTransferCount, pBufferTransfers, imageTransferCount, pImageTransfers);
+}
+
+VkBool32 thsvsGetVulkanAliasingBarrier(
+    const ThsvsAliasingBarrier& thBarrier,
+    VkPipelineStageFlags*       pSrcStages,
+    VkPipelineStageFlags*       pDstStages,
+    VkMemoryBarrier*            pMemoryBarrier,
+    VkImageMemoryBarrier*       pImageBarrier)
+{
+    ThsvsGlobalBarrier globalBarrier;
+    globalBarrier.prevAccessCount = thBarrier.prevAccessCount;
+    globalBarrier.pPrevAccesses   = thBarrier.pPrevAccesses;
+    globalBarrier.nextAccessCount = thBarrier.nextAccessCount;
+    globalBarrier.pNextAccesses   = thBarrier.pNextAccesses;
+
+    VkBool32 needed = thsvsGetVulkanMemoryBarrier(globalBarrier, pSrcStages, pDstStages, pMemoryBarrier);
+
+    if (thBarrier.image != VK_NULL_HANDLE)
+    {
+        VkPipelineStageFlags nextStageMask;
+        VkAccessFlags        nextAccessMask;
+        VkImageLayout        nextImageLayout;
+        bool                 nextHasWriteAccess;
+        thsvsGetAccessInfo(thBarrier.nextAccessCount, thBarrier.pNextAccesses, &nextStageMask, &nextAccessMask, &nextImageLayout, &nextHasWriteAccess);
+
+        pImageBarrier->sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        pImageBarrier->pNext               = NULL;
+
+        // The outgoing resource's writes are made available by the memory barrier; the transition makes itself visible
+        pImageBarrier->srcAccessMask       = 0;
+        pImageBarrier->dstAccessMask       = nextAccessMask;
+        pImageBarrier->oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED;
+        pImageBarrier->newLayout           = thsvsSelectAspectImageLayout(thsvsGetVulkanImageLayout(thBarrier.nextAccessCount, thBarrier.pNextAccesses, thBarrier.nextLayout),
+                                                                          thBarrier.nextLayout, thBarrier.subresourceRange.aspectMask);
+        pImageBarrier->srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        pImageBarrier->dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        pImageBarrier->image               = thBarrier.image;
+        pImageBarrier->subresourceRange    = thBarrier.subresourceRange;
+
+        // The layout transition is a write, so the barrier is always needed
+        needed = VK_TRUE;
+    }
+
+    return needed;
+}
+
+void thsvsCmdAliasingBarrier(
+    VkCommandBuffer             commandBuffer,
+    uint32_t                    aliasingBarrierCount,
+    const ThsvsAliasingBarrier* pAliasingBarriers)
+{
+    VkMemoryBarrier       memoryBarrier;
+    VkImageMemoryBarrier* pImageMemoryBarriers    = NULL;
+    VkPipelineStageFlags  srcStageMask            = 0;
+    VkPipelineStageFlags  dstStageMask            = 0;
+    uint32_t              imageMemoryBarrierCount = 0;
+    bool                  needed                  = false;
+
+    memoryBarrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    memoryBarrier.pNext         = NULL;
+    memoryBarrier.srcAccessMask = 0;
+    memoryBarrier.dstAccessMask = 0;
+
+    if (aliasingBarrierCount > 0)
+        pImageMemoryBarriers = (VkImageMemoryBarrier*)THSVS_TEMP_ALLOC(sizeof(VkImageMemoryBarrier) * aliasingBarrierCount);
+
+    for (uint32_t i = 0; i < aliasingBarrierCount; ++i)
+    {
+        VkPipelineStageFlags tempSrcStageMask = 0;
+        VkPipelineStageFlags tempDstStageMask = 0;
+        VkMemoryBarrier      tempMemoryBarrier;
+
+        if (thsvsGetVulkanAliasingBarrier(pAliasingBarriers[i], &tempSrcStageMask, &tempDstStageMask,
+                                          &tempMemoryBarrier, &pImageMemoryBarriers[imageMemoryBarrierCount]) == VK_TRUE)
+        {
+            srcStageMask |= tempSrcStageMask;
+            dstStageMask |= tempDstStageMask;
+            memoryBarrier.srcAccessMask |= tempMemoryBarrier.srcAccessMask;
+            memoryBarrier.dstAccessMask |= tempMemoryBarrier.dstAccessMask;
+            needed = true;
+
+            if (pAliasingBarriers[i].image != VK_NULL_HANDLE)
+                imageMemoryBarrierCount++;
+        }
+    }
+
+    if (needed)
+    {
+        bool hasMemoryBarrier = memoryBarrier.srcAccessMask != 0 || memoryBarrier.dstAccessMask != 0;
+
+#ifdef THSVS_STATS
+        thsvsInstrumentBarrier(commandBuffer, "thsvsCmdAliasingBarrier", false, srcStageMask, dstStageMask,
+                               hasMemoryBarrier ? 1 : 0, 0, NULL, imageMemoryBarrierCount, pImageMemoryBarriers);
+#endif
+
+#ifdef THSVS_CAPTURE
+        thsvsCaptureVulkanBarriers(srcStageMask, dstStageMask, hasMemoryBarrier ? 1 : 0, &memoryBarrier,
+                                   0, NULL, imageMemoryBarrierCount, pImageMemoryBarriers);
+#endif
+
+#ifdef THSVS_DIAGNOSTICS
+        thsvsDiagnoseSequence(commandBuffer, true);
+#endif
+
+#ifdef THSVS_PROFILE
+        bool profiled = thsvsProfileBeginVulkanBarrier(commandBuffer, imageMemoryBarrierCount, pImageMemoryBarriers);
+#endif
+
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            srcStageMask,
+            dstStageMask,
+            0,
+            hasMemoryBarrier ? 1 : 0,
+            hasMemoryBarrier ? &memoryBarrier : NULL,
+            0,
+            NULL,
+            imageMemoryBarrierCount,
+            pImageMemoryBarriers);
+
+#ifdef THSVS_PROFILE
+        if (profiled)
+            thsvsProfileEndBarrier(commandBuffer);
+#endif
+    }
+
+    THSVS_TEMP_FREE(pImageMemoryBarriers);
+}
+
+VkPipelineStageFlags thsvsGetSemaphoreWaitStageMask(
+    uint32_t                    nextAccessCount,
+    const ThsvsAccessType*      pNextAccesses)
+{
+    VkPipelineStageFlags stageMask;
+    VkAccessFlags        accessMask;
+    VkImageLayout        imageLayout;
+    bool                 hasWriteAccess;
+    thsvsGetAccessInfo(nextAccessCount, pNextAccesses, &stageMask, &accessMask, &imageLayout, &hasWriteAccess);
+
+    // Ensure that the stage mask is valid if no stages were determined
+    if (stageMask == 0)
+        stageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+    return stageMask;
+}
+
+void thsvsInitContext(
+    ThsvsContext*             pContext,
+    void*                     pScratchMemory,
+    size_t                    scratchSize,
+    uint32_t                  accessSetCacheCapacity,
+    ThsvsCachedAccessSet*     pAccessSetCache)
+{
+    thsvsInitScratch(&pContext->scratch, pScratchMemory, scratchSize);
+
+    // Lookups mask the hash with the capacity - 1, so only a power of two of the entries can be used
+    while ((accessSetCacheCapacity & (accessSetCacheCapacity - 1)) != 0)
+        accessSetCacheCapacity &= accessSetCacheCapacity - 1;
+
+    pContext->accessSetCacheCapacity = accessSetCacheCapacity;
+    pContext->accessSetCacheCount    = 0;
+    pContext->pAccessSetCache        = pAccessSetCache;
+
+    // An empty access mask marks an unused entry, as it's never added to the cache
+    for (uint32_t i = 0; i < accessSetCacheCapacity; ++i)
+    {
+        pAccessSetCache[i].accesses.bits[0] = 0;
+        pAccessSetCache[i].accesses.bits[1] = 0;
+    }
+
+    pContext->stats.pipelineBarrierCount     = 0;
+    pContext->stats.waitEventsCount          = 0;
+    pContext->stats.memoryBarrierCount       = 0;
+    pContext->stats.bufferMemoryBarrierCount = 0;
+    pContext->stats.imageMemoryBarrierCount  = 0;
+    pContext->stats.layoutTransitionCount    = 0;
+    pContext->stats.queueTransferCount       = 0;
+    pContext->stats.broadStageMaskCount      = 0;
+    pContext->stats.accessSetCacheHitCount   = 0;
+    pContext->stats.accessSetCacheMissCount  = 0;
+}
+
+void thsvsResetContext(
+    ThsvsContext*             pContext)
+{
+    thsvsResetScratch(&pContext->scratch);
+}
+
+const ThsvsAccessSet* thsvsContextGetAccessSet(
+    ThsvsContext*             pContext,
+    uint32_t                  accessCount,
+    const ThsvsAccessType*    pAccesses)
+{
+    ThsvsAccessMask accesses;
+    thsvsMakeAccessMask(accessCount, pAccesses, &accesses);
+
+    ThsvsCachedAccessSet* pEntry = NULL;
+
+    // Keep the cache at most three quarters full, so probe sequences stay short
+    bool canInsert = (pContext->accessSetCacheCount + 1) * 4 <= pContext->accessSetCacheCapacity * 3;
+
+    if (pContext->accessSetCacheCapacity > 0 && (accesses.bits[0] | accesses.bits[1]) != 0)
+    {
+        uint64_t folded = accesses.bits[0] ^ (accesses.bits[1] << 1);
+        uint32_t hash   = ((uint32_t)folded ^ (uint32_t)(folded >> 32)) * 0x9E3779B1u;
+        uint32_t mask   = pContext->accessSetCacheCapacity - 1;
+        uint32_t index  = (hash ^ (hash >> 16)) & mask;
+
+        // Linear probing - the cache is never full, so this always ends at a match or an unused entry
+        for (uint32_t probe = 0; probe <= mask; ++probe, index = (index + 1) & mask)
+        {
+            ThsvsCachedAccessSet* pCandidate = &pContext->pAccessSetCache[index];
+            if (pCandidate->accesses.bits[0] == accesses.bits[0] && pCandidate->accesses.bits[1] == accesses.bits[1])
+            {
+                pContext->stats.accessSetCacheHitCount++;
+                return &pCandidate->accessSet;
+            }
+
+            if ((pCandidate->accesses.bits[0] | pCandidate->accesses.bits[1]) == 0)
+            {
+                if (canInsert)
+                    pEntry = pCandidate;
+                break;
+            }
+        }
+    }
 
-    // THSVS_ACCESS_COMPUTE_SHADER_WRITE
-    {   VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-        VK_ACCESS_SHADER_WRITE_BIT,
-        VK_IMAGE_LAYOUT_GENERAL},
+    pContext->stats.accessSetCacheMissCount++;
 
-    // THSVS_ACCESS_ANY_SHADER_WRITE
-    {   VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-        VK_ACCESS_SHADER_WRITE_BIT,
-        VK_IMAGE_LAYOUT_GENERAL},
+    ThsvsAccessSet* pAccessSet;
+    if (pEntry != NULL)
+    {
+        pEntry->accesses = accesses;
+        pContext->accessSetCacheCount++;
+        pAccessSet = &pEntry->accessSet;
+    }
+    else
+    {
+        pAccessSet = (ThsvsAccessSet*)thsvsScratchAlloc(&pContext->scratch, sizeof(ThsvsAccessSet));
 
-    // THSVS_ACCESS_TRANSFER_WRITE
-    {   VK_PIPELINE_STAGE_TRANSFER_BIT,
-        VK_ACCESS_TRANSFER_WRITE_BIT,
-        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL},
-    // THSVS_ACCESS_HOST_PREINITIALIZED
-    {   VK_PIPELINE_STAGE_HOST_BIT,
-        VK_ACCESS_HOST_WRITE_BIT,
-        VK_IMAGE_LAYOUT_PREINITIALIZED},
-    // THSVS_ACCESS_HOST_WRITE
-    {   VK_PIPELINE_STAGE_HOST_BIT,
-        VK_ACCESS_HOST_WRITE_BIT,
-        VK_IMAGE_LAYOUT_GENERAL},
-    // THSVS_ACCESS_ACCELERATION_STRUCTURE_BUILD_WRITE_NV
-    {   VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_NV,
-        VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_NV,
-        VK_IMAGE_LAYOUT_UNDEFINED},
+#ifdef THSVS_ERROR_CHECK_SCRATCH_OVERFLOW
+        // Asserts that there was space for the access set
+        assert(pAccessSet != NULL);
+#endif
 
-    // THSVS_ACCESS_COLOR_ATTACHMENT_READ_WRITE
-    {   VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-        VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
-        VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL},
-    // THSVS_ACCESS_GENERAL
-    {   VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-        VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT,
-        VK_IMAGE_LAYOUT_GENERAL}
-};
+        if (pAccessSet == NULL)
+            return NULL;
+    }
 
-void thsvsGetAccessInfo(
-    uint32_t               accessCount,
-    const ThsvsAccessType* pAccesses,
-    VkPipelineStageFlags*  pStageMask,
-    VkAccessFlags*         pAccessMask,
-    VkImageLayout*         pImageLayout,
-    bool*                  pHasWriteAccess)
+    thsvsCompileAccessMask(accesses, pAccessSet);
+    return pAccessSet;
+}
+
+void thsvsContextCmdPipelineBarrier(
+    ThsvsContext*             pContext,
+    VkCommandBuffer           commandBuffer,
+    const ThsvsGlobalBarrier* pGlobalBarrier,
+    uint32_t                  bufferBarrierCount,
+    const ThsvsBufferBarrier* pBufferBarriers,
+    uint32_t                  imageBarrierCount,
+    const ThsvsImageBarrier*  pImageBarriers)
 {
-    *pStageMask   = 0;
-    *pAccessMask  = 0;
-    *pImageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    *pHasWriteAccess = false;
+    thsvsRecordPipelineBarrier(commandBuffer, &pContext->scratch, &pContext->stats, pGlobalBarrier,
+                               bufferBarrierCount, pBufferBarriers, imageBarrierCount, pImageBarriers);
+}
 
-    for (uint32_t i = 0; i < accessCount; ++i)
+void thsvsMergeContextStats(
+    ThsvsContext*             pContext,
+    ThsvsContextStats*        pTotalStats)
+{
+    ThsvsContextStats* pStats = &pContext->stats;
+
+    pTotalStats->pipelineBarrierCount     += pStats->pipelineBarrierCount;
+    pTotalStats->waitEventsCount          += pStats->waitEventsCount;
+    pTotalStats->memoryBarrierCount       += pStats->memoryBarrierCount;
+    pTotalStats->bufferMemoryBarrierCount += pStats->bufferMemoryBarrierCount;
+    pTotalStats->imageMemoryBarrierCount  += pStats->imageMemoryBarrierCount;
+    pTotalStats->layoutTransitionCount    += pStats->layoutTransitionCount;
+    pTotalStats->queueTransferCount       += pStats->queueTransferCount;
+    pTotalStats->broadStageMaskCount      += pStats->broadStageMaskCount;
+    pTotalStats->accessSetCacheHitCount   += pStats->accessSetCacheHitCount;
+    pTotalStats->accessSetCacheMissCount  += pStats->accessSetCacheMissCount;
+
+    pStats->pipelineBarrierCount     = 0;
+    pStats->waitEventsCount          = 0;
+    pStats->memoryBarrierCount       = 0;
+    pStats->bufferMemoryBarrierCount = 0;
+    pStats->imageMemoryBarrierCount  = 0;
+    pStats->layoutTransitionCount    = 0;
+    pStats->queueTransferCount       = 0;
+    pStats->broadStageMaskCount      = 0;
+    pStats->accessSetCacheHitCount   = 0;
+    pStats->accessSetCacheMissCount  = 0;
+}
+
+void thsvsInitLocalBufferState(
+    ThsvsLocalBufferState*  pLocalState,
+    VkBuffer                buffer,
+    VkDeviceSize            offset,
+    VkDeviceSize            size)
+{
+    thsvsInitBufferState(&pLocalState->state, buffer, offset, size);
+    thsvsCompileAccessSet(0, NULL, &pLocalState->firstAccessSet);
+    pLocalState->modified = VK_FALSE;
+}
+
+void thsvsInitLocalImageState(
+    ThsvsLocalImageState*   pLocalState,
+    VkImage                 image,
+    VkImageSubresourceRange subresourceRange)
+{
+    thsvsInitImageState(&pLocalState->state, image, subresourceRange, VK_IMAGE_LAYOUT_UNDEFINED);
+    thsvsCompileAccessSet(0, NULL, &pLocalState->firstAccessSet);
+    pLocalState->firstLayout          = VK_IMAGE_LAYOUT_UNDEFINED;
+    pLocalState->firstDiscardContents = VK_FALSE;
+    pLocalState->modified             = VK_FALSE;
+}
+
+/*
+Shared logic for local buffer and image state transitions.
+Until the first write or layout change, accesses are gathered into the first
+access set without a barrier; after that, this is just thsvsTransitionState.
+*/
+static bool thsvsTransitionLocalState(
+    ThsvsAccessSet*         pFirstAccessSet,
+    VkBool32*               pModified,
+    VkPipelineStageFlags*   pWriteStageMask,
+    VkAccessFlags*          pWriteAccessMask,
+    VkPipelineStageFlags*   pReadStageMask,
+    VkAccessFlags*          pReadAccessMask,
+    const ThsvsAccessSet&   nextAccessSet,
+    bool                    layoutTransition,
+    VkPipelineStageFlags*   pSrcStages,
+    VkPipelineStageFlags*   pDstStages,
+    VkAccessFlags*          pSrcAccessMask,
+    VkAccessFlags*          pDstAccessMask)
+{
+    if (*pModified == VK_FALSE)
     {
-        ThsvsAccessType access = pAccesses[i];
-        const ThsvsVkAccessInfo* pAccessInfo = &ThsvsAccessMap[access];
+        if (pFirstAccessSet->stageMask == 0)
+        {
+            // The first access - waiting on the primary is left to the merge
+            *pFirstAccessSet = nextAccessSet;
+            *pModified       = nextAccessSet.hasWriteAccess;
+
+            *pWriteStageMask  = nextAccessSet.hasWriteAccess ? nextAccessSet.stageMask : 0;
+            *pWriteAccessMask = nextAccessSet.writeAccessMask;
+            *pReadStageMask   = nextAccessSet.hasWriteAccess ? 0 : nextAccessSet.stageMask;
+            *pReadAccessMask  = nextAccessSet.hasWriteAccess ? 0 : nextAccessSet.accessMask;
+            return false;
+        }
 
-#ifdef THSVS_ERROR_CHECK_ACCESS_TYPE_IN_RANGE
-        // Asserts that the previous access index is a valid range for the lookup
-        assert(access < THSVS_NUM_ACCESS_TYPES);
-#endif
+        if (!nextAccessSet.hasWriteAccess && !layoutTransition)
+        {
+            // Leading reads in the same layout all wait on the primary together
+            pFirstAccessSet->stageMask  |= nextAccessSet.stageMask;
+            pFirstAccessSet->accessMask |= nextAccessSet.accessMask;
 
-#ifdef THSVS_ERROR_CHECK_POTENTIAL_HAZARD
-        // Asserts that the access is a read, else it's a write and it should appear on its own.
-        assert(access < THSVS_END_OF_READ_ACCESS || accessCount == 1);
-#endif
+            *pReadStageMask  |= nextAccessSet.stageMask;
+            *pReadAccessMask |= nextAccessSet.accessMask;
+            return false;
+        }
 
-        *pStageMask |= pAccessInfo->stageMask;
+        *pModified = VK_TRUE;
+    }
 
-        if (access > THSVS_END_OF_READ_ACCESS)
-            *pHasWriteAccess = true;
+    return thsvsTransitionState(pWriteStageMask, pWriteAccessMask, pReadStageMask, pReadAccessMask,
+                                nextAccessSet, layoutTransition,
+                                pSrcStages, pDstStages, pSrcAccessMask, pDstAccessMask);
+}
 
-        *pAccessMask |= pAccessInfo->accessMask;
+VkBool32 thsvsTransitionLocalBufferState(
+    ThsvsLocalBufferState*  pLocalState,
+    uint32_t                nextAccessCount,
+    const ThsvsAccessType*  pNextAccesses,
+    VkPipelineStageFlags*   pSrcStages,
+    VkPipelineStageFlags*   pDstStages,
+    VkBufferMemoryBarrier*  pVkBarrier)
+{
+    ThsvsBufferState* pState = &pLocalState->state;
 
-        VkImageLayout layout = pAccessInfo->imageLayout;
+    ThsvsAccessSet nextAccessSet;
+    thsvsCompileAccessSet(nextAccessCount, pNextAccesses, &nextAccessSet);
 
-#ifdef THSVS_ERROR_CHECK_MIXED_IMAGE_LAYOUT
-        assert(*pImageLayout == VK_IMAGE_LAYOUT_UNDEFINED ||
-               *pImageLayout == layout);
-#endif
+    VkAccessFlags srcAccessMask = 0;
+    VkAccessFlags dstAccessMask = 0;
+    if (!thsvsTransitionLocalState(&pLocalState->firstAccessSet, &pLocalState->modified,
+                                   &pState->writeStageMask, &pState->writeAccessMask,
+                                   &pState->readStageMask, &pState->readAccessMask,
+                                   nextAccessSet, false,
+                                   pSrcStages, pDstStages, &srcAccessMask, &dstAccessMask))
+        return VK_FALSE;
 
-        *pImageLayout = layout;
-    }
+    pVkBarrier->sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    pVkBarrier->pNext               = NULL;
+    pVkBarrier->srcAccessMask       = srcAccessMask;
+    pVkBarrier->dstAccessMask       = dstAccessMask;
+    pVkBarrier->srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    pVkBarrier->dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    pVkBarrier->buffer              = pState->buffer;
+    pVkBarrier->offset              = pState->offset;
+    pVkBarrier->size                = pState->size;
+
+    return VK_TRUE;
 }
 
-void thsvsGetVulkanMemoryBarrier(
-    const ThsvsGlobalBarrier& thBarrier,
-    VkPipelineStageFlags*     pSrcStages,
-    VkPipelineStageFlags*     pDstStages,
-    VkMemoryBarrier*          pVkBarrier)
+VkBool32 thsvsTransitionLocalImageState(
+    ThsvsLocalImageState*   pLocalState,
+    uint32_t                nextAccessCount,
+    const ThsvsAccessType*  pNextAccesses,
+    ThsvsImageLayout        nextLayout,
+    VkBool32                discardContents,
+    VkPipelineStageFlags*   pSrcStages,
+    VkPipelineStageFlags*   pDstStages,
+    VkImageMemoryBarrier*   pVkBarrier)
 {
-    *pSrcStages               = 0;
-    *pDstStages               = 0;
-    pVkBarrier->sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
-    pVkBarrier->pNext         = NULL;
-    pVkBarrier->srcAccessMask = 0;
-    pVkBarrier->dstAccessMask = 0;
+    ThsvsImageState* pState = &pLocalState->state;
+
+    ThsvsAccessSet nextAccessSet;
+    thsvsCompileAccessSet(nextAccessCount, pNextAccesses, &nextAccessSet);
 
-    for (uint32_t i = 0; i < thBarrier.prevAccessCount; ++i)
+    VkImageLayout newLayout = thsvsSelectAspectImageLayout(nextAccessSet.imageLayouts[nextLayout], nextLayout, pState->subresourceRange.aspectMask);
+
+    if (pLocalState->firstAccessSet.stageMask == 0)
     {
-        ThsvsAccessType prevAccess = thBarrier.pPrevAccesses[i];
-        const ThsvsVkAccessInfo* pPrevAccessInfo = &ThsvsAccessMap[prevAccess];
+        // The layout the primary needs to transition to before the secondary executes
+        pLocalState->firstLayout          = newLayout;
+        pLocalState->firstDiscardContents = discardContents;
+        pState->layout                    = newLayout;
+    }
 
-#ifdef THSVS_ERROR_CHECK_ACCESS_TYPE_IN_RANGE
-        // Asserts that the previous access index is a valid range for the lookup
-        assert(prevAccess < THSVS_NUM_ACCESS_TYPES);
-#endif
+    VkImageLayout oldLayout = (discardContents == VK_TRUE) ? VK_IMAGE_LAYOUT_UNDEFINED : pState->layout;
+    bool layoutTransition = (oldLayout != newLayout) || discardContents == VK_TRUE;
 
-#ifdef THSVS_ERROR_CHECK_POTENTIAL_HAZARD
-        // Asserts that the access is a read, else it's a write and it should appear on its own.
-        assert(prevAccess < THSVS_END_OF_READ_ACCESS || thBarrier.prevAccessCount == 1);
-#endif
+    VkAccessFlags srcAccessMask = 0;
+    VkAccessFlags dstAccessMask = 0;
+    if (!thsvsTransitionLocalState(&pLocalState->firstAccessSet, &pLocalState->modified,
+                                   &pState->writeStageMask, &pState->writeAccessMask,
+                                   &pState->readStageMask, &pState->readAccessMask,
+                                   nextAccessSet, layoutTransition,
+                                   pSrcStages, pDstStages, &srcAccessMask, &dstAccessMask))
+        return VK_FALSE;
+
+    pState->layout = newLayout;
+
+    pVkBarrier->sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    pVkBarrier->pNext               = NULL;
+    pVkBarrier->srcAccessMask       = srcAccessMask;
+    pVkBarrier->dstAccessMask       = dstAccessMask;
+    pVkBarrier->oldLayout           = oldLayout;
+    pVkBarrier->newLayout           = newLayout;
+    pVkBarrier->srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    pVkBarrier->dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    pVkBarrier->image               = pState->image;
+    pVkBarrier->subresourceRange    = pState->subresourceRange;
+
+    return VK_TRUE;
+}
+
+/*
+Shared logic for merging local buffer and image states.
+The first accesses of the local state are transitioned in the primary's
+state, and if the secondary did anything beyond those, its own state then
+replaces the primary's.
+*/
+static bool thsvsMergeState(
+    VkPipelineStageFlags*   pWriteStageMask,
+    VkAccessFlags*          pWriteAccessMask,
+    VkPipelineStageFlags*   pReadStageMask,
+    VkAccessFlags*          pReadAccessMask,
+    const ThsvsAccessSet&   firstAccessSet,
+    VkBool32                modified,
+    VkPipelineStageFlags    localWriteStageMask,
+    VkAccessFlags           localWriteAccessMask,
+    VkPipelineStageFlags    localReadStageMask,
+    VkAccessFlags           localReadAccessMask,
+    bool                    layoutTransition,
+    VkPipelineStageFlags*   pSrcStages,
+    VkPipelineStageFlags*   pDstStages,
+    VkAccessFlags*          pSrcAccessMask,
+    VkAccessFlags*          pDstAccessMask)
+{
+    // If the secondary goes on to write, its barriers only wait on its first accesses - so those have to wait on
+    // every read in the primary, not just the last write, which is exactly what a layout transition does
+    bool primaryAccessed = (*pWriteStageMask | *pReadStageMask) != 0;
+    bool needed = thsvsTransitionState(pWriteStageMask, pWriteAccessMask, pReadStageMask, pReadAccessMask,
+                                       firstAccessSet, layoutTransition || (modified == VK_TRUE && primaryAccessed),
+                                       pSrcStages, pDstStages, pSrcAccessMask, pDstAccessMask);
+
+    if (modified == VK_TRUE)
+    {
+        *pWriteStageMask  = localWriteStageMask;
+        *pWriteAccessMask = localWriteAccessMask;
+        *pReadStageMask   = localReadStageMask;
+        *pReadAccessMask  = localReadAccessMask;
+    }
+
+    return needed;
+}
+
+VkBool32 thsvsMergeBufferState(
+    ThsvsBufferState*            pState,
+    const ThsvsLocalBufferState* pLocalState,
+    VkPipelineStageFlags*        pSrcStages,
+    VkPipelineStageFlags*        pDstStages,
+    VkBufferMemoryBarrier*       pVkBarrier)
+{
+    if (pLocalState->firstAccessSet.stageMask == 0)
+        return VK_FALSE;
+
+    VkAccessFlags srcAccessMask = 0;
+    VkAccessFlags dstAccessMask = 0;
+    if (!thsvsMergeState(&pState->writeStageMask, &pState->writeAccessMask,
+                         &pState->readStageMask, &pState->readAccessMask,
+                         pLocalState->firstAccessSet, pLocalState->modified,
+                         pLocalState->state.writeStageMask, pLocalState->state.writeAccessMask,
+                         pLocalState->state.readStageMask, pLocalState->state.readAccessMask, false,
+                         pSrcStages, pDstStages, &srcAccessMask, &dstAccessMask))
+        return VK_FALSE;
+
+    pVkBarrier->sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    pVkBarrier->pNext               = NULL;
+    pVkBarrier->srcAccessMask       = srcAccessMask;
+    pVkBarrier->dstAccessMask       = dstAccessMask;
+    pVkBarrier->srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    pVkBarrier->dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    pVkBarrier->buffer              = pState->buffer;
+    pVkBarrier->offset              = pState->offset;
+    pVkBarrier->size                = pState->size;
+
+    return VK_TRUE;
+}
+
+VkBool32 thsvsMergeImageState(
+    ThsvsImageState*             pState,
+    const ThsvsLocalImageState*  pLocalState,
+    VkPipelineStageFlags*        pSrcStages,
+    VkPipelineStageFlags*        pDstStages,
+    VkImageMemoryBarrier*        pVkBarrier)
+{
+    if (pLocalState->firstAccessSet.stageMask == 0)
+        return VK_FALSE;
+
+    VkImageLayout oldLayout = (pLocalState->firstDiscardContents == VK_TRUE) ? VK_IMAGE_LAYOUT_UNDEFINED : pState->layout;
+    VkImageLayout newLayout = pLocalState->firstLayout;
+    bool layoutTransition = (oldLayout != newLayout) || pLocalState->firstDiscardContents == VK_TRUE;
+
+    VkAccessFlags srcAccessMask = 0;
+    VkAccessFlags dstAccessMask = 0;
+    bool needed = thsvsMergeState(&pState->writeStageMask, &pState->writeAccessMask,
+                                  &pState->readStageMask, &pState->readAccessMask,
+                                  pLocalState->firstAccessSet, pLocalState->modified,
+                                  pLocalState->state.writeStageMask, pLocalState->state.writeAccessMask,
+                                  pLocalState->state.readStageMask, pLocalState->state.readAccessMask, layoutTransition,
+                                  pSrcStages, pDstStages, &srcAccessMask, &dstAccessMask);
+
+    pState->layout = (pLocalState->modified == VK_TRUE) ? pLocalState->state.layout : newLayout;
+
+    if (!needed)
+        return VK_FALSE;
+
+    pVkBarrier->sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    pVkBarrier->pNext               = NULL;
+    pVkBarrier->srcAccessMask       = srcAccessMask;
+    pVkBarrier->dstAccessMask       = dstAccessMask;
+    pVkBarrier->oldLayout           = oldLayout;
+    pVkBarrier->newLayout           = newLayout;
+    pVkBarrier->srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    pVkBarrier->dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    pVkBarrier->image               = pState->image;
+    pVkBarrier->subresourceRange    = pState->subresourceRange;
+
+    return VK_TRUE;
+}
+
+void thsvsBatchMergeBufferState(
+    ThsvsBarrierBatch*           pBatch,
+    ThsvsBufferState*            pState,
+    const ThsvsLocalBufferState* pLocalState)
+{
+    VkPipelineStageFlags  srcStageMask = 0;
+    VkPipelineStageFlags  dstStageMask = 0;
+    VkBufferMemoryBarrier bufferMemoryBarrier;
+
+    if (thsvsMergeBufferState(pState, pLocalState, &srcStageMask, &dstStageMask, &bufferMemoryBarrier) == VK_TRUE)
+        thsvsBatchBufferMemoryBarrier(pBatch, srcStageMask, dstStageMask, bufferMemoryBarrier);
+}
+
+void thsvsBatchMergeImageState(
+    ThsvsBarrierBatch*           pBatch,
+    ThsvsImageState*             pState,
+    const ThsvsLocalImageState*  pLocalState)
+{
+    VkPipelineStageFlags srcStageMask = 0;
+    VkPipelineStageFlags dstStageMask = 0;
+    VkImageMemoryBarrier imageMemoryBarrier;
 
-        *pSrcStages |= pPrevAccessInfo->stageMask;
+    if (thsvsMergeImageState(pState, pLocalState, &srcStageMask, &dstStageMask, &imageMemoryBarrier) == VK_TRUE)
+        thsvsBatchImageMemoryBarrier(pBatch, srcStageMask, dstStageMask, imageMemoryBarrier);
+}
+
+static bool thsvsSamePassState(
+    const ThsvsPassAccess& first,
+    const ThsvsPassAccess& second)
+{
+    return (first.pBufferState != NULL) ? first.pBufferState == second.pBufferState
+                                        : first.pImageState == second.pImageState;
+}
 
-        // Add appropriate availability operations - for writes only.
-        if (prevAccess > THSVS_END_OF_READ_ACCESS)
-            pVkBarrier->srcAccessMask |= pPrevAccessInfo->accessMask;
+// Returns true if either access writes to the state, or transitions its layout
+static bool thsvsPassAccessesConflict(
+    const ThsvsPassAccess& first,
+    const ThsvsPassAccess& second)
+{
+    for (uint32_t i = 0; i < first.accessCount; ++i)
+        if (first.pAccesses[i] > THSVS_END_OF_READ_ACCESS)
+            return true;
+
+    for (uint32_t i = 0; i < second.accessCount; ++i)
+        if (second.pAccesses[i] > THSVS_END_OF_READ_ACCESS)
+            return true;
+
+    if (first.pImageState != NULL)
+    {
+        return first.discardContents || second.discardContents ||
+               thsvsGetVulkanImageLayout(first.accessCount, first.pAccesses, first.layout) !=
+               thsvsGetVulkanImageLayout(second.accessCount, second.pAccesses, second.layout);
     }
 
-    for (uint32_t i = 0; i < thBarrier.nextAccessCount; ++i)
+    return false;
+}
+
+static bool thsvsPassDependsOn(
+    const ThsvsPass& pass,
+    const ThsvsPass& earlierPass)
+{
+    for (uint32_t i = 0; i < pass.accessCount; ++i)
     {
-        ThsvsAccessType nextAccess = thBarrier.pNextAccesses[i];
-        const ThsvsVkAccessInfo* pNextAccessInfo = &ThsvsAccessMap[nextAccess];
+        for (uint32_t j = 0; j < earlierPass.accessCount; ++j)
+        {
+            if (thsvsSamePassState(pass.pAccesses[i], earlierPass.pAccesses[j]) &&
+                thsvsPassAccessesConflict(earlierPass.pAccesses[j], pass.pAccesses[i]))
+                return true;
+        }
+    }
 
-#ifdef THSVS_ERROR_CHECK_ACCESS_TYPE_IN_RANGE
-        // Asserts that the next access index is a valid range for the lookup
-        assert(nextAccess < THSVS_NUM_ACCESS_TYPES);
-#endif
+    return false;
+}
 
-#ifdef THSVS_ERROR_CHECK_POTENTIAL_HAZARD
-        // Asserts that the access is a read, else it's a write and it should appear on its own.
-        assert(nextAccess < THSVS_END_OF_READ_ACCESS || thBarrier.nextAccessCount == 1);
-#endif
-        *pDstStages |= pNextAccessInfo->stageMask;
+uint32_t thsvsScheduleFrameGraph(
+    uint32_t                  passCount,
+    const ThsvsPass*          pPasses,
+    uint32_t*                 pPassOrder,
+    uint32_t*                 pPassLevels)
+{
+    uint32_t levelCount = 0;
+
+    // Each pass goes one level after the latest pass it depends on
+    for (uint32_t pass = 0; pass < passCount; ++pass)
+    {
+        uint32_t level = 0;
+
+        for (uint32_t earlierPass = 0; earlierPass < pass; ++earlierPass)
+        {
+            if (pPassLevels[earlierPass] + 1 > level && thsvsPassDependsOn(pPasses[pass], pPasses[earlierPass]))
+                level = pPassLevels[earlierPass] + 1;
+        }
 
-        // Add visibility operations as necessary.
-        // If the src access mask is zero, this is a WAR hazard (or for some reason a "RAR"),
-        // so the dst access mask can be safely zeroed as these don't need visibility.
-        if (pVkBarrier->srcAccessMask != 0)
-            pVkBarrier->dstAccessMask |= pNextAccessInfo->accessMask;
+        pPassLevels[pass] = level;
+        if (level + 1 > levelCount)
+            levelCount = level + 1;
     }
 
-    // Ensure that the stage masks are valid if no stages were determined
-    if (*pSrcStages == 0)
-        *pSrcStages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-    if (*pDstStages == 0)
-        *pDstStages = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+    // Stable sort by level, so that passes within a level keep their order
+    uint32_t orderCount = 0;
+    for (uint32_t level = 0; level < levelCount; ++level)
+    {
+        for (uint32_t pass = 0; pass < passCount; ++pass)
+        {
+            if (pPassLevels[pass] == level)
+                pPassOrder[orderCount++] = pass;
+        }
+    }
+
+    return levelCount;
 }
 
-void thsvsGetVulkanBufferMemoryBarrier(
-    const ThsvsBufferBarrier& thBarrier,
-    VkPipelineStageFlags*     pSrcStages,
-    VkPipelineStageFlags*     pDstStages,
-    VkBufferMemoryBarrier*    pVkBarrier)
+void thsvsCmdExecuteFrameGraph(
+    ThsvsBarrierBatch*        pBatch,
+    ThsvsScratch*             pScratch,
+    uint32_t                  passCount,
+    const ThsvsPass*          pPasses,
+    const uint32_t*           pPassOrder,
+    const uint32_t*           pPassLevels,
+    ThsvsRecordPassCallback   recordPass,
+    void*                     pUserData)
 {
-    *pSrcStages                     = 0;
-    *pDstStages                     = 0;
-    pVkBarrier->sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
-    pVkBarrier->pNext               = NULL;
-    pVkBarrier->srcAccessMask       = 0;
-    pVkBarrier->dstAccessMask       = 0;
-    pVkBarrier->srcQueueFamilyIndex = thBarrier.srcQueueFamilyIndex;
-    pVkBarrier->dstQueueFamilyIndex = thBarrier.dstQueueFamilyIndex;
-    pVkBarrier->buffer              = thBarrier.buffer;
-    pVkBarrier->offset              = thBarrier.offset;
-    pVkBarrier->size                = thBarrier.size;
+    size_t           scratchOffset       = (pScratch != NULL) ? pScratch->offset : 0;
+    ThsvsAccessType* pTempAccesses       = NULL;
+    ThsvsAccessType* pCombinedAccesses   = NULL;
+    uint32_t         combinedAccessCount = 0;
 
-#ifdef THSVS_ERROR_CHECK_COULD_USE_GLOBAL_BARRIER
-    assert(pVkBarrier->srcQueueFamilyIndex != pVkBarrier->dstQueueFamilyIndex);
-#endif
+    // Enough space for every access of a level to be combined for a single state
+    for (uint32_t pass = 0; pass < passCount; ++pass)
+        for (uint32_t i = 0; i < pPasses[pass].accessCount; ++i)
+            combinedAccessCount += pPasses[pass].pAccesses[i].accessCount;
 
-    for (uint32_t i = 0; i < thBarrier.prevAccessCount; ++i)
+    if (combinedAccessCount > 0)
+        THSVS_ALLOC_BARRIERS(ThsvsAccessType, combinedAccessCount, pScratch, pCombinedAccesses, pTempAccesses);
+
+    for (uint32_t levelBegin = 0; levelBegin < passCount;)
     {
-        ThsvsAccessType prevAccess = thBarrier.pPrevAccesses[i];
-        const ThsvsVkAccessInfo* pPrevAccessInfo = &ThsvsAccessMap[prevAccess];
+        uint32_t levelEnd = levelBegin + 1;
+        while (levelEnd < passCount && pPassLevels[pPassOrder[levelEnd]] == pPassLevels[pPassOrder[levelBegin]])
+            ++levelEnd;
 
-#ifdef THSVS_ERROR_CHECK_ACCESS_TYPE_IN_RANGE
-        // Asserts that the previous access index is a valid range for the lookup
-        assert(prevAccess < THSVS_NUM_ACCESS_TYPES);
-#endif
+        // Transition each state accessed in this level once, with the accesses of every pass in the level
+        for (uint32_t order = levelBegin; order < levelEnd; ++order)
+        {
+            const ThsvsPass& pass = pPasses[pPassOrder[order]];
 
-#ifdef THSVS_ERROR_CHECK_POTENTIAL_HAZARD
-        // Asserts that the access is a read, else it's a write and it should appear on its own.
-        assert(prevAccess < THSVS_END_OF_READ_ACCESS || thBarrier.prevAccessCount == 1);
-#endif
+            for (uint32_t i = 0; i < pass.accessCount; ++i)
+            {
+                const ThsvsPassAccess& access = pass.pAccesses[i];
+                bool transitioned = false;
+                uint32_t accessCount = 0;
+
+                for (uint32_t otherOrder = levelBegin; otherOrder <= order && !transitioned; ++otherOrder)
+                {
+                    const ThsvsPass& otherPass = pPasses[pPassOrder[otherOrder]];
+                    uint32_t otherAccessCount = (otherOrder == order) ? i : otherPass.accessCount;
+
+                    for (uint32_t j = 0; j < otherAccessCount; ++j)
+                        if (thsvsSamePassState(access, otherPass.pAccesses[j]))
+                            transitioned = true;
+                }
+
+                if (transitioned)
+                    continue;
+
+                for (uint32_t otherOrder = order; otherOrder < levelEnd; ++otherOrder)
+                {
+                    const ThsvsPass& otherPass = pPasses[pPassOrder[otherOrder]];
+
+                    for (uint32_t j = (otherOrder == order) ? i : 0; j < otherPass.accessCount; ++j)
+                    {
+                        const ThsvsPassAccess& otherAccess = otherPass.pAccesses[j];
+
+                        if (thsvsSamePassState(access, otherAccess))
+                        {
+                            for (uint32_t k = 0; k < otherAccess.accessCount; ++k)
+                                pCombinedAccesses[accessCount++] = otherAccess.pAccesses[k];
+                        }
+                    }
+                }
+
+                if (access.pBufferState != NULL)
+                    thsvsBatchBufferState(pBatch, access.pBufferState, accessCount, pCombinedAccesses);
+                else
+                    thsvsBatchImageState(pBatch, access.pImageState, accessCount, pCombinedAccesses, access.layout, access.discardContents);
+            }
+        }
+
+        thsvsCmdFlushBarrierBatch(pBatch);
 
-        *pSrcStages |= pPrevAccessInfo->stageMask;
+        for (uint32_t order = levelBegin; order < levelEnd; ++order)
+            recordPass(pBatch->commandBuffer, pPassOrder[order], pUserData);
 
-        // Add appropriate availability operations - for writes only.
-        if (prevAccess > THSVS_END_OF_READ_ACCESS)
-            pVkBarrier->srcAccessMask |= pPrevAccessInfo->accessMask;
+        levelBegin = levelEnd;
     }
 
-    for (uint32_t i = 0; i < thBarrier.nextAccessCount; ++i)
+    THSVS_TEMP_FREE(pTempAccesses);
+
+    if (pScratch != NULL)
+        pScratch->offset = scratchOffset;
+}
+
+#ifdef VK_VERSION_1_3
+// Accumulates the synchronization2 stages and accesses of a list of accesses, along with the accesses that write
+static void thsvsAccumulateAccessInfo2(
+    uint32_t               accessCount,
+    const ThsvsAccessType* pAccesses,
+    VkPipelineStageFlags2* pStageMask,
+    VkAccessFlags2*        pAccessMask,
+    VkAccessFlags2*        pWriteAccessMask,
+    bool*                  pHasWriteAccess)
+{
+    *pStageMask       = VK_PIPELINE_STAGE_2_NONE;
+    *pAccessMask      = VK_ACCESS_2_NONE;
+    *pWriteAccessMask = VK_ACCESS_2_NONE;
+    *pHasWriteAccess  = false;
+
+    for (uint32_t i = 0; i < accessCount; ++i)
     {
-        ThsvsAccessType nextAccess = thBarrier.pNextAccesses[i];
-        const ThsvsVkAccessInfo* pNextAccessInfo = &ThsvsAccessMap[nextAccess];
+        ThsvsAccessType access = pAccesses[i];
 
 #ifdef THSVS_ERROR_CHECK_ACCESS_TYPE_IN_RANGE
-        // Asserts that the next access index is a valid range for the lookup
-        assert(nextAccess < THSVS_NUM_ACCESS_TYPES);
+        // Asserts that the access index is a valid range for the lookup
+        assert(access < THSVS_NUM_ACCESS_TYPES);
 #endif
 
 #ifdef THSVS_ERROR_CHECK_POTENTIAL_HAZARD
         // Asserts that the access is a read, else it's a write and it should appear on its own.
-        assert(nextAccess < THSVS_END_OF_READ_ACCESS || thBarrier.nextAccessCount == 1);
+        assert(access < THSVS_END_OF_READ_ACCESS || accessCount == 1);
 #endif
 
-        *pDstStages |= pNextAccessInfo->stageMask;
+        const ThsvsVkAccessInfo2* pAccessInfo = &ThsvsAccessMap2[access];
+
+        *pStageMask  |= pAccessInfo->stageMask;
+        *pAccessMask |= pAccessInfo->accessMask;
+
+        if (access > THSVS_END_OF_READ_ACCESS)
+        {
+            *pWriteAccessMask |= pAccessInfo->accessMask;
+            *pHasWriteAccess = true;
+        }
+    }
+}
+
+// Determines the image layout of a list of accesses, or VK_IMAGE_LAYOUT_UNDEFINED if there are none
+static VkImageLayout thsvsGetAccessesImageLayout(
+    uint32_t               accessCount,
+    const ThsvsAccessType* pAccesses,
+    ThsvsImageLayout       imageLayout)
+{
+    VkImageLayout result = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    for (uint32_t i = 0; i < accessCount; ++i)
+    {
+        VkImageLayout layout = thsvsGetImageLayout(pAccesses[i], imageLayout);
+
+#ifdef THSVS_ERROR_CHECK_MIXED_IMAGE_LAYOUT
+        assert(result == VK_IMAGE_LAYOUT_UNDEFINED ||
+               result == layout);
+#endif
 
-        // Add visibility operations as necessary.
-        // If the src access mask is zero, this is a WAR hazard (or for some reason a "RAR"),
-        // so the dst access mask can be safely zeroed as these don't need visibility.
-        if (pVkBarrier->srcAccessMask != 0)
-            pVkBarrier->dstAccessMask |= pNextAccessInfo->accessMask;
+        result = layout;
     }
 
-    // Ensure that the stage masks are valid if no stages were determined
-    if (*pSrcStages == 0)
-        *pSrcStages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-    if (*pDstStages == 0)
-        *pDstStages = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+    return result;
+}
+
+void thsvsGetAccessInfo2(
+    uint32_t               accessCount,
+    const ThsvsAccessType* pAccesses,
+    VkPipelineStageFlags2* pStageMask,
+    VkAccessFlags2*        pAccessMask,
+    VkImageLayout*         pImageLayout,
+    bool*                  pHasWriteAccess)
+{
+    VkAccessFlags2 writeAccessMask;
+    thsvsAccumulateAccessInfo2(accessCount, pAccesses, pStageMask, pAccessMask, &writeAccessMask, pHasWriteAccess);
+    *pImageLayout = thsvsGetAccessesImageLayout(accessCount, pAccesses, THSVS_IMAGE_LAYOUT_OPTIMAL);
+}
+
+/*
+Fills in the stage and access masks shared by all synchronization2 barriers,
+returning whether the barrier needs to be recorded, given whether it
+transitions a layout or a queue family ownership.
+*/
+static VkBool32 thsvsGetVulkanBarrier2Masks(
+    uint32_t               prevAccessCount,
+    const ThsvsAccessType* pPrevAccesses,
+    uint32_t               nextAccessCount,
+    const ThsvsAccessType* pNextAccesses,
+    bool                   transition,
+    VkPipelineStageFlags2* pSrcStageMask,
+    VkAccessFlags2*        pSrcAccessMask,
+    VkPipelineStageFlags2* pDstStageMask,
+    VkAccessFlags2*        pDstAccessMask)
+{
+    VkAccessFlags2 prevAccessMask;
+    VkAccessFlags2 nextAccessMask;
+    VkAccessFlags2 nextWriteAccessMask;
+    bool           prevHasWriteAccess;
+    bool           nextHasWriteAccess;
+
+    thsvsAccumulateAccessInfo2(prevAccessCount, pPrevAccesses, pSrcStageMask, &prevAccessMask, pSrcAccessMask, &prevHasWriteAccess);
+    thsvsAccumulateAccessInfo2(nextAccessCount, pNextAccesses, pDstStageMask, &nextAccessMask, &nextWriteAccessMask, &nextHasWriteAccess);
+
+    // Visibility operations are only needed if something was made available
+    *pDstAccessMask = (*pSrcAccessMask != VK_ACCESS_2_NONE) ? nextAccessMask : VK_ACCESS_2_NONE;
+
+    return thsvsIsBarrierNeeded(prevHasWriteAccess, *pSrcStageMask != VK_PIPELINE_STAGE_2_NONE, nextHasWriteAccess, transition);
+}
+
+VkBool32 thsvsGetVulkanMemoryBarrier2(
+    const ThsvsGlobalBarrier& thBarrier,
+    VkMemoryBarrier2*         pVkBarrier)
+{
+    pVkBarrier->sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+    pVkBarrier->pNext = NULL;
+
+    return thsvsGetVulkanBarrier2Masks(
+        thBarrier.prevAccessCount, thBarrier.pPrevAccesses,
+        thBarrier.nextAccessCount, thBarrier.pNextAccesses,
+        false,
+        &pVkBarrier->srcStageMask, &pVkBarrier->srcAccessMask,
+        &pVkBarrier->dstStageMask, &pVkBarrier->dstAccessMask);
+}
+
+VkBool32 thsvsGetVulkanBufferMemoryBarrier2(
+    const ThsvsBufferBarrier& thBarrier,
+    VkBufferMemoryBarrier2*   pVkBarrier)
+{
+    pVkBarrier->sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
+    pVkBarrier->pNext               = NULL;
+    pVkBarrier->srcQueueFamilyIndex = thBarrier.srcQueueFamilyIndex;
+    pVkBarrier->dstQueueFamilyIndex = thBarrier.dstQueueFamilyIndex;
+    pVkBarrier->buffer              = thBarrier.buffer;
+    pVkBarrier->offset              = thBarrier.offset;
+    pVkBarrier->size                = thBarrier.size;
+
+#ifdef THSVS_ERROR_CHECK_COULD_USE_GLOBAL_BARRIER
+    assert(pVkBarrier->srcQueueFamilyIndex != pVkBarrier->dstQueueFamilyIndex);
+#endif
+
+    return thsvsGetVulkanBarrier2Masks(
+        thBarrier.prevAccessCount, thBarrier.pPrevAccesses,
+        thBarrier.nextAccessCount, thBarrier.pNextAccesses,
+        pVkBarrier->srcQueueFamilyIndex != pVkBarrier->dstQueueFamilyIndex,
+        &pVkBarrier->srcStageMask, &pVkBarrier->srcAccessMask,
+        &pVkBarrier->dstStageMask, &pVkBarrier->dstAccessMask);
 }
 
-void thsvsGetVulkanImageMemoryBarrier(
-    const ThsvsImageBarrier& thBarrier,
-    VkPipelineStageFlags*    pSrcStages,
-    VkPipelineStageFlags*    pDstStages,
-    VkImageMemoryBarrier*    pVkBarrier)
+VkBool32 thsvsGetVulkanImageMemoryBarrier2(
+    const ThsvsImageBarrier&  thBarrier,
+    VkImageMemoryBarrier2*    pVkBarrier)
 {
-    *pSrcStages                     = 0;
-    *pDstStages                     = 0;
-    pVkBarrier->sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    pVkBarrier->sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
     pVkBarrier->pNext               = NULL;
-    pVkBarrier->srcAccessMask       = 0;
-    pVkBarrier->dstAccessMask       = 0;
     pVkBarrier->srcQueueFamilyIndex = thBarrier.srcQueueFamilyIndex;
     pVkBarrier->dstQueueFamilyIndex = thBarrier.dstQueueFamilyIndex;
     pVkBarrier->image               = thBarrier.image;
     pVkBarrier->subresourceRange    = thBarrier.subresourceRange;
-    pVkBarrier->oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED;
-    pVkBarrier->newLayout           = VK_IMAGE_LAYOUT_UNDEFINED;
-
-    for (uint32_t i = 0; i < thBarrier.prevAccessCount; ++i)
-    {
-        ThsvsAccessType prevAccess = thBarrier.pPrevAccesses[i];
-        const ThsvsVkAccessInfo* pPrevAccessInfo = &ThsvsAccessMap[prevAccess];
+    pVkBarrier->oldLayout           = (thBarrier.discardContents == VK_TRUE) ? VK_IMAGE_LAYOUT_UNDEFINED :
+                                      thsvsSelectAspectImageLayout(thsvsGetAccessesImageLayout(thBarrier.prevAccessCount, thBarrier.pPrevAccesses, thBarrier.prevLayout),
+                                                                   thBarrier.prevLayout, thBarrier.subresourceRange.aspectMask);
+    pVkBarrier->newLayout           = thsvsSelectAspectImageLayout(thsvsGetAccessesImageLayout(thBarrier.nextAccessCount, thBarrier.pNextAccesses, thBarrier.nextLayout),
+                                                                   thBarrier.nextLayout, thBarrier.subresourceRange.aspectMask);
 
-#ifdef THSVS_ERROR_CHECK_ACCESS_TYPE_IN_RANGE
-        // Asserts that the previous access index is a valid range for the lookup
-        assert(prevAccess < THSVS_NUM_ACCESS_TYPES);
+#ifdef THSVS_ERROR_CHECK_COULD_USE_GLOBAL_BARRIER
+    assert(pVkBarrier->newLayout != pVkBarrier->oldLayout ||
+           pVkBarrier->srcQueueFamilyIndex != pVkBarrier->dstQueueFamilyIndex);
 #endif
 
-#ifdef THSVS_ERROR_CHECK_POTENTIAL_HAZARD
-        // Asserts that the access is a read, else it's a write and it should appear on its own.
-        assert(prevAccess < THSVS_END_OF_READ_ACCESS || thBarrier.prevAccessCount == 1);
-#endif
+    return thsvsGetVulkanBarrier2Masks(
+        thBarrier.prevAccessCount, thBarrier.pPrevAccesses,
+        thBarrier.nextAccessCount, thBarrier.pNextAccesses,
+        pVkBarrier->oldLayout != pVkBarrier->newLayout ||
+        pVkBarrier->srcQueueFamilyIndex != pVkBarrier->dstQueueFamilyIndex,
+        &pVkBarrier->srcStageMask, &pVkBarrier->srcAccessMask,
+        &pVkBarrier->dstStageMask, &pVkBarrier->dstAccessMask);
+}
 
-        *pSrcStages |= pPrevAccessInfo->stageMask;
+void thsvsGetVulkanExecutionDependency2(
+    const ThsvsExecutionBarrier& thBarrier,
+    VkMemoryBarrier2*            pVkBarrier)
+{
+    VkAccessFlags2 accessMask;
+    VkAccessFlags2 writeAccessMask;
+    bool           hasWriteAccess;
 
-        // Add appropriate availability operations - for writes only.
-        if (prevAccess > THSVS_END_OF_READ_ACCESS)
-            pVkBarrier->srcAccessMask |= pPrevAccessInfo->accessMask;
+    pVkBarrier->sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+    pVkBarrier->pNext         = NULL;
+    pVkBarrier->srcAccessMask = VK_ACCESS_2_NONE;
+    pVkBarrier->dstAccessMask = VK_ACCESS_2_NONE;
 
-        if (thBarrier.discardContents == VK_TRUE)
-        {
-            pVkBarrier->oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        }
-        else
-        {
-            VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    thsvsAccumulateAccessInfo2(thBarrier.prevAccessCount, thBarrier.pPrevAccesses, &pVkBarrier->srcStageMask, &accessMask, &writeAccessMask, &hasWriteAccess);
+    thsvsAccumulateAccessInfo2(thBarrier.nextAccessCount, thBarrier.pNextAccesses, &pVkBarrier->dstStageMask, &accessMask, &writeAccessMask, &hasWriteAccess);
+}
 
-            switch(thBarrier.prevLayout)
-            {
-                case THSVS_IMAGE_LAYOUT_GENERAL:
-                    if (prevAccess == THSVS_ACCESS_PRESENT)
-                        layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-                    else
-                        layout = VK_IMAGE_LAYOUT_GENERAL;
-                    break;
-                case THSVS_IMAGE_LAYOUT_OPTIMAL:
-                    layout = pPrevAccessInfo->imageLayout;
-                    break;
-                case THSVS_IMAGE_LAYOUT_GENERAL_AND_PRESENTATION:
-                    layout = VK_IMAGE_LAYOUT_SHARED_PRESENT_KHR;
-                    break;
-            }
+static void thsvsGetSemaphoreSubmitInfo(
+    VkSemaphore                  semaphore,
+    uint64_t                     value,
+    uint32_t                     accessCount,
+    const ThsvsAccessType*       pAccesses,
+    VkSemaphoreSubmitInfo*       pSubmitInfo)
+{
+    VkAccessFlags2 accessMask;
+    VkAccessFlags2 writeAccessMask;
+    bool           hasWriteAccess;
+
+    pSubmitInfo->sType       = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+    pSubmitInfo->pNext       = NULL;
+    pSubmitInfo->semaphore   = semaphore;
+    pSubmitInfo->value       = value;
+    pSubmitInfo->deviceIndex = 0;
+
+    // Semaphores make all memory available and visible, so only the stages matter
+    thsvsAccumulateAccessInfo2(accessCount, pAccesses, &pSubmitInfo->stageMask, &accessMask, &writeAccessMask, &hasWriteAccess);
+}
+
+void thsvsGetSemaphoreSignalInfo(
+    VkSemaphore                  semaphore,
+    uint64_t                     value,
+    uint32_t                     prevAccessCount,
+    const ThsvsAccessType*       pPrevAccesses,
+    VkSemaphoreSubmitInfo*       pSubmitInfo)
+{
+    thsvsGetSemaphoreSubmitInfo(semaphore, value, prevAccessCount, pPrevAccesses, pSubmitInfo);
+}
 
+void thsvsGetSemaphoreWaitInfo(
+    VkSemaphore                  semaphore,
+    uint64_t                     value,
+    uint32_t                     nextAccessCount,
+    const ThsvsAccessType*       pNextAccesses,
+    VkSemaphoreSubmitInfo*       pSubmitInfo)
+{
+    thsvsGetSemaphoreSubmitInfo(semaphore, value, nextAccessCount, pNextAccesses, pSubmitInfo);
+}
 
-#ifdef THSVS_ERROR_CHECK_MIXED_IMAGE_LAYOUT
-            assert(pVkBarrier->oldLayout == VK_IMAGE_LAYOUT_UNDEFINED ||
-                   pVkBarrier->oldLayout == layout);
+/*
+Translates a set of barriers into a VkDependencyInfo, writing the Vulkan
+barriers into caller allocated storage - pMemoryBarrier must always be
+valid, and the buffer and image barrier arrays must have space for every
+barrier passed in.
+*/
+static void thsvsTranslateDependencyInfo2(
+    const ThsvsGlobalBarrier* pGlobalBarrier,
+    uint32_t                  bufferBarrierCount,
+    const ThsvsBufferBarrier* pBufferBarriers,
+    uint32_t                  imageBarrierCount,
+    const ThsvsImageBarrier*  pImageBarriers,
+    VkMemoryBarrier2*         pMemoryBarrier,
+    VkBufferMemoryBarrier2*   pBufferMemoryBarriers,
+    VkImageMemoryBarrier2*    pImageMemoryBarriers,
+    VkDependencyInfo*         pDependencyInfo)
+{
+    pDependencyInfo->sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+    pDependencyInfo->pNext                    = NULL;
+    pDependencyInfo->dependencyFlags          = 0;
+    pDependencyInfo->memoryBarrierCount       = 0;
+    pDependencyInfo->pMemoryBarriers          = pMemoryBarrier;
+    pDependencyInfo->bufferMemoryBarrierCount = 0;
+    pDependencyInfo->pBufferMemoryBarriers    = pBufferMemoryBarriers;
+    pDependencyInfo->imageMemoryBarrierCount  = 0;
+    pDependencyInfo->pImageMemoryBarriers     = pImageMemoryBarriers;
+
+    // Unlike the legacy path, unneeded barriers can be dropped individually without affecting any others
+    if (pGlobalBarrier != NULL)
+    {
+        VkBool32 needed = thsvsGetVulkanMemoryBarrier2(*pGlobalBarrier, pMemoryBarrier);
+#ifdef THSVS_ELIDE_REDUNDANT_BARRIERS
+        if (needed == VK_TRUE)
+#else
+        (void)needed;
 #endif
-            pVkBarrier->oldLayout = layout;
-        }
+            ++pDependencyInfo->memoryBarrierCount;
     }
 
-    for (uint32_t i = 0; i < thBarrier.nextAccessCount; ++i)
+    for (uint32_t i = 0; i < bufferBarrierCount; ++i)
     {
-        ThsvsAccessType nextAccess = thBarrier.pNextAccesses[i];
-        const ThsvsVkAccessInfo* pNextAccessInfo = &ThsvsAccessMap[nextAccess];
-
-#ifdef THSVS_ERROR_CHECK_ACCESS_TYPE_IN_RANGE
-        // Asserts that the next access index is a valid range for the lookup
-        assert(nextAccess < THSVS_NUM_ACCESS_TYPES);
+        VkBool32 needed = thsvsGetVulkanBufferMemoryBarrier2(pBufferBarriers[i], &pBufferMemoryBarriers[pDependencyInfo->bufferMemoryBarrierCount]);
+#ifdef THSVS_ELIDE_REDUNDANT_BARRIERS
+        if (needed == VK_TRUE)
+#else
+        (void)needed;
 #endif
+            ++pDependencyInfo->bufferMemoryBarrierCount;
+    }
 
-#ifdef THSVS_ERROR_CHECK_POTENTIAL_HAZARD
-        // Asserts that the access is a read, else it's a write and it should appear on its own.
-        assert(nextAccess < THSVS_END_OF_READ_ACCESS || thBarrier.nextAccessCount == 1);
+    for (uint32_t i = 0; i < imageBarrierCount; ++i)
+    {
+        VkBool32 needed = thsvsGetVulkanImageMemoryBarrier2(pImageBarriers[i], &pImageMemoryBarriers[pDependencyInfo->imageMemoryBarrierCount]);
+#ifdef THSVS_ELIDE_REDUNDANT_BARRIERS
+        if (needed == VK_TRUE)
+#else
+        (void)needed;
 #endif
+            ++pDependencyInfo->imageMemoryBarrierCount;
+    }
+}
+
+#ifdef THSVS_STATS
+// Equivalent of thsvsInstrumentBarrier for vkCmdPipelineBarrier2 and vkCmdWaitEvents2 - each call is counted as
+// one command, however many dependency infos it takes
+static void thsvsInstrumentDependencyInfos2(
+    VkCommandBuffer              commandBuffer,
+    const char*                  pLabelName,
+    bool                         waitEvents,
+    uint32_t                     dependencyInfoCount,
+    const VkDependencyInfo*      pDependencyInfos)
+{
+    ThsvsContextStats* pStats = &thsvsThreadStats;
+    VkPipelineStageFlags2 stageMask = 0;
 
-        *pDstStages |= pNextAccessInfo->stageMask;
+    if (waitEvents)
+        pStats->waitEventsCount++;
+    else
+        pStats->pipelineBarrierCount++;
 
-        // Add visibility operations as necessary.
-        // If the src access mask is zero, this is a WAR hazard (or for some reason a "RAR"),
-        // so the dst access mask can be safely zeroed as these don't need visibility.
-        if (pVkBarrier->srcAccessMask != 0)
-            pVkBarrier->dstAccessMask |= pNextAccessInfo->accessMask;
+    for (uint32_t i = 0; i < dependencyInfoCount; ++i)
+    {
+        const VkDependencyInfo& dependencyInfo = pDependencyInfos[i];
+
+        pStats->memoryBarrierCount       += dependencyInfo.memoryBarrierCount;
+        pStats->bufferMemoryBarrierCount += dependencyInfo.bufferMemoryBarrierCount;
+        pStats->imageMemoryBarrierCount  += dependencyInfo.imageMemoryBarrierCount;
 
-        VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
-        switch(thBarrier.nextLayout)
+        for (uint32_t j = 0; j < dependencyInfo.memoryBarrierCount; ++j)
+            stageMask |= dependencyInfo.pMemoryBarriers[j].srcStageMask | dependencyInfo.pMemoryBarriers[j].dstStageMask;
+
+        for (uint32_t j = 0; j < dependencyInfo.bufferMemoryBarrierCount; ++j)
         {
-            case THSVS_IMAGE_LAYOUT_GENERAL:
-                if (nextAccess == THSVS_ACCESS_PRESENT)
-                    layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-                else
-                    layout = VK_IMAGE_LAYOUT_GENERAL;
-                break;
-            case THSVS_IMAGE_LAYOUT_OPTIMAL:
-                layout = pNextAccessInfo->imageLayout;
-                break;
-            case THSVS_IMAGE_LAYOUT_GENERAL_AND_PRESENTATION:
-                layout = VK_IMAGE_LAYOUT_SHARED_PRESENT_KHR;
-                break;
+            const VkBufferMemoryBarrier2& barrier = dependencyInfo.pBufferMemoryBarriers[j];
+            stageMask |= barrier.srcStageMask | barrier.dstStageMask;
+            if (barrier.srcQueueFamilyIndex != barrier.dstQueueFamilyIndex)
+                pStats->queueTransferCount++;
         }
 
-#ifdef THSVS_ERROR_CHECK_MIXED_IMAGE_LAYOUT
-        assert(pVkBarrier->newLayout == VK_IMAGE_LAYOUT_UNDEFINED ||
-               pVkBarrier->newLayout == layout);
-#endif
-        pVkBarrier->newLayout = layout;
+        for (uint32_t j = 0; j < dependencyInfo.imageMemoryBarrierCount; ++j)
+        {
+            const VkImageMemoryBarrier2& barrier = dependencyInfo.pImageMemoryBarriers[j];
+            stageMask |= barrier.srcStageMask | barrier.dstStageMask;
+            if (barrier.oldLayout != barrier.newLayout)
+                pStats->layoutTransitionCount++;
+            if (barrier.srcQueueFamilyIndex != barrier.dstQueueFamilyIndex)
+                pStats->queueTransferCount++;
+        }
     }
 
-#ifdef THSVS_ERROR_CHECK_COULD_USE_GLOBAL_BARRIER
-    assert(pVkBarrier->newLayout != pVkBarrier->oldLayout ||
-           pVkBarrier->srcQueueFamilyIndex != pVkBarrier->dstQueueFamilyIndex);
-#endif
+    const VkPipelineStageFlags2 broadStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT | VK_PIPELINE_STAGE_2_ALL_GRAPHICS_BIT;
+    bool broad = (stageMask & broadStageMask) != 0;
+    if (broad)
+        pStats->broadStageMaskCount++;
 
-    // Ensure that the stage masks are valid if no stages were determined
-    if (*pSrcStages == 0)
-        *pSrcStages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-    if (*pDstStages == 0)
-        *pDstStages = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+    thsvsInsertBarrierLabel(commandBuffer, pLabelName, broad);
 }
+#endif
 
-void thsvsCmdPipelineBarrier(
+void thsvsCmdPipelineBarrier2(
     VkCommandBuffer           commandBuffer,
     const ThsvsGlobalBarrier* pGlobalBarrier,
     uint32_t                  bufferBarrierCount,
@@ -1189,207 +8357,212 @@ void thsvsCmdPipelineBarrier(
     uint32_t                  imageBarrierCount,
     const ThsvsImageBarrier*  pImageBarriers)
 {
-    VkMemoryBarrier        memoryBarrier;
-    // Vulkan pipeline barrier command parameters
-    //                     commandBuffer;
-    VkPipelineStageFlags   srcStageMask             = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-    VkPipelineStageFlags   dstStageMask             = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-    uint32_t               memoryBarrierCount       = (pGlobalBarrier != NULL) ? 1 : 0;
-    VkMemoryBarrier*       pMemoryBarriers          = (pGlobalBarrier != NULL) ? &memoryBarrier : NULL;
-    uint32_t               bufferMemoryBarrierCount = bufferBarrierCount;
-    VkBufferMemoryBarrier* pBufferMemoryBarriers    = NULL;
-    uint32_t               imageMemoryBarrierCount  = imageBarrierCount;
-    VkImageMemoryBarrier*  pImageMemoryBarriers     = NULL;
+    thsvsCmdPipelineBarrier2Scratch(
+        commandBuffer,
+        NULL,
+        pGlobalBarrier,
+        bufferBarrierCount,
+        pBufferBarriers,
+        imageBarrierCount,
+        pImageBarriers);
+}
 
-    // Global memory barrier
-    if (pGlobalBarrier != NULL)
-    {
-        VkPipelineStageFlags tempSrcStageMask = 0;
-        VkPipelineStageFlags tempDstStageMask = 0;
-        thsvsGetVulkanMemoryBarrier(*pGlobalBarrier, &tempSrcStageMask, &tempDstStageMask, pMemoryBarriers);
-        srcStageMask |= tempSrcStageMask;
-        dstStageMask |= tempDstStageMask;
-    }
+void thsvsCmdPipelineBarrier2Scratch(
+    VkCommandBuffer           commandBuffer,
+    ThsvsScratch*             pScratch,
+    const ThsvsGlobalBarrier* pGlobalBarrier,
+    uint32_t                  bufferBarrierCount,
+    const ThsvsBufferBarrier* pBufferBarriers,
+    uint32_t                  imageBarrierCount,
+    const ThsvsImageBarrier*  pImageBarriers)
+{
+    VkMemoryBarrier2        memoryBarrier;
+    VkDependencyInfo        dependencyInfo;
+    size_t                  scratchOffset         = (pScratch != NULL) ? pScratch->offset : 0;
+    VkBufferMemoryBarrier2* pTempBufferBarriers   = NULL;
+    VkImageMemoryBarrier2*  pTempImageBarriers    = NULL;
+    VkBufferMemoryBarrier2* pBufferMemoryBarriers = NULL;
+    VkImageMemoryBarrier2*  pImageMemoryBarriers  = NULL;
 
-    // Buffer memory barriers
     if (bufferBarrierCount > 0)
-    {
-        pBufferMemoryBarriers = (VkBufferMemoryBarrier*)THSVS_TEMP_ALLOC(sizeof(VkBufferMemoryBarrier) * bufferMemoryBarrierCount);
-
-        VkPipelineStageFlags tempSrcStageMask = 0;
-        VkPipelineStageFlags tempDstStageMask = 0;
-        for (uint32_t i = 0; i < bufferBarrierCount; ++i)
-        {
-            thsvsGetVulkanBufferMemoryBarrier(pBufferBarriers[i], &tempSrcStageMask, &tempDstStageMask, &pBufferMemoryBarriers[i]);
-            srcStageMask |= tempSrcStageMask;
-            dstStageMask |= tempDstStageMask;
-        }
-    }
+        THSVS_ALLOC_BARRIERS(VkBufferMemoryBarrier2, bufferBarrierCount, pScratch, pBufferMemoryBarriers, pTempBufferBarriers);
 
-    // Image memory barriers
     if (imageBarrierCount > 0)
-    {
-        pImageMemoryBarriers = (VkImageMemoryBarrier*)THSVS_TEMP_ALLOC(sizeof(VkImageMemoryBarrier) * imageMemoryBarrierCount);
-
-        VkPipelineStageFlags tempSrcStageMask = 0;
-        VkPipelineStageFlags tempDstStageMask = 0;
-        for (uint32_t i = 0; i < imageBarrierCount; ++i)
-        {
-            thsvsGetVulkanImageMemoryBarrier(pImageBarriers[i], &tempSrcStageMask, &tempDstStageMask, &pImageMemoryBarriers[i]);
-            srcStageMask |= tempSrcStageMask;
-            dstStageMask |= tempDstStageMask;
-        }
-    }
-
-    vkCmdPipelineBarrier(
-        commandBuffer,
-        srcStageMask,
-        dstStageMask,
-        0,
-        memoryBarrierCount,
-        pMemoryBarriers,
-        bufferMemoryBarrierCount,
+        THSVS_ALLOC_BARRIERS(VkImageMemoryBarrier2, imageBarrierCount, pScratch, pImageMemoryBarriers, pTempImageBarriers);
+
+    thsvsTranslateDependencyInfo2(
+        pGlobalBarrier,
+        bufferBarrierCount,
+        pBufferBarriers,
+        imageBarrierCount,
+        pImageBarriers,
+        &memoryBarrier,
         pBufferMemoryBarriers,
-        imageMemoryBarrierCount,
-        pImageMemoryBarriers);
+        pImageMemoryBarriers,
+        &dependencyInfo);
 
-    THSVS_TEMP_FREE(pBufferMemoryBarriers);
-    THSVS_TEMP_FREE(pImageMemoryBarriers);
-}
+    bool recorded = dependencyInfo.memoryBarrierCount > 0 ||
+                    dependencyInfo.bufferMemoryBarrierCount > 0 ||
+                    dependencyInfo.imageMemoryBarrierCount > 0;
 
-void thsvsCmdSetEvent(
-    VkCommandBuffer           commandBuffer,
-    VkEvent                   event,
-    uint32_t                  prevAccessCount,
-    const ThsvsAccessType*    pPrevAccesses)
-{
-    VkPipelineStageFlags stageMask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+#ifdef THSVS_CAPTURE
+    thsvsCaptureBarriers(THSVS_CAPTURE_RECORD_PIPELINE_BARRIER, recorded, 0, 0,
+                         pGlobalBarrier, bufferBarrierCount, pBufferBarriers, imageBarrierCount, pImageBarriers);
+#endif
 
-    for (uint32_t i = 0; i < prevAccessCount; ++i)
+    if (recorded)
     {
-        ThsvsAccessType prevAccess = pPrevAccesses[i];
-        const ThsvsVkAccessInfo* pPrevAccessInfo = &ThsvsAccessMap[prevAccess];
-
-#ifdef THSVS_ERROR_CHECK_ACCESS_TYPE_IN_RANGE
-        // Asserts that the previous access index is a valid range for the lookup
-        assert(prevAccess < THSVS_NUM_ACCESS_TYPES);
+#ifdef THSVS_STATS
+        thsvsInstrumentDependencyInfos2(commandBuffer, "thsvsCmdPipelineBarrier2", false, 1, &dependencyInfo);
 #endif
 
-        stageMask |= pPrevAccessInfo->stageMask;
-    }
-
-    vkCmdSetEvent(
-        commandBuffer,
-        event,
-        stageMask);
-}
-
-void thsvsCmdResetEvent(
-    VkCommandBuffer           commandBuffer,
-    VkEvent                   event,
-    uint32_t                  prevAccessCount,
-    const ThsvsAccessType*    pPrevAccesses)
-{
-    VkPipelineStageFlags stageMask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+#ifdef THSVS_PROFILE
+        bool profiled = thsvsProfileBeginBarrier(commandBuffer, pGlobalBarrier, bufferBarrierCount, pBufferBarriers,
+                                                 imageBarrierCount, pImageBarriers);
+#endif
 
-    for (uint32_t i = 0; i < prevAccessCount; ++i)
-    {
-        ThsvsAccessType prevAccess = pPrevAccesses[i];
-        const ThsvsVkAccessInfo* pPrevAccessInfo = &ThsvsAccessMap[prevAccess];
+        vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
 
-#ifdef THSVS_ERROR_CHECK_ACCESS_TYPE_IN_RANGE
-        // Asserts that the previous access index is a valid range for the lookup
-        assert(prevAccess < THSVS_NUM_ACCESS_TYPES);
+#ifdef THSVS_PROFILE
+        if (profiled)
+            thsvsProfileEndBarrier(commandBuffer);
 #endif
-
-        stageMask |= pPrevAccessInfo->stageMask;
     }
 
-    vkCmdResetEvent(
-        commandBuffer,
-        event,
-        stageMask);
+    THSVS_TEMP_FREE(pTempBufferBarriers);
+    THSVS_TEMP_FREE(pTempImageBarriers);
+
+    if (pScratch != NULL)
+        pScratch->offset = scratchOffset;
 }
 
-void thsvsCmdWaitEvents(
+/*
+Shared by thsvsCmdSetEvents2 and thsvsCmdWaitEvents2, so that both are
+guaranteed to build identical dependency infos from the same event barriers.
+*/
+static void thsvsCmdEvents2(
     VkCommandBuffer           commandBuffer,
-    uint32_t                  eventCount,
-    const VkEvent*            pEvents,
-    const ThsvsGlobalBarrier* pGlobalBarrier,
-    uint32_t                  bufferBarrierCount,
-    const ThsvsBufferBarrier* pBufferBarriers,
-    uint32_t                  imageBarrierCount,
-    const ThsvsImageBarrier*  pImageBarriers)
+    ThsvsScratch*             pScratch,
+    bool                      wait,
+    uint32_t                  eventBarrierCount,
+    const ThsvsEventBarrier*  pEventBarriers)
 {
-    VkMemoryBarrier        memoryBarrier;
-    // Vulkan pipeline barrier command parameters
-    //                     commandBuffer;
-    //                     eventCount;
-    //                     pEvents;
-    VkPipelineStageFlags   srcStageMask             = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-    VkPipelineStageFlags   dstStageMask             = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-    uint32_t               memoryBarrierCount       = (pGlobalBarrier != NULL) ? 1 : 0;
-    VkMemoryBarrier*       pMemoryBarriers          = (pGlobalBarrier != NULL) ? &memoryBarrier : NULL;
-    uint32_t               bufferMemoryBarrierCount = bufferBarrierCount;
-    VkBufferMemoryBarrier* pBufferMemoryBarriers    = NULL;
-    uint32_t               imageMemoryBarrierCount  = imageBarrierCount;
-    VkImageMemoryBarrier*  pImageMemoryBarriers     = NULL;
-
-    // Global memory barrier
-    if (pGlobalBarrier != NULL)
+    size_t                  scratchOffset           = (pScratch != NULL) ? pScratch->offset : 0;
+    VkEvent*                pTempEvents             = NULL;
+    VkDependencyInfo*       pTempDependencyInfos    = NULL;
+    VkMemoryBarrier2*       pTempMemoryBarriers     = NULL;
+    VkBufferMemoryBarrier2* pTempBufferBarriers     = NULL;
+    VkImageMemoryBarrier2*  pTempImageBarriers      = NULL;
+    VkEvent*                pEvents                 = NULL;
+    VkDependencyInfo*       pDependencyInfos        = NULL;
+    VkMemoryBarrier2*       pMemoryBarriers         = NULL;
+    VkBufferMemoryBarrier2* pBufferMemoryBarriers   = NULL;
+    VkImageMemoryBarrier2*  pImageMemoryBarriers    = NULL;
+    uint32_t                bufferBarrierCount      = 0;
+    uint32_t                imageBarrierCount       = 0;
+
+    if (eventBarrierCount == 0)
+        return;
+
+    for (uint32_t i = 0; i < eventBarrierCount; ++i)
     {
-        VkPipelineStageFlags tempSrcStageMask = 0;
-        VkPipelineStageFlags tempDstStageMask = 0;
-        thsvsGetVulkanMemoryBarrier(*pGlobalBarrier, &tempSrcStageMask, &tempDstStageMask, pMemoryBarriers);
-        srcStageMask |= tempSrcStageMask;
-        dstStageMask |= tempDstStageMask;
+        bufferBarrierCount += pEventBarriers[i].bufferBarrierCount;
+        imageBarrierCount  += pEventBarriers[i].imageBarrierCount;
     }
 
-    // Buffer memory barriers
+    if (wait)
+        THSVS_ALLOC_BARRIERS(VkEvent, eventBarrierCount, pScratch, pEvents, pTempEvents);
+
+    THSVS_ALLOC_BARRIERS(VkDependencyInfo, eventBarrierCount, pScratch, pDependencyInfos, pTempDependencyInfos);
+    THSVS_ALLOC_BARRIERS(VkMemoryBarrier2, eventBarrierCount, pScratch, pMemoryBarriers, pTempMemoryBarriers);
+
     if (bufferBarrierCount > 0)
-    {
-        pBufferMemoryBarriers = (VkBufferMemoryBarrier*)THSVS_TEMP_ALLOC(sizeof(VkBufferMemoryBarrier) * bufferMemoryBarrierCount);
+        THSVS_ALLOC_BARRIERS(VkBufferMemoryBarrier2, bufferBarrierCount, pScratch, pBufferMemoryBarriers, pTempBufferBarriers);
 
-        VkPipelineStageFlags tempSrcStageMask = 0;
-        VkPipelineStageFlags tempDstStageMask = 0;
-        for (uint32_t i = 0; i < bufferBarrierCount; ++i)
+    if (imageBarrierCount > 0)
+        THSVS_ALLOC_BARRIERS(VkImageMemoryBarrier2, imageBarrierCount, pScratch, pImageMemoryBarriers, pTempImageBarriers);
+
+    // Each event gets its own dependency info, over its own slice of the barrier arrays
+    VkBufferMemoryBarrier2* pEventBufferMemoryBarriers = pBufferMemoryBarriers;
+    VkImageMemoryBarrier2*  pEventImageMemoryBarriers  = pImageMemoryBarriers;
+    for (uint32_t i = 0; i < eventBarrierCount; ++i)
+    {
+        const ThsvsEventBarrier& eventBarrier = pEventBarriers[i];
+
+        thsvsTranslateDependencyInfo2(
+            eventBarrier.pGlobalBarrier,
+            eventBarrier.bufferBarrierCount,
+            eventBarrier.pBufferBarriers,
+            eventBarrier.imageBarrierCount,
+            eventBarrier.pImageBarriers,
+            &pMemoryBarriers[i],
+            pEventBufferMemoryBarriers,
+            pEventImageMemoryBarriers,
+            &pDependencyInfos[i]);
+
+        pEventBufferMemoryBarriers += eventBarrier.bufferBarrierCount;
+        pEventImageMemoryBarriers  += eventBarrier.imageBarrierCount;
+
+        if (wait)
         {
-            thsvsGetVulkanBufferMemoryBarrier(pBufferBarriers[i], &tempSrcStageMask, &tempDstStageMask, &pBufferMemoryBarriers[i]);
-            srcStageMask |= tempSrcStageMask;
-            dstStageMask |= tempDstStageMask;
+            pEvents[i] = eventBarrier.event;
+
+#ifdef THSVS_DIAGNOSTICS
+            thsvsDiagnoseBarriers(eventBarrier.pGlobalBarrier, eventBarrier.bufferBarrierCount, eventBarrier.pBufferBarriers,
+                                  eventBarrier.imageBarrierCount, eventBarrier.pImageBarriers);
+#endif
         }
     }
 
-    // Image memory barriers
-    if (imageBarrierCount > 0)
+#ifdef THSVS_DIAGNOSTICS
+    thsvsDiagnoseSequence(commandBuffer, false);
+#endif
+
+    if (wait)
     {
-        pImageMemoryBarriers = (VkImageMemoryBarrier*)THSVS_TEMP_ALLOC(sizeof(VkImageMemoryBarrier) * imageMemoryBarrierCount);
+#ifdef THSVS_STATS
+        thsvsInstrumentDependencyInfos2(commandBuffer, "thsvsCmdWaitEvents2", true, eventBarrierCount, pDependencyInfos);
+#endif
 
-        VkPipelineStageFlags tempSrcStageMask = 0;
-        VkPipelineStageFlags tempDstStageMask = 0;
-        for (uint32_t i = 0; i < imageBarrierCount; ++i)
-        {
-            thsvsGetVulkanImageMemoryBarrier(pImageBarriers[i], &tempSrcStageMask, &tempDstStageMask, &pImageMemoryBarriers[i]);
-            srcStageMask |= tempSrcStageMask;
-            dstStageMask |= tempDstStageMask;
-        }
+#ifdef THSVS_CAPTURE
+        thsvsCaptureEventBarriers(THSVS_CAPTURE_RECORD_WAIT_EVENTS, true, 0, 0, eventBarrierCount, pEventBarriers);
+#endif
+
+        vkCmdWaitEvents2(commandBuffer, eventBarrierCount, pEvents, pDependencyInfos);
+    }
+    else
+    {
+        for (uint32_t i = 0; i < eventBarrierCount; ++i)
+            vkCmdSetEvent2(commandBuffer, pEventBarriers[i].event, &pDependencyInfos[i]);
     }
 
-    vkCmdWaitEvents(
-        commandBuffer,
-        eventCount,
-        pEvents,
-        srcStageMask,
-        dstStageMask,
-        memoryBarrierCount,
-        pMemoryBarriers,
-        bufferMemoryBarrierCount,
-        pBufferMemoryBarriers,
-        imageMemoryBarrierCount,
-        pImageMemoryBarriers);
+    THSVS_TEMP_FREE(pTempEvents);
+    THSVS_TEMP_FREE(pTempDependencyInfos);
+    THSVS_TEMP_FREE(pTempMemoryBarriers);
+    THSVS_TEMP_FREE(pTempBufferBarriers);
+    THSVS_TEMP_FREE(pTempImageBarriers);
 
-    THSVS_TEMP_FREE(pBufferMemoryBarriers);
-    THSVS_TEMP_FREE(pImageMemoryBarriers);
+    if (pScratch != NULL)
+        pScratch->offset = scratchOffset;
+}
+
+void thsvsCmdSetEvents2(
+    VkCommandBuffer           commandBuffer,
+    ThsvsScratch*             pScratch,
+    uint32_t                  eventBarrierCount,
+    const ThsvsEventBarrier*  pEventBarriers)
+{
+    thsvsCmdEvents2(commandBuffer, pScratch, false, eventBarrierCount, pEventBarriers);
+}
+
+void thsvsCmdWaitEvents2(
+    VkCommandBuffer           commandBuffer,
+    ThsvsScratch*             pScratch,
+    uint32_t                  eventBarrierCount,
+    const ThsvsEventBarrier*  pEventBarriers)
+{
+    thsvsCmdEvents2(commandBuffer, pScratch, true, eventBarrierCount, pEventBarriers);
 }
+#endif // VK_VERSION_1_3
 
 #endif // THSVS_SIMPLER_VULKAN_SYNCHRONIZATION_IMPLEMENTATION